@@ -103,8 +103,15 @@ private:
   // End of section that should ultimately be moved to AromSF base class
   //////////////////////////////////////////////////////////
 
+  // Returns the index of the current sampled receptor conformer in the
+  // per-conformer grid lists, or -1 to use the union grids
+  int GetConformerGridIndex() const;
+
   InteractionGridPtr m_spAromGrid;
   InteractionGridPtr m_spGuanGrid;
+  // Indexing grids for each sampled receptor conformer (indexed from 0)
+  std::vector<InteractionGridPtr> m_conformerAromGrids;
+  std::vector<InteractionGridPtr> m_conformerGuanGrids;
   InteractionCenterList m_recepAromList;
   InteractionCenterList m_recepGuanList;
   InteractionCenterList m_ligAromList;
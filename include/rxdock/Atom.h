@@ -22,6 +22,7 @@
 #include "rxdock/TriposAtomType.h"
 
 #include <list>
+#include <unordered_map>
 
 #include <nlohmann/json.hpp>
 
@@ -100,6 +101,9 @@ public:
                                                 const Atom &atom);
   friend void to_json(json &j, const Atom &atom);
   friend void from_json(const json &j, Atom &atom);
+  // Stores and restores the atom attributes column-wise in prepared model
+  // cache entries
+  friend class ModelCache;
 
   // Virtual function for dumping atom details to an output stream
   // Derived classes (e.g. pseudoatom) can override if required
@@ -283,6 +287,11 @@ public:
   // and RevertCoords
   void SaveCoords(unsigned int coordNum = 0);
   void RevertCoords(unsigned int coordNum = 0);
+  // Returns the numbered saved coords without changing the current coords
+  const Coord &GetSavedCoords(unsigned int coordNum = 0) const;
+  bool HasSavedCoords(unsigned int coordNum = 0) const {
+    return m_savedCoords.find(coordNum) != m_savedCoords.end();
+  }
 
   // Translate - translate coordinates by the supplied vector
   void Translate(const Vector &vector) { m_coord += vector; }
@@ -381,6 +390,9 @@ typedef std::list<AtomPtr> AtomTrueList; // A real list of smart pointers
 typedef AtomTrueList::iterator AtomTrueListIter;
 typedef AtomTrueList::const_iterator AtomTrueListConstIter;
 
+// Gradient of a score with respect to the coordinates of each atom
+typedef std::unordered_map<const Atom *, Vector> AtomGradientMap;
+
 ///////////////////////////////////////////////
 // Non-member functions (in rxdock namespace)
 //////////////////////////////////////////
@@ -0,0 +1,48 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Abstract base class for deciding whether a docking run is hopeless and
+// should be abandoned part way through. Transforms consult the workspace
+// predicate at the end of their execution and, for the long GA and Monte
+// Carlo loops, periodically during execution.
+
+#ifndef _RBTBASEABORTPREDICATE_H_
+#define _RBTBASEABORTPREDICATE_H_
+
+#include "rxdock/Config.h"
+
+namespace rxdock {
+
+class BaseTransform; // forward definition
+class WorkSpace;     // forward definition
+
+class BaseAbortPredicate {
+public:
+  virtual ~BaseAbortPredicate() {}
+
+  // Returns true if the transform should check the run once it has done the
+  // given fraction (0 to 1) of its work. Lets transforms skip the work of
+  // setting up the models for the check (e.g. syncing the best pose)
+  virtual bool isCheckDue(const BaseTransform *pTransform,
+                          double progress) const = 0;
+  // Returns true if the run should be abandoned, given the current models
+  virtual bool Abort(const BaseTransform *pTransform,
+                     WorkSpace *pWorkSpace) = 0;
+};
+
+// Useful typedefs
+typedef SmartPtr<BaseAbortPredicate> AbortPredicatePtr; // Smart pointer
+
+} // namespace rxdock
+
+#endif //_RBTBASEABORTPREDICATE_H_
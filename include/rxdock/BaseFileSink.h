@@ -20,6 +20,7 @@
 
 #include <fstream>
 
+#include "rxdock/CompressedFileStream.h"
 #include "rxdock/Config.h"
 
 #include <nlohmann/json.hpp>
@@ -48,6 +49,9 @@ public:
   void SetFileName(const std::string &fileName);
   bool StatusOK() { return Status().isOK(); }
   Error Status();
+  // Offset in the file at which the next record will be written. For
+  // compressed files, offset in the decompressed data written by this sink
+  RBTDLL_EXPORT std::size_t GetWriteOffset() const;
 
   // PURE VIRTUAL - MUST BE OVERRIDDEN IN DERIVED CLASSES
   virtual void Render() = 0;
@@ -100,8 +104,11 @@ private:
   //////////////
   std::vector<std::string> m_lineRecs;
   std::string m_strFileName;
-  std::ofstream m_fileOut;
+  // Compresses .gz and .zst files. These are kept open between appending
+  // writes, so that they are compressed as a whole
+  OutputFileStream m_fileOut;
   bool m_bAppend; // If true, Write() appends to file rather than overwriting
+  std::size_t m_nBytesWritten; // Since the file was last overwritten
 };
 
 void to_json(json &j, const BaseFileSink &baseFileSink);
@@ -17,6 +17,7 @@
 
 #include <fstream>
 
+#include "rxdock/CompressedFileStream.h"
 #include "rxdock/Config.h"
 
 #include <nlohmann/json.hpp>
@@ -65,6 +66,14 @@ public:
   RBTDLL_EXPORT void NextRecord();
   void Rewind();
   RBTDLL_EXPORT std::size_t GetEstimatedNumRecords();
+  // Byte offsets in the file of the start of the current record, and of the
+  // end of its delimiter line, so that the record can be copied verbatim
+  RBTDLL_EXPORT std::size_t GetRecordStart();
+  RBTDLL_EXPORT std::size_t GetRecordEnd();
+  // Restricts reading to the records starting at the given byte offsets, in
+  // that order (for files with the delimiter at the end of each record)
+  RBTDLL_EXPORT void
+  SetRecordOffsets(const std::vector<std::size_t> &recordOffsets);
 
 protected:
   //////////////////////////////////////////////////////
@@ -99,7 +108,13 @@ private:
   bool m_bReadOK; // For use by Read
   std::size_t m_numReads;
   std::size_t m_bytesRead;
-  std::ifstream m_fileIn;
+  std::size_t m_recordStart; // Offsets of the current record
+  std::size_t m_recordEnd;
+  bool m_bRecordOffsets; // If true, only the records at m_recordOffsets
+                         // are read
+  std::vector<std::size_t> m_recordOffsets;
+  std::size_t m_iRecordOffset; // Next record to read
+  InputFileStream m_fileIn; // Decompresses .gz and .zst files
   char *m_szBuf;    // Line buffer
   bool m_bFileOpen; // Keep track of whether we've opened the file or not
   bool m_bMultiRec; // Is file multi-record ?
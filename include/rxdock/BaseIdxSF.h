@@ -17,7 +17,9 @@
 #define _RBTBASEIDXSF_H_
 
 #include "rxdock/BaseSF.h"
+#include "rxdock/CacheEntry.h"
 #include "rxdock/InteractionGrid.h"
+#include "rxdock/Model.h"
 #include "rxdock/NonBondedGrid.h"
 #include "rxdock/NonBondedHHSGrid.h"
 
@@ -27,6 +29,8 @@ using json = nlohmann::json;
 
 namespace rxdock {
 
+class ModelCache;
+
 class BaseIdxSF : public virtual BaseSF {
 public:
   // Class type string
@@ -34,6 +38,8 @@ public:
   // Parameter names
   static const std::string _GRIDSTEP;
   static const std::string _BORDER;
+  // Entry type of the receptor setup in the receptor cache
+  static const std::string _SETUP_ENTRY;
 
   ////////////////////////////////////////
   // Constructors/destructors
@@ -67,6 +73,23 @@ protected:
   // GetCorrectedRange() = GetRange() + GetMaxError() + GetBorder()
   double GetCorrectedRange() const;
 
+  // Receptor setup cache (see WorkSpace::SetReceptorCache)
+  // Subclasses call LoadReceptorSetup in SetupReceptor and, if it returns
+  // false, set up the receptor themselves and call SaveReceptorSetup. Both do
+  // nothing (and LoadReceptorSetup returns false) if the workspace has no
+  // receptor cache, or if the receptor has more than one set of coordinates
+  bool LoadReceptorSetup(ModelPtr spReceptor);
+  void SaveReceptorSetup(ModelPtr spReceptor) const;
+  // Subclasses calling the above write their receptor setup in
+  // WriteReceptorSetup, referring to receptor atoms by their index in the
+  // receptor atom list, and read it back in ReadReceptorSetup. A corrupt entry
+  // makes ReadReceptorSetup throw std::length_error, so it must not change
+  // the scoring function before it has read the whole entry
+  virtual void WriteReceptorSetup(CacheEntryWriter &writer) const {}
+  virtual void ReadReceptorSetup(CacheEntryReader &reader) {}
+  // Receptor atoms as the table of atoms referred to by index
+  static AtomRList GetReceptorAtomTable(ModelPtr spReceptor);
+
   // As this has a virtual base class we need a separate OwnParameterUpdated
   // which can be called by concrete subclass ParameterUpdated methods
   // See Stroustrup C++ 3rd edition, p395, on programming virtual base classes
@@ -76,6 +99,12 @@ private:
   ////////////////////////////////////////
   // Private methods
   /////////////////
+  // Returns the receptor cache to use for the receptor, or nullptr
+  const ModelCache *GetReceptorSetupCache(ModelPtr spReceptor) const;
+  // Key of the receptor setup: the receptor cache key, the docking site, and
+  // the names and parameters of this and all other scoring functions in the
+  // same tree (which may set up receptor atom attributes)
+  std::string GetReceptorSetupKey() const;
 
 protected:
   ////////////////////////////////////////
@@ -14,8 +14,10 @@
 #ifndef _RBTBASESF_H_
 #define _RBTBASESF_H_
 
+#include "rxdock/Atom.h"
 #include "rxdock/BaseObject.h"
 #include "rxdock/Config.h"
+#include "rxdock/Coord.h"
 
 #include <nlohmann/json.hpp>
 
@@ -24,6 +26,9 @@ using json = nlohmann::json;
 namespace rxdock {
 
 class SFAgg; // forward declaration
+class PoseBatch; // forward declaration
+class BaseSF;
+typedef std::vector<BaseSF *> BaseSFList; // Vector of regular pointers
 
 class BaseSF : public BaseObject {
 public:
@@ -64,6 +69,18 @@ public:
 
   // Main public method - returns current weighted score
   RBTDLL_EXPORT double Score() const;
+  // Analytic gradients, for gradient-based minimisers.
+  // Returns the weighted score of all terms that provide analytic gradients,
+  // and adds scale * the gradient of that score with respect to the atomic
+  // coordinates to gradient. Enabled terms without analytic gradients are
+  // appended to noGradList instead, and are not included in the returned score
+  virtual double ScoreGradient(AtomGradientMap &gradient,
+                               BaseSFList &noGradList,
+                               double scale = 1.0) const;
+  // Batched scoring of many poses in one call. Sets out[i] to the weighted
+  // score of pose i of the batch. The coordinates of the batch models are
+  // restored on return
+  RBTDLL_EXPORT void ScoreBatch(const PoseBatch &poses, double *out) const;
   // Returns all child component scores as a string-variant map
   // Key = fully qualified component name, value = weighted score
   //(for saving in a Model's data fields)
@@ -86,6 +103,18 @@ protected:
   BaseSF();
   // PURE VIRTUAL - DERIVED CLASSES MUST OVERRIDE
   virtual double RawScore() const = 0;
+  // Analytic gradient of the raw score. Subclasses that support it should
+  // return true, set score to RawScore() and add scale * d(RawScore)/dx for
+  // each atom to gradient. Base class implementation returns false
+  virtual bool RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const;
+  // Raw scores of each pose of the batch. Subclasses can override to amortise
+  // per-atom lookups over the poses, and should then also override
+  // isRawScoreBatched to return true. Base class implementation moves the
+  // models to each pose in turn and calls RawScore, leaving the models in an
+  // arbitrary pose of the batch
+  virtual void RawScoreBatch(const PoseBatch &poses, double *out) const;
+  virtual bool isRawScoreBatched() const;
   // DM 25 Oct 2000 - track changes to parameter values in local data members
   // ParameterUpdated is invoked by ParamHandler::SetParameter
   void ParameterUpdated(const std::string &strName);
@@ -118,7 +147,6 @@ void to_json(json &j, const BaseSF &baseSF);
 void from_json(const json &j, BaseSF &baseSF);
 
 // Useful typedefs
-typedef std::vector<BaseSF *> BaseSFList; // Vector of smart pointers
 typedef BaseSFList::iterator BaseSFListIter;
 typedef BaseSFList::const_iterator BaseSFListConstIter;
 
@@ -76,6 +76,14 @@ protected:
   ///////////////////
   BaseTransform(const std::string &strClass, const std::string &strName);
 
+  // Abort handling for long running transforms: returns true if the
+  // workspace abort predicate wants to check the run once the given fraction
+  // of the transform is done
+  bool isAbortCheckDue(double progress) const;
+  // Throws DockingAbort if the workspace abort predicate abandons the run.
+  // The models must hold the pose to be checked
+  void CheckAbort();
+
 private:
   ////////////////////////////////////////
   // Private methods
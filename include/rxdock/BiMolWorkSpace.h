@@ -51,6 +51,11 @@ public:
   RBTDLL_EXPORT void RemoveSolvent();
   RBTDLL_EXPORT void
   UpdateModelCoordsFromChromRecords(BaseMolecularFileSource *pSource);
+  // As above, from the data fields of a record that has already been read.
+  // strSourceName is only used in messages
+  RBTDLL_EXPORT void
+  UpdateModelCoordsFromChromRecords(const StringVariantMap &dataMap,
+                                    const std::string &strSourceName);
 
   // Model I/O
   // Saves ligand to file sink
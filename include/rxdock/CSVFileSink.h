@@ -20,6 +20,7 @@
 
 #include "rxdock/BaseMolecularFileSink.h"
 #include "rxdock/ElementFileSource.h"
+#include "rxdock/MdlRecord.h"
 
 namespace rxdock {
 
@@ -31,10 +32,15 @@ public:
   virtual ~CSVFileSink();
 
   virtual void Render();
+  // Renders a record read as text, with its atoms as written in the file
+  RBTDLL_EXPORT void RenderRecord(const MdlRecord &record);
+  // Returns the line RenderRecord writes, without writing it. Can be called
+  // concurrently
+  RBTDLL_EXPORT std::string GetRecordLine(const MdlRecord &record) const;
 
 private:
   std::string RenderAtomList(const AtomList &atomList);
-  std::string RenderData(const StringVariantMap &dataMap);
+  std::string RenderData(const StringVariantMap &dataMap) const;
 
   CSVFileSink();                    // Disable default constructor
   CSVFileSink(const CSVFileSink &); // Copy constructor disabled by
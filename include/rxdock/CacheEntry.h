@@ -0,0 +1,220 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Binary buffers of the model cache entries (see ModelCache). Values are
+// stored in native byte order. Vectors and strings are preceded by their
+// uint64 length. Lists of pointers are stored as indices into a table of the
+// objects pointed to, so that they can be restored against another copy of
+// the objects (e.g. the atoms of a receptor loaded from the cache).
+
+#ifndef _RBTCACHEENTRY_H_
+#define _RBTCACHEENTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rxdock {
+
+// Index of each object in a table of pointers, for writing pointers as indices
+template <typename T>
+using CacheIndexMap = std::unordered_map<const T *, std::uint32_t>;
+
+template <typename T>
+CacheIndexMap<T> CreateCacheIndexMap(const std::vector<T *> &table) {
+  CacheIndexMap<T> indexMap;
+  for (std::size_t i = 0; i < table.size(); i++) {
+    indexMap[table[i]] = i;
+  }
+  return indexMap;
+}
+
+// Maps lists of indices read by CacheEntryReader::GetIndexLists back to the
+// pointers in the table
+template <typename T>
+std::vector<T *> GetCachedPointers(const std::vector<std::uint32_t> &indices,
+                                   const std::vector<T *> &table) {
+  std::vector<T *> pointers;
+  pointers.reserve(indices.size());
+  for (auto index : indices) {
+    pointers.push_back(table[index]);
+  }
+  return pointers;
+}
+
+// Appends values to an entry buffer
+class CacheEntryWriter {
+public:
+  template <typename T> void Put(T value) {
+    m_buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  template <typename T> void PutValues(const std::vector<T> &values) {
+    Put<std::uint64_t>(values.size());
+    m_buf.append(reinterpret_cast<const char *>(values.data()),
+                 values.size() * sizeof(T));
+  }
+  void PutString(const std::string &str) {
+    Put<std::uint64_t>(str.size());
+    m_buf.append(str);
+  }
+  void PutStrings(const std::vector<std::string> &strs) {
+    Put<std::uint64_t>(strs.size());
+    for (const auto &str : strs) {
+      PutString(str);
+    }
+  }
+  // Writes n lists of pointers, getList(i) returning the i-th list, as the
+  // list sizes followed by the indices of all the pointers in indexMap
+  template <typename T, typename GetList>
+  void PutIndexLists(std::size_t n, GetList getList,
+                     const CacheIndexMap<T> &indexMap) {
+    std::vector<std::uint32_t> sizes;
+    std::vector<std::uint32_t> indices;
+    sizes.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+      const std::vector<T *> &list = getList(i);
+      sizes.push_back(list.size());
+      for (const T *p : list) {
+        indices.push_back(indexMap.at(p));
+      }
+    }
+    PutValues(sizes);
+    PutValues(indices);
+  }
+  template <typename T>
+  void PutIndexLists(const std::vector<std::vector<T *>> &lists,
+                     const CacheIndexMap<T> &indexMap) {
+    PutIndexLists(
+        lists.size(),
+        [&lists](std::size_t i) -> const std::vector<T *> & {
+          return lists[i];
+        },
+        indexMap);
+  }
+  template <typename T>
+  void PutIndices(const std::vector<T *> &list,
+                  const CacheIndexMap<T> &indexMap) {
+    PutIndexLists(
+        1, [&list](std::size_t) -> const std::vector<T *> & { return list; },
+        indexMap);
+  }
+  const std::string &GetBuffer() const { return m_buf; }
+
+private:
+  std::string m_buf;
+};
+
+// Reads values back from an entry buffer. Throws std::length_error if the
+// entry is truncated, or if a column does not have the expected length or
+// refers to an object beyond the end of its table
+class CacheEntryReader {
+public:
+  CacheEntryReader(const std::string &buf)
+      : m_p(buf.data()), m_end(buf.data() + buf.size()) {}
+  template <typename T> T Get() {
+    T value;
+    Read(&value, sizeof(T));
+    return value;
+  }
+  template <typename T> std::vector<T> GetValues() {
+    std::vector<T> values(GetLength(sizeof(T)));
+    Read(values.data(), values.size() * sizeof(T));
+    return values;
+  }
+  template <typename T> std::vector<T> GetColumn(std::size_t n) {
+    std::vector<T> values = GetValues<T>();
+    CheckColumn(values.size(), n);
+    return values;
+  }
+  std::string GetString() {
+    std::size_t n = GetLength(1);
+    std::string str(m_p, n);
+    m_p += n;
+    return str;
+  }
+  std::vector<std::string> GetStrings() {
+    std::vector<std::string> strs(GetLength(sizeof(std::uint64_t)));
+    for (auto &str : strs) {
+      str = GetString();
+    }
+    return strs;
+  }
+  std::vector<std::string> GetStringColumn(std::size_t n) {
+    std::vector<std::string> strs = GetStrings();
+    CheckColumn(strs.size(), n);
+    return strs;
+  }
+  // Reads n lists written by CacheEntryWriter::PutIndexLists, checking that
+  // every index is below tableSize
+  std::vector<std::vector<std::uint32_t>> GetIndexLists(std::size_t n,
+                                                        std::size_t tableSize) {
+    std::vector<std::uint32_t> sizes = GetColumn<std::uint32_t>(n);
+    std::vector<std::uint32_t> indices = GetValues<std::uint32_t>();
+    std::vector<std::vector<std::uint32_t>> lists(n);
+    std::size_t iIndex = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      if (sizes[i] > indices.size() - iIndex) {
+        throw std::length_error("Truncated model cache entry index list");
+      }
+      lists[i].assign(indices.begin() + iIndex,
+                      indices.begin() + iIndex + sizes[i]);
+      iIndex += sizes[i];
+    }
+    CheckColumn(iIndex, indices.size());
+    for (auto index : indices) {
+      if (index >= tableSize) {
+        throw std::length_error("Model cache entry index " +
+                                std::to_string(index) + " out of range");
+      }
+    }
+    return lists;
+  }
+  std::vector<std::uint32_t> GetIndices(std::size_t tableSize) {
+    return GetIndexLists(1, tableSize).front();
+  }
+
+private:
+  void Read(void *p, std::size_t n) {
+    if (n > static_cast<std::size_t>(m_end - m_p)) {
+      throw std::length_error("Truncated model cache entry");
+    }
+    std::memcpy(p, m_p, n);
+    m_p += n;
+  }
+  // Reads a length, which must fit in the rest of the entry (this guards
+  // against allocating for a corrupt length)
+  std::size_t GetLength(std::size_t elementSize) {
+    std::uint64_t n = Get<std::uint64_t>();
+    if (n > static_cast<std::size_t>(m_end - m_p) / elementSize) {
+      throw std::length_error("Truncated model cache entry");
+    }
+    return n;
+  }
+  void CheckColumn(std::size_t size, std::size_t n) {
+    if (size != n) {
+      throw std::length_error("Model cache entry column has " +
+                              std::to_string(size) + " values, " +
+                              std::to_string(n) + " expected");
+    }
+  }
+
+  const char *m_p;
+  const char *m_end;
+};
+
+} // namespace rxdock
+
+#endif //_RBTCACHEENTRY_H_
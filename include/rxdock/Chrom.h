@@ -50,6 +50,9 @@ public:
   virtual void GetStepVector(std::vector<double> &v) const;
   virtual double CompareVector(const std::vector<double> &v, int &i) const;
   virtual void Print(std::ostream &s) const;
+  virtual void GetGradientVector(const AtomGradientMap &gradient,
+                                 std::vector<double> &v,
+                                 std::vector<bool> &bProjected) const;
 
   // Aggregate methods
   // Appends a new chromosome element to the vector
@@ -0,0 +1,69 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Chromosome element for selecting the receptor conformer from an ensemble of
+// saved receptor coordinate sets (numbered 1 thru N)
+#ifndef RBTCHROMCONFORMERELEMENT_H_
+#define RBTCHROMCONFORMERELEMENT_H_
+
+#include "rxdock/ChromElement.h"
+#include "rxdock/Model.h"
+
+namespace rxdock {
+
+class ChromConformerElement : public ChromElement {
+public:
+  // Class type string
+  static const std::string _CT;
+  // Sole constructor
+  // stepSize = probability of jumping to another conformer on a full-size
+  // mutation
+  RBTDLL_EXPORT ChromConformerElement(Model *pModel, double stepSize);
+
+  virtual ~ChromConformerElement();
+  virtual void Reset();
+  virtual void Randomise();
+  // Jumps to a different, randomly chosen conformer with probability
+  // relStepSize * stepSize
+  virtual void Mutate(double relStepSize);
+  virtual void SyncFromModel();
+  virtual void SyncToModel();
+  virtual ChromElement *clone() const;
+  virtual int GetLength() const { return 1; }
+  virtual int GetXOverLength() const { return 1; }
+  virtual void GetVector(std::vector<double> &v) const;
+  virtual void GetVector(XOverList &v) const;
+  virtual void SetVector(const std::vector<double> &v, int &i);
+  virtual void SetVector(const XOverList &v, int &i);
+  virtual void GetStepVector(std::vector<double> &v) const;
+  virtual double CompareVector(const std::vector<double> &v, int &i) const;
+  virtual void Print(std::ostream &s) const;
+
+  // Rounds a genotype value to the nearest valid conformer number
+  int StandardisedValue(double value) const;
+
+protected:
+  // For use by clone()
+  ChromConformerElement(Model *pModel, int nConformers, double stepSize,
+                        int initialValue, int value);
+
+private:
+  Model *m_pModel;
+  int m_nConformers;  // Number of receptor conformers (N)
+  double m_stepSize;  // Jump probability for relStepSize = 1
+  int m_initialValue; // Conformer current at construction
+  int m_value;        // The genotype value (1 thru N)
+};
+
+} // namespace rxdock
+
+#endif /*RBTCHROMCONFORMERELEMENT_H_*/
@@ -55,6 +55,9 @@ public:
   virtual void GetStepVector(std::vector<double> &v) const;
   virtual double CompareVector(const std::vector<double> &v, int &i) const;
   virtual void Print(std::ostream &s) const;
+  virtual void GetGradientVector(const AtomGradientMap &gradient,
+                                 std::vector<double> &v,
+                                 std::vector<bool> &bProjected) const;
 
   // Returns a standardised dihedral angle in the range [-180, +180}
   // This function operates in degrees
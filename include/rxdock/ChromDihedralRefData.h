@@ -55,6 +55,10 @@ public:
   // Sets the phenotype (model coords) for this bond
   // to a given dihedral angle
   void SetModelValue(double dihedralAngle);
+  // Gets the derivative of a score with respect to the dihedral angle
+  // (per degree) from its atomic gradients, i.e. the torque on the rotated
+  // atoms about the bond axis
+  double GetModelGradient(const AtomGradientMap &gradient) const;
   // Gets the initial dihedral angle for this bond
   //(initialised from model coords in ChromDihedralRefData constructor)
   double GetInitialValue() const { return m_initialValue; }
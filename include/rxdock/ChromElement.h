@@ -14,6 +14,7 @@
 #ifndef RBTCHROMELEMENT_H_
 #define RBTCHROMELEMENT_H_
 
+#include "rxdock/Atom.h"
 #include "rxdock/Config.h"
 #include "rxdock/Rand.h"
 
@@ -112,6 +113,16 @@ public:
   //
   // Invalid operation in base class
   virtual void Add(ChromElement *pChromElement);
+  // Projects the gradient of a score with respect to the atomic coordinates
+  // (e.g. from BaseSF::ScoreGradient) onto the double values of the element,
+  // given that the model coords match the element. Appends GetLength() values
+  // to v, and to bProjected whether each value could be projected. Values
+  // that do not act through the atomic coordinates cannot, and their gradient
+  // has to be found numerically.
+  // Base class appends zeros that are not projected
+  virtual void GetGradientVector(const AtomGradientMap &gradient,
+                                 std::vector<double> &v,
+                                 std::vector<bool> &bProjected) const;
   // Prints details of element to stream (null implementation in base class)
   virtual void Print(std::ostream &s) const {}
   //
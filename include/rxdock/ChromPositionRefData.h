@@ -64,6 +64,13 @@ public:
 
   void GetModelValue(Coord &com, Euler &orientation) const;
   void SetModelValue(const Coord &com, const Euler &orientation);
+  // Gets the derivatives of a score with respect to the center of mass and
+  // the Euler angles (heading, attitude, bank) from its atomic gradients,
+  // i.e. the net force on the movable atoms and the components of their
+  // torque about the center of mass along the Euler rotation axes
+  void GetModelGradient(const AtomGradientMap &gradient, const Coord &com,
+                        const Euler &orientation, Vector &comGradient,
+                        Vector &orientationGradient) const;
 
   friend void to_json(json &j, const ChromPositionRefData &chrposrdata);
   friend void from_json(const json &j, ChromPositionRefData &chrposrdata);
@@ -0,0 +1,99 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Input and output file streams that transparently decompress and compress
+// gzip (.gz) and Zstandard (.zst) files, chosen by the file name extension.
+// Other files are read and written as they are. Compressed output can be
+// appended to an existing file, as concatenated gzip members or zstd frames
+// decompress to the concatenated data. Gzip output is compressed in
+// independent blocks concurrently, and zstd output by the zstd worker threads.
+//
+// Errors while decompressing or compressing cannot be thrown through the
+// stream, so reading stops at a corrupt block as if at the end of the file.
+// Callers check for errors with CheckError() once reads or writes fail.
+//
+// Positions (tellg, seekg) in compressed input are offsets in the
+// decompressed data. Seeking forward decompresses up to the position, and
+// seeking backward decompresses again from the start of the file.
+
+#ifndef _RBTCOMPRESSEDFILESTREAM_H_
+#define _RBTCOMPRESSEDFILESTREAM_H_
+
+#include "rxdock/Config.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+
+namespace rxdock {
+
+// True if the file name ends in .gz or .zst
+RBTDLL_EXPORT bool isCompressedFileName(const std::string &fileName);
+
+class InputFileStream : public std::istream {
+public:
+  RBTDLL_EXPORT InputFileStream();
+  RBTDLL_EXPORT InputFileStream(const std::string &fileName);
+  virtual ~InputFileStream();
+
+  // Sets the failbit if the file cannot be opened, and throws FileReadError
+  // if rxdock has been built without support for its compression
+  RBTDLL_EXPORT void Open(const std::string &fileName);
+  RBTDLL_EXPORT void Close();
+  bool isOpen() const { return m_spBuf != nullptr; }
+  // Number of bytes read so far from the file itself, which is less than
+  // the position in the stream for compressed files
+  RBTDLL_EXPORT std::size_t GetFileOffset();
+  // Throws FileReadError if the file could not be read or decompressed
+  RBTDLL_EXPORT void CheckError() const;
+
+private:
+  InputFileStream(const InputFileStream &);
+  InputFileStream &operator=(const InputFileStream &);
+
+  std::unique_ptr<std::streambuf> m_spBuf;
+  std::string m_fileName;
+  bool m_bCompressed;
+};
+
+class OutputFileStream : public std::ostream {
+public:
+  RBTDLL_EXPORT OutputFileStream();
+  RBTDLL_EXPORT OutputFileStream(const std::string &fileName,
+                                 bool bAppend = false);
+  // Closes the file, ignoring errors
+  virtual ~OutputFileStream();
+
+  // Sets the failbit if the file cannot be opened, and throws FileWriteError
+  // if rxdock has been built without support for its compression
+  RBTDLL_EXPORT void Open(const std::string &fileName, bool bAppend = false);
+  // Flushing compressed output, which writers do at the end of each record,
+  // compresses the buffered data once a block of it has been collected. The
+  // compressed data is only complete once the file is closed. Throws
+  // FileWriteError if the remaining data cannot be written
+  RBTDLL_EXPORT void Close();
+  bool isOpen() const { return m_spBuf != nullptr; }
+  // Throws FileWriteError if the data written so far could not be compressed
+  // or written
+  RBTDLL_EXPORT void CheckError() const;
+
+private:
+  OutputFileStream(const OutputFileStream &);
+  OutputFileStream &operator=(const OutputFileStream &);
+
+  std::unique_ptr<std::streambuf> m_spBuf;
+  std::string m_fileName;
+};
+
+} // namespace rxdock
+
+#endif //_RBTCOMPRESSEDFILESTREAM_H_
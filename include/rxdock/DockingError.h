@@ -21,6 +21,7 @@
 namespace rxdock {
 
 const std::string IDS_DOCKING_ERROR = "RBT_DOCKING_ERROR";
+const std::string IDS_DOCKING_ABORT = "RBT_DOCKING_ABORT";
 
 // Unspecified model error
 class DockingError : public Error {
@@ -36,6 +37,14 @@ protected:
       : Error(strName, strFile, nLine, strMessage) {}
 };
 
+// Run abandoned by the workspace abort predicate
+class DockingAbort : public DockingError {
+public:
+  DockingAbort(const std::string &strFile, int nLine,
+               const std::string &strMessage = "")
+      : DockingError(IDS_DOCKING_ABORT, strFile, nLine, strMessage) {}
+};
+
 } // namespace rxdock
 
 #endif //_RBTDOCKINGERROR_H_
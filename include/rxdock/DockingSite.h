@@ -49,6 +49,12 @@ public:
 
   RBTDLL_EXPORT DockingSite(const CavityList &cavList, double border);
   RBTDLL_EXPORT DockingSite(json j);
+  // Constructor reading the binary docking site format written by WriteBinary
+  // from a memory buffer (usually a memory-mapped file). If spOwner is given,
+  // the distance grid uses the buffer in place instead of copying it, and
+  // spOwner keeps the buffer alive for the lifetime of the grid
+  RBTDLL_EXPORT DockingSite(const char *pData, std::size_t nBytes,
+                            std::shared_ptr<const void> spOwner = nullptr);
 
   // Destructor
   virtual ~DockingSite();
@@ -64,6 +70,19 @@ public:
   // Derived classes can override if required
   virtual void Print(std::ostream &s) const;
 
+  // Writes the cavity coords and the precalculated distance grid in the
+  // binary docking site format. Unlike the JSON format this can be loaded
+  // without any parsing (see ReadDockingSite). The size and modification time
+  // of the JSON file strJSONFile, if given, are stored so that
+  // GetDockingSiteFileName can tell whether the binary file is out of date
+  RBTDLL_EXPORT void WriteBinary(std::ostream &ostr,
+                                 const std::string &strJSONFile = "") const;
+  // Returns true if the binary docking site file strBinFile exists and was
+  // written from the current JSON file strJSONFile (or if there is no JSON
+  // file to compare with)
+  RBTDLL_EXPORT static bool isBinaryUpToDate(const std::string &strBinFile,
+                                             const std::string &strJSONFile);
+
   // Public methods
   RBTDLL_EXPORT RealGridPtr GetGrid();
   double GetBorder() const { return m_border; }
@@ -101,6 +120,9 @@ private:
 
   // Private data
 private:
+  static const char _BIN_MAGIC[8];
+  static const unsigned int _BIN_VERSION;
+
   CavityList m_cavityList; // Cavity list
   Coord m_minCoord;
   Coord m_maxCoord;
@@ -116,6 +138,17 @@ std::ostream &operator<<(std::ostream &s, const DockingSite &site);
 RBTDLL_EXPORT void to_json(json &j, const DockingSite &site);
 void from_json(const json &j, DockingSite &site);
 
+// Returns the path to the docking site file for the given workspace name,
+// preferring the binary file (<name>-docking-site.bin) over the JSON file
+// (<name>-docking-site.json), unless the JSON file has changed since the
+// binary file was written
+RBTDLL_EXPORT std::string GetDockingSiteFileName(const std::string &wsName);
+
+// Reads a docking site file in either the binary or the JSON format, selected
+// by file extension. Binary files are memory-mapped where supported, and the
+// distance grid is used from the mapping without copying
+RBTDLL_EXPORT DockingSitePtr ReadDockingSite(const std::string &strFile);
+
 } // namespace rxdock
 
 #endif //_RBTDOCKINGSITE_H_
@@ -53,6 +53,11 @@ public:
   ModelPtr GetReceptor() const;
   ModelPtr GetLigand() const;
   void SetMaxNRuns(int n) { maxnruns = n; }
+  // Number of termination filters (protocol stages)
+  int GetNumTermFilters() const { return nTermFilters; }
+  // Index of the stage the current ligand is in; equal to the number of
+  // termination filters once the ligand has passed them all
+  int GetTermFilterIndex() const { return filteridx; }
 
   ////////////////////
   // Private methods
@@ -45,6 +45,15 @@ public:
   static const std::string _NCONVERGENCE;
   // Output the best pose every _HISTORY_FREQ cycles.
   static const std::string _HISTORY_FREQ;
+  // Number of island populations. The initial population is the first island,
+  // the others are created with the same size. Islands evolve independently
+  // apart from periodic ring migration, and are merged back into the initial
+  // population at the end
+  static const std::string _NISLANDS;
+  // Migrate between islands every _MIGRATION_FREQ cycles
+  static const std::string _MIGRATION_FREQ;
+  // Number of best genomes copied from each island to the next on migration
+  static const std::string _NMIGRANTS;
 
   ////////////////////////////////////////
   // Constructors/destructors
@@ -11,8 +11,10 @@
  ***********************************************************************/
 
 // Genome for roulette wheel selection.
-// Manages a chromosome element, an associated raw score from a scoring function
-// and a scaled fitness value for roulette wheel selection
+// Manages a flat vector of chromosome values, an associated raw score from a
+// scoring function and a scaled fitness value for roulette wheel selection.
+// The chromosome element is only used as a codec to convert the values to and
+// from model coordinates, and may be shared between many genomes.
 #ifndef _RBT_GENOME_H_
 #define _RBT_GENOME_H_
 
@@ -29,12 +31,15 @@ class BaseSF;
 class Genome {
 public:
   static const std::string _CT;
-  // Sole constructor accepting an existing chromosome.
-  // A clone of the existing chromosome is stored,
-  // and is deleted in the Genome destructor
+  // Constructor accepting an existing chromosome.
+  // The genome stores the current chromosome values, and a clone of the
+  // chromosome to use as its codec
   Genome(ChromElement *pChr);
+  // Constructor accepting a shared codec.
+  // The genome stores the current codec values
+  Genome(ChromElementPtr spChr);
   // Copy constructor and Assignment operator.
-  // The underlying chromosome is cloned during the copy.
+  // The values are copied, the codec is shared.
   Genome(const Genome &);
   Genome &operator=(const Genome &);
   Genome *clone() const;
@@ -43,8 +48,21 @@ public:
   friend void to_json(json &j, const Genome &genome);
   friend void from_json(const json &j, Genome &genome);
 
-  // Gets the underlying chromosome
-  ChromElement *GetChrom() const { return m_chrom; }
+  // Sets the codec to the values of this genome and returns it.
+  // The codec is borrowed, not owned: it may be shared with other genomes, and
+  // the next GetChrom (or Equals) call on any of them overwrites its values.
+  // Changes made via the chromosome are not stored in the genome until
+  // SyncFromChrom is called
+  RBTDLL_EXPORT ChromElement *GetChrom();
+  // Gets the chromosome values
+  const std::vector<double> &GetVector() const { return m_vector; }
+  // Stores the current values of the codec in the genome
+  void SyncFromChrom();
+  // Copies the chromosome values and scores of g, keeping this genome's codec
+  void SetValues(const Genome &g);
+  // Exchanges the chromosome values in the index range [begin, end) with
+  // those of g
+  void SwapValues(Genome &g, int begin, int end);
 
   // Sets the raw score from the scoring function.
   // Model coordinates are updated to reflect the current chromosome element
@@ -52,6 +70,9 @@ public:
   // is a pointer to a scoring function object. If pSF is null, a zero score is
   // set.
   void SetScore(BaseSF *pSF);
+  // Sets the raw score to a value already calculated by the scoring function
+  // (e.g. by a batched evaluation), negated as above
+  void SetScore(double score);
   // Gets the stored raw score (without re-evaluation of the scoring function).
   double GetScore() const { return m_score; }
 
@@ -74,11 +95,10 @@ public:
   double GetRWFitness() const { return m_RWFitness; }
 
   // Tests equality based on chromosome element values.
-  // Does not take score into account.
-  bool Equals(const Genome &g, double threshold) const {
-    return m_chrom->Equals(*(g.m_chrom), threshold);
-  }
-  friend bool operator==(const Genome &g1, const Genome &g2) {
+  // Does not take score into account. Sets the codec to the values of this
+  // genome, as GetChrom does.
+  bool Equals(const Genome &g, double threshold);
+  friend bool operator==(Genome &g1, const Genome &g2) {
     return g1.Equals(g2, ChromElement::_THRESHOLD);
   }
 
@@ -92,7 +112,8 @@ private:
   /////////////////////
   // Private data
   /////////////////////
-  ChromElement *m_chrom;
+  ChromElementPtr m_chrom;      // codec (possibly shared)
+  std::vector<double> m_vector; // chromosome values
   double m_score;     // raw value of the scoring function
   double m_RWFitness; // scaled value of the raw score suitable for use
                       // with roulette wheel selection
@@ -126,7 +147,7 @@ private:
   double m_threshold; // equality threshold
 public:
   explicit isGenome_eq(double threshold) : m_threshold(threshold) {}
-  bool operator()(const Genome *pG1, const Genome *pG2) const {
+  bool operator()(Genome *pG1, const Genome *pG2) const {
     return pG1->Equals(*pG2, m_threshold);
   }
 };
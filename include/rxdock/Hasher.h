@@ -0,0 +1,55 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Incremental hash of the inputs that cache keys and shared memory segment
+// names depend on. GetKey returns a short 64-bit FNV-1a hash, for names whose
+// users check what they attach to. GetDigest returns the SHA-256 digest, for
+// cache entries that are found and trusted by their key alone.
+
+#ifndef _RBTHASHER_H_
+#define _RBTHASHER_H_
+
+#include "rxdock/Config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rxdock {
+
+class Hasher {
+public:
+  RBTDLL_EXPORT Hasher();
+  // Adds the string, followed by a separator so that ("ab", "c") and
+  // ("a", "bc") hash differently
+  RBTDLL_EXPORT void Add(const std::string &str);
+  // Adds the contents of the file. Returns false (and adds a marker instead)
+  // if the file cannot be read
+  RBTDLL_EXPORT bool AddFile(const std::string &strFile);
+  // 64-bit FNV-1a hash as 16 hex digits
+  RBTDLL_EXPORT std::string GetKey() const;
+  // SHA-256 digest as 64 hex digits
+  RBTDLL_EXPORT std::string GetDigest() const;
+
+private:
+  void AddBytes(const unsigned char *pData, std::size_t nBytes);
+  // SHA-256 compression of one 64-byte block into m_state
+  void ProcessBlock(const unsigned char *pBlock);
+
+  std::uint64_t m_hash;
+  std::uint32_t m_state[8];  // SHA-256 state
+  unsigned char m_block[64]; // Pending SHA-256 input
+  std::uint64_t m_nBytes;    // SHA-256 input length
+};
+
+} // namespace rxdock
+
+#endif //_RBTHASHER_H_
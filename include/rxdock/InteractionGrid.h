@@ -169,6 +169,10 @@ public:
   // Set attribute functions
   /////////////////////////
   void SetInteractionLists(InteractionCenter *pIntn, double radius);
+  // Replaces the interaction center list at grid point iXYZ (e.g. with one
+  // read from a cache)
+  void SetInteractionList(unsigned int iXYZ,
+                          const InteractionCenterList &intnList);
   void ClearInteractionLists();
   void UniqueInteractionLists();
 
@@ -0,0 +1,104 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Limited-memory BFGS minimiser over the chromosome degrees of freedom.
+// Atomic gradients are taken from the scoring function terms that provide
+// them analytically and projected onto the chromosome by the chain rule (see
+// ChromElement::GetGradientVector): the net force for translations, the
+// torque for orientations and the torque about the bond axis for dihedrals.
+// Each dihedral is projected with the rest of the model held fixed, so the
+// re-alignment of the principal axes by the position element is neglected.
+// Terms without analytic gradients, and chromosome values that do not move
+// atoms (e.g. occupancies), are differentiated numerically.
+#ifndef _RBTLBFGSTRANSFORM_H_
+#define _RBTLBFGSTRANSFORM_H_
+
+#ifdef __PGI
+#define EIGEN_DONT_VECTORIZE
+#endif
+#include <Eigen/Core>
+
+#include "rxdock/BaseBiMolTransform.h"
+#include "rxdock/BaseSF.h"
+#include "rxdock/ChromElement.h"
+
+namespace rxdock {
+
+class LBFGSTransform : public BaseBiMolTransform {
+public:
+  // Static data member for class type
+  static const std::string _CT;
+  // Parameter names
+  static const std::string _MAX_ITER;
+  static const std::string _HISTORY;
+  static const std::string _PARTITION_DIST;
+  // Maximum step length per iteration, in units of the chromosome step sizes
+  static const std::string _MAX_STEP;
+  // Finite difference step used for the numerical gradients, in units of the
+  // chromosome step sizes
+  static const std::string _GRADIENT_STEP;
+  // Stop once score improves by less than convergence value
+  // between iterations
+  static const std::string _CONVERGENCE;
+
+  ////////////////////////////////////////
+  // Constructors/destructors
+  RBTDLL_EXPORT LBFGSTransform(const std::string &strName = "LBFGS");
+  virtual ~LBFGSTransform();
+
+protected:
+  ////////////////////////////////////////
+  // Protected methods
+  ///////////////////
+  virtual void
+  SetupTransform(); // Called by Update when either model has changed
+  virtual void SetupReceptor(); // Called by Update when receptor is changed
+  virtual void SetupLigand();   // Called by Update when ligand is changed
+  virtual void SetupSolvent();  // Called by Update when solvent is changed
+  virtual void Execute();
+
+private:
+  ////////////////////////////////////////
+  // Private methods
+  /////////////////
+  LBFGSTransform(const LBFGSTransform &); // Copy constructor disabled by
+                                          // default
+  LBFGSTransform &
+  operator=(const LBFGSTransform &); // Copy assignment disabled by default
+
+  // Sets the chromosome and model to the scaled vector x
+  void SyncToModel(const Eigen::VectorXd &x);
+  // Returns the score at x
+  double Score(BaseSF *pSF, const Eigen::VectorXd &x);
+  // Returns the score at x, and its gradient with respect to x in g
+  double ScoreGradient(BaseSF *pSF, const Eigen::VectorXd &x,
+                       Eigen::VectorXd &g);
+
+  ////////////////////////////////////////
+  // Private data
+  //////////////
+  ChromElementPtr m_chrom;
+  std::vector<double> m_steps; // Chromosome step sizes, used as scale factors
+  std::vector<double> m_vc;    // Workspace for the chromosome vector
+  std::vector<double> m_gc;    // Workspace for the chromosome gradient
+  std::vector<bool> m_bProjected; // Chromosome values with analytic gradients
+  BaseSFList m_noGradList; // Terms without analytic gradients in last call
+  int m_nScoreCalls;
+  int m_nGradientCalls;
+};
+
+// Useful typedefs
+typedef SmartPtr<LBFGSTransform> LBFGSTransformPtr; // Smart pointer
+
+} // namespace rxdock
+
+#endif //_RBTLBFGSTRANSFORM_H_
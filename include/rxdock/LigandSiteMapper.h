@@ -35,9 +35,12 @@ public:
   LigandSiteMapper(const std::string &strName = "LIGAND_MAPPER");
   virtual ~LigandSiteMapper();
 
+  using SiteMapper::operator();
+
   // Override SiteMapper pure virtual
   // This is the function which actually does the mapping
-  virtual CavityList operator()();
+  virtual CavityList operator()(const CoordList &coordList,
+                                const std::vector<double> &radiusList);
 };
 
 // Useful typedefs
@@ -38,6 +38,18 @@ public:
   // Default destructor
   virtual ~MdlFileSource();
 
+  // Restricts reading to records [start, end) of the file, counting from
+  // zero, or to the records with the given titles (in the order of the
+  // titles). Records are located with the index of the file (see SDIndex),
+  // which is built and saved on first use
+  RBTDLL_EXPORT void SelectRecords(std::size_t start, std::size_t end);
+  RBTDLL_EXPORT void SelectRecords(const std::vector<std::string> &titles);
+
+  // Returns the key of the prepared model of the current record in a
+  // ModelCache. The key covers the record text, the ionisation, hydrogen and
+  // segment filter options, and is computed without parsing the record
+  RBTDLL_EXPORT std::string GetRecordCacheKey();
+
   friend void to_json(json &j, const MdlFileSource &mdlFileSrc);
   friend void from_json(const json &j, MdlFileSource &mdlFileSrc);
 
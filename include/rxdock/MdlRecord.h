@@ -0,0 +1,86 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Structure-data (SD) record read as text, without building a Model. The
+// record is split into its title, its connection table block (kept as raw
+// text) and its data fields, which is all that is needed to filter, sort,
+// rename and tabulate records. Unless renamed, a record is written back
+// exactly as it was read.
+
+#ifndef _RBTMDLRECORD_H_
+#define _RBTMDLRECORD_H_
+
+#include "rxdock/Coord.h"
+#include "rxdock/Variant.h"
+
+#include <istream>
+#include <ostream>
+
+namespace rxdock {
+
+class MdlRecord {
+public:
+  static const std::string _CT;
+
+  RBTDLL_EXPORT MdlRecord();
+  virtual ~MdlRecord();
+
+  // Reads the next record (up to and including its $$$$ line) from istr.
+  // Returns false at the end of the input
+  RBTDLL_EXPORT bool Read(std::istream &istr);
+  // Parses the text of a single record
+  RBTDLL_EXPORT void Parse(const std::string &text);
+  // Writes the record text to ostr
+  RBTDLL_EXPORT void Write(std::ostream &ostr) const;
+
+  // Record text, including the $$$$ line
+  const std::string &GetText() const { return m_text; }
+  const std::string &GetTitle() const { return m_title; }
+  // Replaces the first title line
+  RBTDLL_EXPORT void SetTitle(const std::string &title);
+
+  // Data fields, with the same conventions as MdlFileSource: a field holds
+  // one string per line, later fields replace earlier ones with the same
+  // name, and Name defaults to the title
+  RBTDLL_EXPORT Variant GetDataValue(const std::string &fieldName) const;
+  RBTDLL_EXPORT StringVariantMap GetDataMap() const;
+
+  // Atoms of the connection table, as written in the file. The formal
+  // charge is converted from the MDL charge code
+  std::size_t GetNumAtoms() const { return m_nAtoms; }
+  RBTDLL_EXPORT void GetAtom(std::size_t iAtom, std::string &strElementName,
+                             Coord &coord, int &nFormalCharge) const;
+  // Bonds of the connection table, as 0-based atom indices
+  std::size_t GetNumBonds() const { return m_bondLines.size(); }
+  RBTDLL_EXPORT void GetBond(std::size_t iBond, std::size_t &iAtom1,
+                             std::size_t &iAtom2) const;
+
+private:
+  MdlRecord(const MdlRecord &);
+  MdlRecord &operator=(const MdlRecord &);
+
+  // Splits m_text into its title, atom lines and data fields
+  void ParseText();
+
+  std::string m_text;
+  std::string m_title;
+  std::size_t m_nAtoms;
+  // Offsets of the start of each atom and bond line in m_text
+  std::vector<std::size_t> m_atomLines;
+  std::vector<std::size_t> m_bondLines;
+  std::vector<std::pair<std::string, std::vector<std::string>>> m_dataFields;
+};
+
+} // namespace rxdock
+
+#endif //_RBTMDLRECORD_H_
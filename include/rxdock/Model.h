@@ -58,6 +58,8 @@ public:
   // DM 30 Jul 2001 - allow access to atom list by helper class for flexible
   // models
   friend class ModelMutator;
+  // Needs to restore the full model state from a prepared model cache entry
+  friend class ModelCache;
 
   //////////////////////
   // Public accessor functions
@@ -117,7 +119,7 @@ public:
   // DM 11 Jul 2000 - pseudoatom handling
   PseudoAtomPtr AddPseudoAtom(const AtomList &atomList);
   void ClearPseudoAtoms();
-  void UpdatePseudoAtoms(); // Updates pseudoatom coords
+  RBTDLL_EXPORT void UpdatePseudoAtoms(); // Updates pseudoatom coords
   unsigned int GetNumPseudoAtoms() const;
   PseudoAtomList GetPseudoAtomList() const;
 
@@ -173,9 +175,17 @@ public:
   int GetNumSavedCoords() const { return m_coordNames.size(); }
   int GetCurrentCoords() const { return m_currentCoord; }
   RBTDLL_EXPORT void RevertCoords(int);
+  // Receptor ensembles: makes saved coord set i current. Unlike RevertCoords,
+  // the coords are copied from contiguous per-conformer arrays (built on first
+  // use), and only the atoms that differ between saved coord sets are updated
+  RBTDLL_EXPORT void SetCurrentConformer(int i);
+  // Receptor ensembles: true if the conformer is sampled during docking (the
+  // model has flexibility data), in which case the scoring functions index
+  // each conformer on its own rather than the union of all conformers
+  RBTDLL_EXPORT bool isConformerSampled() const;
 
   // Returns center of mass of model
-  Coord GetCenterOfMass() const;
+  RBTDLL_EXPORT Coord GetCenterOfMass() const;
   // Translates the model so that the center of mass is at the given coord
   void SetCenterOfMass(const Coord &c) { Translate(c - GetCenterOfMass()); }
 
@@ -329,6 +339,7 @@ private:
   void Create(BaseMolecularFileSource *pMolSource);
   void Clear();                      // Clear the current model
   void AddAtoms(AtomList &atomList); // Register an atom list with the model
+  void CreateConformerArrays();      // Helper for SetCurrentConformer
 
   //////////////////////
   // Private data
@@ -344,6 +355,10 @@ private:
       m_coordNames;           //(DM 8 Feb 1999) map of named coord sets
                               //(key=name, value=index into Atom coord map)
   int m_currentCoord;         // DM 11 Jul 2003 - which coord set is current
+  AtomRList m_conformerAtoms; // Atoms whose coords differ between coord sets
+  std::vector<CoordList>
+      m_conformerCoords; // Coords of m_conformerAtoms for each coord set
+                         // (empty if the set is not saved for all atoms)
   StringVariantMap m_dataMap; // DM 12 May 1999 - associated data (e.g. from
                               // SD file or generated by rbdock)
   PseudoAtomList
@@ -0,0 +1,92 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Persistent on-disk cache of fully prepared models (parsed, ring-perceived,
+// typed, with saved coordinate sets). Entries are stored in a binary columnar
+// layout in a cache directory, one file per key. The key is a SHA-256 digest,
+// supplied by the caller, of everything that went into preparing the model.
+// Entries are spread over subdirectories named after the first two digits of
+// their key, so that no directory holds more than a small share of a large
+// ligand library.
+//
+// The flexibility data of a model is not cached, as it depends on the docking
+// site. The indexed scoring functions store their receptor setup (index grids
+// and interaction lists) in entries of their own type, keyed by the receptor,
+// the docking site and the scoring function parameters, with the receptor
+// atoms referred to by index (see BaseIdxSF::LoadReceptorSetup).
+//
+// Entry layout (native byte order, so a cache directory is not portable
+// between platforms): the magic string "RXDOCKMC", the int32 format version,
+// the key, and the model or other contents (see CacheEntry.h). Strings and
+// arrays are preceded by their uint64 length. The model holds its name and
+// titles, then one array per atom attribute, the saved coordinate sets, one
+// array per bond attribute, the rings as arrays of atom indices, the
+// coordinate set names and the data fields.
+
+#ifndef _RBTMODELCACHE_H_
+#define _RBTMODELCACHE_H_
+
+#include "rxdock/Model.h"
+
+namespace rxdock {
+
+class ModelCache {
+public:
+  static const std::string _CT;
+  static const std::string _MAGIC;
+  // Cache format version, bump whenever the entry layout changes
+  static const int _VERSION;
+  // Entry type (file extension) of models
+  static const std::string _MODEL_ENTRY;
+
+  RBTDLL_EXPORT ModelCache(const std::string &strCacheDir);
+
+  std::string GetCacheDir() const { return m_strCacheDir; }
+
+  // Returns the cached model stored under strKey, or a null ModelPtr if there
+  // is no (readable) entry for the key
+  RBTDLL_EXPORT ModelPtr Load(const std::string &strKey) const;
+  // Stores the model under strKey. The entry is written to a temporary file
+  // and renamed so concurrent readers never see a partial entry
+  RBTDLL_EXPORT void Save(const std::string &strKey, const Model &model) const;
+
+  // Reads the contents of the entry of type strType stored under strKey into
+  // buf. Returns false if there is no (readable) entry for the key
+  RBTDLL_EXPORT bool LoadEntry(const std::string &strKey,
+                               const std::string &strType,
+                               std::string &buf) const;
+  // Stores buf as the entry of type strType under strKey, as Save does.
+  // Returns false if another process stored it first
+  RBTDLL_EXPORT bool SaveEntry(const std::string &strKey,
+                               const std::string &strType,
+                               const std::string &buf) const;
+
+  // Model <-> entry buffer conversion preserving the full topology (bonds and
+  // rings refer to atoms by index). ReadModel throws std::length_error if the
+  // buffer is truncated or inconsistent
+  RBTDLL_EXPORT static std::string WriteModel(const Model &model);
+  RBTDLL_EXPORT static ModelPtr ReadModel(const std::string &buf);
+
+  // Path of the entry file for strKey (<cache dir>/<shard>/<key>.<type>)
+  RBTDLL_EXPORT std::string
+  GetEntryFileName(const std::string &strKey,
+                   const std::string &strType = _MODEL_ENTRY) const;
+  // Subdirectory holding the entry for strKey
+  RBTDLL_EXPORT std::string GetShardDir(const std::string &strKey) const;
+
+private:
+  std::string m_strCacheDir;
+};
+
+} // namespace rxdock
+
+#endif //_RBTMODELCACHE_H_
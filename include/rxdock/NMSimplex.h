@@ -48,6 +48,13 @@ private:
   State<DataType, ParameterType> m_state;
   Criterion m_criterion;
 
+  // Work vectors, reused between iterations and between calls to Optimize so
+  // that once sized the search does not allocate
+  ParameterType m_sum;             // Sum of the polytope vertices
+  ParameterType m_newParameters;   // Reflected vertex
+  ParameterType m_trialParameters; // Expanded or contracted vertex
+  ParameterType m_bestParameters;  // Best vertex, for contraction around it
+
   void InitializePolytope(const ParameterType &start_point, DataType delta,
                           Function &fun) // const
   {
@@ -65,7 +72,7 @@ private:
   }
 
   void InitializePolytope(const ParameterType &start_point,
-                          ParameterType deltas, Function &fun) // const
+                          const ParameterType &deltas, Function &fun) // const
   {
     m_polytopePoints.resize(start_point.size(), start_point.size() + 1);
     m_polytopeValues.resize(1, start_point.size() + 1);
@@ -80,7 +87,9 @@ private:
     }
   }
 
-  void Display(Function &fun, const ParameterType &parameters) // const
+  template <class Derived>
+  void Display(Function &fun,
+               const Eigen::DenseBase<Derived> &parameters) // const
   {
     LOG_F(1, "Point: {}", parameters);
     LOG_F(1, "Value: {}", fun(parameters));
@@ -116,12 +125,14 @@ private:
           m_polytopeValues(0, best), m_polytopePoints.col(best));
   }
 
-  ParameterType CreateNewParameters(const ParameterType &sum,
-                                    const ParameterType &discarded_point,
-                                    DataType t) {
-    DataType fac1 = (1 - t) / sum.size();
+  // Sets parameters to a point on the line through the discarded vertex and
+  // the centroid of the remaining vertices (m_sum must hold the vertex sum)
+  void CreateNewParameters(int discarded, DataType t,
+                           ParameterType &parameters) {
+    DataType fac1 = (1 - t) / m_sum.size();
     DataType fac2 = fac1 - t;
-    return sum * fac1 - discarded_point * fac2;
+    parameters =
+        m_sum * fac1 - m_polytopePoints.col(discarded).matrix() * fac2;
   }
 
 public:
@@ -155,56 +166,54 @@ public:
         m_state.bestParameters = m_state.currentParameters;
       }
 
-      ParameterType new_parameters = CreateNewParameters(
-          m_polytopePoints.rowwise().sum(), m_polytopePoints.col(worst), -1);
-      DataType new_value = fun(new_parameters);
+      m_sum = m_polytopePoints.rowwise().sum();
+      CreateNewParameters(worst, -1, m_newParameters);
+      DataType new_value = fun(m_newParameters);
       LOG_F(1, "Trying normal");
-      Display(fun, new_parameters);
+      Display(fun, m_newParameters);
       if (new_value < m_state.bestValue) {
-        ParameterType expansion_parameters = CreateNewParameters(
-            m_polytopePoints.rowwise().sum(), m_polytopePoints.col(worst), -2);
-        DataType expansion_value = fun(expansion_parameters);
+        CreateNewParameters(worst, -2, m_trialParameters);
+        DataType expansion_value = fun(m_trialParameters);
         LOG_F(1, "Trying expansion");
-        Display(fun, expansion_parameters);
+        Display(fun, m_trialParameters);
         if (expansion_value < m_state.bestValue) {
           m_state.currentValue = m_polytopeValues(0, worst) = expansion_value;
           m_state.currentParameters = m_polytopePoints.col(worst) =
-              expansion_parameters;
+              m_trialParameters;
         } else {
           m_state.currentValue = m_polytopeValues(0, worst) = new_value;
           m_state.currentParameters = m_polytopePoints.col(worst) =
-              new_parameters;
+              m_newParameters;
         }
       } else if (new_value > m_polytopeValues(0, near_worst)) {
         // New point is not better than near worst
-        ParameterType contraction_parameters = CreateNewParameters(
-            m_polytopePoints.rowwise().sum(), m_polytopePoints.col(worst), -.5);
-        DataType contraction_value = fun(contraction_parameters);
+        CreateNewParameters(worst, -.5, m_trialParameters);
+        DataType contraction_value = fun(m_trialParameters);
         LOG_F(1, "Trying contraction");
-        Display(fun, contraction_parameters);
+        Display(fun, m_trialParameters);
         if (contraction_value > new_value) {
           LOG_F(1, "Contraction around lowest");
-          Display(fun, contraction_parameters);
-          ParameterType best_parameters = m_polytopePoints.col(best);
+          Display(fun, m_trialParameters);
+          m_bestParameters = m_polytopePoints.col(best);
           LOG_F(1, "Difference from the best {}",
-                ((m_polytopePoints.colwise() - best_parameters.array()) / 2));
+                ((m_polytopePoints.colwise() - m_bestParameters.array()) / 2));
           m_polytopePoints =
-              ((m_polytopePoints.colwise() - best_parameters.array()) / 2)
+              ((m_polytopePoints.colwise() - m_bestParameters.array()) / 2)
                   .colwise() +
-              best_parameters.array();
+              m_bestParameters.array();
           for (int i = 0; i < m_polytopePoints.cols(); ++i) {
             m_polytopeValues(0, i) = fun(m_polytopePoints.col(i));
           }
         } else {
           m_state.currentValue = m_polytopeValues(0, worst) = contraction_value;
           m_state.currentParameters = m_polytopePoints.col(worst) =
-              contraction_parameters;
+              m_trialParameters;
         }
       } else {
         // New point, not the best, but better than the near worst
         m_state.currentValue = m_polytopeValues(0, worst) = new_value;
         m_state.currentParameters = m_polytopePoints.col(worst) =
-            new_parameters;
+            m_newParameters;
       }
 
       ++m_state.iteration;
@@ -232,7 +241,7 @@ public:
     use_deltas = false;
   }
 
-  void SetDelta(ParameterType deltas) {
+  void SetDelta(const ParameterType &deltas) {
     this->m_deltas = deltas;
     use_deltas = true;
   }
@@ -86,6 +86,9 @@ public:
   // Set attribute functions
   /////////////////////////
   void SetAtomLists(Atom *pAtom, double radius);
+  // Replaces the atom list at grid point iXYZ (e.g. with one read from a
+  // cache)
+  void SetAtomList(unsigned int iXYZ, const AtomRList &atomList);
   void ClearAtomLists();
   void UniqueAtomLists();
 
@@ -41,6 +41,8 @@ public:
   const HHS_SolvationRList &GetHHSList(const Coord &c) const;
 
   void SetHHSLists(HHS_Solvation *pHHS, double radius);
+  // Replaces the list at grid point iXYZ (e.g. with one read from a cache)
+  void SetHHSList(unsigned int iXYZ, const HHS_SolvationRList &hhsList);
   void ClearHHSLists(void);
 
 protected:
@@ -24,6 +24,7 @@ namespace rxdock {
 
 class ParameterFileSource;
 class DockingSite;
+class ModelCache;
 
 class PRMFactory {
 public:
@@ -36,6 +37,8 @@ public:
   static const std::string &_REC_NUM_COORD_FILES;
   static const std::string &_REC_FLEX_DISTANCE;
   static const std::string &_REC_DIHEDRAL_STEP;
+  static const std::string &_REC_SAMPLE_CONFORMERS;
+  static const std::string &_REC_CONFORMER_STEP;
   static const std::string &_REC_ALL_H;
   static const std::string &_REC_MASSES_FILE;
   static const std::string &_REC_SEGMENT_NAME;
@@ -60,18 +63,36 @@ public:
   DockingSite *GetDockingSite() const { return m_pDS; }
   void SetDockingSite(DockingSite *pDS) { m_pDS = pDS; }
 
+  // Optional persistent cache of prepared receptors. If set, CreateReceptor
+  // loads the receptor from the cache when the receptor definition is
+  // unchanged, and stores it otherwise. Only the prepared model is cached:
+  // flexibility data is always attached after loading, and the scoring
+  // function index grids are still built when the receptor is set up.
+  ModelCache *GetModelCache() const { return m_pCache; }
+  void SetModelCache(ModelCache *pCache) { m_pCache = pCache; }
+  // Cache key covering the receptor section parameters and the contents of
+  // all the files they refer to
+  RBTDLL_EXPORT std::string GetReceptorCacheKey();
+
   RBTDLL_EXPORT ModelPtr CreateReceptor();
   RBTDLL_EXPORT ModelPtr CreateLigand(BaseMolecularFileSource *pSource);
   RBTDLL_EXPORT ModelList CreateSolvent();
+  // Defines the flexibility of a ligand for this factory's docking site, so
+  // that a ligand created by another factory (e.g. for another receptor) can
+  // be docked here without being created again
+  RBTDLL_EXPORT void AttachLigandFlexData(Model *pLigand);
 
 private:
+  // Reads and prepares the receptor model from the files in the receptor
+  // section
+  ModelPtr ReadReceptor();
   // Creates the appropriate source according to the file extension
   MolecularFileSourcePtr CreateMolFileSource(const std::string &fileName);
   void AttachReceptorFlexData(Model *pReceptor);
-  void AttachLigandFlexData(Model *pLigand);
   void AttachSolventFlexData(Model *pSolvent);
   ParameterFileSource *m_pParamSource;
   DockingSite *m_pDS;
+  ModelCache *m_pCache;
 };
 
 } // namespace rxdock
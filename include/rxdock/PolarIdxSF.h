@@ -44,10 +44,14 @@ public:
 
 protected:
   virtual void SetupReceptor();
+  virtual void WriteReceptorSetup(CacheEntryWriter &writer) const;
+  virtual void ReadReceptorSetup(CacheEntryReader &reader);
   virtual void SetupLigand();
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  virtual bool RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const;
 
   // Clear the receptor and ligand grids and lists respectively
   // As we are not using smart pointers, there is some memory management to do
@@ -70,8 +74,18 @@ private:
 
   double InterScore(const InteractionCenterList &posList,
                     const InteractionCenterList &negList, bool bCount) const;
+  double InterScoreGradient(const InteractionCenterList &posList,
+                            const InteractionCenterList &negList,
+                            AtomGradientMap &gradient, double scale) const;
+  // Returns the index of the current sampled receptor conformer in the
+  // per-conformer grid lists, or -1 to use the union grids
+  int GetConformerGridIndex() const;
+
   InteractionGridPtr m_spPosGrid;
   InteractionGridPtr m_spNegGrid;
+  // Indexing grids for each sampled receptor conformer (indexed from 0)
+  std::vector<InteractionGridPtr> m_conformerPosGrids;
+  std::vector<InteractionGridPtr> m_conformerNegGrids;
   InteractionCenterList m_recepPosList;
   InteractionCenterList m_recepNegList;
   InteractionCenterList m_flexRecPosList;
@@ -100,6 +100,18 @@ protected:
                     const InteractionCenterList &intnList, const f1prms &Rprms,
                     const f1prms &A1prms, const f1prms &A2prms) const;
 
+  // As IntraScore and PolarScore, also adding the gradient of scale times the
+  // score with respect to the atom coords to gradient
+  double IntraScoreGradient(const InteractionCenterList &posList,
+                            const InteractionCenterList &negList,
+                            const InteractionListMap &prtIntns, bool attr,
+                            AtomGradientMap &gradient, double scale) const;
+  double PolarScoreGradient(const InteractionCenter *intn,
+                            const InteractionCenterList &intnList,
+                            const f1prms &Rprms, const f1prms &A1prms,
+                            const f1prms &A2prms, AtomGradientMap &gradient,
+                            double scale) const;
+
   // As this has a virtual base class we need a separate OwnParameterUpdated
   // which can be called by concrete subclass ParameterUpdated methods
   // See Stroustrup C++ 3rd edition, p395, on programming virtual base classes
@@ -112,6 +124,13 @@ private:
            : (DR > prms.DRMin) ? 1.0 - prms.slope * (DR - prms.DRMin)
                                : 1.0;
   }
+  // Derivative of f1 with respect to DR
+  inline double df1(double DR, const f1prms &prms) const {
+    return ((DR > prms.DRMax) || (DR <= prms.DRMin)) ? 0.0 : -prms.slope;
+  }
+  double AngularFactor(const InteractionCenter *pIC, bool bAngle,
+                       const Coord &cPartner, const f1prms &Aprms,
+                       Vector gIC[3], Vector &gPartner) const;
 
   void UpdateLPprms();
 
@@ -12,11 +12,16 @@
 
 // Manages a population of genomes.
 // Main public method (GAstep) performs one iteration of a GA.
+// Genomes are flat vectors of chromosome values sharing a single chromosome
+// codec, and are recycled between the population and a pool of spare genomes,
+// so that once the pool is large enough a GA iteration performs no heap
+// allocations in the population bookkeeping.
 #ifndef _RBTPOPULATION_H_
 #define _RBTPOPULATION_H_
 
 #include "rxdock/Error.h"
 #include "rxdock/Genome.h"
+#include "rxdock/PoseBatch.h"
 
 #include <nlohmann/json.hpp>
 
@@ -80,6 +85,11 @@ public:
          bool cmutate   // true=cauchy mutations, false=regular mutations
   );
   RBTDLL_EXPORT GenomePtr RouletteWheelSelect() const;
+  // Merges copies of the migrant genomes (e.g. the best genomes of another
+  // island population) into the population. Migrants keep their scores, so
+  // must have been scored with the same scoring function
+  RBTDLL_EXPORT void Immigrate(const GenomeList &migrants,
+                               double equalityThreshold);
 
   void Print(std::ostream &) const;
   friend std::ostream &operator<<(std::ostream &, const Population &);
@@ -90,13 +100,34 @@ private:
   // not scores)
   void MergeNewPop(GenomeList &newPop, double equalityThreshold);
   void EvaluateRWFitness();
+  // Scores the genomes with a single batched call to the scoring function
+  void ScoreGenomes(GenomeList &genomes);
+  // Makes sure there are at least nGenomes spare genomes available for
+  // children
+  void ReserveGenomes(unsigned int nGenomes);
+  // Takes a spare genome and sets it to a copy of the values of parent
+  GenomePtr NewChild(const Genome &parent);
+  // Applies a regular or Cauchy mutation to a genome
+  void Mutate(Genome &genome, double relStepSize, bool cauchy);
+  // 2-point crossover of the values of parent1 and parent2 into child1 and
+  // child2, preserving crossover elements (e.g. all 3 orientation angles)
+  void Crossover(const Genome &parent1, const Genome &parent2, Genome &child1,
+                 Genome &child2);
   Population(const Population &);            // Disable
   Population &operator=(const Population &); // Disable
 
   GenomeList m_pop;       // The population of genomes
+  GenomeList m_newPop;    // Children created in the current iteration
+  GenomeList m_mergedPop; // Workspace for merging m_pop and m_newPop
+  GenomeList m_spare;     // Genomes available for reuse as children
+  ChromElementPtr m_chrom;       // Chromosome codec shared by all genomes
+  std::vector<int> m_xoverIndex; // Start of each crossover element in the
+                                 // chromosome vector, plus the vector length
   unsigned int m_size;    // The maximum size of the population
   double m_c;             // Sigma Truncation Multiplier
   BaseSF *m_pSF;          // The scoring function
+  PoseBatchPtr m_spPoses; // Poses of the movable models, for batched scoring
+  std::vector<double> m_scores; // Workspace for batched scores
   Rand &m_rand;           // reference to the singleton random number generator
   double m_scoreMean;     // the average raw score across all genomes
   double m_scoreVariance; // the variance of raw scores across all genomes
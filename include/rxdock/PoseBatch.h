@@ -0,0 +1,98 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Coordinates of a batch of poses of one or more models, for scoring many
+// poses in a single call (see BaseSF::ScoreBatch). The coordinates are held in
+// structure of arrays layout, atom-major, so that the x, y and z coordinates
+// of a given atom over all poses are contiguous. This lets scoring function
+// terms look up per-atom data (types, grids, interaction lists) once and then
+// loop over the poses.
+// Solvent occupancies and receptor ensemble conformers are stored alongside,
+// so that a pose is fully described by the batch. Atoms of models not in the
+// batch keep their current coordinates in all poses.
+
+#ifndef _RBTPOSEBATCH_H_
+#define _RBTPOSEBATCH_H_
+
+#include "rxdock/Model.h"
+
+#include <unordered_map>
+
+namespace rxdock {
+
+class PoseBatch {
+public:
+  static const std::string _CT;
+
+  // Batch of nPoses poses of the models in modelList (initially all equal to
+  // the current pose)
+  RBTDLL_EXPORT PoseBatch(const ModelList &modelList, std::size_t nPoses = 0);
+  virtual ~PoseBatch();
+
+  std::size_t GetNumPoses() const { return m_nPoses; }
+  std::size_t GetNumAtoms() const { return m_atomList.size(); }
+  const ModelList &GetModelList() const { return m_modelList; }
+  const AtomList &GetAtomList() const { return m_atomList; }
+  // Index of the atom in the batch, or GetNumAtoms() if it is not included
+  std::size_t GetAtomIndex(const Atom *pAtom) const {
+    auto iter = m_atomIndex.find(pAtom);
+    return (iter != m_atomIndex.end()) ? iter->second : m_atomList.size();
+  }
+  // Coordinates of atom iAtom over all poses
+  const double *GetX(std::size_t iAtom) const {
+    return m_x.data() + iAtom * m_nPoses;
+  }
+  const double *GetY(std::size_t iAtom) const {
+    return m_y.data() + iAtom * m_nPoses;
+  }
+  const double *GetZ(std::size_t iAtom) const {
+    return m_z.data() + iAtom * m_nPoses;
+  }
+
+  // Changes the number of poses. The contents of all poses are undefined
+  // afterwards. Storage is only reallocated if the batch grows beyond its
+  // largest size so far
+  RBTDLL_EXPORT void SetNumPoses(std::size_t nPoses);
+  // Stores the current coordinates, occupancies and conformers of the models
+  // as pose iPose
+  RBTDLL_EXPORT void SetPose(std::size_t iPose);
+  // Moves the models to pose iPose
+  RBTDLL_EXPORT void ApplyPose(std::size_t iPose) const;
+
+private:
+  PoseBatch(const PoseBatch &);
+  PoseBatch &operator=(const PoseBatch &);
+
+  ModelList m_modelList;
+  AtomList m_atomList;
+  // Regular pointers to the same models and atoms, so that they can be moved
+  // by the const ApplyPose method
+  std::vector<Model *> m_models;
+  AtomRList m_atoms;
+  std::unordered_map<const Atom *, std::size_t> m_atomIndex;
+  std::size_t m_nPoses;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_z;
+  // Model occupancies, enabled states and current coord set indexes,
+  // model-major like the coordinates
+  std::vector<double> m_occupancy;
+  std::vector<char> m_enabled;
+  std::vector<int> m_conformer;
+};
+
+typedef SmartPtr<PoseBatch> PoseBatchPtr;
+
+} // namespace rxdock
+
+#endif //_RBTPOSEBATCH_H_
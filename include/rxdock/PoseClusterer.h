@@ -0,0 +1,83 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Running clustering of the docked poses of a single ligand, used to detect
+// when repeated docking runs have converged. Poses are compared by heavy atom
+// RMSD, with atoms matched by their fixed order in the ligand model (no
+// symmetry correction), so all poses must come from the same model.
+// A pose joins the first cluster whose representative (its best scoring
+// pose) lies within the RMSD threshold; otherwise it starts a new cluster.
+// Runs converge on the best cluster if they land in it with a score within
+// the score window of its best score.
+
+#ifndef _RBTPOSECLUSTERER_H_
+#define _RBTPOSECLUSTERER_H_
+
+#include "rxdock/Atom.h"
+
+namespace rxdock {
+
+class PoseClusterer {
+public:
+  static const std::string _CT;
+
+  RBTDLL_EXPORT PoseClusterer(double rmsdThreshold, double scoreWindow);
+  virtual ~PoseClusterer();
+
+  // Clears all clusters and takes the heavy atoms of the new ligand
+  RBTDLL_EXPORT void SetAtoms(const AtomList &atomList);
+  // Adds the current heavy atom coordinates of the ligand, with their score.
+  // Returns the index of the cluster the pose was assigned to
+  RBTDLL_EXPORT std::size_t AddPose(double score);
+
+  std::size_t GetNumClusters() const { return m_clusters.size(); }
+  std::size_t GetNumPoses() const { return m_nPoses; }
+  std::size_t GetClusterSize(std::size_t iCluster) const {
+    return m_clusters[iCluster].size;
+  }
+  double GetClusterScore(std::size_t iCluster) const {
+    return m_clusters[iCluster].score;
+  }
+  // Index of the cluster with the best (lowest) score
+  std::size_t GetBestCluster() const { return m_iBest; }
+  // Number of consecutive poses, up to and including the last one, that
+  // converged on the best cluster
+  std::size_t GetNumConverged() const { return m_nConverged; }
+
+  // Root mean square distance between two equally sized coord lists
+  RBTDLL_EXPORT static double RMSD(const CoordList &coords1,
+                                   const CoordList &coords2);
+
+private:
+  PoseClusterer(const PoseClusterer &);
+  PoseClusterer &operator=(const PoseClusterer &);
+
+  struct Cluster {
+    CoordList coords; // Best scoring pose
+    double score;
+    std::size_t size;
+  };
+
+  double m_rmsdThreshold;
+  double m_scoreWindow;
+  AtomList m_atomList;
+  CoordList m_coords; // Workspace for the current pose
+  std::vector<Cluster> m_clusters;
+  std::size_t m_iBest;
+  std::size_t m_nPoses;
+  std::size_t m_nConverged;
+};
+
+} // namespace rxdock
+
+#endif //_RBTPOSECLUSTERER_H_
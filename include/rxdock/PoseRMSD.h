@@ -0,0 +1,79 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Symmetry corrected heavy atom RMSD of poses against a reference ligand.
+// The topological symmetries of the reference (automorphisms of its heavy
+// atom graph, matching elements) are enumerated once; each RMSD is the
+// lowest over all of them. Poses must list their heavy atoms in the same
+// order as the reference, as docked poses of the same ligand do. Pose
+// coordinates are passed as contiguous arrays of x,y,z triplets, so that
+// many poses can be compared concurrently.
+
+#ifndef _RBTPOSERMSD_H_
+#define _RBTPOSERMSD_H_
+
+#include "rxdock/Model.h"
+#include "rxdock/Quat.h"
+
+namespace rxdock {
+
+class PoseRMSD {
+public:
+  static const std::string _CT;
+
+  // Takes the heavy atoms of the reference model, and enumerates up to
+  // maxSymmetries of its symmetries (the identity is always the first)
+  RBTDLL_EXPORT PoseRMSD(const Model &refModel,
+                         std::size_t maxSymmetries = 1000);
+  virtual ~PoseRMSD();
+
+  std::size_t GetNumAtoms() const { return m_elements.size(); }
+  std::size_t GetNumSymmetries() const { return m_symmetries.size(); }
+  // False if the enumeration stopped at maxSymmetries
+  bool isComplete() const { return m_bComplete; }
+  // Atom i is equivalent to atom GetSymmetry(iSym)[i] of the reference
+  const std::vector<std::size_t> &GetSymmetry(std::size_t iSym) const {
+    return m_symmetries[iSym];
+  }
+
+  // Copies the heavy atom coordinates of the model into coords (3 values per
+  // atom). Returns false if the heavy atoms do not match the reference
+  RBTDLL_EXPORT bool GetCoords(const Model &model,
+                               std::vector<double> &coords) const;
+
+  // Lowest RMSD between the pose and the reference, in place
+  RBTDLL_EXPORT double RMSD(const double *coords) const;
+  // Lowest RMSD between the pose and the reference after optimal
+  // superposition of the pose. If pQuat and pTrans are not null, returns the
+  // superposition, which moves pose coordinate c to pQuat->Rotate(c) + *pTrans
+  RBTDLL_EXPORT double FitRMSD(const double *coords, Quat *pQuat = nullptr,
+                               Vector *pTrans = nullptr) const;
+  // Lowest RMSD between two poses, in place
+  RBTDLL_EXPORT double RMSD(const double *coords1,
+                            const double *coords2) const;
+
+private:
+  PoseRMSD(const PoseRMSD &);
+  PoseRMSD &operator=(const PoseRMSD &);
+
+  std::vector<int> m_elements; // Atomic numbers of the heavy atoms
+  std::vector<std::vector<std::size_t>> m_symmetries;
+  bool m_bComplete;
+  // Reference coordinates for each symmetry, relative to their center
+  std::vector<std::vector<double>> m_refCoords;
+  Coord m_refCenter;
+  double m_refNorm2; // Sum of the squared centered reference coordinates
+};
+
+} // namespace rxdock
+
+#endif //_RBTPOSERMSD_H_
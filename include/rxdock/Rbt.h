@@ -86,9 +86,9 @@ std::string GetFileType(const std::string &strFile);
 // Returns a list of files in a directory (strDir) whose names begin with
 // strFilePrefix (optional) and whose type is strFileType (optional, as returned
 // by GetFileType)
-std::vector<std::string> GetDirList(const std::string &strDir,
-                                    const std::string &strFilePrefix = "",
-                                    const std::string &strFileType = "");
+RBTDLL_EXPORT std::vector<std::string>
+GetDirList(const std::string &strDir, const std::string &strFilePrefix = "",
+           const std::string &strFileType = "");
 //
 ////////////////////////////////////////////////////////////////
 
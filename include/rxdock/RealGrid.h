@@ -25,6 +25,8 @@
 
 #include "rxdock/BaseGrid.h"
 
+#include <memory>
+
 namespace rxdock {
 
 class RealGrid : public BaseGrid {
@@ -42,6 +44,13 @@ public:
   // Constructor reading all params from binary stream
   RBTDLL_EXPORT RealGrid(json j);
 
+  // Constructor wrapping an existing data array of GetN() values instead of
+  // allocating one (e.g. a read-only shared memory segment). spOwner keeps the
+  // storage alive for the lifetime of the grid. Grids created this way must
+  // not be modified; copies get their own storage.
+  RBTDLL_EXPORT RealGrid(const BaseGrid &grid, const float *pData, double tol,
+                         std::shared_ptr<const void> spOwner);
+
   ~RealGrid(); // Default destructor
 
   // Copy constructor
@@ -74,6 +83,9 @@ public:
     float *data = m_grid.data();
     return data;
   }
+  const float *GetGridData() const { return m_grid.data(); }
+  // True if the data array is not owned by this grid
+  bool isExternal() const { return m_spExternal != nullptr; }
 
   /////////////////////////
   // Get/Set value functions
@@ -100,6 +112,19 @@ public:
   // DM 20 Jul 2000 - get values smoothed by trilinear interpolation
   // D. Oberlin and H.A. Scheraga, J. Comp. Chem. (1998) 19, 71.
   RBTDLL_EXPORT double GetSmoothedValue(const Coord &c) const;
+  // As above, also returning the gradient of the interpolated value in
+  // gradient. Outside the grid the gradient is zero
+  RBTDLL_EXPORT double GetSmoothedValueGradient(const Coord &c,
+                                                Vector &gradient) const;
+  // Batched form of GetSmoothedValue for the n points (x[i],y[i],z[i]), e.g.
+  // one atom in many poses. Adds the values to values[i] and, unless gx is
+  // null, the gradients to (gx[i],gy[i],gz[i]). The results are identical to
+  // calling GetSmoothedValue (or GetSmoothedValueGradient) for each point
+  RBTDLL_EXPORT void AddSmoothedValues(std::size_t n, const double *x,
+                                       const double *y, const double *z,
+                                       double *values, double *gx = nullptr,
+                                       double *gy = nullptr,
+                                       double *gz = nullptr) const;
 
   void SetValue(const Coord &c, double val) {
     if (isValid(c))
@@ -211,6 +236,8 @@ private:
                  bool bOverwrite = true);
 
   void CreateArrays();
+  // Points m_grid at the given data array
+  void MapArrays(float *pData);
 
   // Helper function called by copy constructor and assignment operator
   void CopyGrid(const RealGrid &);
@@ -224,9 +251,11 @@ private:
   ////////////////////////////////////////
   // Private data
   //////////////
-  Eigen::Tensor<float, 3, Eigen::RowMajor>
-      m_grid;   // 3-D array, accessed as m_grid(i, j, k), indicies from 0
-  double m_tol; // Tolerance for comparing grid values;
+  typedef Eigen::TensorMap<Eigen::Tensor<float, 3, Eigen::RowMajor>> GridMap;
+  std::vector<float> m_data; // Grid values, unless stored externally
+  std::shared_ptr<const void> m_spExternal; // Owner of external grid values
+  GridMap m_grid; // 3-D array, accessed as m_grid(i, j, k), indicies from 0
+  double m_tol;   // Tolerance for comparing grid values;
 };
 
 // Useful typedefs
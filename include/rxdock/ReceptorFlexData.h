@@ -24,6 +24,8 @@ public:
   static const std::string &_FLEX_DISTANCE;
   // Dihedral mutation step length (deg)
   static const std::string &_DIHEDRAL_STEP;
+  // Receptor ensembles: probability of switching conformer per mutation
+  static const std::string &_CONFORMER_STEP;
   RBTDLL_EXPORT ReceptorFlexData(DockingSite *pDockSite);
   virtual void Accept(FlexDataVisitor &v) { v.VisitReceptorFlexData(this); }
 
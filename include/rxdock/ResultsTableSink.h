@@ -0,0 +1,92 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Columnar binary table of docking results, written alongside the SD output
+// so that score analysis can read just the columns it needs instead of
+// parsing every data field of every pose. Rows are buffered and written in
+// row groups, each holding one contiguous array per column; a JSON footer
+// describes the columns and where each row group stores them (see
+// ResultsTableSource for the layout). Columns can appear at any row, earlier
+// rows read as NaN, 0 or empty.
+
+#ifndef _RBTRESULTSTABLESINK_H_
+#define _RBTRESULTSTABLESINK_H_
+
+#include "rxdock/Config.h"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+
+namespace rxdock {
+
+class ResultsTableSink {
+public:
+  static const std::string _CT;
+  // Magic string at the start and end of the file
+  static const std::string _MAGIC;
+
+  enum ColumnType { INT64, FLOAT64, STRING };
+
+  RBTDLL_EXPORT ResultsTableSink(const std::string &fileName,
+                                 std::size_t rowGroupSize = 65536);
+  // Closes the table if Close() was not called
+  virtual ~ResultsTableSink();
+
+  // Set values in the current row
+  RBTDLL_EXPORT void SetInt(const std::string &name, std::int64_t value);
+  RBTDLL_EXPORT void SetDouble(const std::string &name, double value);
+  RBTDLL_EXPORT void SetString(const std::string &name,
+                               const std::string &value);
+  // Completes the current row
+  RBTDLL_EXPORT void EndRow();
+  // Writes the remaining rows and the footer
+  RBTDLL_EXPORT void Close();
+
+  std::size_t GetNumRows() const { return m_nRows; }
+
+private:
+  ResultsTableSink(const ResultsTableSink &);
+  ResultsTableSink &operator=(const ResultsTableSink &);
+
+  struct Column {
+    std::string name;
+    ColumnType type;
+    // Values of the current row group
+    std::vector<std::int64_t> ints;
+    std::vector<double> doubles;
+    std::vector<std::string> strings;
+    // Offset and length of the column in each row group
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> chunks;
+  };
+
+  // Returns the column, adding it if new. Throws if the type differs
+  Column &GetColumn(const std::string &name, ColumnType type);
+  // Pads the column to the current row with null values
+  void Pad(Column &column, std::size_t nRows);
+  void WriteRowGroup();
+
+  std::string m_fileName;
+  std::ofstream m_fileOut;
+  std::size_t m_rowGroupSize;
+  std::vector<Column> m_columns;
+  std::map<std::string, std::size_t> m_columnIndex;
+  std::size_t m_nRows;      // Completed rows
+  std::size_t m_nGroupRows; // Completed rows in the current row group
+  std::vector<std::uint64_t> m_rowGroupSizes;
+  bool m_bClosed;
+};
+
+} // namespace rxdock
+
+#endif //_RBTRESULTSTABLESINK_H_
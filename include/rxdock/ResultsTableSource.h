@@ -0,0 +1,80 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Reads the columnar results tables written by ResultsTableSink. Only the
+// footer is read on construction, and each column is read on its own.
+//
+// Layout (native byte order, little endian on all supported platforms):
+//   magic (8 bytes)
+//   row groups: per column, the values of the rows in the group
+//     int64 / float64: one 8-byte value per row
+//     string: one 8-byte end offset per row, then the characters
+//   JSON footer: {"version", "num-rows", "row-groups": [rows per group],
+//                 "columns": [{"name", "type", "chunks": [[offset, length]]}]}
+//     (a chunk offset of 0 means the column is absent from that row group)
+//   footer length (8 bytes), magic (8 bytes)
+
+#ifndef _RBTRESULTSTABLESOURCE_H_
+#define _RBTRESULTSTABLESOURCE_H_
+
+#include "rxdock/ResultsTableSink.h"
+
+namespace rxdock {
+
+class ResultsTableSource {
+public:
+  static const std::string _CT;
+
+  RBTDLL_EXPORT ResultsTableSource(const std::string &fileName);
+  virtual ~ResultsTableSource();
+
+  std::size_t GetNumRows() const { return m_nRows; }
+  RBTDLL_EXPORT std::vector<std::string> GetColumnNames() const;
+  RBTDLL_EXPORT bool isColumnPresent(const std::string &name) const;
+  RBTDLL_EXPORT ResultsTableSink::ColumnType
+  GetColumnType(const std::string &name) const;
+
+  // Read a whole column. Rows written before the column first appeared are
+  // 0, NaN or empty. Integer columns can also be read as doubles
+  RBTDLL_EXPORT std::vector<std::int64_t>
+  GetIntColumn(const std::string &name);
+  RBTDLL_EXPORT std::vector<double> GetDoubleColumn(const std::string &name);
+  RBTDLL_EXPORT std::vector<std::string>
+  GetStringColumn(const std::string &name);
+
+private:
+  ResultsTableSource(const ResultsTableSource &);
+  ResultsTableSource &operator=(const ResultsTableSource &);
+
+  struct Column {
+    std::string name;
+    ResultsTableSink::ColumnType type;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> chunks;
+  };
+
+  const Column &GetColumn(const std::string &name,
+                          ResultsTableSink::ColumnType type) const;
+  // Reads a chunk of 8-byte values
+  template <typename T>
+  void ReadValues(std::uint64_t offset, std::size_t n, T *values);
+
+  std::string m_fileName;
+  std::ifstream m_fileIn;
+  std::size_t m_nRows;
+  std::vector<std::size_t> m_rowGroupSizes;
+  std::vector<Column> m_columns;
+};
+
+} // namespace rxdock
+
+#endif //_RBTRESULTSTABLESOURCE_H_
@@ -41,6 +41,8 @@ public:
 
 protected:
   virtual void SetupReceptor();
+  virtual void WriteReceptorSetup(CacheEntryWriter &writer) const;
+  virtual void ReadReceptorSetup(CacheEntryReader &reader);
   virtual void SetupLigand();
   virtual void SetupSolvent();
   virtual void SetupScore();
@@ -68,6 +70,11 @@ private:
 
   typedef std::vector<SAIdxSF::solvprms> SolvTable;
   void Setup();
+  // Sets up the receptor interaction centers for the current receptor coords
+  void SetupReceptorCoords();
+  // Returns the index of the current sampled receptor conformer in the
+  // per-conformer lists, or -1 if the receptor has a single conformation
+  int GetConformerIndex() const;
   HHS_SolvationRList CreateInteractionCenters(const AtomList &atomList) const;
   void BuildIntraMap(HHS_SolvationRList &ICList) const;
   void BuildIntraMap(HHS_SolvationRList &ICList1,
@@ -93,6 +100,13 @@ private:
   HHS_SolvationRList
       theSolventList; // DM 21 Dec 2005 - explicit solvent interaction centers
   NonBondedHHSGridPtr theIdxGrid;
+  // Receptor ensembles: the rigid receptor interaction centers, the subset
+  // within range of the docking site, its indexing grid and the initial site
+  // solvation energy for each sampled conformer (indexed from 0)
+  std::vector<HHS_SolvationRList> m_conformerRSPLists;
+  std::vector<HHS_SolvationRList> m_conformerCavLists;
+  std::vector<NonBondedHHSGridPtr> m_conformerIdxGrids;
+  std::vector<double> m_conformerSite0;
   SolvTable m_solvTable;
   ParameterFileSourcePtr m_spSolvSource; // File source for solvation params
   double m_maxR;   // Maximum radius of any atom type, used to adjust Range()
@@ -123,6 +123,7 @@ public:
 
   // Get properties
   double GetA_i(void) const { return A_i; }
+  double GetA_inv(void) const { return A_inv; }
   double GetS_i(void) const { return S_i; }
   double GetP_i(void) const { return p_i; }
   double GetR_i(void) const { return r_i; }
@@ -151,8 +152,14 @@ public:
   // to this center
   const std::vector<HHS_Solvation *> &GetVariable() const { return m_prt; }
   int GetNumVariable() const { return m_prt.size(); }
+  // Get a list of all the variable-distance interactions to this center
+  const std::vector<HHS_Solvation *> &GetAllVariable() const { return m_var; }
   // Add a variable-distance interaction
   void AddVariable(HHS_Solvation *anAtom);
+  // Restores the exposed fractions and variable-distance interactions of a
+  // previously set up center (e.g. read from a cache)
+  void SetState(double a, double aInv, const std::vector<HHS_Solvation *> &var,
+                const std::vector<HHS_Solvation *> &prt);
   // Helper function to calculate the overlap for all the variable interactions
   // to this center All are 1-4+ by definition
   void OverlapVariable();
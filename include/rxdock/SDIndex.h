@@ -0,0 +1,84 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Random access index of the records of an SD file: the byte offset of each
+// record, and its title. The index is built in a single pass over the file
+// and saved to a sidecar file (<SD file>.idx), which is reused as long as the
+// size and modification time of the SD file are unchanged. The offsets of
+// compressed SD files are offsets in the decompressed data (see
+// InputFileStream), so reaching a record still decompresses the file up to it.
+//
+// Sidecar layout (native byte order, little endian on all supported
+// platforms), all values 8 bytes:
+//   magic, version, SD file size, SD file modification time, n records
+//   n + 1 record offsets (the last one is the end of the last record)
+//   n title end offsets, then the characters of the titles
+
+#ifndef _RBTSDINDEX_H_
+#define _RBTSDINDEX_H_
+
+#include "rxdock/Config.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace rxdock {
+
+class SDIndex {
+public:
+  static const std::string _CT;
+  static const std::string _MAGIC;
+  // Sidecar format version, bump whenever the layout changes
+  static const std::uint64_t _VERSION;
+
+  // Loads the index of the SD file from its sidecar file if it is up to date,
+  // otherwise builds it and (if bSave) saves it to the sidecar file. Failing
+  // to save the sidecar file is not an error
+  RBTDLL_EXPORT SDIndex(const std::string &strSDFile, bool bSave = true);
+  virtual ~SDIndex();
+
+  static std::string GetIndexFileName(const std::string &strSDFile) {
+    return strSDFile + ".idx";
+  }
+
+  std::size_t GetNumRecords() const { return m_offsets.size() - 1; }
+  // Byte offset of record iRecord; GetNumRecords() gives the end of the file
+  std::size_t GetRecordOffset(std::size_t iRecord) const {
+    return m_offsets[iRecord];
+  }
+  RBTDLL_EXPORT std::string GetTitle(std::size_t iRecord) const;
+  // Record numbers of the records with the given title, in file order. The
+  // title hash is built on the first call
+  RBTDLL_EXPORT std::vector<std::size_t> FindTitle(const std::string &title);
+
+private:
+  SDIndex(const SDIndex &);
+  SDIndex &operator=(const SDIndex &);
+
+  bool Load();
+  void Build();
+  void Save() const;
+
+  std::string m_strSDFile;
+  std::uint64_t m_fileSize;
+  std::uint64_t m_fileTime;
+  std::vector<std::uint64_t> m_offsets;
+  std::vector<std::uint64_t> m_titleEnds;
+  std::string m_titles;
+  std::unordered_map<std::string, std::vector<std::size_t>> m_titleIndex;
+};
+
+typedef SmartPtr<SDIndex> SDIndexPtr; // Smart pointer
+
+} // namespace rxdock
+
+#endif //_RBTSDINDEX_H_
@@ -55,6 +55,10 @@ public:
   // Key = fully qualified component name, value = weighted score
   //(for saving in a Model's data fields)
   virtual void ScoreMap(StringVariantMap &scoreMap) const;
+  // Aggregate version sums the gradients of all children
+  virtual double ScoreGradient(AtomGradientMap &gradient,
+                               BaseSFList &noGradList,
+                               double scale = 1.0) const;
 
   // Aggregate handling methods
   virtual void Add(BaseSF *);
@@ -89,6 +93,8 @@ protected:
   // Protected methods
   ///////////////////
   virtual double RawScore() const;
+  virtual void RawScoreBatch(const PoseBatch &poses, double *out) const;
+  virtual bool isRawScoreBatched() const;
 
 private:
   ////////////////////////////////////////
@@ -0,0 +1,79 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Abandons a docking run when a score term is not below a threshold after a
+// given transform. The thresholds are defined in the transform sections of
+// the run script:
+//
+//  "ga-slope-3": {
+//    "transform": "GATransform",
+//    "abort-threshold@rxdock.score.inter": -15,
+//    "abort-after": 0.5,
+//    ...
+//  }
+//
+// abandons the run if the best pose of the GA does not have an intermolecular
+// score below -15 once half of the GA cycles are done (and at every cycle
+// after that). abort-after defaults to 1, i.e. the run is only checked at the
+// end of the transform. Scores are those seen by the transform, i.e. with any
+// scoring function parameters changed by earlier stages.
+
+#ifndef _RBTSCOREABORTPREDICATE_H_
+#define _RBTSCOREABORTPREDICATE_H_
+
+#include "rxdock/BaseAbortPredicate.h"
+#include "rxdock/ParameterFileSource.h"
+
+#include <map>
+
+namespace rxdock {
+
+class ScoreAbortPredicate : public BaseAbortPredicate {
+public:
+  static const std::string _CT;
+  // Run script parameter names
+  static const std::string _ABORT_THRESHOLD;
+  static const std::string _ABORT_AFTER;
+
+  // Reads the thresholds from all transform sections of the run script
+  RBTDLL_EXPORT ScoreAbortPredicate(ParameterFileSourcePtr spPrmSource);
+  virtual ~ScoreAbortPredicate();
+
+  // True if the run script parameter belongs to the abort predicate rather
+  // than to the transform
+  static bool isAbortParameter(const std::string &strParamName);
+
+  // True if any thresholds were defined
+  bool isEmpty() const { return m_checks.empty(); }
+
+  virtual bool isCheckDue(const BaseTransform *pTransform,
+                          double progress) const;
+  virtual bool Abort(const BaseTransform *pTransform, WorkSpace *pWorkSpace);
+
+private:
+  ScoreAbortPredicate(const ScoreAbortPredicate &);
+  ScoreAbortPredicate &operator=(const ScoreAbortPredicate &);
+
+  struct Check {
+    double after; // Fraction of the transform after which to check
+    // Score term name and threshold pairs
+    std::vector<std::pair<std::string, double>> thresholds;
+  };
+
+  // Checks by transform name
+  std::map<std::string, Check> m_checks;
+};
+
+} // namespace rxdock
+
+#endif //_RBTSCOREABORTPREDICATE_H_
@@ -0,0 +1,55 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+// Stages of a multi-stage high-throughput screening protocol, as defined in
+// the run script. Any run script section with a "runs" parameter and no
+// "transform" parameter is a stage, and the stages are applied in the order
+// they are listed. A ligand is docked up to the number of runs of the current
+// stage; as soon as a run scores below all of the stage thresholds (given as
+// "threshold@<score term>" parameters) the ligand moves on to the next stage,
+// otherwise it is abandoned once the runs are used up. Passing the last stage
+// finishes the ligand, so the last stage normally has no thresholds.
+//
+//  "stage-1": {"runs": 5, "threshold@rxdock.score.inter": -22},
+//  "stage-2": {"runs": 10, "threshold@rxdock.score.inter": -25},
+//  "stage-3": {"runs": 50}
+
+#ifndef _RBTSCREENINGSTAGE_H_
+#define _RBTSCREENINGSTAGE_H_
+
+#include "rxdock/ParameterFileSource.h"
+
+namespace rxdock {
+
+struct ScreeningStage {
+  std::string name;
+  std::size_t nRuns;
+  // Score term name and threshold pairs, all of which have to be met
+  std::vector<std::pair<std::string, double>> thresholds;
+};
+
+typedef std::vector<ScreeningStage> ScreeningStageList;
+
+// Reads the stages from the run script, returns an empty list if there are
+// none
+RBTDLL_EXPORT ScreeningStageList
+ReadScreeningStages(ParameterFileSourcePtr spPrmSource);
+
+// Returns the equivalent termination filter definition, as read by Filter.
+// All poses are written
+RBTDLL_EXPORT std::string
+GetScreeningFilterDefinition(const ScreeningStageList &stages);
+
+} // namespace rxdock
+
+#endif //_RBTSCREENINGSTAGE_H_
@@ -44,6 +44,8 @@ protected:
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  virtual bool RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const;
 
 private:
   void SetupAtomList(AtomList &atomList, const AtomList &neighbourList);
@@ -0,0 +1,83 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+// Named POSIX shared memory segment for sharing read-only, position
+// independent data (e.g. scoring function grids) between docking processes
+// on the same node. The first process creates and fills the segment, then
+// publishes it; later processes attach to it read-only. Every process using a
+// segment holds a shared lock on it, and the last one to detach (or exit)
+// removes it, so segments do not outlive the jobs using them. A segment left
+// behind by processes that all crashed is removed by the next process to
+// attach to it and detach, and one whose creator died before publishing it is
+// removed by the next process trying to attach to it.
+// Not supported on Windows, where Create and Attach always return null.
+
+#ifndef _RBTSHAREDMEMORYSEGMENT_H_
+#define _RBTSHAREDMEMORYSEGMENT_H_
+
+#include "rxdock/Config.h"
+
+#include <memory>
+
+namespace rxdock {
+
+class SharedMemorySegment;
+typedef std::shared_ptr<SharedMemorySegment> SharedMemorySegmentPtr;
+
+class SharedMemorySegment {
+public:
+  static const std::string _CT;
+
+  // Creates a new segment with room for nBytes of data, mapped read-write.
+  // Returns null if a segment with this name already exists (e.g. another
+  // process is creating it) or cannot be created
+  RBTDLL_EXPORT static SharedMemorySegmentPtr
+  Create(const std::string &strName, std::size_t nBytes);
+  // Attaches read-only to a published segment, waiting up to dTimeout seconds
+  // for its creator to publish it. Returns null if the segment does not exist,
+  // or is still unpublished after the timeout. An unpublished segment whose
+  // creator has died is removed, and null returned, so that the caller can
+  // Create it again
+  RBTDLL_EXPORT static SharedMemorySegmentPtr
+  Attach(const std::string &strName, double dTimeout = 0.0);
+  // Removes the segment name; processes already attached are unaffected
+  RBTDLL_EXPORT static void Remove(const std::string &strName);
+
+  // Detaches, removing the segment if no other process is attached
+  RBTDLL_EXPORT ~SharedMemorySegment();
+
+  std::string GetName() const { return m_strName; }
+  std::size_t GetSize() const { return m_nBytes; }
+  const char *GetData() const { return m_pData; }
+  // Only valid for segments returned by Create, before Publish
+  char *GetWritableData() { return m_bWritable ? m_pData : nullptr; }
+  // Marks the data as complete so that other processes can attach to it
+  RBTDLL_EXPORT void Publish();
+
+private:
+  SharedMemorySegment(const std::string &strName, int fd, void *pBase,
+                      std::size_t nMapped, bool bWritable);
+  SharedMemorySegment(const SharedMemorySegment &);
+  SharedMemorySegment &operator=(const SharedMemorySegment &);
+
+  std::string m_strName;
+  int m_fd;               // Kept open to hold the shared lock
+  void *m_pBase;          // Start of the mapping (header)
+  std::size_t m_nMapped;  // Size of the mapping
+  char *m_pData;          // Start of the data (after the header)
+  std::size_t m_nBytes;   // Size of the data
+  bool m_bWritable;
+};
+
+} // namespace rxdock
+
+#endif //_RBTSHAREDMEMORYSEGMENT_H_
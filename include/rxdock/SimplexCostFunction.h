@@ -24,17 +24,24 @@
 namespace rxdock {
 
 // Rosenbrock cost function
+// Parameters are copied into a chromosome vector buffer that is allocated
+// once, so evaluations do not allocate
 class SimplexCostFunction {
 public:
   SimplexCostFunction(BaseSF *pSF, ChromElementPtr chrom)
-      : m_pSF(pSF), m_chrom(chrom) {}
+      : m_pSF(pSF), m_chrom(chrom), m_vector(chrom->GetLength()) {}
   typedef double DataType;
   typedef Eigen::VectorXd ParameterType;
-  double operator()(const ParameterType &parameters) { // const
+  // Accepts any Eigen vector expression (e.g. a column of the simplex
+  // vertices) without creating a temporary parameter vector
+  template <class Derived>
+  double operator()(const Eigen::DenseBase<Derived> &parameters) { // const
     nCalls++;
-    std::vector<double> vec(parameters.data(),
-                            parameters.data() + parameters.size());
-    m_chrom->SetVector(vec);
+    m_vector.resize(parameters.size());
+    for (Eigen::Index i = 0; i < parameters.size(); ++i) {
+      m_vector[i] = parameters(i);
+    }
+    m_chrom->SetVector(m_vector);
     m_chrom->SyncToModel();
     return m_pSF->Score();
   }
@@ -43,6 +50,7 @@ public:
 private:
   BaseSF *m_pSF;
   ChromElementPtr m_chrom;
+  std::vector<double> m_vector; // Chromosome vector buffer
 };
 
 } // namespace rxdock
@@ -48,9 +48,23 @@ public:
   ////////////////
   ModelPtr GetReceptor() const { return m_spReceptor; }
 
+  // Maps the cavities using the current receptor coords
+  virtual CavityList operator()();
+
   // PURE VIRTUAL - subclasses must override
+  // Maps the cavities using an explicit snapshot of the receptor heavy atom
+  // coords and vdW radii. Must not touch the receptor model itself, so that
+  // different snapshots (e.g. receptor ensemble conformations) can be mapped
+  // concurrently
   // NB - subclasses should also override Observer::Update pure virtual
-  virtual CavityList operator()() = 0;
+  virtual CavityList operator()(const CoordList &coordList,
+                                const std::vector<double> &radiusList) = 0;
+
+  // Fills coordList and radiusList with the receptor heavy atom coords and vdW
+  // radii. iCoord >= 0 selects a saved receptor coord set, iCoord < 0 the
+  // current coords. The receptor model is not modified
+  void GetReceptorSnapshot(int iCoord, CoordList &coordList,
+                           std::vector<double> &radiusList) const;
 
   // Override Observer pure virtual
   // Notify observer that subject has changed
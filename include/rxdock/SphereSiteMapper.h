@@ -36,9 +36,12 @@ public:
   SphereSiteMapper(const std::string &strName = "SPHERE_MAPPER");
   virtual ~SphereSiteMapper();
 
+  using SiteMapper::operator();
+
   // Override SiteMapper pure virtual
   // This is the function which actually does the mapping
-  virtual CavityList operator()();
+  virtual CavityList operator()(const CoordList &coordList,
+                                const std::vector<double> &radiusList);
 };
 
 // Useful typedefs
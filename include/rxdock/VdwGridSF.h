@@ -17,6 +17,7 @@
 
 #include "rxdock/BaseInterSF.h"
 #include "rxdock/RealGrid.h"
+#include "rxdock/SharedMemorySegment.h"
 
 #include <nlohmann/json.hpp>
 
@@ -35,10 +36,19 @@ public:
   static const std::string _GRID; // Suffix for grid filename
   static const std::string
       _SMOOTHED; // Controls whether to smooth the grid values
+  // Share the grids read-only between all docking processes on the node via
+  // a named shared memory segment, instead of reading a private copy
+  static const std::string _SHARED_MEMORY;
 
   VdwGridSF(const std::string &strName = "vdw");
   virtual ~VdwGridSF();
 
+  // Grid file name for the workspace name and grid suffix. Each sampled
+  // receptor conformer (numbered from 1) has its own grid file
+  RBTDLL_EXPORT static std::string GetGridFileName(const std::string &strWSName,
+                                                   const std::string &strSuffix,
+                                                   int iConformer = 0);
+
   friend void to_json(json &j, const VdwGridSF &vdwGridSF);
   friend void from_json(const json &j, VdwGridSF &vdwGridSF);
 
@@ -48,6 +58,10 @@ protected:
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  virtual bool RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const;
+  virtual void RawScoreBatch(const PoseBatch &poses, double *out) const;
+  virtual bool isRawScoreBatched() const { return true; }
   // DM 25 Oct 2000 - track changes to parameter values in local data members
   // ParameterUpdated is invoked by ParamHandler::SetParameter
   void ParameterUpdated(const std::string &strName);
@@ -55,11 +69,25 @@ protected:
 private:
   // Read grids from input stream
   void ReadGrids(json vdwGrids);
+  // Read grids from file into m_grids, or attach to them in shared memory
+  void ReadGridFile(const std::string &strFile);
+  // Returns the grids for the current receptor conformer
+  const RealGridList &GetReceptorGrids() const;
+  // Shared memory segment name for the given grid file
+  std::string GetSharedGridsName(const std::string &strFile) const;
+  // Copies m_grids into a new shared memory segment. Returns null if the
+  // segment could not be created (e.g. another process is creating it)
+  SharedMemorySegmentPtr WriteSharedGrids(const std::string &strName) const;
+  // Replaces m_grids with read-only views of the grids in the segment
+  void ReadSharedGrids(SharedMemorySegmentPtr spSegment);
 
   RealGridList m_grids;
+  // Grids for each sampled receptor conformer (indexed from 0)
+  std::vector<RealGridList> m_conformerGrids;
   AtomRList m_ligAtomList;
   TriposAtomTypeList m_ligAtomTypes;
   bool m_bSmoothed;
+  bool m_bSharedMemory;
 };
 
 void to_json(json &j, const VdwGridSF &vdwGridSF);
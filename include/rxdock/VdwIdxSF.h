@@ -55,10 +55,14 @@ public:
 
 protected:
   virtual void SetupReceptor();
+  virtual void WriteReceptorSetup(CacheEntryWriter &writer) const;
+  virtual void ReadReceptorSetup(CacheEntryReader &reader);
   virtual void SetupLigand();
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  virtual bool RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const;
   double InterScore() const;
   double ReceptorScore() const;
   double SolventScore() const;
@@ -71,8 +75,12 @@ protected:
 
 private:
   void RenderAnnotationsByResidue(std::vector<std::string> &retVal) const;
+  // Returns the indexing grid for the current receptor conformer
+  const NonBondedGrid *GetReceptorGrid() const;
 
   NonBondedGridPtr m_spGrid;        // Indexing grid for receptor
+  // Indexing grids for each sampled receptor conformer (indexed from 0)
+  std::vector<NonBondedGridPtr> m_conformerGrids;
   NonBondedGridPtr m_spSolventGrid; // Indexing grid for fixed/tethered solvent
   AtomList m_recAtomList;
   AtomRList m_recRigidAtomList;
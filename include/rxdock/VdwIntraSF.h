@@ -42,6 +42,8 @@ public:
 protected:
   virtual void SetupScore();
   virtual double RawScore() const;
+  virtual bool RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const;
 
   // DM 25 Oct 2000 - track changes to parameter values in local data members
   // ParameterUpdated is invoked by ParamHandler::SetParameter
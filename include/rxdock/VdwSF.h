@@ -62,6 +62,10 @@ protected:
   // As above, but with additional checks for enabled state of each atom
   double VdwScoreEnabledOnly(const Atom *pAtom,
                              const AtomRList &atomList) const;
+  // As VdwScore (without annotation), also adding scale * the gradient of the
+  // score to gradient for pAtom and each atom in atomList
+  double VdwScoreGradient(const Atom *pAtom, const AtomRList &atomList,
+                          AtomGradientMap &gradient, double scale) const;
   // XB Same as above, used to calcutate intra terms without the reweighting
   // factors Double VdwScoreIntra(const Atom* pAtom, const AtomRList&
   // atomList) const; Looks up the maximum range (rmax_sq) for any interaction
@@ -132,6 +136,37 @@ private:
     }
   }
 
+  // As f6_12 and f4_8, also returning d(score)/d(R_sq) in dS
+  inline double df6_12(double R_sq, const vdwprms &prms, double &dS) const {
+    if ((prms.kij == 0.0) || (R_sq > prms.rmax_sq)) {
+      dS = 0.0;
+      return 0.0;
+    } else if (R_sq < prms.rcutoff_sq) {
+      dS = -prms.slope;
+      return prms.e0 - (prms.slope * R_sq);
+    } else {
+      double rr2 = 1.0 / R_sq;
+      double rr6 = rr2 * rr2 * rr2;
+      dS = rr6 * rr2 * (3.0 * prms.B - 6.0 * rr6 * prms.A);
+      return rr6 * (rr6 * prms.A - prms.B);
+    }
+  }
+
+  inline double df4_8(double R_sq, const vdwprms &prms, double &dS) const {
+    if ((prms.kij == 0.0) || (R_sq > prms.rmax_sq)) {
+      dS = 0.0;
+      return 0.0;
+    } else if (R_sq < prms.rcutoff_sq) {
+      dS = -prms.slope;
+      return prms.e0 - (prms.slope * R_sq);
+    } else {
+      double rr2 = 1.0 / R_sq;
+      double rr4 = rr2 * rr2;
+      dS = rr4 * rr2 * (2.0 * prms.B - 4.0 * rr4 * prms.A);
+      return rr4 * (rr4 * prms.A - prms.B);
+    }
+  }
+
   void Setup(); // Initialise m_vdwTable with appropriate params for each atom
                 // type pair
   void SetupCloseRange(); // Regenerate the short-range params only (called more
@@ -21,6 +21,7 @@
 #ifndef _RBTWORKSPACE_H_
 #define _RBTWORKSPACE_H_
 
+#include "rxdock/BaseAbortPredicate.h"
 #include "rxdock/BaseMolecularFileSink.h"
 #include "rxdock/Config.h"
 #include "rxdock/DockingSite.h"
@@ -34,6 +35,7 @@ namespace rxdock {
 
 class BaseSF;        // Forward definition
 class BaseTransform; // Forward definition
+class ModelCache;    // Forward definition
 
 class WorkSpace : public Subject, public ParamHandler {
 public:
@@ -131,6 +133,21 @@ public:
   FilterPtr GetFilter() const;
   RBTDLL_EXPORT void SetFilter(FilterPtr spFilter);
 
+  // Abort predicate handling
+  // Transforms consult the predicate to abandon hopeless runs early
+  BaseAbortPredicate *GetAbortPredicate();
+  RBTDLL_EXPORT void SetAbortPredicate(AbortPredicatePtr spAbortPredicate);
+
+  // Receptor cache handling
+  // The indexed scoring functions store their receptor setup in the cache,
+  // under the cache key of the receptor (see PRMFactory::GetReceptorCacheKey)
+  // combined with the docking site and their parameters. Set the cache before
+  // the receptor, and again for each new receptor. A null cache disables it
+  const ModelCache *GetReceptorCache() const;
+  std::string GetReceptorCacheKey() const;
+  RBTDLL_EXPORT void SetReceptorCache(const ModelCache *pCache,
+                                      const std::string &strReceptorKey);
+
 protected:
   ////////////////////////////////////////
   // Protected methods
@@ -163,6 +180,9 @@ private:
   PopulationPtr m_population;
   DockingSitePtr m_spDockSite;
   FilterPtr m_spFilter;
+  AbortPredicatePtr m_spAbortPredicate;
+  const ModelCache *m_pReceptorCache;
+  std::string m_strReceptorCacheKey;
 };
 
 // Useful typedefs
@@ -20,22 +20,84 @@
 
 #include "rxdock/support/Export.h"
 
+#include <limits>
 #include <string>
+#include <vector>
 
 namespace rxdock {
 namespace operation {
 
+/// \brief Options of the dock operation. The defaults are those of rxcmd dock.
+struct DockOptions {
+  // Ligand input
+  std::string strLigandMdlFile;
+  bool bRecordRange = false;
+  std::size_t nStartRecord = 0;
+  std::size_t nEndRecord = std::numeric_limits<std::size_t>::max();
+  std::vector<std::string> ligandNames;
+  bool bPosIonise = false;
+  bool bNegIonise = false;
+  bool bExplH = false;
+  // Output
+  std::string strOutputMdlFile;
+  bool bOutputCrd = false;
+  std::string strOutputCrdFile;
+  bool bOutputHistory = false;
+  std::string strOutputHistoryFilePrefix;
+  bool bOutputTable = false;
+  std::string strOutputTableFile;
+  // Receptors and docking protocol
+  std::vector<std::string> receptorPrmFiles;
+  std::string strParamFile;
+  bool bFilter = false;
+  std::string strFilterFile;
+  // Number of runs and termination
+  bool bDockingRuns = false;
+  std::size_t nDockingRuns = 50;
+  bool bTarget = false;
+  double dTargetScore = 0.0;
+  bool bContinue = false;
+  std::size_t nConvergedRuns = 0;
+  double dClusterRMSD = 2.0;
+  double dClusterScoreWindow = 1.0;
+  bool bSeed = false;
+  std::size_t nSeed = 0;
+  // Caches
+  bool bReceptorCache = false;
+  std::string strReceptorCacheDir;
+  bool bLigandCache = false;
+  std::string strLigandCacheDir;
+};
+
 ///
 /// \brief Docks ligand(s) to the receptor.
 ///
-RBTDLL_EXPORT int
-dock(std::string strLigandMdlFile, std::string strOutputMdlFile,
-     bool bOutputCrd, std::string strOutputCrdFile, bool bOutputHistory,
-     std::string strOutputHistoryFilePrefix, std::string strReceptorPrmFile,
-     std::string strParamFile, bool bFilter, std::string strFilterFile,
-     bool bDockingRuns, std::size_t nDockingRuns, bool bPosIonise,
-     bool bNegIonise, bool bExplH, bool bTarget, double dTargetScore,
-     bool bContinue, bool bSeed, std::size_t nSeed);
+/// If nConvergedRuns is non-zero, the runs for a ligand stop once that many
+/// consecutive runs have landed within dClusterRMSD (heavy atom RMSD) and
+/// dClusterScoreWindow (total score) of the best pose found so far.
+///
+/// If bRecordRange is true, only the ligand records [nStartRecord,
+/// nEndRecord) of the SD file (counting from zero) are docked, and ligands
+/// are numbered from their position in the file. If ligandNames is not empty,
+/// only the records with those titles are docked. Records are located with
+/// the index of the SD file (see SDIndex), so no other record is read.
+///
+/// If bOutputTable is true, each saved pose is also added as a row of a
+/// columnar results table (see ResultsTableSink), with its ligand record
+/// number, name, run number, offset in the output SD file and score terms.
+///
+/// If receptorPrmFiles lists several receptors, each ligand is read and
+/// prepared once and then docked against every receptor in turn, each with its
+/// own workspace, scoring function, docking site and filter. Each receptor
+/// writes its own output files, named after the receptor parameter file (e.g.
+/// out.sd becomes out_<receptor>.sd).
+///
+/// If bLigandCache is true, prepared ligands are stored in and loaded from the
+/// cache directory strLigandCacheDir (see ModelCache), keyed by the text of
+/// their SD records and the ionisation and hydrogen options, so that ligands
+/// docked again in a later run are not parsed and prepared again.
+///
+RBTDLL_EXPORT int dock(const DockOptions &options);
 
 } // namespace operation
 } // namespace rxdock
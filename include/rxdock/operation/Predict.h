@@ -0,0 +1,50 @@
+//===-- Predict.h - Predict operation ---------------------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://rxdock.gitlab.io/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Predict operation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_OPERATION_PREDICT_H
+#define RXDOCK_OPERATION_PREDICT_H
+
+#include "rxdock/support/Export.h"
+
+#include <string>
+
+namespace rxdock {
+namespace operation {
+
+///
+/// \brief Finds the score thresholds of a multi-stage high-throughput
+/// screening protocol from the scores of an exhaustive docking of a
+/// representative set of ligands.
+///
+/// The scores are read from a structure-data file, or from a table with a
+/// header row (comma, tab or space separated). Protocols with nRuns1 runs at
+/// threshold 1, nRuns2 runs at threshold 2 and nRunsFinal runs in the last
+/// stage are evaluated over the given ranges of thresholds, and written to
+/// strOutputFile. The cheapest protocol that keeps at least dMinRecall
+/// percent of the top dTopPercent percent of ligands is reported.
+///
+RBTDLL_EXPORT int
+predict(std::string strInputFile, std::string strOutputFile,
+        std::string strNameField, std::string strScoreField,
+        std::size_t nRuns1, std::size_t nRuns2, std::size_t nRunsFinal,
+        double dThr1Max, double dThr1Min, double dThr2Max, double dThr2Min,
+        double dThrStep, double dTopPercent, double dMinRecall);
+
+} // namespace operation
+} // namespace rxdock
+
+#endif // RXDOCK_OPERATION_PREDICT_H
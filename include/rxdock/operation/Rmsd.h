@@ -0,0 +1,48 @@
+//===-- Rmsd.h - RMSD operation ---------------------------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://rxdock.gitlab.io/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// RMSD operation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_OPERATION_RMSD_H
+#define RXDOCK_OPERATION_RMSD_H
+
+#include "rxdock/support/Export.h"
+
+#include <string>
+
+namespace rxdock {
+namespace operation {
+
+///
+/// \brief Calculates the symmetry corrected heavy atom RMSD between each
+/// record of a structure-data file and the first record of a reference file.
+///
+/// If bFit is true, each pose is optimally superposed onto the reference
+/// first. If dThreshold is positive, poses within dThreshold RMSD of an
+/// earlier kept pose are discarded, and counted in the population of the
+/// closest one. If strOutputSDFile is not empty, the kept poses are written
+/// to it (superposed, if bFit is true) with their RMSD and population. At
+/// most nMaxSymmetries symmetries of the reference are considered. Poses are
+/// read as text records and compared in parallel; only the poses written to
+/// the output are built as models.
+///
+RBTDLL_EXPORT int rmsd(std::string strRefSDFile, std::string strInputSDFile,
+                       std::string strOutputSDFile, bool bFit,
+                       double dThreshold, std::size_t nMaxSymmetries);
+
+} // namespace operation
+} // namespace rxdock
+
+#endif // RXDOCK_OPERATION_RMSD_H
@@ -21,6 +21,7 @@
 #include "rxdock/support/Export.h"
 
 #include <string>
+#include <vector>
 
 namespace rxdock {
 namespace operation {
@@ -28,8 +29,17 @@ namespace operation {
 ///
 /// \brief Represents structure-data file (SDF) as a CSV table.
 ///
+/// Records are read as text, without building models, so the atoms are listed
+/// as written in the file. The input is read in blocks whose records are
+/// tabulated concurrently, and the rows are written in the input order.
+///
+/// If fieldNames is not empty, the table has a header row and one column per
+/// named data field, after the title and the coordinates of the first nAtoms
+/// atoms; nDataFields is then unused.
+///
 RBTDLL_EXPORT int tabularize(std::string inputSDFile, std::string outputCSVFile,
-                             std::size_t nAtoms, std::size_t nDataFields);
+                             std::size_t nAtoms, std::size_t nDataFields,
+                             std::vector<std::string> fieldNames);
 
 } // namespace operation
 } // namespace rxdock
@@ -28,6 +28,13 @@ namespace operation {
 ///
 /// \brief Transforms structure-data file (SDF) according to your requirements.
 ///
+/// Selected records are copied verbatim from the input (apart from their
+/// titles, if renamed), so memory use does not depend on the size of the
+/// output. At most bufferSize records are sorted in memory, larger sorts are
+/// spilled to temporary files next to the output and merged. Limits per
+/// molecule are applied while merging records sorted by molecule name, so
+/// memory use does not depend on the number of molecules either.
+///
 RBTDLL_EXPORT int transform(std::string inputSDFile, std::string outputSDFile,
                             bool limitedRecPerMolecule,
                             std::size_t maxNumRecPerMolecule, bool checkName,
@@ -87,9 +87,6 @@ void AromIdxSF::SetupReceptor() {
   if (GetReceptor().Null())
     return;
 
-  m_spAromGrid = CreateInteractionGrid();
-  m_spGuanGrid = CreateInteractionGrid();
-
   double idxIncr = GetParameter(_INCR); // vdw Radius increment for indexing
   double maxError = GetMaxError();
   idxIncr += maxError;
@@ -127,21 +124,41 @@ void AromIdxSF::SetupReceptor() {
       m_recepGuanList.push_back(pIntnCenter); // Store the interaction center
     }
 
+    // Sampled conformers get their own grids, so that only the interaction
+    // centers of the current conformer are scored. Otherwise the union of all
+    // conformers is indexed
+    bool bSampled = GetReceptor()->isConformerSampled();
+    if (!bSampled) {
+      m_spAromGrid = CreateInteractionGrid();
+      m_spGuanGrid = CreateInteractionGrid();
+    }
     for (int i = 1; i <= nCoords; i++) {
       LOG_F(1, "AromIdxSF setup indexing receptor coords #{}", i);
-      GetReceptor()->RevertCoords(i);
+      GetReceptor()->SetCurrentConformer(i);
+      InteractionGridPtr spAromGrid = m_spAromGrid;
+      InteractionGridPtr spGuanGrid = m_spGuanGrid;
+      if (bSampled) {
+        spAromGrid = CreateInteractionGrid();
+        spGuanGrid = CreateInteractionGrid();
+        m_conformerAromGrids.push_back(spAromGrid);
+        m_conformerGuanGrids.push_back(spGuanGrid);
+      }
       for (InteractionCenterListConstIter iter = m_recepAromList.begin();
            iter != m_recepAromList.end(); iter++) {
-        m_spAromGrid->SetInteractionLists(*iter, idxIncr);
+        spAromGrid->SetInteractionLists(*iter, idxIncr);
       }
-      m_spAromGrid->UniqueInteractionLists();
       for (InteractionCenterListConstIter iter = m_recepGuanList.begin();
            iter != m_recepGuanList.end(); iter++) {
-        m_spGuanGrid->SetInteractionLists(*iter, idxIncr);
+        spGuanGrid->SetInteractionLists(*iter, idxIncr);
+      }
+      if (!bSampled) {
+        m_spAromGrid->UniqueInteractionLists();
+        m_spGuanGrid->UniqueInteractionLists();
       }
-      m_spGuanGrid->UniqueInteractionLists();
     }
   } else {
+    m_spAromGrid = CreateInteractionGrid();
+    m_spGuanGrid = CreateInteractionGrid();
     DockingSite::isAtomInRange bIsInRange(spDS->GetGrid(), 0.0,
                                           GetCorrectedRange());
     for (AtomListListConstIter rIter = recepRingLists.begin();
@@ -226,8 +243,15 @@ double AromIdxSF::RawScore() const {
   m_nArom = 0;
   m_nGuan = 0;
 
+  const InteractionGrid *pAromGrid = m_spAromGrid.Ptr();
+  const InteractionGrid *pGuanGrid = m_spGuanGrid.Ptr();
+  int iConformer = GetConformerGridIndex();
+  if (iConformer >= 0) {
+    pAromGrid = m_conformerAromGrids[iConformer].Ptr();
+    pGuanGrid = m_conformerGuanGrids[iConformer].Ptr();
+  }
   // Check grids are defined
-  if (m_spAromGrid.Null() || m_spGuanGrid.Null())
+  if (pAromGrid == nullptr || pGuanGrid == nullptr)
     return score;
 
   f1prms Rprms = GetRprms(); // Distance params
@@ -239,10 +263,10 @@ double AromIdxSF::RawScore() const {
     const Coord &cLig1 = (*ligIter)->GetAtom1Ptr()->GetCoords();
     // Get the list of nearby receptor aromatic centers
     const InteractionCenterList &recepAromList =
-        m_spAromGrid->GetInteractionList(cLig1);
+        pAromGrid->GetInteractionList(cLig1);
     // Get the list of nearby receptor guanidinium centers
     const InteractionCenterList &recepGuanList =
-        m_spGuanGrid->GetInteractionList(cLig1);
+        pGuanGrid->GetInteractionList(cLig1);
 
     double s = AromScore(*ligIter, recepAromList, Rprms, Aprms);
     s += AromScore(*ligIter, recepGuanList, Rprms, Aprms);
@@ -259,7 +283,7 @@ double AromIdxSF::RawScore() const {
     const Coord &cLig1 = (*ligIter)->GetAtom1Ptr()->GetCoords();
     // Get the list of nearby receptor aromatic centers
     const InteractionCenterList &recepAromList =
-        m_spAromGrid->GetInteractionList(cLig1);
+        pAromGrid->GetInteractionList(cLig1);
 
     double s = AromScore(*ligIter, recepAromList, Rprms, Aprms);
     // Double s = 0.0;
@@ -271,12 +295,27 @@ double AromIdxSF::RawScore() const {
   return score;
 }
 
+int AromIdxSF::GetConformerGridIndex() const {
+  if (m_conformerAromGrids.empty()) {
+    return -1;
+  }
+  int iConformer = GetReceptor()->GetCurrentCoords();
+  if (iConformer < 1 ||
+      iConformer > static_cast<int>(m_conformerAromGrids.size())) {
+    throw InvalidRequest(_WHERE_, "No indexing grids for receptor coords #" +
+                                      std::to_string(iConformer));
+  }
+  return iConformer - 1;
+}
+
 // Clear the receptor and ligand grids and lists respectively
 // As we are not using smart pointers, there is some memory management to do
 void AromIdxSF::ClearReceptor() {
   // Wipe the grids
   m_spAromGrid = InteractionGridPtr();
   m_spGuanGrid = InteractionGridPtr();
+  m_conformerAromGrids.clear();
+  m_conformerGuanGrids.clear();
   // Delete the receptor interaction centers
   for (InteractionCenterListIter iter = m_recepAromList.begin();
        iter != m_recepAromList.end(); iter++) {
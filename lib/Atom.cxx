@@ -341,6 +341,15 @@ void Atom::RevertCoords(unsigned int coordNum) {
                          "RevertCoords failed on atom " + GetFullAtomName());
 }
 
+const Coord &Atom::GetSavedCoords(unsigned int coordNum) const {
+  UIntCoordMapConstIter iter = m_savedCoords.find(coordNum);
+  if (iter == m_savedCoords.end()) {
+    throw InvalidRequest(_WHERE_,
+                         "GetSavedCoords failed on atom " + GetFullAtomName());
+  }
+  return (*iter).second;
+}
+
 // DM 04 Dec 1998  Now we have the bond map, we can easily provide coordination
 // numbers This version returns the total number of coordinated atoms (includes
 // implicit hydrogens) Equivalent to GetNumBonds()+GetNumImplicitHydrogens()
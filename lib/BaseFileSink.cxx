@@ -12,6 +12,9 @@
 
 #include "rxdock/BaseFileSink.h"
 #include "rxdock/FileError.h"
+#include <sys/stat.h>
+
+#include <loguru.hpp>
 
 using namespace rxdock;
 
@@ -24,12 +27,17 @@ using namespace rxdock;
 //}
 
 BaseFileSink::BaseFileSink(const std::string &fileName)
-    : m_strFileName(fileName), m_bAppend(false) {
+    : m_strFileName(fileName), m_bAppend(false), m_nBytesWritten(0) {
   _RBTOBJECTCOUNTER_CONSTR_("BaseFileSink");
 }
 
 BaseFileSink::~BaseFileSink() {
-  Write(); // Just in case there is anything in the cache
+  try {
+    Write(); // Just in case there is anything in the cache
+    Close();
+  } catch (Error &e) {
+    LOG_F(ERROR, "{}", e.what());
+  }
   _RBTOBJECTCOUNTER_DESTR_("BaseFileSink");
 }
 
@@ -38,15 +46,19 @@ BaseFileSink::~BaseFileSink() {
 ////////////////
 void BaseFileSink::SetFileName(const std::string &fileName) {
   Write(); // Just in case there is anything in the cache
+  Close();
   m_strFileName = fileName;
 }
 
 Error BaseFileSink::Status() {
   // For file sinks, all we can is try and open the file for writing and see
   // what we catch
+  bool bOpen = m_fileOut.isOpen();
   try {
     Open(true); // Open for append, so as not to overwrite the file
-    Close();
+    if (!bOpen) {
+      Close();
+    }
     // If we get here then everything is fine
     return Error();
   }
@@ -58,6 +70,18 @@ Error BaseFileSink::Status() {
   }
 }
 
+std::size_t BaseFileSink::GetWriteOffset() const {
+  // The first write overwrites the file
+  if (isCompressedFileName(m_strFileName)) {
+    return m_bAppend ? m_nBytesWritten : 0;
+  }
+  struct stat fileStat;
+  if (m_bAppend && stat(m_strFileName.c_str(), &fileStat) == 0) {
+    return fileStat.st_size;
+  }
+  return 0;
+}
+
 ////////////////////////////////////////
 // Protected methods
 ///////////////////
@@ -77,10 +101,17 @@ void BaseFileSink::Write(bool bClearCache) {
       // implementations so it is worth to pay this "pointless" price in
       // conversion
       std::string delimited((*iter).c_str());
-      m_fileOut << delimited << std::endl;
+      m_fileOut << delimited << '\n';
+      m_nBytesWritten += delimited.size() + 1;
       // m_fileOut << *iter << std::endl;
     }
-    Close();
+    // The cache ends at a record boundary, where compressed files kept open
+    // between writes may write their buffered block
+    m_fileOut.flush();
+    m_fileOut.CheckError();
+    if (!m_bAppend || !isCompressedFileName(m_strFileName)) {
+      Close();
+    }
     if (bClearCache)
       ClearCache(); // Clear the cache so we don't write the file again
   }
@@ -109,15 +140,20 @@ void BaseFileSink::ReplaceLine(const std::string &fileRec, unsigned int nRec) {
 // Private methods
 /////////////////
 void BaseFileSink::Open(bool bAppend) {
-  std::ios_base::openmode openMode = std::ios_base::out;
-  if (bAppend)
-    openMode = openMode | std::ios_base::app;
-  m_fileOut.open(m_strFileName.c_str(), openMode);
+  // Compressed files may have been kept open by the previous write
+  if (m_fileOut.isOpen()) {
+    if (bAppend)
+      return;
+    Close();
+  }
+  m_fileOut.Open(m_strFileName, bAppend);
   if (!m_fileOut)
     throw FileWriteError(_WHERE_, "Error opening " + m_strFileName);
+  if (!bAppend)
+    m_nBytesWritten = 0;
 }
 
-void BaseFileSink::Close() { m_fileOut.close(); }
+void BaseFileSink::Close() { m_fileOut.Close(); }
 
 void BaseFileSink::ClearCache() { m_lineRecs.clear(); }
 
@@ -28,7 +28,9 @@ using namespace rxdock;
 //}
 
 BaseFileSource::BaseFileSource(const std::string &fileName)
-    : m_numReads(0), m_bytesRead(0), m_bFileOpen(false), m_bMultiRec(false) {
+    : m_fileSize(0), m_numReads(0), m_bytesRead(0), m_recordStart(0),
+      m_recordEnd(0), m_bRecordOffsets(false), m_iRecordOffset(0),
+      m_bFileOpen(false), m_bMultiRec(false) {
   m_strFileName = fileName;
   struct stat fileStat;
   if (stat(fileName.c_str(), &fileStat) == 0) {
@@ -42,8 +44,9 @@ BaseFileSource::BaseFileSource(const std::string &fileName)
 // Multi-record constructor
 BaseFileSource::BaseFileSource(const std::string &fileName,
                                const std::string &strRecDelim)
-    : m_numReads(0), m_bytesRead(0), m_bFileOpen(false), m_bMultiRec(true),
-      m_strRecDelim(strRecDelim) {
+    : m_fileSize(0), m_numReads(0), m_bytesRead(0), m_recordStart(0),
+      m_recordEnd(0), m_bRecordOffsets(false), m_iRecordOffset(0),
+      m_bFileOpen(false), m_bMultiRec(true), m_strRecDelim(strRecDelim) {
   m_strFileName = fileName;
   struct stat fileStat;
   if (stat(fileName.c_str(), &fileStat) == 0) {
@@ -75,6 +78,9 @@ std::string BaseFileSource::GetFileName() { return m_strFileName; }
 void BaseFileSource::SetFileName(const std::string &fileName) {
   Close();
   ClearCache();
+  m_bRecordOffsets = false;
+  m_recordOffsets.clear();
+  m_iRecordOffset = 0;
   m_strFileName = fileName;
 }
 
@@ -127,11 +133,24 @@ void BaseFileSource::Rewind() {
   if (m_bMultiRec) {
     Close();
     ClearCache();
+    m_iRecordOffset = 0;
   }
 }
 
 // Estimate the number of records in the file from the file size
 std::size_t BaseFileSource::GetEstimatedNumRecords() {
+  if (m_bMultiRec && m_bRecordOffsets) {
+    return m_recordOffsets.size();
+  }
+  if (m_bMultiRec && isCompressedFileName(m_strFileName)) {
+    // Records per byte of the compressed file read so far
+    std::size_t fileOffset = m_fileIn.GetFileOffset();
+    if (m_numReads > 0 && fileOffset > 0) {
+      return static_cast<std::size_t>(static_cast<double>(m_fileSize) *
+                                      m_numReads / fileOffset);
+    }
+    return 0;
+  }
   if (m_bMultiRec) {
     if (m_numReads > 0 && m_bytesRead > 0) {
       double avgBytesRead =
@@ -145,6 +164,25 @@ std::size_t BaseFileSource::GetEstimatedNumRecords() {
   return 1;
 }
 
+std::size_t BaseFileSource::GetRecordStart() {
+  Read();
+  return m_recordStart;
+}
+
+std::size_t BaseFileSource::GetRecordEnd() {
+  Read();
+  return m_recordEnd;
+}
+
+void BaseFileSource::SetRecordOffsets(
+    const std::vector<std::size_t> &recordOffsets) {
+  Close();
+  ClearCache();
+  m_bRecordOffsets = true;
+  m_recordOffsets = recordOffsets;
+  m_iRecordOffset = 0;
+}
+
 // Protected functions
 
 void BaseFileSource::Read(bool aDelimiterAtEnd) {
@@ -161,6 +199,15 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
         if (m_bMultiRec) {
           const char *cszRecDelim = m_strRecDelim.c_str();
           int n = strlen(cszRecDelim);
+          if (m_bRecordOffsets) {
+            if (m_iRecordOffset >= m_recordOffsets.size()) {
+              throw FileReadError(_WHERE_, "End of selected records in " +
+                                               m_strFileName);
+            }
+            m_fileIn.clear(); // The previous record may have ended at EOF
+            m_fileIn.seekg(m_recordOffsets[m_iRecordOffset++]);
+          }
+          m_recordStart = m_fileIn.tellg();
           while ((m_fileIn.getline(m_szBuf, MAXLINELENGTH)) &&
                  (strncmp(m_szBuf, cszRecDelim, n) != 0)) {
             LOG_F(1, "File line read is {}", m_szBuf);
@@ -169,6 +216,13 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             // to check for CRLF as they are considered unsupported
             m_lineRecs.push_back(m_szBuf);
           }
+          // The stream fails at the end of the file, which for compressed
+          // files is only known once it has been read
+          std::ios_base::iostate state = m_fileIn.rdstate();
+          m_fileIn.CheckError();
+          m_fileIn.clear();
+          m_recordEnd = static_cast<std::size_t>(m_fileIn.tellg());
+          m_fileIn.setstate(state);
         }
         // Single-record read
         // Read entire file and close immediately
@@ -177,6 +231,7 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             bytesLastRead += std::strlen(m_szBuf) + 1;
             m_lineRecs.push_back(m_szBuf);
           }
+          m_fileIn.CheckError();
           Close();
         }
         // DM 25 Mar 1999 - check for end of file (i.e. no lines read)
@@ -210,6 +265,7 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             bytesLastRead += std::strlen(m_szBuf) + 1;
             m_lineRecs.push_back(m_szBuf);
           }
+          m_fileIn.CheckError();
         }
         // Single-record read
         // Read entire file and close immediately
@@ -218,6 +274,7 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             bytesLastRead += std::strlen(m_szBuf) + 1;
             m_lineRecs.push_back(m_szBuf);
           }
+          m_fileIn.CheckError();
           Close();
         }
         // DM 25 Mar 1999 - check for end of file (i.e. no lines read)
@@ -243,7 +300,7 @@ void BaseFileSource::Open() {
   // DM 23 Mar 1999 - check if file is already open, to allow Open() to be
   // called redundantly
   if (!m_bFileOpen)
-    m_fileIn.open(m_strFileName.c_str(), std::ios_base::in);
+    m_fileIn.Open(m_strFileName);
 
   // If file did not open, throw an error
   if (!m_fileIn)
@@ -253,7 +310,7 @@ void BaseFileSource::Open() {
 }
 
 void BaseFileSource::Close() {
-  m_fileIn.close();
+  m_fileIn.Close();
   m_bFileOpen = false;
 }
 
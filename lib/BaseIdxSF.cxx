@@ -11,16 +11,53 @@
  ***********************************************************************/
 
 #include "rxdock/BaseIdxSF.h"
+#include "rxdock/Hasher.h"
+#include "rxdock/ModelCache.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
 
+#include <iomanip>
+#include <sstream>
+
 using namespace rxdock;
 
+namespace {
+// Adds the value to the hasher with full precision
+void AddValue(Hasher &hasher, double d) {
+  std::ostringstream ostr;
+  ostr << std::setprecision(17) << d;
+  hasher.Add(ostr.str());
+}
+
+void AddCoord(Hasher &hasher, const Coord &c) {
+  AddValue(hasher, c.xyz(0));
+  AddValue(hasher, c.xyz(1));
+  AddValue(hasher, c.xyz(2));
+}
+
+// Adds the names and parameters of the scoring function and its children
+void AddSF(Hasher &hasher, const BaseSF *pSF) {
+  hasher.Add(pSF->GetFullName());
+  StringVariantMap params = pSF->GetParameters();
+  for (const auto &param : params) {
+    hasher.Add(param.first);
+    AddValue(hasher, param.second.GetDouble());
+    for (const auto &str : param.second.GetStringList()) {
+      hasher.Add(str);
+    }
+  }
+  for (unsigned int i = 0; i < pSF->GetNumSF(); i++) {
+    AddSF(hasher, pSF->GetSF(i));
+  }
+}
+} // namespace
+
 // Static data members
 const std::string BaseIdxSF::_CT = "BaseIdxSF";
 const std::string BaseIdxSF::_GRIDSTEP = "grid-step";
 const std::string BaseIdxSF::_BORDER = "border";
+const std::string BaseIdxSF::_SETUP_ENTRY = "setup";
 
 BaseIdxSF::BaseIdxSF() : m_gridStep(0.5), m_border(1.0) {
   LOG_F(2, "BaseIdxSF default constructor");
@@ -121,6 +158,62 @@ double BaseIdxSF::GetCorrectedRange() const {
   return GetRange() + GetMaxError() + m_border;
 }
 
+// Reads the receptor setup from the receptor cache, if there is an entry
+// for this scoring function, receptor and docking site
+bool BaseIdxSF::LoadReceptorSetup(ModelPtr spReceptor) {
+  const ModelCache *pCache = GetReceptorSetupCache(spReceptor);
+  if (pCache == nullptr) {
+    return false;
+  }
+  std::string strKey = GetReceptorSetupKey();
+  std::string buf;
+  if (!pCache->LoadEntry(strKey, _SETUP_ENTRY, buf)) {
+    return false;
+  }
+  std::string strFile = pCache->GetEntryFileName(strKey, _SETUP_ENTRY);
+  try {
+    CacheEntryReader reader(buf);
+    std::uint64_t nAtoms = reader.Get<std::uint64_t>();
+    if (nAtoms != static_cast<std::uint64_t>(spReceptor->GetNumAtoms())) {
+      LOG_F(WARNING, "Ignoring stale receptor setup cache entry {}", strFile);
+      return false;
+    }
+    ReadReceptorSetup(reader);
+  } catch (std::exception &e) {
+    LOG_F(WARNING, "Ignoring unreadable receptor setup cache entry {}: {}",
+          strFile, e.what());
+    return false;
+  }
+  LOG_F(INFO, "Loaded receptor setup of {} from cache entry {}",
+        GetFullName(), strFile);
+  return true;
+}
+
+void BaseIdxSF::SaveReceptorSetup(ModelPtr spReceptor) const {
+  const ModelCache *pCache = GetReceptorSetupCache(spReceptor);
+  if (pCache == nullptr) {
+    return;
+  }
+  CacheEntryWriter writer;
+  writer.Put<std::uint64_t>(spReceptor->GetNumAtoms());
+  WriteReceptorSetup(writer);
+  std::string strKey = GetReceptorSetupKey();
+  if (pCache->SaveEntry(strKey, _SETUP_ENTRY, writer.GetBuffer())) {
+    LOG_F(INFO, "Saved receptor setup of {} to cache entry {}", GetFullName(),
+          pCache->GetEntryFileName(strKey, _SETUP_ENTRY));
+  }
+}
+
+AtomRList BaseIdxSF::GetReceptorAtomTable(ModelPtr spReceptor) {
+  AtomList atomList = spReceptor->GetAtomList();
+  AtomRList atomTable;
+  atomTable.reserve(atomList.size());
+  for (auto &spAtom : atomList) {
+    atomTable.push_back(spAtom.Ptr());
+  }
+  return atomTable;
+}
+
 // As this has a virtual base class we need a separate OwnParameterUpdated
 // which can be called by concrete subclass ParameterUpdated methods
 // See Stroustrup C++ 3rd edition, p395, on programming virtual base classes
@@ -132,6 +225,40 @@ void BaseIdxSF::OwnParameterUpdated(const std::string &strName) {
   }
 }
 
+// Receptor ensembles are not cached, as the setup of the indexed scoring
+// functions depends on all their coordinates
+const ModelCache *BaseIdxSF::GetReceptorSetupCache(ModelPtr spReceptor) const {
+  WorkSpace *pWorkSpace = GetWorkSpace();
+  if (pWorkSpace == nullptr || pWorkSpace->GetReceptorCache() == nullptr ||
+      pWorkSpace->GetDockingSite().Null() || spReceptor.Null() ||
+      spReceptor->GetNumSavedCoords() > 1) {
+    return nullptr;
+  }
+  return pWorkSpace->GetReceptorCache();
+}
+
+std::string BaseIdxSF::GetReceptorSetupKey() const {
+  WorkSpace *pWorkSpace = GetWorkSpace();
+  Hasher hasher;
+  hasher.Add(pWorkSpace->GetReceptorCacheKey());
+  hasher.Add(GetFullName());
+  const BaseSF *pRootSF = this;
+  while (pRootSF->GetParentSF() != nullptr) {
+    pRootSF = pRootSF->GetParentSF();
+  }
+  AddSF(hasher, pRootSF);
+  DockingSitePtr spDS = pWorkSpace->GetDockingSite();
+  AddValue(hasher, spDS->GetBorder());
+  AddCoord(hasher, spDS->GetMinCoord());
+  AddCoord(hasher, spDS->GetMaxCoord());
+  CoordList coords;
+  spDS->GetCoordList(coords);
+  for (const auto &c : coords) {
+    AddCoord(hasher, c);
+  }
+  return hasher.GetDigest();
+}
+
 void rxdock::to_json(json &j, const BaseIdxSF &baseIdxSF) {
   j = json{{"grid-step", baseIdxSF.m_gridStep}, {"border", baseIdxSF.m_border}};
 }
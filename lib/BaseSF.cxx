@@ -11,10 +11,13 @@
  ***********************************************************************/
 
 #include "rxdock/BaseSF.h"
+#include "rxdock/PoseBatch.h"
 #include "rxdock/SFRequest.h"
 
 #include <loguru.hpp>
 
+#include <algorithm>
+
 using namespace rxdock;
 
 // Static data members
@@ -72,6 +75,35 @@ double BaseSF::Score() const {
   return isEnabled() ? GetWeight() * RawScore() : 0.0;
 }
 
+double BaseSF::ScoreGradient(AtomGradientMap &gradient,
+                             BaseSFList &noGradList, double scale) const {
+  if (!isEnabled()) {
+    return 0.0;
+  }
+  double rs(0.0);
+  if (RawScoreGradient(rs, gradient, scale * GetWeight())) {
+    return GetWeight() * rs;
+  }
+  noGradList.push_back(const_cast<BaseSF *>(this));
+  return 0.0;
+}
+
+void BaseSF::ScoreBatch(const PoseBatch &poses, double *out) const {
+  std::size_t nPoses = poses.GetNumPoses();
+  if (!isEnabled()) {
+    std::fill(out, out + nPoses, 0.0);
+    return;
+  }
+  // Save the current pose, as the batch scoring moves the models around
+  PoseBatch current(poses.GetModelList(), 1);
+  RawScoreBatch(poses, out);
+  current.ApplyPose(0);
+  double w = GetWeight();
+  for (std::size_t i = 0; i < nPoses; i++) {
+    out[i] *= w;
+  }
+}
+
 // Returns all child component scores as a string-variant map
 // Key = fully qualified component name, value = weighted score
 //(for saving in a Model's data fields)
@@ -106,6 +138,21 @@ void BaseSF::AddToParentMapEntry(StringVariantMap &scoreMap, double rs) const {
   }
 }
 
+// No analytic gradient in base class
+bool BaseSF::RawScoreGradient(double &score, AtomGradientMap &gradient,
+                              double scale) const {
+  return false;
+}
+
+void BaseSF::RawScoreBatch(const PoseBatch &poses, double *out) const {
+  for (std::size_t i = 0; i < poses.GetNumPoses(); i++) {
+    poses.ApplyPose(i);
+    out[i] = RawScore();
+  }
+}
+
+bool BaseSF::isRawScoreBatched() const { return false; }
+
 // Aggregate handling (virtual) methods
 // Base class throws an InvalidRequest error
 
@@ -12,6 +12,7 @@
 
 #include "rxdock/BaseTransform.h"
 #include "rxdock/BaseSF.h"
+#include "rxdock/DockingError.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
@@ -53,6 +54,9 @@ void BaseTransform::Go() {
     // Send any stored Scoring Function requests (e.g. to change any params)
     SendSFRequests();
     Execute();
+    if (isAbortCheckDue(1.0)) {
+      CheckAbort();
+    }
   }
 }
 
@@ -86,6 +90,25 @@ void BaseTransform::Orphan() {
   }
 }
 
+// Abort handling
+bool BaseTransform::isAbortCheckDue(double progress) const {
+  WorkSpace *pWorkSpace = GetWorkSpace();
+  if (pWorkSpace == nullptr) {
+    return false;
+  }
+  BaseAbortPredicate *pAbortPredicate = pWorkSpace->GetAbortPredicate();
+  return (pAbortPredicate != nullptr) &&
+         pAbortPredicate->isCheckDue(this, progress);
+}
+
+void BaseTransform::CheckAbort() {
+  WorkSpace *pWorkSpace = GetWorkSpace();
+  BaseAbortPredicate *pAbortPredicate = pWorkSpace->GetAbortPredicate();
+  if (pAbortPredicate->Abort(this, pWorkSpace)) {
+    throw DockingAbort(_WHERE_, "Run abandoned by " + GetName());
+  }
+}
+
 // Scoring function request handling
 // Transforms can store up a list of requests to send to the workspace
 // scoring function each time Go() is executed
@@ -71,6 +71,12 @@ void BiMolWorkSpace::RemoveSolvent() {
 
 void BiMolWorkSpace::UpdateModelCoordsFromChromRecords(
     BaseMolecularFileSource *pSource) {
+  UpdateModelCoordsFromChromRecords(pSource->GetDataMap(),
+                                    pSource->GetFileName());
+}
+
+void BiMolWorkSpace::UpdateModelCoordsFromChromRecords(
+    const StringVariantMap &dataMap, const std::string &strSourceName) {
   int nModels = GetNumModels();
   for (int iModel = 0; iModel < nModels; iModel++) {
     // if (iModel == LIGAND) continue;
@@ -83,11 +89,12 @@ void BiMolWorkSpace::UpdateModelCoordsFromChromRecords(
           std::ostringstream ostr;
           ostr << GetMetaDataPrefix() << "chrom." << iModel;
           std::string chromField = ostr.str();
-          if (pSource->isDataFieldPresent(chromField)) {
+          StringVariantMapConstIter chromIter = dataMap.find(chromField);
+          if (chromIter != dataMap.end()) {
             // TODO: Move this code to Variant class
             // Concatenate the multi-record value into a single string
-            std::string chromRecord = ConvertListToDelimitedString(
-                pSource->GetDataValue(chromField), ",");
+            std::string chromRecord =
+                ConvertListToDelimitedString(chromIter->second, ",");
             // Now split into string values and convert to doubles
             std::vector<std::string> chromValues =
                 ConvertDelimitedStringToList(chromRecord, ",");
@@ -105,7 +112,7 @@ void BiMolWorkSpace::UpdateModelCoordsFromChromRecords(
             } else {
               LOG_F(INFO, "Mismatched chromosome sizes for model #{}", iModel);
               LOG_F(INFO, "{} record in {} has {} elements", chromField,
-                    pSource->GetFileName(), chromValues.size());
+                    strSourceName, chromValues.size());
               LOG_F(INFO, "Expected number of elements is {}", chromLength);
               LOG_F(INFO, "Model chromosome not updated");
             }
@@ -84,6 +84,41 @@ void CSVFileSink::Render() {
   }
 }
 
+void CSVFileSink::RenderRecord(const MdlRecord &record) {
+  AddLine(GetRecordLine(record));
+  Write();
+}
+
+std::string CSVFileSink::GetRecordLine(const MdlRecord &record) const {
+  std::string line = record.GetTitle() + ",";
+
+  // Write atoms, with the charges in the same convention as Render()
+  std::ostringstream oss;
+  std::size_t nAtoms = record.GetNumAtoms();
+  oss << nAtoms << ",";
+  std::string strElementName;
+  Coord coord;
+  int nFormalCharge;
+  std::size_t i = 0;
+  for (; i < nAtoms && i < m_nAtoms; i++) {
+    record.GetAtom(i, strElementName, coord, nFormalCharge);
+    if (nFormalCharge != 0)
+      nFormalCharge = 4 - nFormalCharge;
+    oss << strElementName << ",";
+    oss << coord.xyz(0) << "," << coord.xyz(1) << "," << coord.xyz(2) << ",";
+    oss << nFormalCharge << ",";
+  }
+  // Pad the model atoms, and the (empty) solvent atoms, as Render() does
+  for (; i < 2 * m_nAtoms; i++) {
+    oss << ",,,,,";
+  }
+  line += oss.str();
+
+  // Write data fields
+  line += RenderData(record.GetDataMap());
+  return line;
+}
+
 std::string CSVFileSink::RenderAtomList(const AtomList &atomList) {
   std::string atomLine;
   std::size_t i = 0;
@@ -111,7 +146,7 @@ std::string CSVFileSink::RenderAtomList(const AtomList &atomList) {
   return atomLine;
 }
 
-std::string CSVFileSink::RenderData(const StringVariantMap &dataMap) {
+std::string CSVFileSink::RenderData(const StringVariantMap &dataMap) const {
   std::string dataLine;
 
   std::ostringstream oss;
@@ -156,6 +156,15 @@ void Chrom::GetStepVector(std::vector<double> &v) const {
   }
 }
 
+void Chrom::GetGradientVector(const AtomGradientMap &gradient,
+                              std::vector<double> &v,
+                              std::vector<bool> &bProjected) const {
+  for (ChromElementListConstIter iter = m_elementList.begin();
+       iter != m_elementList.end(); ++iter) {
+    (*iter)->GetGradientVector(gradient, v, bProjected);
+  }
+}
+
 // Returns the maximum difference of any of the underlying chromosome elements
 // or -1 if there is a mismatch in vector sizes
 double Chrom::CompareVector(const std::vector<double> &v, int &i) const {
@@ -0,0 +1,134 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/ChromConformerElement.h"
+
+#include <cmath>
+
+using namespace rxdock;
+
+const std::string ChromConformerElement::_CT = "ChromConformerElement";
+
+ChromConformerElement::ChromConformerElement(Model *pModel, double stepSize)
+    : m_pModel(pModel), m_nConformers(pModel->GetNumSavedCoords() - 1),
+      m_stepSize(stepSize), m_initialValue(1), m_value(1) {
+  // Set the initial genotype to match the current phenotype
+  SyncFromModel();
+  m_initialValue = m_value;
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+ChromConformerElement::ChromConformerElement(Model *pModel, int nConformers,
+                                             double stepSize, int initialValue,
+                                             int value)
+    : m_pModel(pModel), m_nConformers(nConformers), m_stepSize(stepSize),
+      m_initialValue(initialValue), m_value(value) {
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+ChromConformerElement::~ChromConformerElement() {
+  _RBTOBJECTCOUNTER_DESTR_(_CT);
+}
+
+void ChromConformerElement::Reset() { m_value = m_initialValue; }
+
+void ChromConformerElement::Randomise() {
+  m_value = 1 + GetRand().GetRandomInt(m_nConformers);
+}
+
+void ChromConformerElement::Mutate(double relStepSize) {
+  if ((m_nConformers > 1) &&
+      (GetRand().GetRandom01() < relStepSize * m_stepSize)) {
+    // Pick one of the other N-1 conformers
+    int newValue = 1 + GetRand().GetRandomInt(m_nConformers - 1);
+    m_value = (newValue >= m_value) ? newValue + 1 : newValue;
+  }
+}
+
+void ChromConformerElement::SyncFromModel() {
+  m_value = StandardisedValue(m_pModel->GetCurrentCoords());
+}
+
+void ChromConformerElement::SyncToModel() {
+  m_pModel->SetCurrentConformer(m_value);
+}
+
+ChromElement *ChromConformerElement::clone() const {
+  return new ChromConformerElement(m_pModel, m_nConformers, m_stepSize,
+                                   m_initialValue, m_value);
+}
+
+void ChromConformerElement::GetVector(std::vector<double> &v) const {
+  v.push_back(m_value);
+}
+
+void ChromConformerElement::GetVector(XOverList &v) const {
+  XOverElement conformerElement;
+  conformerElement.push_back(m_value);
+  v.push_back(conformerElement);
+}
+
+void ChromConformerElement::SetVector(const std::vector<double> &v, int &i) {
+  if (VectorOK(v, i)) {
+    m_value = StandardisedValue(v[i++]);
+  } else {
+    throw BadArgument(_WHERE_,
+                      "Index out of range or insufficient elements remaining");
+  }
+}
+
+void ChromConformerElement::SetVector(const XOverList &v, int &i) {
+  if (VectorOK(v, i)) {
+    XOverElement conformerElement(v[i++]);
+    if (conformerElement.size() == 1) {
+      m_value = StandardisedValue(conformerElement[0]);
+    } else {
+      throw BadArgument(_WHERE_,
+                        "conformerElement vector is of incorrect length");
+    }
+  } else {
+    throw BadArgument(_WHERE_,
+                      "Index out of range or insufficient elements remaining");
+  }
+}
+
+// Continuous optimisers (e.g. simplex) see a step of one conformer
+void ChromConformerElement::GetStepVector(std::vector<double> &v) const {
+  v.push_back(1.0);
+}
+
+double ChromConformerElement::CompareVector(const std::vector<double> &v,
+                                            int &i) const {
+  double retVal(0.0);
+  if (!VectorOK(v, i)) {
+    retVal = -1.0;
+  } else {
+    // Different conformers are never considered equal
+    int otherValue = StandardisedValue(v[i++]);
+    retVal = (otherValue == m_value) ? 0.0 : 1.0;
+  }
+  return retVal;
+}
+
+void ChromConformerElement::Print(std::ostream &s) const {
+  s << "CONFORMER " << m_value << std::endl;
+}
+
+int ChromConformerElement::StandardisedValue(double value) const {
+  int iValue = static_cast<int>(std::lround(value));
+  if (iValue < 1) {
+    iValue = 1;
+  } else if (iValue > m_nConformers) {
+    iValue = m_nConformers;
+  }
+  return iValue;
+}
@@ -126,6 +126,13 @@ void ChromDihedralElement::GetStepVector(std::vector<double> &v) const {
   v.push_back(m_spRefData->GetStepSize());
 }
 
+void ChromDihedralElement::GetGradientVector(
+    const AtomGradientMap &gradient, std::vector<double> &v,
+    std::vector<bool> &bProjected) const {
+  v.push_back(m_spRefData->GetModelGradient(gradient));
+  bProjected.push_back(true);
+}
+
 double ChromDihedralElement::CompareVector(const std::vector<double> &v,
                                            int &i) const {
   double retVal(0.0);
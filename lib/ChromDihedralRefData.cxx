@@ -58,6 +58,21 @@ void ChromDihedralRefData::SetModelValue(double dihedralAngle) {
   }
 }
 
+double
+ChromDihedralRefData::GetModelGradient(const AtomGradientMap &gradient) const {
+  const Coord &coord1(m_atom2->GetCoords());
+  Vector torque;
+  for (AtomRListConstIter iter = m_rotAtoms.begin(); iter != m_rotAtoms.end();
+       ++iter) {
+    AtomGradientMap::const_iterator gIter = gradient.find(*iter);
+    if (gIter != gradient.end()) {
+      torque += Cross((*iter)->GetCoords() - coord1, gIter->second);
+    }
+  }
+  Vector axis = (m_atom3->GetCoords() - coord1).Unit();
+  return Dot(torque, axis) * M_PI / 180.0;
+}
+
 void ChromDihedralRefData::Setup(BondPtr spBond,
                                  const AtomList &tetheredAtoms) {
   Atom *pAtom2 = spBond->GetAtom1Ptr();
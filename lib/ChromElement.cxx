@@ -72,6 +72,14 @@ void ChromElement::Add(ChromElement *pChromElement) {
       "Add(ChromElement*) invalid for non-aggregate chromosome element");
 }
 
+void ChromElement::GetGradientVector(const AtomGradientMap &gradient,
+                                     std::vector<double> &v,
+                                     std::vector<bool> &bProjected) const {
+  int length = GetLength();
+  v.insert(v.end(), length, 0.0);
+  bProjected.insert(bProjected.end(), length, false);
+}
+
 bool ChromElement::VectorOK(const std::vector<double> &v,
                             unsigned int i) const {
   unsigned int length = GetLength();
@@ -12,6 +12,7 @@
 
 #include "rxdock/ChromFactory.h"
 #include "rxdock/Chrom.h"
+#include "rxdock/ChromConformerElement.h"
 #include "rxdock/ChromDihedralElement.h"
 #include "rxdock/ChromOccupancyElement.h"
 #include "rxdock/ChromPositionElement.h"
@@ -36,13 +37,21 @@ void ChromFactory::VisitReceptorFlexData(ReceptorFlexData *pFlexData) {
         pFlexData->GetParameter(ReceptorFlexData::_FLEX_DISTANCE);
     double dihedralStepSize =
         pFlexData->GetParameter(ReceptorFlexData::_DIHEDRAL_STEP);
-    // Trap the combination of flexible OH/NH3 AND multiple receptor
-    // conformations We do not support both of these simultaneously
+    // Multiple receptor conformations: the receptor conformer is sampled
+    // instead. Trap the combination of flexible OH/NH3 AND multiple receptor
+    // conformations. We do not support both of these simultaneously
     if (pModel->GetNumSavedCoords() > 1) {
-      std::string message(
-          "The combination of flexible OH/NH3 groups AND multiple receptor "
-          "conformations is not supported currently");
-      throw InvalidRequest(_WHERE_, message);
+      if (flexDistance > 0.0) {
+        std::string message(
+            "The combination of flexible OH/NH3 groups AND multiple receptor "
+            "conformations is not supported currently");
+        throw InvalidRequest(_WHERE_, message);
+      }
+      double conformerStepSize =
+          pFlexData->GetParameter(ReceptorFlexData::_CONFORMER_STEP);
+      m_pChrom->Add(new ChromConformerElement(pModel, conformerStepSize));
+      m_spMutator.SetNull();
+      return;
     }
 
     // Find all the terminal OH and NH3+ bonds within range of the docking
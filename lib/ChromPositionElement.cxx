@@ -257,6 +257,24 @@ void ChromPositionElement::SetVector(const XOverList &v, int &i) {
   }
 }
 
+void ChromPositionElement::GetGradientVector(
+    const AtomGradientMap &gradient, std::vector<double> &v,
+    std::vector<bool> &bProjected) const {
+  Vector comGradient;
+  Vector orientationGradient;
+  m_spRefData->GetModelGradient(gradient, m_com, m_orientation, comGradient,
+                                orientationGradient);
+  if (!m_spRefData->IsTransFixed()) {
+    v.insert(v.end(), comGradient.xyz.data(), comGradient.xyz.data() + 3);
+    bProjected.insert(bProjected.end(), 3, true);
+  }
+  if (!m_spRefData->IsRotFixed()) {
+    v.insert(v.end(), orientationGradient.xyz.data(),
+             orientationGradient.xyz.data() + 3);
+    bProjected.insert(bProjected.end(), 3, true);
+  }
+}
+
 void ChromPositionElement::GetStepVector(std::vector<double> &v) const {
   if (!m_spRefData->IsTransFixed()) {
     double transStepSize = m_spRefData->GetTransStepSize();
@@ -89,6 +89,36 @@ void ChromPositionRefData::SetModelValue(const Coord &com,
   }
 }
 
+void ChromPositionRefData::GetModelGradient(const AtomGradientMap &gradient,
+                                            const Coord &com,
+                                            const Euler &orientation,
+                                            Vector &comGradient,
+                                            Vector &orientationGradient) const {
+  Vector force;
+  Vector torque;
+  for (AtomRListConstIter iter = m_movableAtoms.begin();
+       iter != m_movableAtoms.end(); ++iter) {
+    AtomGradientMap::const_iterator gIter = gradient.find(*iter);
+    if (gIter != gradient.end()) {
+      force += gIter->second;
+      torque += Cross((*iter)->GetCoords() - com, gIter->second);
+    }
+  }
+  comGradient = force;
+  // Euler::ToQuat composes the rotations as bank (about x) * attitude (about
+  // y) * heading (about z), so the heading is applied first. Each angle
+  // rotates the atoms about its axis as moved by the rotations applied after
+  // it
+  Quat qBank = Euler(0.0, 0.0, orientation.GetBank()).ToQuat();
+  Quat qAttitude = Euler(0.0, orientation.GetAttitude(), 0.0).ToQuat();
+  Vector headingAxis = (qBank * qAttitude).Rotate(Vector(0.0, 0.0, 1.0));
+  Vector attitudeAxis = qBank.Rotate(Vector(0.0, 1.0, 0.0));
+  Vector bankAxis(1.0, 0.0, 0.0);
+  orientationGradient = Vector(Dot(torque, headingAxis),
+                               Dot(torque, attitudeAxis),
+                               Dot(torque, bankAxis));
+}
+
 void rxdock::to_json(json &j, const ChromPositionRefData &chrposrdata) {
   json atomList;
   for (const auto &aIter : chrposrdata.m_refAtoms) {
@@ -0,0 +1,647 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
+
+#ifdef RBT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef RBT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <loguru.hpp>
+
+using namespace rxdock;
+
+namespace {
+
+enum Compression { NONE, GZIP, ZSTD };
+
+bool endsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+Compression getCompression(const std::string &fileName) {
+  if (endsWith(fileName, ".gz")) {
+    return GZIP;
+  } else if (endsWith(fileName, ".zst")) {
+    return ZSTD;
+  }
+  return NONE;
+}
+
+// Size of the compressed and decompressed buffers of input streams
+const std::size_t _INPUT_BUFFER_SIZE = 256 << 10;
+
+// Reads a compressed file and decompresses it into its get area. Derived
+// classes decode the compressed data. An exception thrown out of underflow()
+// would only set the badbit of the stream, so a decompression error ends the
+// input and is kept for CheckError()
+class DecompressBuf : public std::streambuf {
+public:
+  DecompressBuf()
+      : m_fileOffset(0), m_in(_INPUT_BUFFER_SIZE), m_inNext(nullptr),
+        m_inAvail(0), m_bInEOF(false), m_out(_INPUT_BUFFER_SIZE),
+        m_outStart(0) {
+    setg(m_out.data(), m_out.data(), m_out.data());
+  }
+
+  bool Open(const std::string &fileName) {
+    m_fileName = fileName;
+    return m_file.open(fileName, std::ios_base::in | std::ios_base::binary) !=
+           nullptr;
+  }
+
+  std::size_t GetFileOffset() const { return m_fileOffset - m_inAvail; }
+
+  void CheckError() const {
+    if (m_error) {
+      std::rethrow_exception(m_error);
+    }
+  }
+
+protected:
+  // Decodes from the compressed input at m_inNext into out, consuming the
+  // input it uses. Returns the number of bytes written to out, which may be
+  // zero if the input only holds headers
+  virtual std::size_t Decode(char *out, std::size_t outSize) = 0;
+  // True if the input decoded so far ends at the end of a gzip member or
+  // zstd frame
+  virtual bool isFrameComplete() const = 0;
+  virtual void ResetDecoder() = 0;
+
+  void Consume(std::size_t n) {
+    m_inNext += n;
+    m_inAvail -= n;
+  }
+
+  virtual int_type underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    } else if (m_error) {
+      return traits_type::eof();
+    }
+    try {
+      return Fill();
+    } catch (Error &) {
+      m_error = std::current_exception();
+      setg(m_out.data(), m_out.data(), m_out.data());
+      return traits_type::eof();
+    }
+  }
+
+  // Decompresses the next data into the get area
+  int_type Fill() {
+    m_outStart += egptr() - eback();
+    setg(m_out.data(), m_out.data(), m_out.data());
+    for (;;) {
+      if (m_inAvail == 0 && !m_bInEOF) {
+        m_inAvail = m_file.sgetn(m_in.data(), m_in.size());
+        m_inNext = m_in.data();
+        m_fileOffset += m_inAvail;
+        m_bInEOF = (m_inAvail == 0);
+      }
+      if (m_inAvail == 0 && m_bInEOF) {
+        if (!isFrameComplete()) {
+          throw FileReadError(_WHERE_, "Truncated compressed file " +
+                                           m_fileName);
+        }
+        return traits_type::eof();
+      }
+      std::size_t n = Decode(m_out.data(), m_out.size());
+      if (n > 0) {
+        setg(m_out.data(), m_out.data(), m_out.data() + n);
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+  }
+
+  virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                           std::ios_base::openmode which) {
+    std::uint64_t pos = m_outStart + (gptr() - eback());
+    if (dir == std::ios_base::cur) {
+      return (off == 0) ? pos_type(pos) : seekpos(pos + off, which);
+    } else if (dir == std::ios_base::beg) {
+      return seekpos(off, which);
+    }
+    return pos_type(off_type(-1)); // The decompressed size is not known
+  }
+
+  virtual pos_type seekpos(pos_type sp, std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in) || sp < 0) {
+      return pos_type(off_type(-1));
+    }
+    std::uint64_t target = static_cast<std::uint64_t>(off_type(sp));
+    if (target < m_outStart) {
+      // Start again from the beginning of the file
+      if (m_file.pubseekpos(0, std::ios_base::in) != pos_type(0)) {
+        return pos_type(off_type(-1));
+      }
+      m_inAvail = 0;
+      m_bInEOF = false;
+      m_fileOffset = 0;
+      m_outStart = 0;
+      setg(m_out.data(), m_out.data(), m_out.data());
+      ResetDecoder();
+    }
+    while (target > m_outStart + (egptr() - eback())) {
+      setg(eback(), egptr(), egptr());
+      if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+        return pos_type(off_type(-1));
+      }
+    }
+    setg(eback(), eback() + (target - m_outStart), egptr());
+    return sp;
+  }
+
+  std::string m_fileName;
+  std::filebuf m_file;
+  std::size_t m_fileOffset; // Bytes read from m_file
+  std::vector<char> m_in;
+  const char *m_inNext; // Compressed input not yet decoded
+  std::size_t m_inAvail;
+  bool m_bInEOF;
+  std::vector<char> m_out;
+  std::uint64_t m_outStart; // Position of eback() in the decompressed data
+  std::exception_ptr m_error;
+};
+
+// Buffers the data written to it and compresses it into a file. Derived
+// classes compress the buffered data. The buffer is compressed when the
+// stream is flushed, which writers do at the end of each record, once it holds
+// at least blockSize bytes. Until then it grows up to maxSize bytes, so that
+// records are not split between blocks. As with input, errors are kept for
+// CheckError() rather than thrown through the stream
+class CompressBuf : public std::streambuf {
+public:
+  CompressBuf(std::size_t blockSize, std::size_t maxSize)
+      : m_blockSize(blockSize), m_maxSize(maxSize), m_buf(blockSize) {
+    setp(m_buf.data(), m_buf.data() + m_buf.size());
+  }
+
+  bool Open(const std::string &fileName, bool bAppend) {
+    m_fileName = fileName;
+    std::ios_base::openmode mode = std::ios_base::out | std::ios_base::binary;
+    mode |= bAppend ? std::ios_base::app : std::ios_base::trunc;
+    return m_file.open(fileName, mode) != nullptr;
+  }
+
+  // Compresses the remaining data and closes the file
+  void Finish() {
+    if (!m_error) {
+      try {
+        Compress(pbase(), pptr() - pbase(), true);
+      } catch (Error &) {
+        m_error = std::current_exception();
+      }
+    }
+    setp(m_buf.data(), m_buf.data() + m_buf.size());
+    bool bClosed = m_file.close() != nullptr;
+    CheckError();
+    if (!bClosed) {
+      throw FileWriteError(_WHERE_, "Error writing " + m_fileName);
+    }
+  }
+
+  void CheckError() const {
+    if (m_error) {
+      std::rethrow_exception(m_error);
+    }
+  }
+
+protected:
+  // Compresses n bytes of data, ending the compressed data if bEnd
+  virtual void Compress(const char *data, std::size_t n, bool bEnd) = 0;
+
+  void WriteFile(const char *data, std::size_t n) {
+    if (m_file.sputn(data, n) != static_cast<std::streamsize>(n)) {
+      throw FileWriteError(_WHERE_, "Error writing " + m_fileName);
+    }
+  }
+
+  virtual int_type overflow(int_type c) {
+    std::size_t n = pptr() - pbase();
+    if (m_buf.size() < m_maxSize) {
+      m_buf.resize(std::min(2 * m_buf.size(), m_maxSize));
+      setp(m_buf.data(), m_buf.data() + m_buf.size());
+      pbump(static_cast<int>(n));
+    } else if (!CompressBuffer()) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  virtual int sync() {
+    std::size_t n = pptr() - pbase();
+    return (n < m_blockSize || CompressBuffer()) ? 0 : -1;
+  }
+
+  std::string m_fileName;
+
+private:
+  bool CompressBuffer() {
+    if (m_error) {
+      return false;
+    }
+    try {
+      Compress(pbase(), pptr() - pbase(), false);
+    } catch (Error &) {
+      m_error = std::current_exception();
+    }
+    setp(m_buf.data(), m_buf.data() + m_buf.size());
+    return !m_error;
+  }
+
+  std::size_t m_blockSize;
+  std::size_t m_maxSize;
+  std::filebuf m_file;
+  std::vector<char> m_buf;
+  std::exception_ptr m_error;
+};
+
+#ifdef RBT_HAVE_ZLIB
+// Gzip input, possibly of several concatenated members
+class GzipDecompressBuf : public DecompressBuf {
+public:
+  GzipDecompressBuf() : m_bInMember(false) {
+    m_zs.zalloc = Z_NULL;
+    m_zs.zfree = Z_NULL;
+    m_zs.opaque = Z_NULL;
+    m_zs.next_in = Z_NULL;
+    m_zs.avail_in = 0;
+    // Gzip header and trailer only
+    if (inflateInit2(&m_zs, 15 + 16) != Z_OK) {
+      throw FileReadError(_WHERE_, "Error initialising gzip decompression");
+    }
+  }
+  virtual ~GzipDecompressBuf() { inflateEnd(&m_zs); }
+
+protected:
+  virtual std::size_t Decode(char *out, std::size_t outSize) {
+    m_zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(m_inNext));
+    m_zs.avail_in = static_cast<uInt>(m_inAvail);
+    m_zs.next_out = reinterpret_cast<Bytef *>(out);
+    m_zs.avail_out = static_cast<uInt>(outSize);
+    int ret = inflate(&m_zs, Z_NO_FLUSH);
+    std::size_t nConsumed = m_inAvail - m_zs.avail_in;
+    std::size_t nProduced = outSize - m_zs.avail_out;
+    Consume(nConsumed);
+    if (ret == Z_STREAM_END) {
+      // The next member, if any, starts with a new header
+      m_bInMember = false;
+      inflateReset(&m_zs);
+    } else if (ret == Z_OK && (nConsumed > 0 || nProduced > 0)) {
+      m_bInMember = true;
+    } else {
+      throw FileReadError(_WHERE_, "Error decompressing " + m_fileName +
+                                       ": " +
+                                       (m_zs.msg ? m_zs.msg : "invalid data"));
+    }
+    return nProduced;
+  }
+  virtual bool isFrameComplete() const { return !m_bInMember; }
+  virtual void ResetDecoder() {
+    inflateReset(&m_zs);
+    m_bInMember = false;
+  }
+
+private:
+  z_stream m_zs;
+  bool m_bInMember; // True if a member has been started but not ended
+};
+
+// Size of the blocks compressed into independent gzip members. A block ends
+// at the first record boundary after this size, or at twice this size
+const std::size_t _GZIP_BLOCK_SIZE = 1 << 20;
+
+// Gzip output. Each block is compressed into an independent gzip member by a
+// background thread while the next block is filled. Members are written in
+// order as soon as they are compressed, with at most one block per hardware
+// thread waiting
+class GzipCompressBuf : public CompressBuf {
+public:
+  GzipCompressBuf()
+      : CompressBuf(_GZIP_BLOCK_SIZE, 2 * _GZIP_BLOCK_SIZE),
+        m_maxPending(std::max(1u, std::thread::hardware_concurrency())) {}
+
+protected:
+  virtual void Compress(const char *data, std::size_t n, bool bEnd) {
+    if (n > 0) {
+      m_pending.push_back(std::async(std::launch::async, CompressBlock,
+                                     std::vector<char>(data, data + n),
+                                     m_fileName));
+    }
+    while (!m_pending.empty() &&
+           (bEnd || m_pending.size() > m_maxPending ||
+            m_pending.front().wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready)) {
+      // Rethrows any compression error
+      std::vector<char> member = m_pending.front().get();
+      m_pending.pop_front();
+      WriteFile(member.data(), member.size());
+    }
+  }
+
+private:
+  static std::vector<char> CompressBlock(const std::vector<char> &block,
+                                         const std::string &fileName) {
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree = Z_NULL;
+    zs.opaque = Z_NULL;
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw FileWriteError(_WHERE_, "Error initialising gzip compression");
+    }
+    std::vector<char> member(
+        deflateBound(&zs, static_cast<uLong>(block.size())));
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(block.data()));
+    zs.avail_in = static_cast<uInt>(block.size());
+    zs.next_out = reinterpret_cast<Bytef *>(member.data());
+    zs.avail_out = static_cast<uInt>(member.size());
+    int ret = deflate(&zs, Z_FINISH);
+    member.resize(zs.total_out);
+    deflateEnd(&zs);
+    if (ret != Z_STREAM_END) {
+      throw FileWriteError(_WHERE_, "Error compressing " + fileName);
+    }
+    return member;
+  }
+
+  std::size_t m_maxPending;
+  std::deque<std::future<std::vector<char>>> m_pending;
+};
+#endif // RBT_HAVE_ZLIB
+
+#ifdef RBT_HAVE_ZSTD
+// Zstandard input, possibly of several concatenated frames
+class ZstdDecompressBuf : public DecompressBuf {
+public:
+  ZstdDecompressBuf() : m_ds(ZSTD_createDCtx()), m_bInFrame(false) {
+    if (m_ds == nullptr) {
+      throw FileReadError(_WHERE_, "Error initialising zstd decompression");
+    }
+  }
+  virtual ~ZstdDecompressBuf() { ZSTD_freeDCtx(m_ds); }
+
+protected:
+  virtual std::size_t Decode(char *out, std::size_t outSize) {
+    ZSTD_inBuffer in = {m_inNext, m_inAvail, 0};
+    ZSTD_outBuffer output = {out, outSize, 0};
+    std::size_t ret = ZSTD_decompressStream(m_ds, &output, &in);
+    if (ZSTD_isError(ret)) {
+      throw FileReadError(_WHERE_, "Error decompressing " + m_fileName +
+                                       ": " + ZSTD_getErrorName(ret));
+    }
+    Consume(in.pos);
+    // Zero once a frame is completely decoded and flushed
+    m_bInFrame = (ret != 0);
+    return output.pos;
+  }
+  virtual bool isFrameComplete() const { return !m_bInFrame; }
+  virtual void ResetDecoder() {
+    ZSTD_DCtx_reset(m_ds, ZSTD_reset_session_only);
+    m_bInFrame = false;
+  }
+
+private:
+  ZSTD_DCtx *m_ds;
+  bool m_bInFrame;
+};
+
+// Zstandard output, compressed by the zstd worker threads (if libzstd has
+// been built with multithreading support)
+class ZstdCompressBuf : public CompressBuf {
+public:
+  ZstdCompressBuf()
+      : CompressBuf(ZSTD_CStreamInSize(), ZSTD_CStreamInSize()),
+        m_cs(ZSTD_createCCtx()),
+        m_out(ZSTD_CStreamOutSize()) {
+    if (m_cs == nullptr) {
+      throw FileWriteError(_WHERE_, "Error initialising zstd compression");
+    }
+    ZSTD_CCtx_setParameter(m_cs, ZSTD_c_compressionLevel, 3);
+    // Gzip members carry a CRC; the frame checksum lets corrupt zstd data be
+    // detected too
+    ZSTD_CCtx_setParameter(m_cs, ZSTD_c_checksumFlag, 1);
+    // Fails without multithreading support, in which case compression is
+    // done by the calling thread
+    int nWorkers = static_cast<int>(std::thread::hardware_concurrency());
+    ZSTD_CCtx_setParameter(m_cs, ZSTD_c_nbWorkers, nWorkers);
+  }
+  virtual ~ZstdCompressBuf() { ZSTD_freeCCtx(m_cs); }
+
+protected:
+  virtual void Compress(const char *data, std::size_t n, bool bEnd) {
+    ZSTD_inBuffer in = {data, n, 0};
+    ZSTD_EndDirective mode = bEnd ? ZSTD_e_end : ZSTD_e_continue;
+    bool bDone = false;
+    while (!bDone) {
+      ZSTD_outBuffer output = {m_out.data(), m_out.size(), 0};
+      std::size_t remaining = ZSTD_compressStream2(m_cs, &output, &in, mode);
+      if (ZSTD_isError(remaining)) {
+        throw FileWriteError(_WHERE_, "Error compressing " + m_fileName +
+                                          ": " + ZSTD_getErrorName(remaining));
+      }
+      WriteFile(m_out.data(), output.pos);
+      bDone = bEnd ? (remaining == 0) : (in.pos == in.size);
+    }
+  }
+
+private:
+  ZSTD_CCtx *m_cs;
+  std::vector<char> m_out;
+};
+#endif // RBT_HAVE_ZSTD
+
+} // namespace
+
+bool rxdock::isCompressedFileName(const std::string &fileName) {
+  return getCompression(fileName) != NONE;
+}
+
+InputFileStream::InputFileStream()
+    : std::istream(nullptr), m_bCompressed(false) {}
+
+InputFileStream::InputFileStream(const std::string &fileName)
+    : std::istream(nullptr), m_bCompressed(false) {
+  Open(fileName);
+}
+
+InputFileStream::~InputFileStream() { Close(); }
+
+void InputFileStream::Open(const std::string &fileName) {
+  Close();
+  m_fileName = fileName;
+  Compression compression = getCompression(fileName);
+  m_bCompressed = (compression != NONE);
+  bool bOpen = false;
+  if (compression == NONE) {
+    std::filebuf *pFileBuf = new std::filebuf();
+    m_spBuf.reset(pFileBuf);
+    bOpen = pFileBuf->open(fileName, std::ios_base::in) != nullptr;
+  } else {
+    DecompressBuf *pDecompressBuf = nullptr;
+#ifdef RBT_HAVE_ZLIB
+    if (compression == GZIP) {
+      pDecompressBuf = new GzipDecompressBuf();
+    }
+#endif
+#ifdef RBT_HAVE_ZSTD
+    if (compression == ZSTD) {
+      pDecompressBuf = new ZstdDecompressBuf();
+    }
+#endif
+    if (pDecompressBuf == nullptr) {
+      throw FileReadError(_WHERE_, "Cannot read " + fileName +
+                                       ", rxdock has been built without "
+                                       "support for its compression");
+    }
+    m_spBuf.reset(pDecompressBuf);
+    bOpen = pDecompressBuf->Open(fileName);
+  }
+  if (bOpen) {
+    rdbuf(m_spBuf.get());
+  } else {
+    m_spBuf.reset();
+    setstate(std::ios_base::failbit);
+  }
+}
+
+void InputFileStream::Close() {
+  if (m_spBuf) {
+    rdbuf(nullptr);
+    m_spBuf.reset();
+  }
+}
+
+std::size_t InputFileStream::GetFileOffset() {
+  if (!m_spBuf) {
+    return 0;
+  } else if (m_bCompressed) {
+    return static_cast<DecompressBuf *>(m_spBuf.get())->GetFileOffset();
+  }
+  return static_cast<std::size_t>(m_spBuf->pubseekoff(0, std::ios_base::cur));
+}
+
+void InputFileStream::CheckError() const {
+  if (!m_spBuf) {
+    return;
+  } else if (m_bCompressed) {
+    static_cast<DecompressBuf *>(m_spBuf.get())->CheckError();
+  }
+  if (bad()) {
+    throw FileReadError(_WHERE_, "Error reading " + m_fileName);
+  }
+}
+
+OutputFileStream::OutputFileStream() : std::ostream(nullptr) {}
+
+OutputFileStream::OutputFileStream(const std::string &fileName, bool bAppend)
+    : std::ostream(nullptr) {
+  Open(fileName, bAppend);
+}
+
+OutputFileStream::~OutputFileStream() {
+  try {
+    Close();
+  } catch (Error &e) {
+    LOG_F(ERROR, "{}", e.what());
+  }
+}
+
+void OutputFileStream::Open(const std::string &fileName, bool bAppend) {
+  Close();
+  m_fileName = fileName;
+  Compression compression = getCompression(fileName);
+  bool bOpen = false;
+  if (compression == NONE) {
+    std::ios_base::openmode mode = std::ios_base::out;
+    if (bAppend) {
+      mode |= std::ios_base::app;
+    }
+    std::filebuf *pFileBuf = new std::filebuf();
+    m_spBuf.reset(pFileBuf);
+    bOpen = pFileBuf->open(fileName, mode) != nullptr;
+  } else {
+    CompressBuf *pCompressBuf = nullptr;
+#ifdef RBT_HAVE_ZLIB
+    if (compression == GZIP) {
+      pCompressBuf = new GzipCompressBuf();
+    }
+#endif
+#ifdef RBT_HAVE_ZSTD
+    if (compression == ZSTD) {
+      pCompressBuf = new ZstdCompressBuf();
+    }
+#endif
+    if (pCompressBuf == nullptr) {
+      throw FileWriteError(_WHERE_, "Cannot write " + fileName +
+                                        ", rxdock has been built without "
+                                        "support for its compression");
+    }
+    m_spBuf.reset(pCompressBuf);
+    bOpen = pCompressBuf->Open(fileName, bAppend);
+  }
+  if (bOpen) {
+    rdbuf(m_spBuf.get());
+  } else {
+    m_spBuf.reset();
+    setstate(std::ios_base::failbit);
+  }
+}
+
+void OutputFileStream::Close() {
+  if (!m_spBuf) {
+    return;
+  }
+  // Release the buffer even if the remaining data cannot be written
+  std::unique_ptr<std::streambuf> spBuf(std::move(m_spBuf));
+  bool bOK = !bad();
+  rdbuf(nullptr);
+  if (getCompression(m_fileName) == NONE) {
+    bOK = static_cast<std::filebuf *>(spBuf.get())->close() != nullptr && bOK;
+  } else {
+    static_cast<CompressBuf *>(spBuf.get())->Finish();
+  }
+  if (!bOK) {
+    throw FileWriteError(_WHERE_, "Error writing " + m_fileName);
+  }
+}
+
+void OutputFileStream::CheckError() const {
+  if (!m_spBuf) {
+    return;
+  } else if (getCompression(m_fileName) != NONE) {
+    static_cast<CompressBuf *>(m_spBuf.get())->CheckError();
+  }
+  if (bad()) {
+    throw FileWriteError(_WHERE_, "Error writing " + m_fileName);
+  }
+}
@@ -12,7 +12,16 @@
 
 #include "rxdock/DockingSite.h"
 #include "rxdock/FileError.h"
+#include <cstdint>
 #include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include <loguru.hpp>
 
@@ -40,8 +49,61 @@ public:
 
 } // namespace rxdock
 
+namespace {
+
+// Sequential reader over a binary docking site buffer
+class DockingSiteBinReader {
+public:
+  DockingSiteBinReader(const char *pData, std::size_t nBytes)
+      : m_pData(pData), m_nBytes(nBytes), m_pos(0) {}
+
+  template <typename T> T Read() {
+    T val;
+    ReadArray(&val, 1);
+    return val;
+  }
+
+  Coord ReadCoord() {
+    double xyz[3];
+    ReadArray(xyz, 3);
+    return Coord(xyz[0], xyz[1], xyz[2]);
+  }
+
+  template <typename T> void ReadArray(T *pVal, std::size_t n) {
+    std::memcpy(pVal, Skip(n * sizeof(T)), n * sizeof(T));
+  }
+
+  // Returns the current position in the buffer and moves past nBytes
+  const char *Skip(std::size_t nBytes) {
+    if (nBytes > m_nBytes - m_pos) {
+      throw FileReadError(_WHERE_, "Truncated binary docking site data");
+    }
+    const char *pPos = m_pData + m_pos;
+    m_pos += nBytes;
+    return pPos;
+  }
+
+private:
+  const char *m_pData;
+  std::size_t m_nBytes;
+  std::size_t m_pos;
+};
+
+template <typename T> void WriteBin(std::ostream &ostr, const T &val) {
+  WriteWithThrow(ostr, reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+void WriteBinCoord(std::ostream &ostr, const Coord &c) {
+  double xyz[3] = {c.xyz(0), c.xyz(1), c.xyz(2)};
+  WriteWithThrow(ostr, reinterpret_cast<const char *>(xyz), sizeof(xyz));
+}
+
+} // namespace
+
 // Static data members
 const std::string DockingSite::_CT = "DockingSite";
+const char DockingSite::_BIN_MAGIC[8] = {'R', 'X', 'D', 'S', 'I', 'T', 'E', 0};
+const unsigned int DockingSite::_BIN_VERSION = 2;
 
 // STL predicate for selecting atoms within a defined distance range from
 // nearest cavity coords Uses precalculated distance grid
@@ -81,6 +143,79 @@ DockingSite::DockingSite(json j) {
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
+// Binary layout (native byte order, checked by the byte order marker):
+// magic[8], uint32 version, uint32 byte order marker, uint64 JSON file size,
+// int64 JSON file modification time, double border, double minCoord[3],
+// double maxCoord[3], uint64 nCavities,
+// per cavity: double gridStep[3], uint64 nCoords, double coords[3 * nCoords]
+// uint32 hasGrid, if set: int32 nXYZMin[3], double gridStep[3],
+// uint32 NX, NY, NZ, NPad, double tolerance, float data[NX * NY * NZ]
+// The fields are sized so that the grid data starts 8 byte aligned, which
+// lets the distance grid use a memory-mapped file in place
+DockingSite::DockingSite(const char *pData, std::size_t nBytes,
+                         std::shared_ptr<const void> spOwner) {
+  DockingSiteBinReader reader(pData, nBytes);
+  char magic[sizeof(_BIN_MAGIC)];
+  reader.ReadArray(magic, sizeof(magic));
+  if (std::memcmp(magic, _BIN_MAGIC, sizeof(magic)) != 0) {
+    throw FileParseError(_WHERE_, "Not a binary docking site file");
+  }
+  std::uint32_t version = reader.Read<std::uint32_t>();
+  std::uint32_t byteOrder = reader.Read<std::uint32_t>();
+  if (version != _BIN_VERSION || byteOrder != 0x01020304) {
+    throw FileParseError(
+        _WHERE_, "Incompatible binary docking site file (version or byte "
+                 "order); rerun cavity-search to regenerate it");
+  }
+  // Size and modification time of the JSON file, see isBinaryUpToDate
+  reader.Skip(sizeof(std::uint64_t) + sizeof(std::int64_t));
+  m_border = reader.Read<double>();
+  m_minCoord = reader.ReadCoord();
+  m_maxCoord = reader.ReadCoord();
+
+  std::uint64_t nCavities = reader.Read<std::uint64_t>();
+  m_cavityList.reserve(nCavities);
+  std::vector<double> xyz;
+  for (std::uint64_t i = 0; i < nCavities; i++) {
+    Vector gridStep = reader.ReadCoord();
+    std::uint64_t nCoords = reader.Read<std::uint64_t>();
+    xyz.resize(3 * nCoords);
+    reader.ReadArray(xyz.data(), xyz.size());
+    CoordList coordList;
+    coordList.reserve(nCoords);
+    for (std::uint64_t j = 0; j < nCoords; j++) {
+      coordList.push_back(Coord(xyz[3 * j], xyz[3 * j + 1], xyz[3 * j + 2]));
+    }
+    m_cavityList.push_back(CavityPtr(new Cavity(coordList, gridStep)));
+  }
+
+  if (reader.Read<std::uint32_t>()) {
+    std::int32_t nXYZMin[3];
+    reader.ReadArray(nXYZMin, 3);
+    Vector gridStep = reader.ReadCoord();
+    std::uint32_t nXYZPad[4];
+    reader.ReadArray(nXYZPad, 4);
+    double tol = reader.Read<double>();
+    // Pass the grid min as an exact multiple of the grid step so that the
+    // integral grid coords are reproduced without rounding errors
+    Coord gridMin = Coord(nXYZMin[0], nXYZMin[1], nXYZMin[2]) * gridStep;
+    BaseGrid grid(gridMin, gridStep, nXYZPad[0], nXYZPad[1], nXYZPad[2],
+                  nXYZPad[3]);
+    const char *pGridData = reader.Skip(grid.GetN() * sizeof(float));
+    if (spOwner != nullptr &&
+        reinterpret_cast<std::uintptr_t>(pGridData) % alignof(float) == 0) {
+      m_spGrid = RealGridPtr(new RealGrid(
+          grid, reinterpret_cast<const float *>(pGridData), tol, spOwner));
+    } else {
+      m_spGrid = RealGridPtr(new RealGrid(grid));
+      m_spGrid->SetTolerance(tol);
+      std::memcpy(m_spGrid->GetGridData(), pGridData,
+                  grid.GetN() * sizeof(float));
+    }
+  }
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
 DockingSite::~DockingSite() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
 
 // Insertion operator
@@ -98,6 +233,93 @@ void DockingSite::Print(std::ostream &s) const {
   }
 }
 
+void DockingSite::WriteBinary(std::ostream &ostr,
+                              const std::string &strJSONFile) const {
+  std::uint64_t jsonSize = 0;
+  std::int64_t jsonTime = 0;
+  struct stat fileStat;
+  if (!strJSONFile.empty() && stat(strJSONFile.c_str(), &fileStat) == 0) {
+    jsonSize = fileStat.st_size;
+    jsonTime = fileStat.st_mtime;
+  }
+  WriteWithThrow(ostr, _BIN_MAGIC, sizeof(_BIN_MAGIC));
+  WriteBin<std::uint32_t>(ostr, _BIN_VERSION);
+  WriteBin<std::uint32_t>(ostr, 0x01020304);
+  WriteBin<std::uint64_t>(ostr, jsonSize);
+  WriteBin<std::int64_t>(ostr, jsonTime);
+  WriteBin<double>(ostr, m_border);
+  WriteBinCoord(ostr, m_minCoord);
+  WriteBinCoord(ostr, m_maxCoord);
+
+  WriteBin<std::uint64_t>(ostr, m_cavityList.size());
+  std::vector<double> xyz;
+  for (const auto &cIter : m_cavityList) {
+    const CoordList &coordList = cIter->GetCoordList();
+    WriteBinCoord(ostr, cIter->GetGridStep());
+    WriteBin<std::uint64_t>(ostr, coordList.size());
+    xyz.clear();
+    xyz.reserve(3 * coordList.size());
+    for (const auto &c : coordList) {
+      xyz.push_back(c.xyz(0));
+      xyz.push_back(c.xyz(1));
+      xyz.push_back(c.xyz(2));
+    }
+    WriteWithThrow(ostr, reinterpret_cast<const char *>(xyz.data()),
+                   xyz.size() * sizeof(double));
+  }
+
+  // The grid is only missing if there are no cavities, see CreateGrid
+  WriteBin<std::uint32_t>(ostr, m_spGrid.Null() ? 0 : 1);
+  if (!m_spGrid.Null()) {
+    std::int32_t nXYZMin[3] = {m_spGrid->GetnXMin(), m_spGrid->GetnYMin(),
+                               m_spGrid->GetnZMin()};
+    WriteWithThrow(ostr, reinterpret_cast<const char *>(nXYZMin),
+                   sizeof(nXYZMin));
+    WriteBinCoord(ostr, m_spGrid->GetGridStep());
+    std::uint32_t nXYZPad[4] = {m_spGrid->GetNX(), m_spGrid->GetNY(),
+                                m_spGrid->GetNZ(), m_spGrid->GetPad()};
+    WriteWithThrow(ostr, reinterpret_cast<const char *>(nXYZPad),
+                   sizeof(nXYZPad));
+    WriteBin<double>(ostr, m_spGrid->GetTolerance());
+    WriteWithThrow(ostr,
+                   reinterpret_cast<const char *>(m_spGrid->GetGridData()),
+                   m_spGrid->GetN() * sizeof(float));
+  }
+}
+
+bool DockingSite::isBinaryUpToDate(const std::string &strBinFile,
+                                   const std::string &strJSONFile) {
+  std::ifstream binFile(strBinFile.c_str(),
+                        std::ios_base::in | std::ios_base::binary);
+  if (!binFile) {
+    return false;
+  }
+  struct stat fileStat;
+  if (stat(strJSONFile.c_str(), &fileStat) != 0) {
+    return true;
+  }
+  char header[sizeof(_BIN_MAGIC) + 2 * sizeof(std::uint32_t) +
+              sizeof(std::uint64_t) + sizeof(std::int64_t)];
+  binFile.read(header, sizeof(header));
+  if (binFile) {
+    DockingSiteBinReader reader(header, sizeof(header));
+    reader.Skip(sizeof(_BIN_MAGIC));
+    std::uint32_t version = reader.Read<std::uint32_t>();
+    std::uint32_t byteOrder = reader.Read<std::uint32_t>();
+    std::uint64_t jsonSize = reader.Read<std::uint64_t>();
+    std::int64_t jsonTime = reader.Read<std::int64_t>();
+    if (std::memcmp(header, _BIN_MAGIC, sizeof(_BIN_MAGIC)) == 0 &&
+        version == _BIN_VERSION && byteOrder == 0x01020304 &&
+        jsonSize == static_cast<std::uint64_t>(fileStat.st_size) &&
+        jsonTime == static_cast<std::int64_t>(fileStat.st_mtime)) {
+      return true;
+    }
+  }
+  LOG_F(WARNING, "Ignoring binary docking site file {}, as it is older than {}",
+        strBinFile, strJSONFile);
+  return false;
+}
+
 // Return distance grid, calculated on demand if necessary
 RealGridPtr DockingSite::GetGrid() {
   if (m_spGrid.Null()) {
@@ -122,12 +344,12 @@ void DockingSite::GetCoordList(CoordList &retVal) const {
     const CoordList &cavCoords = iter->GetCoordList();
     retVal.reserve(retVal.size() + cavCoords.size());
     std::copy(cavCoords.begin(), cavCoords.end(), std::back_inserter(retVal));
-    // Sort the coords so we can remove any dups
-    std::sort(retVal.begin(), retVal.end(), CoordCmp());
-    CoordListIter uniqIter = std::unique(retVal.begin(), retVal.end());
-    retVal.erase(uniqIter, retVal.end());
     LOG_F(1, "Cav = {}; total = {}", cavCoords.size(), retVal.size());
   }
+  // Sort the coords so we can remove any dups
+  std::sort(retVal.begin(), retVal.end(), CoordCmp());
+  CoordListIter uniqIter = std::unique(retVal.begin(), retVal.end());
+  retVal.erase(uniqIter, retVal.end());
 }
 
 // Filters an atom list according to distance from the cavity coords
@@ -198,31 +420,35 @@ void DockingSite::CreateGrid() {
   m_spGrid->SetAllValues(999999.9);
 
   // Get the total list of cavity coords
+  std::size_t nCoords(0);
+  for (auto &iter : m_cavityList) {
+    nCoords += iter->GetCoordList().size();
+  }
   CoordList allCoords;
+  allCoords.reserve(nCoords);
   for (auto &iter : m_cavityList) {
-    const CoordList cavCoords = iter->GetCoordList();
-    // Reserve enough space for appending the next cavity coord list
-    allCoords.reserve(allCoords.size() + cavCoords.size());
-    // Perform the append
+    const CoordList &cavCoords = iter->GetCoordList();
     std::copy(cavCoords.begin(), cavCoords.end(),
               std::back_inserter(allCoords));
-    // We can save a bit of time by initialising the distance^2 of the grid
-    // points nearest to each cavity coord Normally zero, but we allow the
-    // possibility that the grid step may be different i.e. the cavity coords
-    // may not lie directly on a grid point.
-    for (auto &cIter : cavCoords) {
-      unsigned int i =
-          m_spGrid->GetIXYZ(cIter); // Grid index of nearest grid point
-      double dist2 = Length2(cIter, m_spGrid->GetCoord(i));
-      m_spGrid->SetValue(i, dist2);
-    }
-    // Sort the coords so we can remove any dups
-
-    std::sort(allCoords.begin(), allCoords.end(), CoordCmp());
-    CoordListIter uniqIter = std::unique(allCoords.begin(), allCoords.end());
-    allCoords.erase(uniqIter, allCoords.end());
     LOG_F(1, "Cav = {}; total = {}", cavCoords.size(), allCoords.size());
   }
+  // Sort the coords so we can remove any dups. Receptor ensembles produce
+  // heavily overlapping cavities, so this is done once for the merged list
+  // rather than after every cavity
+  std::sort(allCoords.begin(), allCoords.end(), CoordCmp());
+  CoordListIter uniqIter = std::unique(allCoords.begin(), allCoords.end());
+  allCoords.erase(uniqIter, allCoords.end());
+  LOG_F(1, "Unique cavity coords = {}", allCoords.size());
+
+  // We can save a bit of time by initialising the distance^2 of the grid
+  // points nearest to each cavity coord Normally zero, but we allow the
+  // possibility that the grid step may be different i.e. the cavity coords
+  // may not lie directly on a grid point.
+  for (auto &cIter : allCoords) {
+    unsigned int i = m_spGrid->GetIXYZ(cIter); // Grid index of nearest point
+    double dist2 = Length2(cIter, m_spGrid->GetCoord(i));
+    m_spGrid->SetValue(i, std::min(m_spGrid->GetValue(i), dist2));
+  }
 
   // Loop over all grid points in the distance grid
   // Can terminate when distance^2 is less than or equal to mindist^2 (shortest
@@ -276,3 +502,60 @@ void rxdock::from_json(const json &j, DockingSite &site) {
   }
   j.at("border").get_to(site.m_border);
 }
+
+std::string rxdock::GetDockingSiteFileName(const std::string &wsName) {
+  std::string strBinFile =
+      GetDataFileName("data/grids", wsName + "-docking-site.bin");
+  std::string strJSONFile =
+      GetDataFileName("data/grids", wsName + "-docking-site.json");
+  if (DockingSite::isBinaryUpToDate(strBinFile, strJSONFile)) {
+    return strBinFile;
+  }
+  return strJSONFile;
+}
+
+DockingSitePtr rxdock::ReadDockingSite(const std::string &strFile) {
+  if (GetFileType(strFile) != "bin") {
+    std::ifstream inputFile(strFile.c_str());
+    if (!inputFile) {
+      throw FileReadError(_WHERE_, "Cannot open docking site file " + strFile);
+    }
+    json siteData;
+    inputFile >> siteData;
+    inputFile.close();
+    return DockingSitePtr(new DockingSite(siteData.at("docking-site")));
+  }
+#ifndef _WIN32
+  int fd = open(strFile.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw FileReadError(_WHERE_, "Cannot open docking site file " + strFile);
+  }
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+    close(fd);
+    throw FileReadError(_WHERE_, "Cannot read docking site file " + strFile);
+  }
+  std::size_t nBytes = fileStat.st_size;
+  void *pData = mmap(nullptr, nBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pData == MAP_FAILED) {
+    throw FileReadError(_WHERE_, "Cannot map docking site file " + strFile);
+  }
+  // The mapping is owned by the distance grid, which uses it in place
+  std::shared_ptr<const void> spMapping(pData, [nBytes](const void *p) {
+    munmap(const_cast<void *>(p), nBytes);
+  });
+  return DockingSitePtr(new DockingSite(static_cast<const char *>(pData),
+                                        nBytes, spMapping));
+#else
+  std::ifstream inputFile(strFile.c_str(), std::ios_base::binary);
+  if (!inputFile) {
+    throw FileReadError(_WHERE_, "Cannot open docking site file " + strFile);
+  }
+  std::shared_ptr<std::vector<char>> spData(new std::vector<char>(
+      (std::istreambuf_iterator<char>(inputFile)),
+      std::istreambuf_iterator<char>()));
+  return DockingSitePtr(
+      new DockingSite(spData->data(), spData->size(), spData));
+#endif
+}
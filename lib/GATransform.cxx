@@ -17,6 +17,7 @@
 
 #include <loguru.hpp>
 
+#include <algorithm>
 #include <iomanip>
 
 using namespace rxdock;
@@ -31,6 +32,40 @@ const std::string GATransform::_EQUALITY_THRESHOLD = "equality-threshold";
 const std::string GATransform::_NCYCLES = "number-of-cycles";
 const std::string GATransform::_NCONVERGENCE = "number-for-convergence";
 const std::string GATransform::_HISTORY_FREQ = "history-frequency";
+const std::string GATransform::_NISLANDS = "number-of-islands";
+const std::string GATransform::_MIGRATION_FREQ = "migration-frequency";
+const std::string GATransform::_NMIGRANTS = "number-of-migrants";
+
+namespace {
+
+// Ring migration: the best nMigrants genomes of each island are copied to the
+// next island. All migrants are selected before any are merged
+void Migrate(std::vector<PopulationPtr> &islands, int nMigrants,
+             double equalityThreshold) {
+  std::vector<GenomeList> migrants;
+  for (const auto &island : islands) {
+    const GenomeList &genomeList = island->GetGenomeList();
+    std::size_t n = std::min<std::size_t>(nMigrants, genomeList.size());
+    migrants.push_back(GenomeList(genomeList.begin(), genomeList.begin() + n));
+  }
+  for (std::size_t i = 0; i < islands.size(); ++i) {
+    islands[(i + 1) % islands.size()]->Immigrate(migrants[i],
+                                                 equalityThreshold);
+  }
+}
+
+// Index of the island with the best scoring genome
+std::size_t GetBestIsland(const std::vector<PopulationPtr> &islands) {
+  std::size_t iBest = 0;
+  for (std::size_t i = 1; i < islands.size(); ++i) {
+    if (islands[i]->Best()->GetScore() > islands[iBest]->Best()->GetScore()) {
+      iBest = i;
+    }
+  }
+  return iBest;
+}
+
+} // namespace
 
 GATransform::GATransform(const std::string &strName)
     : BaseBiMolTransform(_CT, strName), m_rand(GetRandInstance()) {
@@ -43,6 +78,9 @@ GATransform::GATransform(const std::string &strName)
   AddParameter(_NCYCLES, 100);
   AddParameter(_NCONVERGENCE, 6);
   AddParameter(_HISTORY_FREQ, 0);
+  AddParameter(_NISLANDS, 1);
+  AddParameter(_MIGRATION_FREQ, 10);
+  AddParameter(_NMIGRANTS, 1);
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
@@ -83,28 +121,48 @@ void GATransform::Execute() {
   int nCycles = GetParameter(_NCYCLES);
   int nConvergence = GetParameter(_NCONVERGENCE);
   int nHisFreq = GetParameter(_HISTORY_FREQ);
+  int nIslands = GetParameter(_NISLANDS);
+  int nMigrationFreq = GetParameter(_MIGRATION_FREQ);
+  int nMigrants = GetParameter(_NMIGRANTS);
 
   double popsize = static_cast<double>(pop->GetMaxSize());
   int nrepl = static_cast<int>(newFraction * popsize);
   bool bHistory = nHisFreq > 0;
+  bool bMigrate = (nIslands > 1) && (nMigrationFreq > 0) && (nMigrants > 0);
 
-  double bestScore = pop->Best()->GetScore();
+  // The workspace population is the first island
+  std::vector<PopulationPtr> islands(1, pop);
+  for (int i = 1; i < nIslands; ++i) {
+    islands.push_back(
+        new Population(pop->Best()->GetChrom(), pop->GetMaxSize(), pSF));
+  }
+  std::size_t iBest = GetBestIsland(islands);
+  double bestScore = islands[iBest]->Best()->GetScore();
   // Number of consecutive cycles with no improvement in best score
   int iConvergence = 0;
 
+  if (nIslands > 1) {
+    LOG_F(INFO, "{} islands of {} genomes", nIslands, pop->GetMaxSize());
+  }
   LOG_F(INFO, "CYCLE CONV      BEST      MEAN       VAR");
   LOG_F(INFO, " Init    -{:10.3f}{:10.3f}{:10.3f}", bestScore,
-        pop->GetScoreMean(), pop->GetScoreVariance());
+        islands[iBest]->GetScoreMean(), islands[iBest]->GetScoreVariance());
 
   for (int iCycle = 0; (iCycle < nCycles) && (iConvergence < nConvergence);
        ++iCycle) {
     if (bHistory && ((iCycle % nHisFreq) == 0)) {
-      pop->Best()->GetChrom()->SyncToModel();
+      islands[iBest]->Best()->GetChrom()->SyncToModel();
       pWorkSpace->SaveHistory(true);
     }
-    pop->GAstep(nrepl, relStepSize, equalityThreshold, pcross, xovermut,
-                cmutate);
-    double score = pop->Best()->GetScore();
+    for (auto &island : islands) {
+      island->GAstep(nrepl, relStepSize, equalityThreshold, pcross, xovermut,
+                     cmutate);
+    }
+    if (bMigrate && (((iCycle + 1) % nMigrationFreq) == 0)) {
+      Migrate(islands, nMigrants, equalityThreshold);
+    }
+    iBest = GetBestIsland(islands);
+    double score = islands[iBest]->Best()->GetScore();
     if (score > bestScore) {
       bestScore = score;
       iConvergence = 0;
@@ -112,7 +170,20 @@ void GATransform::Execute() {
       iConvergence++;
     }
     LOG_F(INFO, "{:5d}{:5d}{:10.3f}{:10.3f}{:10.3f}", iCycle, iConvergence,
-          score, pop->GetScoreMean(), pop->GetScoreVariance());
+          score, islands[iBest]->GetScoreMean(),
+          islands[iBest]->GetScoreVariance());
+    // Give up early on hopeless runs, judged by the best pose so far. The
+    // end of the transform is checked by Go()
+    if ((iCycle + 1 < nCycles) &&
+        isAbortCheckDue(static_cast<double>(iCycle + 1) / nCycles)) {
+      islands[iBest]->Best()->GetChrom()->SyncToModel();
+      CheckAbort();
+    }
+  }
+  // Merge the other islands back into the workspace population, for use by
+  // subsequent stages
+  for (std::size_t i = 1; i < islands.size(); ++i) {
+    pop->Immigrate(islands[i]->GetGenomeList(), equalityThreshold);
   }
   pop->Best()->GetChrom()->SyncToModel();
   int ri = GetReceptor()->GetCurrentCoords();
@@ -14,40 +14,77 @@
 #include "rxdock/BaseSF.h"
 #include "rxdock/ChromElement.h"
 
+#include <algorithm>
+
 using namespace rxdock;
 
 const std::string Genome::_CT = "Genome";
 
 Genome::Genome(ChromElement *pChr)
     : m_chrom(pChr->clone()), m_score(0.0), m_RWFitness(0.0) {
+  SyncFromChrom();
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+Genome::Genome(ChromElementPtr spChr)
+    : m_chrom(spChr), m_score(0.0), m_RWFitness(0.0) {
+  SyncFromChrom();
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
 Genome::Genome(const Genome &g)
-    : m_chrom((g.m_chrom)->clone()), m_score(g.m_score),
+    : m_chrom(g.m_chrom), m_vector(g.m_vector), m_score(g.m_score),
       m_RWFitness(g.m_RWFitness) {
   _RBTOBJECTCOUNTER_COPYCONSTR_(_CT);
 }
 
+// Reuses the existing value storage, so assigning between genomes of the same
+// chromosome does not allocate
 Genome &Genome::operator=(const Genome &g) {
   if (&g != this) {
-    m_chrom = (g.m_chrom)->clone();
-    m_score = g.m_score;
-    m_RWFitness = g.m_RWFitness;
+    m_chrom = g.m_chrom;
+    SetValues(g);
   }
   return *this;
 }
 
-Genome::~Genome() {
-  delete m_chrom;
-  _RBTOBJECTCOUNTER_DESTR_(_CT);
-}
+Genome::~Genome() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
 
 Genome *Genome::clone() const { return new Genome(*this); }
 
+ChromElement *Genome::GetChrom() {
+  m_chrom->SetVector(m_vector);
+  return m_chrom.Ptr();
+}
+
+void Genome::SyncFromChrom() {
+  m_vector.clear();
+  m_chrom->GetVector(m_vector);
+}
+
+void Genome::SetValues(const Genome &g) {
+  m_vector.assign(g.m_vector.begin(), g.m_vector.end());
+  m_score = g.m_score;
+  m_RWFitness = g.m_RWFitness;
+}
+
+void Genome::SwapValues(Genome &g, int begin, int end) {
+  std::swap_ranges(m_vector.begin() + begin, m_vector.begin() + end,
+                   g.m_vector.begin() + begin);
+}
+
+bool Genome::Equals(const Genome &g, double threshold) {
+  if (m_vector.size() != g.m_vector.size()) {
+    return false;
+  }
+  int i(0);
+  double cmp = GetChrom()->CompareVector(g.m_vector, i);
+  return ((cmp >= 0.0) && (cmp < threshold));
+}
+
 void Genome::SetScore(BaseSF *pSF) {
   if (pSF != nullptr) {
-    m_chrom->SyncToModel();
+    GetChrom()->SyncToModel();
     m_score = -pSF->Score();
   } else {
     m_score = 0.0;
@@ -55,6 +92,11 @@ void Genome::SetScore(BaseSF *pSF) {
   SetRWFitness(0.0, 0.0);
 }
 
+void Genome::SetScore(double score) {
+  m_score = -score;
+  SetRWFitness(0.0, 0.0);
+}
+
 double Genome::SetRWFitness(double sigmaOffset, double partialSum) {
   // Apply sigma truncation to the raw score
   m_RWFitness = std::max(0.0, GetScore() - sigmaOffset);
@@ -70,8 +112,12 @@ void Genome::NormaliseRWFitness(double total) {
   }
 }
 
+// Prints a decoded copy of the codec, so that printing leaves the shared codec
+// untouched
 void Genome::Print(std::ostream &s) const {
-  s << *m_chrom << std::endl;
+  ChromElementPtr spChr(m_chrom->clone());
+  spChr->SetVector(m_vector);
+  s << *spChr << std::endl;
   s << "Score: " << GetScore() << "; RWFitness: " << GetRWFitness()
     << std::endl;
 }
@@ -0,0 +1,163 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/Hasher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace rxdock;
+
+namespace {
+
+// SHA-256 round constants (FIPS 180-4)
+const std::uint32_t _SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline std::uint32_t RotR(std::uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+} // namespace
+
+Hasher::Hasher()
+    : m_hash(14695981039346656037ULL),
+      m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f,
+              0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      m_nBytes(0) {}
+
+void Hasher::Add(const std::string &str) {
+  AddBytes(reinterpret_cast<const unsigned char *>(str.data()), str.size());
+  const unsigned char separator = 0xff;
+  AddBytes(&separator, 1);
+}
+
+bool Hasher::AddFile(const std::string &strFile) {
+  std::ifstream inFile(strFile.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (!inFile) {
+    Add("<missing>");
+    return false;
+  }
+  std::ostringstream ostr;
+  ostr << inFile.rdbuf();
+  Add(ostr.str());
+  return true;
+}
+
+std::string Hasher::GetKey() const {
+  std::ostringstream ostr;
+  ostr << std::hex;
+  ostr.width(16);
+  ostr.fill('0');
+  ostr << m_hash;
+  return ostr.str();
+}
+
+std::string Hasher::GetDigest() const {
+  // Pad a copy, so that more input can still be added to this hasher. The
+  // input is followed by a 1 bit, zeros up to 8 bytes short of a whole block,
+  // and the input length in bits as a big-endian uint64
+  Hasher padded(*this);
+  std::size_t nPending = m_nBytes % 64;
+  std::size_t nZeros = (nPending < 56 ? 56 : 120) - nPending;
+  unsigned char padding[72] = {0x80};
+  std::uint64_t nBits = m_nBytes * 8;
+  for (int i = 0; i < 8; i++) {
+    padding[nZeros + i] = static_cast<unsigned char>(nBits >> (56 - 8 * i));
+  }
+  padded.AddBytes(padding, nZeros + 8);
+  std::ostringstream ostr;
+  ostr << std::hex;
+  ostr.fill('0');
+  for (std::uint32_t word : padded.m_state) {
+    ostr.width(8);
+    ostr << word;
+  }
+  return ostr.str();
+}
+
+void Hasher::AddBytes(const unsigned char *pData, std::size_t nBytes) {
+  for (std::size_t i = 0; i < nBytes; i++) {
+    m_hash ^= pData[i];
+    m_hash *= 1099511628211ULL;
+  }
+  std::size_t nPending = m_nBytes % 64;
+  m_nBytes += nBytes;
+  while (nBytes > 0) {
+    std::size_t n = std::min(nBytes, sizeof(m_block) - nPending);
+    std::memcpy(m_block + nPending, pData, n);
+    nPending += n;
+    pData += n;
+    nBytes -= n;
+    if (nPending == sizeof(m_block)) {
+      ProcessBlock(m_block);
+      nPending = 0;
+    }
+  }
+}
+
+void Hasher::ProcessBlock(const unsigned char *pBlock) {
+  std::uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (std::uint32_t(pBlock[4 * i]) << 24) |
+           (std::uint32_t(pBlock[4 * i + 1]) << 16) |
+           (std::uint32_t(pBlock[4 * i + 2]) << 8) |
+           std::uint32_t(pBlock[4 * i + 3]);
+  }
+  for (int i = 16; i < 64; i++) {
+    std::uint32_t s0 =
+        RotR(w[i - 15], 7) ^ RotR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    std::uint32_t s1 =
+        RotR(w[i - 2], 17) ^ RotR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  std::uint32_t a = m_state[0], b = m_state[1], c = m_state[2],
+                d = m_state[3], e = m_state[4], f = m_state[5],
+                g = m_state[6], h = m_state[7];
+  for (int i = 0; i < 64; i++) {
+    std::uint32_t s1 = RotR(e, 6) ^ RotR(e, 11) ^ RotR(e, 25);
+    std::uint32_t ch = (e & f) ^ (~e & g);
+    std::uint32_t t1 = h + s1 + ch + _SHA256_K[i] + w[i];
+    std::uint32_t s0 = RotR(a, 2) ^ RotR(a, 13) ^ RotR(a, 22);
+    std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    std::uint32_t t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  m_state[0] += a;
+  m_state[1] += b;
+  m_state[2] += c;
+  m_state[3] += d;
+  m_state[4] += e;
+  m_state[5] += f;
+  m_state[6] += g;
+  m_state[7] += h;
+}
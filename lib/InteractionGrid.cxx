@@ -178,6 +178,13 @@ InteractionGrid::GetInteractionList(const Coord &c) const {
 /////////////////////////
 // Set attribute functions
 /////////////////////////
+void InteractionGrid::SetInteractionList(
+    unsigned int iXYZ, const InteractionCenterList &intnList) {
+  if (isValid(iXYZ)) {
+    m_intnMap[iXYZ] = intnList;
+  }
+}
+
 void InteractionGrid::SetInteractionLists(InteractionCenter *pIntn,
                                           double radius) {
   // Index using atom 1 coords - check if atom 1 is present
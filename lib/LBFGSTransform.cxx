@@ -0,0 +1,323 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/LBFGSTransform.h"
+#include "rxdock/Atom.h"
+#include "rxdock/Chrom.h"
+#include "rxdock/SFRequest.h"
+#include "rxdock/WorkSpace.h"
+
+#include <fmt/ostream.h>
+#include <loguru.hpp>
+
+#include <deque>
+
+using namespace rxdock;
+
+// Static data member for class type
+const std::string LBFGSTransform::_CT = "LBFGSTransform";
+// Parameter names
+const std::string LBFGSTransform::_MAX_ITER = "maximum-number-of-iterations";
+const std::string LBFGSTransform::_HISTORY = "history-size";
+const std::string LBFGSTransform::_PARTITION_DIST = "partition-distance";
+const std::string LBFGSTransform::_MAX_STEP = "maximum-step";
+const std::string LBFGSTransform::_GRADIENT_STEP = "gradient-step";
+const std::string LBFGSTransform::_CONVERGENCE = "convergence";
+
+namespace {
+
+// Armijo sufficient decrease constant and maximum number of step halvings
+// for the backtracking line search
+const double _ARMIJO = 1.0e-4;
+const int _MAX_BACKTRACK = 20;
+
+// Product of the weights of all ancestors of pTerm, up to and including pRoot
+double GetAncestorWeight(const BaseSF *pTerm, const BaseSF *pRoot) {
+  double w = 1.0;
+  for (const BaseSF *p = pTerm; p != pRoot && p->GetParentSF() != nullptr;
+       p = p->GetParentSF()) {
+    w *= p->GetParentSF()->GetWeight();
+  }
+  return w;
+}
+
+} // namespace
+
+////////////////////////////////////////
+// Constructors/destructors
+LBFGSTransform::LBFGSTransform(const std::string &strName)
+    : BaseBiMolTransform(_CT, strName), m_nScoreCalls(0),
+      m_nGradientCalls(0) {
+  LOG_F(2, "LBFGSTransform parameterised constructor");
+  AddParameter(_MAX_ITER, 100);
+  AddParameter(_HISTORY, 6);
+  AddParameter(_PARTITION_DIST, 0.0);
+  AddParameter(_MAX_STEP, 3.0);
+  AddParameter(_GRADIENT_STEP, 1.0e-2);
+  AddParameter(_CONVERGENCE, 0.001);
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+LBFGSTransform::~LBFGSTransform() {
+  LOG_F(2, "LBFGSTransform destructor");
+  _RBTOBJECTCOUNTER_DESTR_(_CT);
+}
+
+////////////////////////////////////////
+// Protected methods
+///////////////////
+void LBFGSTransform::SetupReceptor() {}
+
+void LBFGSTransform::SetupLigand() {}
+
+void LBFGSTransform::SetupSolvent() {}
+
+void LBFGSTransform::SetupTransform() {
+  // Construct the overall chromosome for the system
+  m_chrom.SetNull();
+  WorkSpace *pWorkSpace = GetWorkSpace();
+  if (pWorkSpace) {
+    m_chrom = new Chrom(pWorkSpace->GetModels());
+  }
+}
+
+////////////////////////////////////////
+// Private methods
+///////////////////
+// Pure virtual in BaseTransform
+// Actually apply the transform
+void LBFGSTransform::Execute() {
+  LOG_F(2, "LBFGSTransform::Execute");
+  // Get the current scoring function from the workspace
+  WorkSpace *pWorkSpace = GetWorkSpace();
+  if (pWorkSpace == nullptr) // Return if this transform is not registered
+    return;
+  BaseSF *pSF = pWorkSpace->GetSF();
+  if (pSF == nullptr) // Return if workspace does not have a scoring function
+    return;
+
+  pWorkSpace->ClearPopulation();
+  int maxIter = GetParameter(_MAX_ITER);
+  unsigned int historySize = static_cast<int>(GetParameter(_HISTORY));
+  double maxStep = GetParameter(_MAX_STEP);
+  double convergence = GetParameter(_CONVERGENCE);
+  double partDist = GetParameter(_PARTITION_DIST);
+  RequestPtr spPartReq(new SFPartitionRequest(partDist));
+  RequestPtr spClearPartReq(new SFPartitionRequest(0.0));
+  pSF->HandleRequest(spPartReq);
+
+  m_chrom->SyncFromModel();
+  // Minimise in units of the chromosome step sizes, so that translations,
+  // rotations and torsions are comparably scaled
+  m_steps.clear();
+  m_chrom->GetStepVector(m_steps);
+  for (auto &step : m_steps) {
+    if (step <= 0.0) {
+      step = 1.0;
+    }
+  }
+  m_vc.clear();
+  m_chrom->GetVector(m_vc);
+  int n = m_vc.size();
+  Eigen::VectorXd x(n);
+  for (int i = 0; i < n; i++) {
+    x(i) = m_vc[i] / m_steps[i];
+  }
+
+  m_nScoreCalls = 0;
+  m_nGradientCalls = 0;
+  Eigen::VectorXd g(n);
+  double initScore = ScoreGradient(pSF, x, g);
+  double f = initScore;
+  for (BaseSFListConstIter iter = m_noGradList.begin();
+       iter != m_noGradList.end(); iter++) {
+    LOG_F(INFO, "No analytic gradient for {}, differentiating numerically",
+          (*iter)->GetFullName());
+  }
+
+  // Correction pairs, most recent last
+  std::deque<Eigen::VectorXd> sList;
+  std::deque<Eigen::VectorXd> yList;
+  std::deque<double> rhoList;
+  Eigen::VectorXd d(n);
+  Eigen::VectorXd gNew(n);
+  std::vector<double> alpha(historySize);
+
+  LOG_F(INFO, " ITER  DOF     CALLS     SCORE     DELTA");
+  LOG_F(INFO, " Init{:5d}{:10d}{:10f}         -", n, m_nScoreCalls, f);
+  LOG_F(1, "{}", *m_chrom);
+
+  for (int iter = 0; iter < maxIter && n > 0; iter++) {
+    // Two-loop recursion for the search direction d = -H.g
+    d = -g;
+    int nPairs = sList.size();
+    for (int i = nPairs - 1; i >= 0; i--) {
+      alpha[i] = rhoList[i] * sList[i].dot(d);
+      d -= alpha[i] * yList[i];
+    }
+    if (nPairs > 0) {
+      d *= sList.back().dot(yList.back()) / yList.back().squaredNorm();
+    }
+    for (int i = 0; i < nPairs; i++) {
+      double beta = rhoList[i] * yList[i].dot(d);
+      d += (alpha[i] - beta) * sList[i];
+    }
+    double slope = g.dot(d);
+    if (slope >= 0.0) {
+      // Not a descent direction, restart from steepest descent
+      sList.clear();
+      yList.clear();
+      rhoList.clear();
+      d = -g;
+      slope = g.dot(d);
+      if (slope >= 0.0) {
+        break; // Zero gradient
+      }
+    }
+    double dNorm = d.norm();
+    if (dNorm > maxStep) {
+      d *= maxStep / dNorm;
+      slope *= maxStep / dNorm;
+    }
+
+    // Backtracking line search
+    double step = 1.0;
+    double fNew = 0.0;
+    bool bAccepted = false;
+    for (int i = 0; i < _MAX_BACKTRACK; i++, step *= 0.5) {
+      fNew = Score(pSF, x + step * d);
+      if (fNew <= f + _ARMIJO * step * slope) {
+        bAccepted = true;
+        break;
+      }
+    }
+    if (!bAccepted) {
+      if (sList.empty()) {
+        break; // No progress even along steepest descent
+      }
+      sList.clear();
+      yList.clear();
+      rhoList.clear();
+      continue;
+    }
+
+    Eigen::VectorXd xNew = x + step * d;
+    fNew = ScoreGradient(pSF, xNew, gNew);
+    Eigen::VectorXd s = xNew - x;
+    Eigen::VectorXd y = gNew - g;
+    double sy = s.dot(y);
+    // Only keep pairs that maintain a positive definite Hessian estimate
+    if (sy > 1.0e-10) {
+      if (sList.size() == historySize) {
+        sList.pop_front();
+        yList.pop_front();
+        rhoList.pop_front();
+      }
+      sList.push_back(s);
+      yList.push_back(y);
+      rhoList.push_back(1.0 / sy);
+    }
+    double delta = fNew - f;
+    x = xNew;
+    g = gNew;
+    f = fNew;
+    LOG_F(INFO, "{:5d}{:5d}{:10d}{:10f}{:10f}", iter, n, m_nScoreCalls, f,
+          delta);
+    LOG_F(1, "{}", *m_chrom);
+    if (delta > -convergence) {
+      // Converged, unless the curvature estimate was leading us astray, in
+      // which case restart from steepest descent
+      if (nPairs == 0) {
+        break;
+      }
+      sList.clear();
+      yList.clear();
+      rhoList.clear();
+    }
+  }
+  SyncToModel(x);
+  pSF->HandleRequest(spClearPartReq); // Clear any partitioning
+  double finalScore = pSF->Score();
+  LOG_F(INFO, "Final{:5d}{:10d}{:10f}{:10f}", m_nGradientCalls, m_nScoreCalls,
+        finalScore, finalScore - initScore);
+}
+
+void LBFGSTransform::SyncToModel(const Eigen::VectorXd &x) {
+  for (std::size_t i = 0; i < m_vc.size(); i++) {
+    m_vc[i] = x(i) * m_steps[i];
+  }
+  m_chrom->SetVector(m_vc);
+  m_chrom->SyncToModel();
+}
+
+double LBFGSTransform::Score(BaseSF *pSF, const Eigen::VectorXd &x) {
+  m_nScoreCalls++;
+  SyncToModel(x);
+  return pSF->Score();
+}
+
+double LBFGSTransform::ScoreGradient(BaseSF *pSF, const Eigen::VectorXd &x,
+                                     Eigen::VectorXd &g) {
+  m_nScoreCalls++;
+  m_nGradientCalls++;
+  SyncToModel(x);
+  AtomGradientMap atomGradients;
+  m_noGradList.clear();
+  double score = pSF->ScoreGradient(atomGradients, m_noGradList);
+  m_gc.clear();
+  m_bProjected.clear();
+  m_chrom->GetGradientVector(atomGradients, m_gc, m_bProjected);
+  // Chromosome values are scaled by their step sizes
+  bool bAllProjected = true;
+  for (int k = 0; k < x.size(); k++) {
+    g(k) = m_gc[k] * m_steps[k];
+    bAllProjected = bAllProjected && m_bProjected[k];
+  }
+  std::vector<double> noGradWeights;
+  for (BaseSFListConstIter iter = m_noGradList.begin();
+       iter != m_noGradList.end(); iter++) {
+    double w = GetAncestorWeight(*iter, pSF);
+    noGradWeights.push_back(w);
+    score += w * (*iter)->Score();
+  }
+  if (m_noGradList.empty() && bAllProjected) {
+    return score;
+  }
+
+  // Central differences of the terms without analytic gradients, added to the
+  // projected gradients. Values that could not be projected are
+  // differentiated over the whole score instead
+  double h = GetParameter(_GRADIENT_STEP);
+  Eigen::VectorXd xh = x;
+  for (int k = 0; k < x.size(); k++) {
+    if (m_bProjected[k] && m_noGradList.empty()) {
+      continue;
+    }
+    double sum[2] = {0.0, 0.0};
+    for (int i = 0; i < 2; i++) {
+      xh(k) = (i == 0) ? x(k) + h : x(k) - h;
+      SyncToModel(xh);
+      if (!m_bProjected[k]) {
+        sum[i] = pSF->Score();
+        continue;
+      }
+      for (std::size_t j = 0; j < m_noGradList.size(); j++) {
+        sum[i] += noGradWeights[j] * m_noGradList[j]->Score();
+      }
+    }
+    xh(k) = x(k);
+    double gh = (sum[0] - sum[1]) / (2.0 * h);
+    g(k) = m_bProjected[k] ? g(k) + gh : gh;
+  }
+  SyncToModel(x);
+  return score;
+}
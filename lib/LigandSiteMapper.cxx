@@ -19,9 +19,15 @@
 #include <loguru.hpp>
 
 #include <functional>
+#include <mutex>
 
 using namespace rxdock;
 
+namespace {
+// Serialises reading of the reference ligand between concurrent mappings
+std::mutex refMolMutex;
+} // namespace
+
 // Static data member for class type
 const std::string LigandSiteMapper::_CT = "LigandSiteMapper";
 const std::string LigandSiteMapper::_REF_MOL = "reference-molecule";
@@ -52,10 +58,10 @@ LigandSiteMapper::~LigandSiteMapper() {
   _RBTOBJECTCOUNTER_DESTR_(_CT);
 }
 
-CavityList LigandSiteMapper::operator()() {
+CavityList LigandSiteMapper::operator()(const CoordList &coordList,
+                                        const std::vector<double> &radiusList) {
   CavityList cavityList;
-  ModelPtr spReceptor(GetReceptor());
-  if (spReceptor.Null())
+  if (coordList.empty())
     return cavityList;
 
   std::string strRef = GetParameter(_REF_MOL);
@@ -77,23 +83,24 @@ CavityList LigandSiteMapper::operator()() {
   // Simple extension would be to read all the records from the SD file
   // to construct a docking site from the superimposition of all the reference
   // ligands
-  std::string strMolFile = GetDataFileName("data/ligands", strRef);
-  MolecularFileSourcePtr spMdlFileSource(
-      new MdlFileSource(strMolFile, false, false, true));
-  // Only include non-H reference atoms in the mapping
-  AtomList refAtomList = GetAtomListWithPredicate(
-      spMdlFileSource->GetAtomList(), std::not1(isAtomicNo_eq(1)));
+  // The file parsing shares the element and type tables with any other
+  // mapping running concurrently, so only the grid work below runs in parallel
+  CoordList refCoordList;
+  {
+    std::lock_guard<std::mutex> lock(refMolMutex);
+    std::string strMolFile = GetDataFileName("data/ligands", strRef);
+    MolecularFileSourcePtr spMdlFileSource(
+        new MdlFileSource(strMolFile, false, false, true));
+    // Only include non-H reference atoms in the mapping
+    AtomList refAtomList = GetAtomListWithPredicate(
+        spMdlFileSource->GetAtomList(), std::not1(isAtomicNo_eq(1)));
+    GetCoordList(refAtomList, refCoordList);
+  }
 
   FFTGridPtr spGrid;
-
-  // Only include non-H receptor atoms in the mapping
-  AtomList atomList = GetAtomListWithPredicate(spReceptor->GetAtomList(),
-                                               std::not1(isAtomicNo_eq(1)));
   Vector gridStep(step, step, step);
 
   // Construct the grid to cover the ligand coords + radius
-  CoordList refCoordList;
-  GetCoordList(refAtomList, refCoordList);
   double border = radius + smallR + step;
   Coord minCoord = Min(refCoordList) - border;
   Coord maxCoord = Max(refCoordList) + border;
@@ -118,10 +125,8 @@ CavityList LigandSiteMapper::operator()() {
   LOG_F(INFO, "N(unallocated)={}", spGrid->Count(0.0));
 
   // Now exclude the receptor volume
-  for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
-       iter++) {
-    double r = (**iter).GetVdwRadius();
-    spGrid->SetSphere((**iter).GetCoords(), r + rVolIncr, recVal, true);
+  for (std::size_t i = 0; i < coordList.size(); i++) {
+    spGrid->SetSphere(coordList[i], radiusList[i] + rVolIncr, recVal, true);
   }
 
   LOG_F(INFO, "EXCLUDE RECEPTOR VOLUME");
@@ -11,7 +11,7 @@
  ***********************************************************************/
 
 // XB cctype for check atom in MOL2 is number
-//#include <cctype>
+#include <cctype>
 #include <functional>
 #include <sstream>
 
@@ -25,6 +25,51 @@
 
 using namespace rxdock;
 
+namespace {
+
+// A whitespace-delimited field of a MOL2 line, referenced in place. The ATOM
+// and BOND records of large receptors are split into these without
+// allocating a string per field.
+struct MOL2Field {
+  const char *begin;
+  std::size_t size;
+  std::string str() const { return std::string(begin, size); }
+};
+
+// Maximum number of fields used from an ATOM record (atom_id to charge)
+const std::size_t _MAX_ATOM_FIELDS = 9;
+// Maximum number of fields used from a BOND record (bond_id to bond_type)
+const std::size_t _MAX_BOND_FIELDS = 4;
+
+// Splits aLine at whitespace into at most maxFields fields and returns the
+// number of fields found. Each field is followed by whitespace or by the
+// terminating null of the line, so std::atoi and std::atof can be applied
+// to field.begin directly.
+std::size_t SplitFields(const std::string &aLine, MOL2Field *fields,
+                        std::size_t maxFields) {
+  const char *p = aLine.data();
+  const char *end = p + aLine.size();
+  std::size_t nFields = 0;
+  while (nFields < maxFields) {
+    while ((p != end) && std::isspace(static_cast<unsigned char>(*p))) {
+      ++p;
+    }
+    if (p == end) {
+      break;
+    }
+    const char *begin = p;
+    while ((p != end) && !std::isspace(static_cast<unsigned char>(*p))) {
+      ++p;
+    }
+    fields[nFields].begin = begin;
+    fields[nFields].size = p - begin;
+    ++nFields;
+  }
+  return nFields;
+}
+
+} // namespace
+
 const std::string MOL2FileSource::_CT = "MOL2FileSource";
 // record delimiter strings
 const std::string MOL2FileSource::_TRIPOS_DELIM = "@<TRIPOS>";
@@ -244,29 +289,31 @@ void MOL2FileSource::ParseRecordMOLECULE(const std::string &aLine) {
   }
 }
 
+// ATOM and BOND records make up nearly all of a receptor file, so they are
+// split in place with SplitFields rather than tokenized into strings
 void MOL2FileSource::ParseRecordATOM(const std::string &aLine) {
-  std::vector<std::string> tokens;
-  Tokenize(aLine, tokens);
+  MOL2Field fields[_MAX_ATOM_FIELDS];
+  std::size_t nFields = SplitFields(aLine, fields, _MAX_ATOM_FIELDS);
   // there must be at least 6 fields, rest is optional
-  if (tokens.size() < 6)
+  if (nFields < 6)
     throw FileParseError(_WHERE_,
                          "Corrupted MOL2 file: not enough fields in ATOM ");
 
   // Compulsory fields
-  int atom_id = std::atoi(tokens[0].c_str());
-  std::string atom_name = tokens[1];
+  int atom_id = std::atoi(fields[0].begin);
+  std::string atom_name = fields[1].str();
   Coord atom_coord;
-  atom_coord.xyz(0) = std::atof(tokens[2].c_str());
-  atom_coord.xyz(1) = std::atof(tokens[3].c_str());
-  atom_coord.xyz(2) = std::atof(tokens[4].c_str());
-  std::string atom_type = tokens[5];
+  atom_coord.xyz(0) = std::atof(fields[2].begin);
+  atom_coord.xyz(1) = std::atof(fields[3].begin);
+  atom_coord.xyz(2) = std::atof(fields[4].begin);
+  std::string atom_type = fields[5].str();
 
   // Optional fields.
-  int subst_id = (tokens.size() > 6) ? std::atoi(tokens[6].c_str()) : 1;
-  std::string subst_name = (tokens.size() > 7) ? tokens[7] : "****";
+  int subst_id = (nFields > 6) ? std::atoi(fields[6].begin) : 1;
+  std::string subst_name = (nFields > 7) ? fields[7].str() : "****";
   std::string sID, sName;
   GetSSIDandName(subst_name, subst_id, sID, sName);
-  double charge = (tokens.size() > 8) ? std::atof(tokens[8].c_str()) : 0.0;
+  double charge = (nFields > 8) ? std::atof(fields[8].begin) : 0.0;
   // XB reweighting parameters
   //	Double wxb = (tokens.size() > 9) ? std::atof(tokens[9].c_str())
   //: 1.0;
@@ -321,18 +368,18 @@ void MOL2FileSource::ParseRecordATOM(const std::string &aLine) {
 }
 
 void MOL2FileSource::ParseRecordBOND(const std::string &aLine) {
-  std::vector<std::string> tokens;
-  Tokenize(aLine, tokens);
+  MOL2Field fields[_MAX_BOND_FIELDS];
+  std::size_t nFields = SplitFields(aLine, fields, _MAX_BOND_FIELDS);
   // there must be at least 4 fields, rest is optional
-  if (tokens.size() < 4)
+  if (nFields < 4)
     throw FileParseError(_WHERE_,
                          "Corrupted MOL2 file: not enough fields in BOND");
 
   // Compulsory fields
-  unsigned int bond_id = std::atoi(tokens[0].c_str());
-  unsigned int origin_bond_id = std::atoi(tokens[1].c_str());
-  unsigned int target_bond_id = std::atoi(tokens[2].c_str());
-  std::string bond_type = tokens[3];
+  unsigned int bond_id = std::atoi(fields[0].begin);
+  unsigned int origin_bond_id = std::atoi(fields[1].begin);
+  unsigned int target_bond_id = std::atoi(fields[2].begin);
+  std::string bond_type = fields[3].str();
 
   // In rDock we only have integer bond order
   // Aromatics should be defined as alternate double/single bonds as in MDL mol
@@ -658,11 +705,9 @@ void MOL2FileSource::GetSSIDandName(const std::string &subst_name, int subst_id,
   const std::string nonstandard("*<");
   const std::string numeric("0123456789");
   const std::string defaultName("UNK");
-  const std::string defaultID =
-      Variant(subst_id); // Quick way to convert from int to string
 
   if (subst_name.empty() || (subst_name.find_first_of(nonstandard) == 0)) {
-    sID = defaultID;
+    sID = std::string(Variant(subst_id)); // Quick int to string conversion
     sName = defaultName;
     return;
   }
@@ -672,7 +717,10 @@ void MOL2FileSource::GetSSIDandName(const std::string &subst_name, int subst_id,
   // Name is up to the beginning of 1st numeric char
   // ID is from the first numeric char onwards (may have non-numeric suffix as
   // well e.g 100B)
-  sID = (nFirst != std::string::npos) ? subst_name.substr(nFirst) : defaultID;
+  // The default ID is only rendered when needed, as this is called for every
+  // ATOM record
+  sID = (nFirst != std::string::npos) ? subst_name.substr(nFirst)
+                                      : std::string(Variant(subst_id));
   sName = (nFirst > 0) ? subst_name.substr(0, nFirst) : defaultName;
   return;
 }
@@ -10,14 +10,19 @@
  * http://rdock.sourceforge.net/
  ***********************************************************************/
 
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
 #include <iomanip>
 
 #include "rxdock/AtomFuncs.h"
 #include "rxdock/FileError.h"
+#include "rxdock/Hasher.h"
 #include "rxdock/MdlFileSource.h"
+#include "rxdock/ModelCache.h"
 #include "rxdock/ModelError.h"
 #include "rxdock/Plane.h"
+#include "rxdock/SDIndex.h"
 
 #include <fmt/ostream.h>
 #include <loguru.hpp>
@@ -39,6 +44,48 @@ MdlFileSource::MdlFileSource(const std::string &fileName, bool bPosIonisable,
 // Default destructor
 MdlFileSource::~MdlFileSource() { _RBTOBJECTCOUNTER_DESTR_("MdlFileSource"); }
 
+void MdlFileSource::SelectRecords(std::size_t start, std::size_t end) {
+  SDIndex index(GetFileName());
+  end = std::min(end, index.GetNumRecords());
+  std::vector<std::size_t> recordOffsets;
+  for (std::size_t i = start; i < end; i++) {
+    recordOffsets.push_back(index.GetRecordOffset(i));
+  }
+  SetRecordOffsets(recordOffsets);
+}
+
+void MdlFileSource::SelectRecords(const std::vector<std::string> &titles) {
+  SDIndex index(GetFileName());
+  std::vector<std::size_t> recordOffsets;
+  for (const auto &title : titles) {
+    std::vector<std::size_t> records = index.FindTitle(title);
+    if (records.empty()) {
+      LOG_F(WARNING, "No record titled {} in {}", title, GetFileName());
+    }
+    for (auto iRecord : records) {
+      recordOffsets.push_back(index.GetRecordOffset(iRecord));
+    }
+  }
+  SetRecordOffsets(recordOffsets);
+}
+
+std::string MdlFileSource::GetRecordCacheKey() {
+  Read(); // Read the current record
+  Hasher hasher;
+  hasher.Add(std::to_string(ModelCache::_VERSION));
+  hasher.Add(GetProgramVersion());
+  // Ring perception can be disabled from the environment
+  hasher.Add(std::getenv("RBT_NORINGS") ? "norings" : "rings");
+  hasher.Add(m_bPosIonisable ? "pos-ionise" : "");
+  hasher.Add(m_bNegIonisable ? "neg-ionise" : "");
+  hasher.Add(m_bImplHydrogens ? "implicit-h" : "explicit-h");
+  hasher.Add(ConvertSegmentMapToString(GetSegmentFilterMap()));
+  for (const auto &line : m_lineRecs) {
+    hasher.Add(line);
+  }
+  return hasher.GetDigest();
+}
+
 void MdlFileSource::Parse() {
   // Only parse if we haven't already done so
   if (!m_bParsedOK) {
@@ -0,0 +1,208 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/MdlRecord.h"
+#include "rxdock/FileError.h"
+
+#include <cstdlib>
+
+using namespace rxdock;
+
+const std::string MdlRecord::_CT = "MdlRecord";
+
+MdlRecord::MdlRecord() : m_nAtoms(0) { _RBTOBJECTCOUNTER_CONSTR_(_CT); }
+
+MdlRecord::~MdlRecord() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+bool MdlRecord::Read(std::istream &istr) {
+  std::string text;
+  std::string line;
+  bool bBlank = true;
+  while (std::getline(istr, line)) {
+    text += line;
+    // Only the last line of the input can lack a newline
+    if (!istr.eof()) {
+      text += '\n';
+    }
+    if (bBlank && line.find_first_not_of(" \t\r") != std::string::npos) {
+      bBlank = false;
+    }
+    if (line.compare(0, 4, "$$$$") == 0) {
+      break;
+    }
+  }
+  // Trailing blank lines are not a record
+  if (bBlank) {
+    return false;
+  }
+  m_text.swap(text);
+  ParseText();
+  return true;
+}
+
+void MdlRecord::Parse(const std::string &text) {
+  m_text = text;
+  ParseText();
+}
+
+void MdlRecord::Write(std::ostream &ostr) const {
+  ostr << m_text;
+  if (!m_text.empty() && m_text.back() != '\n') {
+    ostr << '\n';
+  }
+}
+
+void MdlRecord::SetTitle(const std::string &title) {
+  std::size_t titleEnd = m_text.find('\n');
+  if (titleEnd == std::string::npos) {
+    titleEnd = m_text.size();
+  }
+  m_text.replace(0, titleEnd, title);
+  m_title = title;
+  for (auto &atomLine : m_atomLines) {
+    atomLine = atomLine - titleEnd + title.size();
+  }
+  for (auto &bondLine : m_bondLines) {
+    bondLine = bondLine - titleEnd + title.size();
+  }
+}
+
+Variant MdlRecord::GetDataValue(const std::string &fieldName) const {
+  for (auto iter = m_dataFields.rbegin(); iter != m_dataFields.rend();
+       ++iter) {
+    if (iter->first == fieldName) {
+      return Variant(iter->second);
+    }
+  }
+  return Variant();
+}
+
+StringVariantMap MdlRecord::GetDataMap() const {
+  StringVariantMap dataMap;
+  for (const auto &dataField : m_dataFields) {
+    dataMap[dataField.first] = Variant(dataField.second);
+  }
+  return dataMap;
+}
+
+void MdlRecord::GetAtom(std::size_t iAtom, std::string &strElementName,
+                        Coord &coord, int &nFormalCharge) const {
+  std::size_t lineStart = m_atomLines.at(iAtom);
+  std::size_t lineEnd = m_text.find('\n', lineStart);
+  std::istringstream istr(m_text.substr(lineStart, lineEnd - lineStart));
+  int nMassDiff = 0;
+  nFormalCharge = 0;
+  istr >> coord.xyz(0) >> coord.xyz(1) >> coord.xyz(2) >> strElementName >>
+      nMassDiff >> nFormalCharge;
+  // MDL stores non-zero charges as 4-charge, as in MdlFileSource
+  if (nFormalCharge > 0) {
+    nFormalCharge = 4 - nFormalCharge;
+  }
+}
+
+void MdlRecord::GetBond(std::size_t iBond, std::size_t &iAtom1,
+                        std::size_t &iAtom2) const {
+  // The atom fields are 3 characters wide and may coalesce
+  std::size_t lineStart = m_bondLines.at(iBond);
+  iAtom1 = std::atoi(m_text.substr(lineStart, 3).c_str()) - 1;
+  iAtom2 = std::atoi(m_text.substr(lineStart + 3, 3).c_str()) - 1;
+}
+
+// Private methods
+
+void MdlRecord::ParseText() {
+  m_title.clear();
+  m_nAtoms = 0;
+  m_atomLines.clear();
+  m_bondLines.clear();
+  m_dataFields.clear();
+
+  // Returns the next line, and moves pos to the start of the following line
+  std::size_t pos = 0;
+  std::string line;
+  auto getLine = [this, &pos, &line]() {
+    if (pos >= m_text.size()) {
+      return false;
+    }
+    std::size_t lineEnd = m_text.find('\n', pos);
+    if (lineEnd == std::string::npos) {
+      lineEnd = m_text.size();
+    }
+    line.assign(m_text, pos, lineEnd - pos);
+    pos = lineEnd + 1;
+    return true;
+  };
+  auto isDelimiter = [&line]() { return line.compare(0, 4, "$$$$") == 0; };
+
+  // Title lines
+  for (int i = 0; i < 3; i++) {
+    if (!getLine() || isDelimiter()) {
+      throw FileParseError(_WHERE_, "Incomplete title records");
+    }
+    if (i == 0) {
+      if (!line.empty() && line.back() == '\r') {
+        throw FileParseError(_WHERE_, "Windows CRLF line endings detected");
+      }
+      m_title = line;
+    }
+  }
+
+  // Counts line; the fields are 3 characters wide and may coalesce
+  if (!getLine() || isDelimiter()) {
+    throw FileParseError(_WHERE_, "Missing atom and bond information");
+  }
+  m_nAtoms = std::atoi(line.substr(0, 3).c_str());
+  std::size_t nBonds =
+      line.size() > 3 ? std::atoi(line.substr(3, 3).c_str()) : 0;
+
+  m_atomLines.reserve(m_nAtoms);
+  for (std::size_t i = 0; i < m_nAtoms; i++) {
+    m_atomLines.push_back(pos);
+    if (!getLine() || isDelimiter()) {
+      throw FileParseError(_WHERE_, "Incomplete atom records");
+    }
+  }
+  m_bondLines.reserve(nBonds);
+  for (std::size_t i = 0; i < nBonds; i++) {
+    m_bondLines.push_back(pos);
+    if (!getLine() || isDelimiter()) {
+      throw FileParseError(_WHERE_, "Incomplete bond records");
+    }
+  }
+
+  // Data fields, from "> <name>" lines to the next blank line
+  bool bName = false;
+  while (getLine() && !isDelimiter()) {
+    if (line.compare(0, 1, ">") != 0) {
+      continue;
+    }
+    std::string::size_type ob = line.find('<');
+    std::string::size_type cb = line.rfind('>');
+    if (ob == std::string::npos || cb == std::string::npos || cb < ob) {
+      continue;
+    }
+    std::string fieldName = line.substr(ob + 1, cb - ob - 1);
+    bName = bName || fieldName == "Name";
+    std::vector<std::string> sl;
+    while (getLine() && !line.empty() && !isDelimiter()) {
+      sl.push_back(line);
+    }
+    m_dataFields.emplace_back(fieldName, sl);
+    if (isDelimiter()) {
+      break;
+    }
+  }
+  if (!bName) {
+    m_dataFields.emplace_back("Name", std::vector<std::string>{m_title});
+  }
+}
@@ -541,6 +541,9 @@ void Model::RotateBond(BondPtr spBond, double thetaDeg, bool bSwap) {
 }
 
 void Model::SaveCoords(const std::string &coordName) {
+  // Saved coords are changing, so the conformer arrays are out of date
+  m_conformerAtoms.clear();
+  m_conformerCoords.clear();
   // Look up the coord name in the map
   std::map<std::string, int>::const_iterator iter =
       m_coordNames.find(coordName);
@@ -589,6 +592,72 @@ void Model::RevertCoords(int i) {
   }
 }
 
+void Model::SetCurrentConformer(int i) {
+  if (i == m_currentCoord) {
+    return;
+  }
+  if (m_conformerCoords.size() != m_coordNames.size()) {
+    CreateConformerArrays();
+  }
+  if (i < 0 || i >= static_cast<int>(m_conformerCoords.size()) ||
+      m_conformerCoords[i].size() != m_conformerAtoms.size()) {
+    // Coord set is not available for every atom, let RevertCoords report it
+    RevertCoords(i);
+    return;
+  }
+  const CoordList &coords = m_conformerCoords[i];
+  for (std::size_t j = 0; j < m_conformerAtoms.size(); j++) {
+    m_conformerAtoms[j]->SetCoords(coords[j]);
+  }
+  UpdatePseudoAtoms();
+  m_currentCoord = i;
+}
+
+void Model::CreateConformerArrays() {
+  m_conformerAtoms.clear();
+  m_conformerCoords.clear();
+  unsigned int nCoords = m_coordNames.size();
+  // Only coord sets saved for all atoms can be used
+  std::vector<bool> bComplete(nCoords, true);
+  for (unsigned int i = 0; i < nCoords; i++) {
+    for (AtomListConstIter iter = m_atomList.begin();
+         bComplete[i] && iter != m_atomList.end(); iter++) {
+      bComplete[i] = (*iter)->HasSavedCoords(i);
+    }
+  }
+  // Atoms that are in the same place in every coord set never need updating
+  for (AtomListConstIter iter = m_atomList.begin(); iter != m_atomList.end();
+       iter++) {
+    const Coord *pFirst = nullptr;
+    for (unsigned int i = 0; i < nCoords; i++) {
+      if (!bComplete[i]) {
+        continue;
+      }
+      const Coord &c = (*iter)->GetSavedCoords(i);
+      if (pFirst == nullptr) {
+        pFirst = &c;
+      } else if (c != *pFirst) {
+        m_conformerAtoms.push_back(*iter);
+        break;
+      }
+    }
+  }
+  m_conformerCoords = std::vector<CoordList>(nCoords);
+  for (unsigned int i = 0; i < nCoords; i++) {
+    if (bComplete[i]) {
+      CoordList &coords = m_conformerCoords[i];
+      coords.reserve(m_conformerAtoms.size());
+      for (AtomRListConstIter iter = m_conformerAtoms.begin();
+           iter != m_conformerAtoms.end(); iter++) {
+        coords.push_back((*iter)->GetSavedCoords(i));
+      }
+    }
+  }
+  LOG_F(1, "Model::CreateConformerArrays: {} of {} atoms vary across {} "
+           "coord sets",
+        m_conformerAtoms.size(), m_atomList.size(), nCoords);
+}
+
 // Returns center of mass of model
 Coord Model::GetCenterOfMass() const {
   return GetCenterOfAtomicMass(m_atomList);
@@ -648,6 +717,10 @@ ChromElement *Model::GetChrom() const {
 
 bool Model::isFlexible() const { return !m_spMutator.Null(); }
 
+bool Model::isConformerSampled() const {
+  return (m_pFlexData != nullptr) && (GetNumSavedCoords() > 1);
+}
+
 const AtomRList &Model::GetFlexIntns(Atom *pAtom) const {
   if (isFlexible()) {
     // Check if atom is actually in the model
@@ -963,6 +1036,8 @@ void Model::Clear() {
     (*liter).clear();
   m_ringList.clear();   // Now clear the list of lists
   m_coordNames.clear(); // Clear map of named coords
+  m_conformerAtoms.clear();
+  m_conformerCoords.clear();
   m_dataMap.clear();    // DM 12 May 1999 - clear associated data
   ClearPseudoAtoms();
   SetFlexData(nullptr);
@@ -0,0 +1,443 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/ModelCache.h"
+#include "rxdock/CacheEntry.h"
+#include "rxdock/FileError.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <unordered_map>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <loguru.hpp>
+
+using namespace rxdock;
+
+const std::string ModelCache::_CT = "ModelCache";
+const std::string ModelCache::_MAGIC = "RXDOCKMC";
+const int ModelCache::_VERSION = 3;
+const std::string ModelCache::_MODEL_ENTRY = "model";
+
+namespace {
+
+void AppendCoord(std::vector<double> &xyz, const Coord &coord) {
+  xyz.push_back(coord.xyz(0));
+  xyz.push_back(coord.xyz(1));
+  xyz.push_back(coord.xyz(2));
+}
+
+// Returns the i-th coord of a flat x,y,z list
+Coord GetCoord(const std::vector<double> &xyz, std::size_t i) {
+  return Coord(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]);
+}
+
+// Creates the directory if it does not exist yet
+void MakeDirectory(const std::string &strDir) {
+  struct stat fStat;
+  if (stat(strDir.c_str(), &fStat) != 0) {
+#ifdef _WIN32
+    int status = _mkdir(strDir.c_str());
+#else
+    int status = mkdir(strDir.c_str(), 0777);
+#endif
+    // Another process may have created it in the meantime
+    if (status != 0 && stat(strDir.c_str(), &fStat) != 0) {
+      throw FileWriteError(_WHERE_, "Cannot create cache directory " + strDir);
+    }
+  }
+}
+
+} // namespace
+
+ModelCache::ModelCache(const std::string &strCacheDir)
+    : m_strCacheDir(strCacheDir) {
+  MakeDirectory(m_strCacheDir);
+}
+
+ModelPtr ModelCache::Load(const std::string &strKey) const {
+  std::string buf;
+  if (!LoadEntry(strKey, _MODEL_ENTRY, buf)) {
+    return ModelPtr();
+  }
+  std::string strFile = GetEntryFileName(strKey);
+  try {
+    ModelPtr spModel = ReadModel(buf);
+    LOG_F(INFO, "Loaded prepared model {} from cache entry {}",
+          spModel->GetName(), strFile);
+    return spModel;
+  } catch (std::exception &e) {
+    // A corrupt entry is treated as a cache miss; it will be overwritten
+    LOG_F(WARNING, "Ignoring unreadable model cache entry {}: {}", strFile,
+          e.what());
+    return ModelPtr();
+  }
+}
+
+void ModelCache::Save(const std::string &strKey, const Model &model) const {
+  if (SaveEntry(strKey, _MODEL_ENTRY, WriteModel(model))) {
+    LOG_F(INFO, "Saved prepared model {} to cache entry {}", model.GetName(),
+          GetEntryFileName(strKey));
+  }
+}
+
+bool ModelCache::LoadEntry(const std::string &strKey,
+                           const std::string &strType,
+                           std::string &buf) const {
+  std::string strFile = GetEntryFileName(strKey, strType);
+  std::ifstream inFile(strFile.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (!inFile) {
+    LOG_F(1, "ModelCache::LoadEntry: no cache entry {}", strFile);
+    return false;
+  }
+  inFile.seekg(0, std::ios_base::end);
+  std::size_t fileSize = inFile.tellg();
+  inFile.seekg(0);
+  std::string magic(_MAGIC.size(), ' ');
+  inFile.read(&magic[0], magic.size());
+  if (!inFile || magic != _MAGIC) {
+    LOG_F(WARNING, "Ignoring stale model cache entry {}", strFile);
+    return false;
+  }
+  std::string entry(fileSize - magic.size(), '\0');
+  inFile.read(&entry[0], entry.size());
+  if (!inFile) {
+    LOG_F(WARNING, "Ignoring unreadable model cache entry {}", strFile);
+    return false;
+  }
+  try {
+    CacheEntryReader reader(entry);
+    if (reader.Get<std::int32_t>() != _VERSION ||
+        reader.GetString() != strKey) {
+      LOG_F(WARNING, "Ignoring stale model cache entry {}", strFile);
+      return false;
+    }
+    buf = reader.GetString();
+    return true;
+  } catch (std::exception &e) {
+    LOG_F(WARNING, "Ignoring unreadable model cache entry {}: {}", strFile,
+          e.what());
+    return false;
+  }
+}
+
+bool ModelCache::SaveEntry(const std::string &strKey,
+                           const std::string &strType,
+                           const std::string &buf) const {
+  MakeDirectory(GetShardDir(strKey));
+  std::string strFile = GetEntryFileName(strKey, strType);
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = getpid();
+#endif
+  std::string strTmpFile = strFile + ".tmp" + std::to_string(pid);
+
+  CacheEntryWriter writer;
+  writer.Put<std::int32_t>(_VERSION);
+  writer.PutString(strKey);
+  writer.PutString(buf);
+  const std::string &entry = writer.GetBuffer();
+
+  std::ofstream outFile(strTmpFile.c_str(),
+                        std::ios_base::out | std::ios_base::binary |
+                            std::ios_base::trunc);
+  outFile.write(_MAGIC.data(), _MAGIC.size());
+  outFile.write(entry.data(), entry.size());
+  outFile.close();
+  if (!outFile) {
+    std::remove(strTmpFile.c_str());
+    throw FileWriteError(_WHERE_, "Error writing model cache entry " +
+                                      strTmpFile);
+  }
+  if (std::rename(strTmpFile.c_str(), strFile.c_str()) != 0) {
+    // Most likely another process won the race (rename does not replace an
+    // existing file on Windows); either way the entry is equivalent
+    LOG_F(WARNING, "Could not rename {} to {}", strTmpFile, strFile);
+    std::remove(strTmpFile.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string ModelCache::GetEntryFileName(const std::string &strKey,
+                                         const std::string &strType) const {
+  return GetShardDir(strKey) + "/" + strKey + "." + strType;
+}
+
+std::string ModelCache::GetShardDir(const std::string &strKey) const {
+  return m_strCacheDir + "/" + strKey.substr(0, 2);
+}
+
+// Atom and bond attributes are stored column-wise, as arrays of fixed-size
+// values in native byte order, so that a cached ligand loads several times
+// faster than it can be prepared from its SD record
+std::string ModelCache::WriteModel(const Model &model) {
+  std::size_t nAtoms = model.m_atomList.size();
+  std::unordered_map<const Atom *, std::uint64_t> atomIndex;
+  std::vector<std::int32_t> atomicNo, atomId, state, formalCharge, pmfType,
+      triposType;
+  std::vector<std::uint32_t> nHydrogens;
+  std::vector<std::string> atomName, subunitId, subunitName, segmentName,
+      ffType;
+  std::vector<std::uint8_t> atomCyclic, atomSelected, user1;
+  std::vector<double> user1Value, user2Value, coords, partialCharge,
+      groupCharge, atomicMass, vdwRadius;
+  // Atom indices and coords of each saved coordinate set
+  std::map<unsigned int, std::pair<std::vector<std::uint64_t>,
+                                   std::vector<double>>>
+      savedCoords;
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    const Atom &atom = *model.m_atomList[i];
+    atomIndex[&atom] = i;
+    atomicNo.push_back(atom.m_nAtomicNo);
+    atomId.push_back(atom.m_nAtomId);
+    atomName.push_back(atom.m_strAtomName);
+    subunitId.push_back(atom.m_strSubunitId);
+    subunitName.push_back(atom.m_strSubunitName);
+    segmentName.push_back(atom.m_strSegmentName);
+    state.push_back(atom.m_eState);
+    nHydrogens.push_back(atom.m_nHydrogens);
+    formalCharge.push_back(atom.m_nFormalCharge);
+    atomCyclic.push_back(atom.m_bCyclic);
+    atomSelected.push_back(atom.m_bSelected);
+    user1.push_back(atom.m_bUser1);
+    user1Value.push_back(atom.m_dUser1);
+    user2Value.push_back(atom.m_dUser2);
+    pmfType.push_back(atom.m_nPMFType);
+    triposType.push_back(atom.m_triposType);
+    AppendCoord(coords, atom.m_coord);
+    partialCharge.push_back(atom.m_dPartialCharge);
+    groupCharge.push_back(atom.m_dGroupCharge);
+    atomicMass.push_back(atom.m_dAtomicMass);
+    vdwRadius.push_back(atom.m_dVdwRadius);
+    ffType.push_back(atom.m_strFFType);
+    for (const auto &saved : atom.m_savedCoords) {
+      savedCoords[saved.first].first.push_back(i);
+      AppendCoord(savedCoords[saved.first].second, saved.second);
+    }
+  }
+
+  CacheEntryWriter writer;
+  writer.PutString(model.m_strName);
+  writer.PutStrings(model.m_titleList);
+  writer.Put<std::uint64_t>(nAtoms);
+  writer.PutValues(atomicNo);
+  writer.PutValues(atomId);
+  writer.PutStrings(atomName);
+  writer.PutStrings(subunitId);
+  writer.PutStrings(subunitName);
+  writer.PutStrings(segmentName);
+  writer.PutValues(state);
+  writer.PutValues(nHydrogens);
+  writer.PutValues(formalCharge);
+  writer.PutValues(atomCyclic);
+  writer.PutValues(atomSelected);
+  writer.PutValues(user1);
+  writer.PutValues(user1Value);
+  writer.PutValues(user2Value);
+  writer.PutValues(pmfType);
+  writer.PutValues(triposType);
+  writer.PutValues(coords);
+  writer.PutValues(partialCharge);
+  writer.PutValues(groupCharge);
+  writer.PutValues(atomicMass);
+  writer.PutValues(vdwRadius);
+  writer.PutStrings(ffType);
+  writer.Put<std::uint64_t>(savedCoords.size());
+  for (const auto &saved : savedCoords) {
+    writer.Put<std::uint32_t>(saved.first);
+    writer.PutValues(saved.second.first);
+    writer.PutValues(saved.second.second);
+  }
+
+  std::vector<std::int32_t> bondId, formalOrder;
+  std::vector<std::uint64_t> atom1, atom2;
+  std::vector<double> partialOrder;
+  std::vector<std::uint8_t> bondCyclic, bondSelected;
+  for (const auto &spBond : model.m_bondList) {
+    bondId.push_back(spBond->GetBondId());
+    atom1.push_back(atomIndex.at(spBond->GetAtom1Ptr().Ptr()));
+    atom2.push_back(atomIndex.at(spBond->GetAtom2Ptr().Ptr()));
+    formalOrder.push_back(spBond->GetFormalBondOrder());
+    partialOrder.push_back(spBond->GetPartialBondOrder());
+    bondCyclic.push_back(spBond->GetCyclicFlag());
+    bondSelected.push_back(spBond->GetSelectionFlag());
+  }
+  writer.Put<std::uint64_t>(model.m_bondList.size());
+  writer.PutValues(bondId);
+  writer.PutValues(atom1);
+  writer.PutValues(atom2);
+  writer.PutValues(formalOrder);
+  writer.PutValues(partialOrder);
+  writer.PutValues(bondCyclic);
+  writer.PutValues(bondSelected);
+
+  writer.Put<std::uint64_t>(model.m_ringList.size());
+  for (const auto &ring : model.m_ringList) {
+    std::vector<std::uint64_t> ringIndices;
+    for (const auto &spAtom : ring) {
+      ringIndices.push_back(atomIndex.at(spAtom.Ptr()));
+    }
+    writer.PutValues(ringIndices);
+  }
+
+  writer.Put<std::uint64_t>(model.m_coordNames.size());
+  for (const auto &coordName : model.m_coordNames) {
+    writer.PutString(coordName.first);
+    writer.Put<std::int32_t>(coordName.second);
+  }
+  writer.Put<std::int32_t>(model.m_currentCoord);
+  // The data fields of a freshly read model are all string lists (see
+  // MdlFileSource), which is all a Variant needs to be rebuilt from
+  writer.Put<std::uint64_t>(model.m_dataMap.size());
+  for (const auto &data : model.m_dataMap) {
+    writer.PutString(data.first);
+    writer.PutStrings(data.second.GetStringList());
+  }
+  writer.Put<double>(model.m_occupancy);
+  writer.Put<std::uint8_t>(model.m_enabled);
+  return writer.GetBuffer();
+}
+
+ModelPtr ModelCache::ReadModel(const std::string &buf) {
+  CacheEntryReader reader(buf);
+  std::string strName = reader.GetString();
+  std::vector<std::string> titleList = reader.GetStrings();
+
+  std::size_t nAtoms = reader.Get<std::uint64_t>();
+  std::vector<std::int32_t> atomicNo = reader.GetColumn<std::int32_t>(nAtoms);
+  std::vector<std::int32_t> atomId = reader.GetColumn<std::int32_t>(nAtoms);
+  std::vector<std::string> atomName = reader.GetStringColumn(nAtoms);
+  std::vector<std::string> subunitId = reader.GetStringColumn(nAtoms);
+  std::vector<std::string> subunitName = reader.GetStringColumn(nAtoms);
+  std::vector<std::string> segmentName = reader.GetStringColumn(nAtoms);
+  std::vector<std::int32_t> state = reader.GetColumn<std::int32_t>(nAtoms);
+  std::vector<std::uint32_t> nHydrogens =
+      reader.GetColumn<std::uint32_t>(nAtoms);
+  std::vector<std::int32_t> formalCharge =
+      reader.GetColumn<std::int32_t>(nAtoms);
+  std::vector<std::uint8_t> atomCyclic = reader.GetColumn<std::uint8_t>(nAtoms);
+  std::vector<std::uint8_t> atomSelected =
+      reader.GetColumn<std::uint8_t>(nAtoms);
+  std::vector<std::uint8_t> user1 = reader.GetColumn<std::uint8_t>(nAtoms);
+  std::vector<double> user1Value = reader.GetColumn<double>(nAtoms);
+  std::vector<double> user2Value = reader.GetColumn<double>(nAtoms);
+  std::vector<std::int32_t> pmfType = reader.GetColumn<std::int32_t>(nAtoms);
+  std::vector<std::int32_t> triposType =
+      reader.GetColumn<std::int32_t>(nAtoms);
+  std::vector<double> coords = reader.GetColumn<double>(3 * nAtoms);
+  std::vector<double> partialCharge = reader.GetColumn<double>(nAtoms);
+  std::vector<double> groupCharge = reader.GetColumn<double>(nAtoms);
+  std::vector<double> atomicMass = reader.GetColumn<double>(nAtoms);
+  std::vector<double> vdwRadius = reader.GetColumn<double>(nAtoms);
+  std::vector<std::string> ffType = reader.GetStringColumn(nAtoms);
+
+  AtomList atomList;
+  atomList.reserve(nAtoms);
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    AtomPtr spAtom(new Atom());
+    Atom &atom = *spAtom;
+    atom.m_nAtomicNo = atomicNo[i];
+    atom.m_nAtomId = atomId[i];
+    atom.m_strAtomName = atomName[i];
+    atom.m_strSubunitId = subunitId[i];
+    atom.m_strSubunitName = subunitName[i];
+    atom.m_strSegmentName = segmentName[i];
+    atom.m_eState = static_cast<Atom::eHybridState>(state[i]);
+    atom.m_nHydrogens = nHydrogens[i];
+    atom.m_nFormalCharge = formalCharge[i];
+    atom.m_bCyclic = atomCyclic[i];
+    atom.m_bSelected = atomSelected[i];
+    atom.m_bUser1 = user1[i];
+    atom.m_dUser1 = user1Value[i];
+    atom.m_dUser2 = user2Value[i];
+    atom.m_nPMFType = static_cast<PMFType>(pmfType[i]);
+    atom.m_triposType = static_cast<TriposAtomType::eType>(triposType[i]);
+    atom.m_coord = GetCoord(coords, i);
+    atom.m_dPartialCharge = partialCharge[i];
+    atom.m_dGroupCharge = groupCharge[i];
+    atom.m_dAtomicMass = atomicMass[i];
+    atom.m_dVdwRadius = vdwRadius[i];
+    atom.m_strFFType = ffType[i];
+    atomList.push_back(spAtom);
+  }
+  std::size_t nSavedCoords = reader.Get<std::uint64_t>();
+  for (std::size_t iSaved = 0; iSaved < nSavedCoords; iSaved++) {
+    unsigned int coordNum = reader.Get<std::uint32_t>();
+    std::vector<std::uint64_t> savedAtoms = reader.GetValues<std::uint64_t>();
+    std::vector<double> savedXyz =
+        reader.GetColumn<double>(3 * savedAtoms.size());
+    for (std::size_t i = 0; i < savedAtoms.size(); i++) {
+      atomList.at(savedAtoms[i])->m_savedCoords[coordNum] =
+          GetCoord(savedXyz, i);
+    }
+  }
+
+  std::size_t nBonds = reader.Get<std::uint64_t>();
+  std::vector<std::int32_t> bondId = reader.GetColumn<std::int32_t>(nBonds);
+  std::vector<std::uint64_t> atom1 = reader.GetColumn<std::uint64_t>(nBonds);
+  std::vector<std::uint64_t> atom2 = reader.GetColumn<std::uint64_t>(nBonds);
+  std::vector<std::int32_t> formalOrder =
+      reader.GetColumn<std::int32_t>(nBonds);
+  std::vector<double> partialOrder = reader.GetColumn<double>(nBonds);
+  std::vector<std::uint8_t> bondCyclic = reader.GetColumn<std::uint8_t>(nBonds);
+  std::vector<std::uint8_t> bondSelected =
+      reader.GetColumn<std::uint8_t>(nBonds);
+  BondList bondList;
+  bondList.reserve(nBonds);
+  for (std::size_t i = 0; i < nBonds; i++) {
+    // Bond constructor registers the bond with both atoms
+    BondPtr spBond(new Bond(bondId[i], atomList.at(atom1[i]),
+                            atomList.at(atom2[i]), formalOrder[i]));
+    spBond->SetPartialBondOrder(partialOrder[i]);
+    spBond->SetCyclicFlag(bondCyclic[i]);
+    spBond->SetSelectionFlag(bondSelected[i]);
+    bondList.push_back(spBond);
+  }
+
+  ModelPtr spModel(new Model(atomList, bondList));
+  spModel->m_strName = strName;
+  spModel->m_titleList = titleList;
+  std::size_t nRings = reader.Get<std::uint64_t>();
+  for (std::size_t iRing = 0; iRing < nRings; iRing++) {
+    AtomList ringAtoms;
+    for (auto index : reader.GetValues<std::uint64_t>()) {
+      ringAtoms.push_back(atomList.at(index));
+    }
+    spModel->m_ringList.push_back(ringAtoms);
+  }
+  std::size_t nCoordNames = reader.Get<std::uint64_t>();
+  for (std::size_t i = 0; i < nCoordNames; i++) {
+    std::string strCoordName = reader.GetString();
+    spModel->m_coordNames[strCoordName] = reader.Get<std::int32_t>();
+  }
+  spModel->m_currentCoord = reader.Get<std::int32_t>();
+  std::size_t nData = reader.Get<std::uint64_t>();
+  for (std::size_t i = 0; i < nData; i++) {
+    std::string strField = reader.GetString();
+    spModel->m_dataMap[strField] = Variant(reader.GetStrings());
+  }
+  spModel->m_occupancy = reader.Get<double>();
+  spModel->m_enabled = reader.Get<std::uint8_t>() != 0;
+  return spModel;
+}
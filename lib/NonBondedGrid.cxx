@@ -132,6 +132,13 @@ const AtomRList &NonBondedGrid::GetAtomList(const Coord &c) const {
 /////////////////////////
 // Set attribute functions
 /////////////////////////
+void NonBondedGrid::SetAtomList(unsigned int iXYZ,
+                                const AtomRList &atomList) {
+  if (isValid(iXYZ)) {
+    m_atomMap[iXYZ] = atomList;
+  }
+}
+
 void NonBondedGrid::SetAtomLists(Atom *pAtom, double radius) {
   const Coord &c = pAtom->GetCoords();
   std::vector<unsigned int> sphereIndices;
@@ -93,6 +93,13 @@ const HHS_SolvationRList &NonBondedHHSGrid::GetHHSList(const Coord &c) const {
   }
 }
 
+void NonBondedHHSGrid::SetHHSList(unsigned int iXYZ,
+                                  const HHS_SolvationRList &hhsList) {
+  if (isValid(iXYZ)) {
+    m_hhsMap[iXYZ] = hhsList;
+  }
+}
+
 void NonBondedHHSGrid::SetHHSLists(HHS_Solvation *pHHS, double radius) {
   const Coord &c = (pHHS->GetAtom())->GetCoords();
   std::vector<unsigned int> sphereIndices;
@@ -13,9 +13,11 @@
 #include "rxdock/PRMFactory.h"
 #include "rxdock/ChromPositionRefData.h"
 #include "rxdock/CrdFileSource.h"
+#include "rxdock/Hasher.h"
 #include "rxdock/LigandFlexData.h"
 #include "rxdock/MOL2FileSource.h"
 #include "rxdock/MdlFileSource.h"
+#include "rxdock/ModelCache.h"
 #include "rxdock/ParameterFileSource.h"
 #include "rxdock/PdbFileSource.h"
 #include "rxdock/PsfFileSource.h"
@@ -37,6 +39,9 @@ const std::string &PRMFactory::_REC_NUM_COORD_FILES =
 const std::string &PRMFactory::_REC_FLEX_DISTANCE = "flexibility-distance";
 const std::string &PRMFactory::_REC_DIHEDRAL_STEP =
     "dihedral-maximum-mutation-step";
+const std::string &PRMFactory::_REC_SAMPLE_CONFORMERS = "sample-conformers";
+const std::string &PRMFactory::_REC_CONFORMER_STEP =
+    "conformer-mutation-probability";
 const std::string &PRMFactory::_REC_ALL_H = "keep-all-hydrogens";
 const std::string &PRMFactory::_REC_MASSES_FILE = "masses-file";
 const std::string &PRMFactory::_REC_SEGMENT_NAME = "segment-name";
@@ -45,10 +50,11 @@ const std::string &PRMFactory::_SOLV_SECTION = "solvent";
 const std::string &PRMFactory::_SOLV_FILE = "file";
 
 PRMFactory::PRMFactory(ParameterFileSource *pParamSource)
-    : m_pParamSource(pParamSource), m_pDS(nullptr) {}
+    : m_pParamSource(pParamSource), m_pDS(nullptr), m_pCache(nullptr) {}
 
 PRMFactory::PRMFactory(ParameterFileSource *pParamSource, DockingSite *pDS)
-    : m_pParamSource(pParamSource), m_pDS(pDS) {}
+    : m_pParamSource(pParamSource), m_pDS(pDS), m_pCache(nullptr) {}
+
 ModelPtr PRMFactory::CreateReceptor() {
   ModelPtr retVal;
 
@@ -56,6 +62,30 @@ ModelPtr PRMFactory::CreateReceptor() {
   std::string title = m_pParamSource->GetTitle();
   LOG_F(INFO, "Using parameter file: {}", title);
 
+  std::string strCacheKey;
+  if (m_pCache) {
+    strCacheKey = GetReceptorCacheKey();
+    retVal = m_pCache->Load(strCacheKey);
+  }
+  if (retVal.Null()) {
+    retVal = ReadReceptor();
+    if (m_pCache) {
+      m_pCache->Save(strCacheKey, *retVal);
+    }
+  }
+
+  // If the docking site is defined, then we can define the
+  // receptor flexibility
+  if (m_pDS) {
+    AttachReceptorFlexData(retVal);
+  }
+
+  return retVal;
+}
+
+ModelPtr PRMFactory::ReadReceptor() {
+  ModelPtr retVal;
+
   m_pParamSource->SetSection(_REC_SECTION);
   // Detect if we have an ensemble of receptor coordinate files defined
   bool bEnsemble =
@@ -159,15 +189,38 @@ ModelPtr PRMFactory::CreateReceptor() {
     LOG_F(INFO, "Total number of receptor conformations read = {}", nCoords);
   }
 
-  // If the docking site is defined, then we can define the
-  // receptor flexibility
-  if (m_pDS) {
-    AttachReceptorFlexData(retVal);
-  }
-
   return retVal;
 }
 
+std::string PRMFactory::GetReceptorCacheKey() {
+  Hasher hasher;
+  hasher.Add(std::to_string(ModelCache::_VERSION));
+  hasher.Add(GetProgramVersion());
+  // Ring perception can be disabled from the environment
+  hasher.Add(std::getenv("RBT_NORINGS") ? "norings" : "rings");
+
+  // Parameter file gets parsed here if it has not been already, as parsing
+  // resets the current section
+  m_pParamSource->GetTitle();
+  m_pParamSource->SetSection(_REC_SECTION);
+  std::vector<std::string> paramList = m_pParamSource->GetParameterList();
+  std::sort(paramList.begin(), paramList.end());
+  for (const auto &paramName : paramList) {
+    std::string strValue = m_pParamSource->GetParameterValueAsString(paramName);
+    hasher.Add(paramName);
+    hasher.Add(strValue);
+    // Hash the contents of every molecular file referenced, so the key changes
+    // whenever the receptor changes on disk
+    if (paramName == _REC_FILE || paramName == _REC_TOPOL_FILE ||
+        paramName.compare(0, _REC_COORD_FILE.size(), _REC_COORD_FILE) == 0) {
+      hasher.AddFile(GetDataFileName("", strValue));
+    } else if (paramName == _REC_MASSES_FILE) {
+      hasher.AddFile(GetDataFileName("data", strValue));
+    }
+  }
+  return hasher.GetDigest();
+}
+
 ModelPtr PRMFactory::CreateLigand(BaseMolecularFileSource *pSource) {
   ModelPtr retVal;
   // TODO: Move some of the status checks from rbdock to here.
@@ -302,6 +355,27 @@ void PRMFactory::AttachReceptorFlexData(Model *pReceptor) {
     pReceptor->SetFlexData(pFlexData);
     LOG_F(INFO, "RECEPTOR FLEXIBILITY PARAMETERS: {}", *pFlexData);
   }
+  // Receptor ensembles: the receptor conformer is sampled during docking if
+  // requested. Otherwise the union of all conformers is scored, as before
+  else if ((pReceptor->GetNumSavedCoords() > 1) &&
+           m_pParamSource->isParameterPresent(_REC_SAMPLE_CONFORMERS) &&
+           Variant(m_pParamSource->GetParameterValueAsString(
+                       _REC_SAMPLE_CONFORMERS))
+               .GetBool()) {
+    LOG_F(INFO, "Receptor conformer will be sampled from the ensemble");
+    FlexData *pFlexData = new ReceptorFlexData(m_pDS);
+    pFlexData->SetParameter(ReceptorFlexData::_FLEX_DISTANCE, 0.0);
+    if (m_pParamSource->isParameterPresent(_REC_CONFORMER_STEP)) {
+      double conformerStepSize =
+          m_pParamSource->GetParameterValue(_REC_CONFORMER_STEP);
+      pFlexData->SetParameter(ReceptorFlexData::_CONFORMER_STEP,
+                              conformerStepSize);
+      LOG_F(INFO, "{}::{} = {}", _REC_SECTION, _REC_CONFORMER_STEP,
+            conformerStepSize);
+    }
+    pReceptor->SetFlexData(pFlexData);
+    LOG_F(INFO, "RECEPTOR FLEXIBILITY PARAMETERS: {}", *pFlexData);
+  }
 }
 
 void PRMFactory::AttachLigandFlexData(Model *pLigand) {
@@ -12,6 +12,7 @@
 
 #include "rxdock/PolarIdxSF.h"
 #include "rxdock/Plane.h"
+#include "rxdock/PseudoAtom.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
@@ -110,27 +111,46 @@ void PolarIdxSF::SetupReceptor() {
   int nCoords = GetReceptor()->GetNumSavedCoords() - 1;
   if (nCoords > 0) {
     AtomList atomList = GetReceptor()->GetAtomList();
-    m_spPosGrid = CreateInteractionGrid();
     m_recepPosList = CreateDonorInteractionCenters(atomList);
-    m_spNegGrid = CreateInteractionGrid();
     m_recepNegList = CreateAcceptorInteractionCenters(atomList);
+    // Sampled conformers get a grid each, so that only the interaction
+    // centers of the current conformer are scored. Otherwise the union of all
+    // conformers is indexed
+    bool bSampled = GetReceptor()->isConformerSampled();
+    if (!bSampled) {
+      m_spPosGrid = CreateInteractionGrid();
+      m_spNegGrid = CreateInteractionGrid();
+    }
     for (int i = 1; i <= nCoords; i++) {
       LOG_F(1, "PolarIdxSF::SetupReceptor: Indexing receptor coords # {}", i);
-      GetReceptor()->RevertCoords(i);
+      GetReceptor()->SetCurrentConformer(i);
+      InteractionGridPtr spPosGrid = m_spPosGrid;
+      InteractionGridPtr spNegGrid = m_spNegGrid;
+      if (bSampled) {
+        spPosGrid = CreateInteractionGrid();
+        spNegGrid = CreateInteractionGrid();
+        m_conformerPosGrids.push_back(spPosGrid);
+        m_conformerNegGrids.push_back(spNegGrid);
+      }
       for (InteractionCenterListConstIter iter = m_recepPosList.begin();
            iter != m_recepPosList.end(); iter++) {
         double rvdw = (*iter)->GetAtom1Ptr()->GetVdwRadius();
-        m_spPosGrid->SetInteractionLists(*iter, rvdw + idxIncr);
+        spPosGrid->SetInteractionLists(*iter, rvdw + idxIncr);
       }
-      m_spPosGrid->UniqueInteractionLists();
       for (InteractionCenterListConstIter iter = m_recepNegList.begin();
            iter != m_recepNegList.end(); iter++) {
         double rvdw = (*iter)->GetAtom1Ptr()->GetVdwRadius();
-        m_spNegGrid->SetInteractionLists(*iter, rvdw + idxIncr);
+        spNegGrid->SetInteractionLists(*iter, rvdw + idxIncr);
+      }
+      if (!bSampled) {
+        m_spPosGrid->UniqueInteractionLists();
+        m_spNegGrid->UniqueInteractionLists();
       }
-      m_spNegGrid->UniqueInteractionLists();
     }
   } else {
+    if (LoadReceptorSetup(GetReceptor())) {
+      return;
+    }
     AtomList atomList = spDS->GetAtomList(GetReceptor()->GetAtomList(), 0.0,
                                           GetCorrectedRange());
     m_spPosGrid = CreateInteractionGrid();
@@ -214,6 +234,144 @@ void PolarIdxSF::SetupReceptor() {
       double rvdw = (*iter)->GetAtom1Ptr()->GetVdwRadius();
       m_spNegGrid->SetInteractionLists(*iter, rvdw + idxIncr);
     }
+    SaveReceptorSetup(GetReceptor());
+  }
+}
+
+// The interaction centers are written as the indices of their atoms in the
+// receptor atom list, followed by the pseudo atoms they refer to (which are
+// written as their constituent atoms and recreated on reading). The grids and
+// interaction maps refer to the interaction centers by their index in the
+// concatenated receptor lists
+void PolarIdxSF::WriteReceptorSetup(CacheEntryWriter &writer) const {
+  AtomRList atomTable = GetReceptorAtomTable(GetReceptor());
+  CacheIndexMap<Atom> atomIndex = CreateCacheIndexMap(atomTable);
+  InteractionCenterList icTable;
+  for (const auto *pList : {&m_recepPosList, &m_flexRecPosList,
+                            &m_recepNegList, &m_flexRecNegList}) {
+    writer.Put<std::uint64_t>(pList->size());
+    std::copy(pList->begin(), pList->end(), std::back_inserter(icTable));
+  }
+
+  AtomRListList pseudoAtoms;
+  std::vector<std::int32_t> atomRefs;
+  std::vector<std::uint8_t> lp;
+  for (const auto *pIC : icTable) {
+    for (Atom *pAtom :
+         {pIC->GetAtom1Ptr(), pIC->GetAtom2Ptr(), pIC->GetAtom3Ptr()}) {
+      if (pAtom == nullptr) {
+        atomRefs.push_back(-1);
+        continue;
+      }
+      auto iter = atomIndex.find(pAtom);
+      if (iter == atomIndex.end()) {
+        AtomRList constituents;
+        for (auto &spAtom :
+             dynamic_cast<PseudoAtom *>(pAtom)->GetAtomList()) {
+          constituents.push_back(spAtom.Ptr());
+        }
+        pseudoAtoms.push_back(constituents);
+        iter = atomIndex.emplace(pAtom, atomIndex.size()).first;
+      }
+      atomRefs.push_back(iter->second);
+    }
+    lp.push_back(pIC->LP());
+  }
+  writer.Put<std::uint64_t>(pseudoAtoms.size());
+  writer.PutIndexLists(pseudoAtoms, atomIndex);
+  writer.PutValues(atomRefs);
+  writer.PutValues(lp);
+
+  CacheIndexMap<InteractionCenter> icIndex = CreateCacheIndexMap(icTable);
+  for (const auto *pGrid : {m_spPosGrid.Ptr(), m_spNegGrid.Ptr()}) {
+    writer.PutIndexLists(
+        pGrid->GetN(),
+        [pGrid](std::size_t i) -> const InteractionCenterList & {
+          return pGrid->GetInteractionList(i);
+        },
+        icIndex);
+  }
+  writer.PutIndexLists(m_flexRecIntns, icIndex);
+  writer.PutIndexLists(m_flexRecPrtIntns, icIndex);
+}
+
+void PolarIdxSF::ReadReceptorSetup(CacheEntryReader &reader) {
+  AtomList atomList = GetReceptor()->GetAtomList();
+  std::size_t nAtoms = atomList.size();
+  std::size_t nIntns = m_bFlexRec ? nAtoms : 0;
+  std::vector<std::size_t> listSizes;
+  std::size_t nICs = 0;
+  for (int i = 0; i < 4; i++) {
+    listSizes.push_back(reader.Get<std::uint64_t>());
+    nICs += listSizes.back();
+  }
+  std::size_t nPseudoAtoms = reader.Get<std::uint64_t>();
+  std::vector<std::vector<std::uint32_t>> pseudoAtoms =
+      reader.GetIndexLists(nPseudoAtoms, nAtoms);
+  std::vector<std::int32_t> atomRefs =
+      reader.GetColumn<std::int32_t>(3 * nICs);
+  std::vector<std::uint8_t> lp = reader.GetColumn<std::uint8_t>(nICs);
+  for (std::size_t i = 0; i < atomRefs.size(); i++) {
+    // Every interaction center has an atom 1
+    std::int32_t minRef = (i % 3 == 0) ? 0 : -1;
+    if (atomRefs[i] < minRef ||
+        atomRefs[i] >= static_cast<std::int32_t>(nAtoms + nPseudoAtoms)) {
+      throw std::length_error("Receptor setup atom index out of range");
+    }
+  }
+  for (auto value : lp) {
+    if (value > InteractionCenter::LONEPAIR) {
+      throw std::length_error("Receptor setup lone pair type out of range");
+    }
+  }
+  InteractionGridPtr spPosGrid = CreateInteractionGrid();
+  InteractionGridPtr spNegGrid = CreateInteractionGrid();
+  std::vector<std::vector<std::uint32_t>> posCells =
+      reader.GetIndexLists(spPosGrid->GetN(), nICs);
+  std::vector<std::vector<std::uint32_t>> negCells =
+      reader.GetIndexLists(spNegGrid->GetN(), nICs);
+  std::vector<std::vector<std::uint32_t>> flexIntns =
+      reader.GetIndexLists(nIntns, nICs);
+  std::vector<std::vector<std::uint32_t>> flexPrtIntns =
+      reader.GetIndexLists(nIntns, nICs);
+
+  AtomRList atomTable = GetReceptorAtomTable(GetReceptor());
+  for (const auto &indices : pseudoAtoms) {
+    AtomList constituents;
+    for (auto index : indices) {
+      constituents.push_back(atomList[index]);
+    }
+    atomTable.push_back(GetReceptor()->AddPseudoAtom(constituents).Ptr());
+  }
+  InteractionCenterList icTable;
+  for (std::size_t i = 0; i < nICs; i++) {
+    Atom *pAtoms[3];
+    for (int j = 0; j < 3; j++) {
+      std::int32_t ref = atomRefs[3 * i + j];
+      pAtoms[j] = (ref < 0) ? nullptr : atomTable[ref];
+    }
+    icTable.push_back(
+        new InteractionCenter(pAtoms[0], pAtoms[1], pAtoms[2],
+                              static_cast<InteractionCenter::eLP>(lp[i])));
+  }
+  InteractionCenterListConstIter iter = icTable.begin();
+  std::vector<InteractionCenterList *> lists{
+      &m_recepPosList, &m_flexRecPosList, &m_recepNegList, &m_flexRecNegList};
+  for (std::size_t i = 0; i < lists.size(); i++) {
+    lists[i]->assign(iter, iter + listSizes[i]);
+    iter += listSizes[i];
+  }
+  m_spPosGrid = spPosGrid;
+  m_spNegGrid = spNegGrid;
+  for (std::size_t i = 0; i < posCells.size(); i++) {
+    m_spPosGrid->SetInteractionList(i, GetCachedPointers(posCells[i], icTable));
+  }
+  for (std::size_t i = 0; i < negCells.size(); i++) {
+    m_spNegGrid->SetInteractionList(i, GetCachedPointers(negCells[i], icTable));
+  }
+  for (std::size_t i = 0; i < nIntns; i++) {
+    m_flexRecIntns.push_back(GetCachedPointers(flexIntns[i], icTable));
+    m_flexRecPrtIntns.push_back(GetCachedPointers(flexPrtIntns[i], icTable));
   }
 }
 
@@ -274,11 +432,41 @@ double PolarIdxSF::RawScore() const {
          SolventScore() + ReceptorSolventScore();
 }
 
+// Analytic gradient is implemented for the receptor-ligand and
+// intra-receptor terms only, i.e. not in the presence of explicit solvent
+bool PolarIdxSF::RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                  double scale) const {
+  if (m_bSolvent) {
+    return false;
+  }
+  score = InterScoreGradient(m_ligPosList, m_ligNegList, gradient, scale);
+  if (m_bFlexRec) {
+    score += IntraScoreGradient(m_flexRecPosList, m_flexRecNegList,
+                                m_flexRecPrtIntns, m_bAttr, gradient, scale);
+  }
+  return true;
+}
+
+int PolarIdxSF::GetConformerGridIndex() const {
+  if (m_conformerPosGrids.empty()) {
+    return -1;
+  }
+  int iConformer = GetReceptor()->GetCurrentCoords();
+  if (iConformer < 1 ||
+      iConformer > static_cast<int>(m_conformerPosGrids.size())) {
+    throw InvalidRequest(_WHERE_, "No indexing grids for receptor coords #" +
+                                      std::to_string(iConformer));
+  }
+  return iConformer - 1;
+}
+
 // Clear the receptor and ligand grids and lists respectively
 // As we are not using smart pointers, there is some memory management to do
 void PolarIdxSF::ClearReceptor() {
   m_spPosGrid = InteractionGridPtr();
   m_spNegGrid = InteractionGridPtr();
+  m_conformerPosGrids.clear();
+  m_conformerNegGrids.clear();
   m_flexRecIntns.clear();
   m_flexRecPrtIntns.clear();
   m_bFlexRec = false;
@@ -401,8 +589,15 @@ double PolarIdxSF::InterScore(const InteractionCenterList &posList,
     m_nNeg = 0;
   }
 
+  const InteractionGrid *pPosGrid = m_spPosGrid.Ptr();
+  const InteractionGrid *pNegGrid = m_spNegGrid.Ptr();
+  int iConformer = GetConformerGridIndex();
+  if (iConformer >= 0) {
+    pPosGrid = m_conformerPosGrids[iConformer].Ptr();
+    pNegGrid = m_conformerNegGrids[iConformer].Ptr();
+  }
   // Check grid is defined
-  if (m_spPosGrid.Null() || m_spNegGrid.Null())
+  if (pPosGrid == nullptr || pNegGrid == nullptr)
     return score;
 
   PolarSF::f1prms Rprms = GetRprms();   // Distance params
@@ -419,13 +614,13 @@ double PolarIdxSF::InterScore(const InteractionCenterList &posList,
     // adjacent +ve centres (HBD/M+/guan)
     if (m_bAttr) {
       const InteractionCenterList &rList =
-          m_spPosGrid->GetInteractionList(cLig1);
+          pPosGrid->GetInteractionList(cLig1);
       s = PolarScore(*lIter, rList, Rprms, A2prms, A1prms);
     } else {
       // If this is an repulsive potential we calculate the score with all
       // adjacent HBA
       const InteractionCenterList &rList =
-          m_spNegGrid->GetInteractionList(cLig1);
+          pNegGrid->GetInteractionList(cLig1);
       s = PolarScore(*lIter, rList, Rprms, A2prms, A2prms);
     }
     s *= pLig1->GetUser1Value();
@@ -444,13 +639,13 @@ double PolarIdxSF::InterScore(const InteractionCenterList &posList,
     // adjacent HBA
     if (m_bAttr) {
       const InteractionCenterList &rList =
-          m_spNegGrid->GetInteractionList(cLig1);
+          pNegGrid->GetInteractionList(cLig1);
       s = PolarScore(*lIter, rList, Rprms, A1prms, A2prms);
     } else {
       // If this is an repulsive potential we calculate the score with all
       // adjacent +ve centres (HBD/M+/guan)
       const InteractionCenterList &rList =
-          m_spPosGrid->GetInteractionList(cLig1);
+          pPosGrid->GetInteractionList(cLig1);
       s = PolarScore(*lIter, rList, Rprms, A1prms, A1prms);
     }
     s *= pLig1->GetUser1Value();
@@ -461,3 +656,51 @@ double PolarIdxSF::InterScore(const InteractionCenterList &posList,
   }
   return score;
 }
+
+// As InterScore, also adding the gradient of scale times the score to
+// gradient. The counts of positive and negative centers are not updated
+double PolarIdxSF::InterScoreGradient(const InteractionCenterList &posList,
+                                      const InteractionCenterList &negList,
+                                      AtomGradientMap &gradient,
+                                      double scale) const {
+  double score = 0.0;
+  const InteractionGrid *pPosGrid = m_spPosGrid.Ptr();
+  const InteractionGrid *pNegGrid = m_spNegGrid.Ptr();
+  int iConformer = GetConformerGridIndex();
+  if (iConformer >= 0) {
+    pPosGrid = m_conformerPosGrids[iConformer].Ptr();
+    pNegGrid = m_conformerNegGrids[iConformer].Ptr();
+  }
+  if (pPosGrid == nullptr || pNegGrid == nullptr)
+    return score;
+
+  PolarSF::f1prms Rprms = GetRprms();   // Distance params
+  PolarSF::f1prms A1prms = GetA1prms(); // Donor angle params
+  PolarSF::f1prms A2prms = GetA2prms(); // Acceptor angle params
+
+  // Ligand HBA, with adjacent +ve centres if attractive, else adjacent HBA
+  for (InteractionCenterListConstIter lIter = negList.begin();
+       lIter != negList.end(); lIter++) {
+    Atom *pLig1 = (*lIter)->GetAtom1Ptr();
+    const InteractionGrid *pGrid = m_bAttr ? pPosGrid : pNegGrid;
+    const InteractionCenterList &rList =
+        pGrid->GetInteractionList(pLig1->GetCoords());
+    double u = pLig1->GetUser1Value();
+    score += u * PolarScoreGradient(*lIter, rList, Rprms, A2prms,
+                                    m_bAttr ? A1prms : A2prms, gradient,
+                                    scale * u);
+  }
+  // Ligand HBD, with adjacent HBA if attractive, else adjacent +ve centres
+  for (InteractionCenterListConstIter lIter = posList.begin();
+       lIter != posList.end(); lIter++) {
+    Atom *pLig1 = (*lIter)->GetAtom1Ptr();
+    const InteractionGrid *pGrid = m_bAttr ? pNegGrid : pPosGrid;
+    const InteractionCenterList &rList =
+        pGrid->GetInteractionList(pLig1->GetCoords());
+    double u = pLig1->GetUser1Value();
+    score += u * PolarScoreGradient(*lIter, rList, Rprms, A1prms,
+                                    m_bAttr ? A2prms : A1prms, gradient,
+                                    scale * u);
+  }
+  return score;
+}
@@ -12,6 +12,7 @@
 
 #include "rxdock/PolarSF.h"
 #include "rxdock/Plane.h"
+#include "rxdock/PseudoAtom.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
@@ -45,6 +46,78 @@ const std::string PolarSF::_LP_DPHIMAX = "lp-dphi-maximum";
 const std::string PolarSF::_LP_DTHETAMIN = "lp-dtheta-minimum";
 const std::string PolarSF::_LP_DTHETAMAX = "lp-dtheta-maximum";
 
+namespace {
+
+const double _RAD_TO_DEG = 180.0 / M_PI;
+
+inline double Sign(double x) { return (x < 0.0) ? -1.0 : 1.0; }
+
+// Adds w times the gradient of Angle(c1, c2, c3), in degrees, with respect to
+// each of the coords to g1, g2 and g3
+void AddAngleGradient(const Coord &c1, const Coord &c2, const Coord &c3,
+                      double w, Vector &g1, Vector &g2, Vector &g3) {
+  Vector u = c1 - c2;
+  Vector v = c3 - c2;
+  double lu = u.Length();
+  double lv = v.Length();
+  if (lu == 0.0 || lv == 0.0) {
+    return;
+  }
+  u /= lu;
+  v /= lv;
+  double cosA = Dot(u, v);
+  double sinA = Cross(u, v).Length();
+  if (sinA < 1.0e-8) {
+    return;
+  }
+  double k = -w * _RAD_TO_DEG / sinA;
+  Vector ga = (v - u * cosA) * (k / lu);
+  Vector gc = (u - v * cosA) * (k / lv);
+  g1 += ga;
+  g3 += gc;
+  g2 -= ga + gc;
+}
+
+// Projects the gradient gn of a function of the unit normal n of
+// Plane(c0, c1, c2) onto the three coords, adding it to g0, g1 and g2
+void AddNormalGradient(const Coord &c0, const Coord &c1, const Coord &c2,
+                       const Vector &n, const Vector &gn, Vector &g0,
+                       Vector &g1, Vector &g2) {
+  Vector a = c1 - c0;
+  Vector b = c2 - c0;
+  Vector m = Cross(a, b);
+  double lm = m.Length();
+  if (lm == 0.0) {
+    return;
+  }
+  // Plane may have flipped the normal when normalising it
+  Vector gm = (gn - n * Dot(n, gn)) * (Sign(Dot(n, m)) / lm);
+  Vector ga = Cross(b, gm);
+  Vector gb = Cross(gm, a);
+  g1 += ga;
+  g2 += gb;
+  g0 -= ga + gb;
+}
+
+// The gradient of a pseudo atom is shared equally between its constituent
+// atoms, as it sits at their mean coords
+void AddAtomGradient(AtomGradientMap &gradient, const Atom *pAtom,
+                     const Vector &g) {
+  const PseudoAtom *pPseudoAtom = dynamic_cast<const PseudoAtom *>(pAtom);
+  if (pPseudoAtom == nullptr) {
+    gradient[pAtom] += g;
+    return;
+  }
+  AtomList atomList = pPseudoAtom->GetAtomList();
+  Vector gi = g / atomList.size();
+  for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
+       iter++) {
+    gradient[*iter] += gi;
+  }
+}
+
+} // namespace
+
 PolarSF::PolarSF()
     : m_R12Factor(1.0), m_R12Incr(0.6), m_DR12Min(0.25), m_DR12Max(0.6),
       m_A1(180.0), m_DA1Min(30.0), m_DA1Max(80.0), m_A2(150.0), m_DA2Min(30.0),
@@ -548,6 +621,219 @@ double PolarSF::PolarScore(const InteractionCenter *pIC1,
   return s;
 }
 
+double PolarSF::IntraScoreGradient(const InteractionCenterList &posList,
+                                   const InteractionCenterList &negList,
+                                   const InteractionListMap &intns, bool attr,
+                                   AtomGradientMap &gradient,
+                                   double scale) const {
+  double score = 0.0;
+  PolarSF::f1prms Rprms = GetRprms();   // Distance params
+  PolarSF::f1prms A1prms = GetA1prms(); // Donor angle params
+  PolarSF::f1prms A2prms = GetA2prms(); // Acceptor angle params
+  // Pos-neg or pos-pos
+  for (InteractionCenterListConstIter iter = posList.begin();
+       iter != posList.end(); iter++) {
+    Atom *pAtom = (*iter)->GetAtom1Ptr();
+    int id = pAtom->GetAtomId() - 1;
+    double u = pAtom->GetUser1Value();
+    score += u * PolarScoreGradient(*iter, intns[id], Rprms, A1prms,
+                                    attr ? A2prms : A1prms, gradient,
+                                    scale * u);
+  }
+  // Neg-pos or neg-neg
+  for (InteractionCenterListConstIter iter = negList.begin();
+       iter != negList.end(); iter++) {
+    Atom *pAtom = (*iter)->GetAtom1Ptr();
+    int id = pAtom->GetAtomId() - 1;
+    double u = pAtom->GetUser1Value();
+    score += u * PolarScoreGradient(*iter, intns[id], Rprms, A2prms,
+                                    attr ? A1prms : A2prms, gradient,
+                                    scale * u);
+  }
+  return score;
+}
+
+// The score of each pair of interaction centers is a product of piecewise
+// linear factors of the distance and angles between them, so its gradient is
+// built up by the product rule, one factor at a time
+double PolarSF::PolarScoreGradient(const InteractionCenter *pIC1,
+                                   const InteractionCenterList &IC2List,
+                                   const f1prms &Rprms, const f1prms &A1prms,
+                                   const f1prms &A2prms,
+                                   AtomGradientMap &gradient,
+                                   double scale) const {
+  double s(0.0);
+  Atom *pAtom1_1 = pIC1->GetAtom1Ptr();
+  if (IC2List.empty() || !pAtom1_1->GetEnabled()) {
+    return s;
+  }
+  const Coord &cAtom1_1 = pAtom1_1->GetCoords();
+  Atom *pAtoms1[3] = {pAtom1_1, pIC1->GetAtom2Ptr(), pIC1->GetAtom3Ptr()};
+  bool bAngle1 = (pAtoms1[1] != nullptr) && (pAtoms1[2] == nullptr);
+  bool bPlane1 =
+      (pAtoms1[2] != nullptr) && (pIC1->LP() == InteractionCenter::NONE);
+  bool bLP1 =
+      (pAtoms1[2] != nullptr) && (pIC1->LP() != InteractionCenter::NONE);
+  double radius1 = pAtom1_1->GetVdwRadius();
+  const Vector zero(0.0, 0.0, 0.0);
+  Vector gSum1[3] = {zero, zero, zero};
+
+  for (InteractionCenterListConstIter IC2Iter = IC2List.begin();
+       IC2Iter != IC2List.end(); IC2Iter++) {
+    const InteractionCenter *pIC2 = *IC2Iter;
+    Atom *pAtom2_1 = pIC2->GetAtom1Ptr();
+    if (!pAtom2_1->GetEnabled())
+      continue; // check for disabled interaction centre 2
+    const Coord &cAtom2_1 = pAtom2_1->GetCoords();
+    Atom *pAtoms2[3] = {pAtom2_1, pIC2->GetAtom2Ptr(), pIC2->GetAtom3Ptr()};
+    bool bAngle2 = (pAtoms2[1] != nullptr) && (pAtoms2[2] == nullptr);
+    bool bPlane2 =
+        (pAtoms2[2] != nullptr) && (pIC2->LP() == InteractionCenter::NONE);
+    bool bLP2 =
+        (pAtoms2[2] != nullptr) && (pIC2->LP() != InteractionCenter::NONE);
+    double radius2 = pAtom2_1->GetVdwRadius();
+    double R12 = m_R12Factor * (radius1 + radius2) + m_R12Incr;
+    Vector v12 = cAtom1_1 - cAtom2_1;
+    double R = v12.Length();
+    double DR = R - R12;
+    double f = m_bAbsDR12 ? f1(std::fabs(DR), Rprms) : f1(DR, Rprms);
+    if (f <= 0.0) {
+      continue;
+    }
+    // Gradients of f with respect to the atoms of each center
+    double dfdR = m_bAbsDR12 ? df1(std::fabs(DR), Rprms) * Sign(DR)
+                             : df1(DR, Rprms);
+    Vector g1[3] = {v12 * (dfdR / R), zero, zero};
+    Vector g2[3] = {v12 * (-dfdR / R), zero, zero};
+    Vector h[3];
+    Vector hPartner;
+    // For guanidinium bPlane2 interacting with C=O lone pair bLP1, we want to
+    // use the regular angular dependence
+    double a = AngularFactor(pIC1, bAngle1 || (bPlane2 && bLP1), cAtom2_1,
+                             A1prms, h, hPartner);
+    for (int i = 0; i < 3; i++) {
+      g1[i] = g1[i] * a + h[i] * f;
+      g2[i] *= a;
+    }
+    g2[0] += hPartner * f;
+    f *= a;
+    if (f <= 0.0) {
+      continue;
+    }
+    a = AngularFactor(pIC2, bAngle2 || (bPlane1 && bLP2), cAtom1_1, A2prms, h,
+                      hPartner);
+    for (int i = 0; i < 3; i++) {
+      g2[i] = g2[i] * a + h[i] * f;
+      g1[i] *= a;
+    }
+    g1[0] += hPartner * f;
+    f *= a;
+    if (f <= 0.0) {
+      continue;
+    }
+    double u2 = pAtom2_1->GetUser1Value();
+    s += u2 * f;
+    double w = scale * u2;
+    for (int i = 0; i < 3; i++) {
+      gSum1[i] += g1[i] * w;
+      if (pAtoms2[i] != nullptr) {
+        AddAtomGradient(gradient, pAtoms2[i], g2[i] * w);
+      }
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    if (pAtoms1[i] != nullptr) {
+      AddAtomGradient(gradient, pAtoms1[i], gSum1[i]);
+    }
+  }
+  return s;
+}
+
+// Angular factor of PolarScore for interaction center pIC, with respect to
+// the first atom of its partner center at cPartner. Sets gIC to the gradient
+// of the factor with respect to the (up to) three atoms of pIC, and gPartner
+// to the gradient with respect to the partner atom
+double PolarSF::AngularFactor(const InteractionCenter *pIC, bool bAngle,
+                              const Coord &cPartner, const f1prms &Aprms,
+                              Vector gIC[3], Vector &gPartner) const {
+  const Vector zero(0.0, 0.0, 0.0);
+  gIC[0] = gIC[1] = gIC[2] = gPartner = zero;
+  Atom *pAtom2 = pIC->GetAtom2Ptr();
+  Atom *pAtom3 = pIC->GetAtom3Ptr();
+  if (!bAngle && (pAtom3 == nullptr)) {
+    return 1.0;
+  }
+  const Coord &c1 = pIC->GetAtom1Ptr()->GetCoords();
+  const Coord &c2 = pAtom2->GetCoords();
+  if (bAngle) {
+    double DA = Angle(c2, c1, cPartner) - Aprms.R0;
+    double dfdA = df1(std::fabs(DA), Aprms) * Sign(DA);
+    if (dfdA != 0.0) {
+      AddAngleGradient(c2, c1, cPartner, dfdA, gIC[1], gIC[0], gPartner);
+    }
+    return f1(std::fabs(DA), Aprms);
+  }
+
+  const Coord &c3 = pAtom3->GetCoords();
+  Plane pl(c1, c2, c3);
+  Vector n = pl.VNorm();
+  Vector d = cPartner - c1;
+  double R = d.Length();
+  if (pIC->LP() == InteractionCenter::NONE) {
+    // Angle between the interaction and the normal to the plane
+    double p = Dot(d.Unit(), n);
+    double A = std::acos(-std::fabs(p)) * _RAD_TO_DEG;
+    double DA = A - Aprms.R0;
+    double dfdA = df1(std::fabs(DA), Aprms) * Sign(DA);
+    if (dfdA != 0.0 && p * p < 1.0) {
+      double w = dfdA * Sign(p) * _RAD_TO_DEG / std::sqrt(1.0 - p * p);
+      Vector u = d / R;
+      Vector gd = (n - u * p) * (w / R);
+      gPartner += gd;
+      gIC[0] -= gd;
+      AddNormalGradient(c1, c2, c3, n, u * w, gIC[0], gIC[1], gIC[2]);
+    }
+    return f1(std::fabs(DA), Aprms);
+  }
+
+  // Lone pair geometry: theta is the elevation of the partner above the plane
+  // of the lone pairs, phi the angle of its projection into the plane
+  const f1prms &PHIprms = (pIC->LP() == InteractionCenter::LONEPAIR)
+                              ? m_PHI_lp_prms
+                              : m_PHI_plane_prms;
+  double dPerp = DistanceFromPointToPlane(cPartner, pl);
+  Coord cPerp = cPartner - dPerp * n;
+  double t = dPerp / R;
+  double theta = std::asin(t) * _RAD_TO_DEG;
+  double fTheta = f1(std::fabs(theta), m_THETAprms);
+  if (fTheta <= 0.0) {
+    return 0.0;
+  }
+  double Dphi = 180.0 - Angle(cPerp, c1, c2) - PHIprms.R0;
+  double fPhi = f1(std::fabs(Dphi), PHIprms);
+  double dfdTheta = fPhi * df1(std::fabs(theta), m_THETAprms) * Sign(theta);
+  if (dfdTheta != 0.0 && t * t < 1.0) {
+    // t = Dot(d, n) / R
+    double w = dfdTheta * _RAD_TO_DEG / std::sqrt(1.0 - t * t);
+    Vector gd = (n - d * (t / R)) * (w / R);
+    gPartner += gd;
+    gIC[0] -= gd;
+    AddNormalGradient(c1, c2, c3, n, d * (w / R), gIC[0], gIC[1], gIC[2]);
+  }
+  double dfdPhi = fTheta * df1(std::fabs(Dphi), PHIprms) * Sign(Dphi);
+  if (dfdPhi != 0.0) {
+    // cPerp = cPartner - Dot(cPartner - c1, n) * n
+    Vector gPerp = zero;
+    AddAngleGradient(cPerp, c1, c2, -dfdPhi, gPerp, gIC[0], gIC[1]);
+    double ng = Dot(n, gPerp);
+    gPartner += gPerp - n * ng;
+    gIC[0] += n * ng;
+    AddNormalGradient(c1, c2, c3, n, -(d * ng) - gPerp * dPerp, gIC[0],
+                      gIC[1], gIC[2]);
+  }
+  return fTheta * fPhi;
+}
+
 // As this has a virtual base class we need a separate OwnParameterUpdated
 // which can be called by concrete subclass ParameterUpdated methods
 // See Stroustrup C++ 3rd edition, p395, on programming virtual base classes
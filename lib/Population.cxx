@@ -13,12 +13,34 @@
 #include "rxdock/Population.h"
 #include "rxdock/Debug.h"
 #include "rxdock/DockingError.h"
+#include "rxdock/WorkSpace.h"
 #include <algorithm>
 
+#include <loguru.hpp>
+
 using namespace rxdock;
 
 const std::string Population::_CT = "Population";
 
+namespace {
+
+// Stable sort of genomes into descending order of score. Unlike
+// std::stable_sort this never allocates a temporary buffer, and populations
+// are small enough for an insertion sort
+void SortByScore(GenomeList &genomes) {
+  GenomeCmp_Score cmp;
+  for (std::size_t i = 1; i < genomes.size(); ++i) {
+    GenomePtr genome = genomes[i];
+    std::size_t j = i;
+    for (; (j > 0) && cmp(genome, genomes[j - 1]); --j) {
+      genomes[j] = genomes[j - 1];
+    }
+    genomes[j] = genome;
+  }
+}
+
+} // namespace
+
 Population::Population(ChromElement *pChr, int size, BaseSF *pSF)
     : m_size(size), m_c(2.0), m_pSF(pSF), m_rand(GetRandInstance()),
       m_scoreMean(0.0), m_scoreVariance(0.0) {
@@ -28,14 +50,24 @@ Population::Population(ChromElement *pChr, int size, BaseSF *pSF)
   } else if (size <= 0) {
     throw BadArgument(_WHERE_, "Population size must be positive (non-zero)");
   }
+  // All genomes share a single clone of the chromosome as their codec
+  m_chrom = pChr->clone();
+  // Determine the crossover element boundaries in the chromosome vector
+  XOverList xoverList;
+  m_chrom->GetVector(xoverList);
+  m_xoverIndex.push_back(0);
+  for (XOverListConstIter iter = xoverList.begin(); iter != xoverList.end();
+       ++iter) {
+    m_xoverIndex.push_back(m_xoverIndex.back() + iter->size());
+  }
+  std::vector<double> seed;
+  m_chrom->GetVector(seed);
   // Create a random population
   m_pop.reserve(m_size);
   for (unsigned int i = 0; i < m_size; ++i) {
-    // The Genome constructor clones the chromosome to create an independent
-    // copy
-    GenomePtr genome = new Genome(pChr);
-    genome->GetChrom()->Randomise();
-    m_pop.push_back(genome);
+    m_chrom->SetVector(seed);
+    m_chrom->Randomise();
+    m_pop.push_back(new Genome(m_chrom));
   }
   // Calculate the scores and evaluate roulette wheel fitness
   SetSF(m_pSF);
@@ -50,10 +82,27 @@ void Population::SetSF(BaseSF *pSF) {
     throw BadArgument(_WHERE_, "Null scoring function passed to SetSF");
   }
   m_pSF = pSF;
-  for (GenomeListIter iter = m_pop.begin(); iter != m_pop.end(); ++iter) {
-    (*iter)->SetScore(m_pSF);
+  // The batch covers all models moved by the chromosomes, i.e. those with
+  // flexibility data. Chromosomes built without flexibility data could move
+  // any of the models
+  m_spPoses.SetNull();
+  WorkSpace *pWorkSpace = m_pSF->GetWorkSpace();
+  if (pWorkSpace != nullptr) {
+    ModelList modelList;
+    ModelList movableModels;
+    for (const auto &spModel : pWorkSpace->GetModels()) {
+      if (!spModel.Null()) {
+        modelList.push_back(spModel);
+        if (spModel->GetFlexData() != nullptr) {
+          movableModels.push_back(spModel);
+        }
+      }
+    }
+    m_spPoses =
+        new PoseBatch(movableModels.empty() ? modelList : movableModels);
   }
-  std::stable_sort(m_pop.begin(), m_pop.end(), GenomeCmp_Score());
+  ScoreGenomes(m_pop);
+  SortByScore(m_pop);
   EvaluateRWFitness();
 }
 
@@ -63,8 +112,8 @@ void Population::GAstep(int nReplicates, double relStepSize,
   if (nReplicates <= 0) {
     throw BadArgument(_WHERE_, "nReplicates must be positive (non-zero)");
   }
-  GenomeList newPop;
-  newPop.reserve(nReplicates);
+  ReserveGenomes(nReplicates);
+  m_newPop.clear();
   for (int i = 0; i < nReplicates / 2; i++) {
     GenomePtr mother = RouletteWheelSelect();
     GenomePtr father = RouletteWheelSelect();
@@ -80,42 +129,46 @@ void Population::GAstep(int nReplicates, double relStepSize,
                            "Population failure - not enough diversity");
       j++;
     }
-    GenomePtr child1 = new Genome(*mother);
-    GenomePtr child2 = new Genome(*father);
+    GenomePtr child1 = NewChild(*mother);
+    GenomePtr child2 = NewChild(*father);
     // Crossover
     if (m_rand.GetRandom01() < pcross) {
-      Crossover(father->GetChrom(), mother->GetChrom(), child1->GetChrom(),
-                child2->GetChrom());
+      Crossover(*father, *mother, *child1, *child2);
       // Cauchy mutation following crossover
       if (xovermut) {
-        child1->GetChrom()->CauchyMutate(0.0, relStepSize);
-        child2->GetChrom()->CauchyMutate(0.0, relStepSize);
+        Mutate(*child1, relStepSize, true);
+        Mutate(*child2, relStepSize, true);
       }
     }
-    // Mutation
+    // Mutation (Cauchy or regular)
     else {
-      // Cauchy mutation
-      if (cmutate) {
-        child1->GetChrom()->CauchyMutate(0.0, relStepSize);
-        child2->GetChrom()->CauchyMutate(0.0, relStepSize);
-      }
-      // Regular mutation
-      else {
-        child1->GetChrom()->Mutate(relStepSize);
-        child2->GetChrom()->Mutate(relStepSize);
-      }
+      Mutate(*child1, relStepSize, cmutate);
+      Mutate(*child2, relStepSize, cmutate);
     }
-    newPop.push_back(child1);
-    newPop.push_back(child2);
+    m_newPop.push_back(child1);
+    m_newPop.push_back(child2);
   }
   // check if one more is needed (odd nReplicates).
   if (nReplicates % 2) {
     GenomePtr mother = RouletteWheelSelect();
-    GenomePtr child = new Genome(*mother);
-    child->GetChrom()->CauchyMutate(0.0, relStepSize);
-    newPop.push_back(child);
+    GenomePtr child = NewChild(*mother);
+    Mutate(*child, relStepSize, true);
+    m_newPop.push_back(child);
+  }
+  ScoreGenomes(m_newPop);
+  MergeNewPop(m_newPop, equalityThreshold);
+  EvaluateRWFitness();
+}
+
+void Population::Immigrate(const GenomeList &migrants,
+                           double equalityThreshold) {
+  ReserveGenomes(migrants.size());
+  m_newPop.clear();
+  for (GenomeListConstIter iter = migrants.begin(); iter != migrants.end();
+       ++iter) {
+    m_newPop.push_back(NewChild(**iter));
   }
-  MergeNewPop(newPop, equalityThreshold);
+  MergeNewPop(m_newPop, equalityThreshold);
   EvaluateRWFitness();
 }
 
@@ -153,26 +206,103 @@ GenomePtr Population::RouletteWheelSelect() const {
   return (m_pop[lower]);
 }
 
-void Population::MergeNewPop(GenomeList &newPop, double equalityThreshold) {
-  // Assume newPop needs scoring and sorting
-  for (GenomeListIter iter = newPop.begin(); iter != newPop.end(); ++iter) {
-    (*iter)->SetScore(m_pSF);
+void Population::ScoreGenomes(GenomeList &genomes) {
+  // Without a workspace we do not know which models the chromosomes move
+  if (m_spPoses.Null()) {
+    for (GenomeListIter iter = genomes.begin(); iter != genomes.end();
+         ++iter) {
+      (*iter)->SetScore(m_pSF);
+    }
+    return;
+  }
+  m_spPoses->SetNumPoses(genomes.size());
+  for (std::size_t i = 0; i < genomes.size(); i++) {
+    genomes[i]->GetChrom()->SyncToModel();
+    m_spPoses->SetPose(i);
   }
-  std::stable_sort(newPop.begin(), newPop.end(), GenomeCmp_Score());
+  m_scores.resize(genomes.size());
+  m_pSF->ScoreBatch(*m_spPoses, m_scores.data());
+  for (std::size_t i = 0; i < genomes.size(); i++) {
+    genomes[i]->SetScore(m_scores[i]);
+  }
+}
 
-  GenomeList mergedPop;
-  mergedPop.reserve(m_pop.size() + newPop.size());
+void Population::MergeNewPop(GenomeList &newPop, double equalityThreshold) {
+  // Assume newPop is scored, but needs sorting
+  SortByScore(newPop);
+
+  m_mergedPop.clear();
   // Merge pops by score
   std::merge(m_pop.begin(), m_pop.end(), newPop.begin(), newPop.end(),
-             std::back_inserter(mergedPop), GenomeCmp_Score());
+             std::back_inserter(m_mergedPop), GenomeCmp_Score());
   // Remove neighbouring duplicates by equality of chromosome element values
-  GenomeListIter end = std::unique(mergedPop.begin(), mergedPop.end(),
-                                   isGenome_eq(equalityThreshold));
-  mergedPop.erase(end, mergedPop.end());
+  // and truncate to the maximum size. Rejected genomes are recycled
   m_pop.clear();
-  end = (mergedPop.size() > m_size) ? (mergedPop.begin() + m_size)
-                                    : mergedPop.end();
-  std::copy(mergedPop.begin(), end, back_inserter(m_pop));
+  for (GenomeListIter iter = m_mergedPop.begin(); iter != m_mergedPop.end();
+       ++iter) {
+    if ((m_pop.size() < m_size) &&
+        (m_pop.empty() || !m_pop.back()->Equals(**iter, equalityThreshold))) {
+      m_pop.push_back(*iter);
+    } else {
+      m_spare.push_back(*iter);
+    }
+  }
+  m_mergedPop.clear();
+  newPop.clear();
+}
+
+void Population::ReserveGenomes(unsigned int nGenomes) {
+  if (m_spare.size() >= nGenomes) {
+    return;
+  }
+  // Capacity for every genome that may be in circulation, so that the lists
+  // never need to grow during GAstep
+  m_newPop.reserve(nGenomes);
+  m_mergedPop.reserve(m_size + nGenomes);
+  m_spare.reserve(m_size + nGenomes);
+  while (m_spare.size() < nGenomes) {
+    m_spare.push_back(new Genome(m_chrom));
+  }
+}
+
+GenomePtr Population::NewChild(const Genome &parent) {
+  GenomePtr child = m_spare.back();
+  m_spare.pop_back();
+  child->SetValues(parent);
+  return child;
+}
+
+void Population::Mutate(Genome &genome, double relStepSize, bool cauchy) {
+  ChromElement *pChr = genome.GetChrom();
+  if (cauchy) {
+    pChr->CauchyMutate(0.0, relStepSize);
+  } else {
+    pChr->Mutate(relStepSize);
+  }
+  genome.SyncFromChrom();
+}
+
+void Population::Crossover(const Genome &parent1, const Genome &parent2,
+                           Genome &child1, Genome &child2) {
+  int length = m_xoverIndex.size() - 1;
+  unsigned int nValues = m_xoverIndex.back();
+  if ((parent1.GetVector().size() != nValues) ||
+      (parent2.GetVector().size() != nValues)) {
+    throw BadArgument(_WHERE_, "Crossover: mismatch in chromosome lengths");
+  }
+  // 2-point crossover
+  // In the spirit of STL, ixbegin is the first gene to crossover, ixend is one
+  // after the last gene to crossover
+  int ixbegin = m_rand.GetRandomInt(length);
+  // if ixbegin is 0, we need to avoid selecting the whole chromosome
+  int ixend = (ixbegin == 0)
+                  ? m_rand.GetRandomInt(length - 1) + 1
+                  : m_rand.GetRandomInt(length - ixbegin) + ixbegin + 1;
+
+  LOG_F(1, "Crossover: ixbegin = {}, ixend = {}", ixbegin, ixend);
+  child1 = parent1;
+  child2 = parent2;
+  child1.SwapValues(child2, m_xoverIndex[ixbegin], m_xoverIndex[ixend]);
 }
 
 void Population::EvaluateRWFitness() {
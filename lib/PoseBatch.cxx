@@ -0,0 +1,98 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/PoseBatch.h"
+
+using namespace rxdock;
+
+const std::string PoseBatch::_CT = "PoseBatch";
+
+PoseBatch::PoseBatch(const ModelList &modelList, std::size_t nPoses)
+    : m_modelList(modelList), m_nPoses(0) {
+  for (auto &spModel : m_modelList) {
+    m_models.push_back(spModel.Ptr());
+    AtomList atomList = spModel->GetAtomList();
+    for (auto &spAtom : atomList) {
+      m_atomIndex[spAtom.Ptr()] = m_atomList.size();
+      m_atomList.push_back(spAtom);
+      m_atoms.push_back(spAtom.Ptr());
+    }
+  }
+  SetNumPoses(nPoses);
+  for (std::size_t iPose = 0; iPose < nPoses; iPose++) {
+    SetPose(iPose);
+  }
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+PoseBatch::~PoseBatch() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+void PoseBatch::SetNumPoses(std::size_t nPoses) {
+  m_nPoses = nPoses;
+  std::size_t nAtomValues = m_atomList.size() * nPoses;
+  m_x.resize(nAtomValues);
+  m_y.resize(nAtomValues);
+  m_z.resize(nAtomValues);
+  std::size_t nModelValues = m_modelList.size() * nPoses;
+  m_occupancy.resize(nModelValues);
+  m_enabled.resize(nModelValues);
+  m_conformer.resize(nModelValues);
+}
+
+void PoseBatch::SetPose(std::size_t iPose) {
+  if (iPose >= m_nPoses) {
+    throw BadArgument(_WHERE_, "Pose index out of range");
+  }
+  std::size_t i = iPose;
+  for (const Atom *pAtom : m_atoms) {
+    const Coord &c = pAtom->GetCoords();
+    m_x[i] = c.xyz(0);
+    m_y[i] = c.xyz(1);
+    m_z[i] = c.xyz(2);
+    i += m_nPoses;
+  }
+  i = iPose;
+  for (const Model *pModel : m_models) {
+    m_occupancy[i] = pModel->GetOccupancy();
+    m_enabled[i] = pModel->GetEnabled();
+    m_conformer[i] = pModel->GetCurrentCoords();
+    i += m_nPoses;
+  }
+}
+
+void PoseBatch::ApplyPose(std::size_t iPose) const {
+  if (iPose >= m_nPoses) {
+    throw BadArgument(_WHERE_, "Pose index out of range");
+  }
+  // The conformer is restored first, as scoring functions look up their
+  // per-conformer data from it. The stored coordinates then override those of
+  // the conformer, for atoms moved since it was selected
+  std::size_t i = iPose;
+  for (Model *pModel : m_models) {
+    pModel->SetCurrentConformer(m_conformer[i]);
+    i += m_nPoses;
+  }
+  i = iPose;
+  for (Atom *pAtom : m_atoms) {
+    pAtom->SetCoords(m_x[i], m_y[i], m_z[i]);
+    i += m_nPoses;
+  }
+  i = iPose;
+  for (Model *pModel : m_models) {
+    // The occupancy threshold is chosen to reproduce the stored enabled
+    // state, as occupancies always lie between 0 and 1
+    pModel->SetOccupancy(m_occupancy[i], m_enabled[i] ? 0.0 : 2.0);
+    pModel->UpdatePseudoAtoms();
+    i += m_nPoses;
+  }
+}
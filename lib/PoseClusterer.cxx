@@ -0,0 +1,93 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/PoseClusterer.h"
+#include "rxdock/Error.h"
+
+#include <cmath>
+
+using namespace rxdock;
+
+const std::string PoseClusterer::_CT = "PoseClusterer";
+
+PoseClusterer::PoseClusterer(double rmsdThreshold, double scoreWindow)
+    : m_rmsdThreshold(rmsdThreshold), m_scoreWindow(scoreWindow), m_iBest(0),
+      m_nPoses(0), m_nConverged(0) {
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+PoseClusterer::~PoseClusterer() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+void PoseClusterer::SetAtoms(const AtomList &atomList) {
+  m_atomList =
+      GetAtomListWithPredicate(atomList, std::not1(isAtomicNo_eq(1)));
+  m_coords.resize(m_atomList.size());
+  m_clusters.clear();
+  m_iBest = 0;
+  m_nPoses = 0;
+  m_nConverged = 0;
+}
+
+std::size_t PoseClusterer::AddPose(double score) {
+  for (std::size_t i = 0; i < m_atomList.size(); i++) {
+    m_coords[i] = m_atomList[i]->GetCoords();
+  }
+  m_nPoses++;
+
+  std::size_t iCluster = 0;
+  for (; iCluster < m_clusters.size(); iCluster++) {
+    if (RMSD(m_coords, m_clusters[iCluster].coords) <= m_rmsdThreshold) {
+      break;
+    }
+  }
+  if (iCluster == m_clusters.size()) {
+    Cluster cluster;
+    cluster.coords = m_coords;
+    cluster.score = score;
+    cluster.size = 1;
+    m_clusters.push_back(cluster);
+  } else {
+    Cluster &cluster = m_clusters[iCluster];
+    cluster.size++;
+    if (score < cluster.score) {
+      cluster.coords = m_coords;
+      cluster.score = score;
+    }
+  }
+
+  // Landing in any cluster other than the best one (including a new, better
+  // one) resets the count
+  bool bConverged = (iCluster == m_iBest) && (m_clusters[iCluster].size > 1) &&
+                    (score <= m_clusters[iCluster].score + m_scoreWindow);
+  if (m_clusters[iCluster].score < m_clusters[m_iBest].score) {
+    m_iBest = iCluster;
+  }
+  m_nConverged = bConverged ? m_nConverged + 1 : 0;
+  return iCluster;
+}
+
+double PoseClusterer::RMSD(const CoordList &coords1,
+                           const CoordList &coords2) {
+  std::size_t nCoords = coords1.size();
+  if (nCoords != coords2.size()) {
+    throw BadArgument(_WHERE_, "Coord lists differ in size");
+  }
+  if (nCoords == 0) {
+    return 0.0;
+  }
+  double rms = 0.0;
+  for (std::size_t i = 0; i < nCoords; i++) {
+    rms += Length2(coords1[i], coords2[i]);
+  }
+  return std::sqrt(rms / nCoords);
+}
@@ -0,0 +1,351 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/PoseRMSD.h"
+
+#ifdef __PGI
+#define EIGEN_DONT_VECTORIZE
+#endif
+#include <Eigen/Eigenvalues>
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+using namespace rxdock;
+
+const std::string PoseRMSD::_CT = "PoseRMSD";
+
+namespace {
+
+// Enumerates the automorphisms of a graph whose vertices carry labels, by
+// backtracking over vertices in breadth first order. Candidate images are
+// restricted to vertices in the same class after iterative refinement of
+// the labels by those of the neighbours
+class AutomorphismEnumerator {
+public:
+  AutomorphismEnumerator(const std::vector<int> &labels,
+                         const std::vector<std::vector<std::size_t>> &adj,
+                         std::size_t maxAutomorphisms)
+      : m_adj(adj), m_maxAutomorphisms(maxAutomorphisms),
+        m_bComplete(true) {
+    std::size_t n = labels.size();
+    m_isAdj.assign(n * n, false);
+    for (std::size_t i = 0; i < n; i++) {
+      for (std::size_t j : adj[i]) {
+        m_isAdj[i * n + j] = true;
+      }
+    }
+    RefineClasses(labels);
+    SetOrder();
+  }
+
+  bool isComplete() const { return m_bComplete; }
+
+  void Enumerate(std::vector<std::vector<std::size_t>> &automorphisms) {
+    automorphisms.clear();
+    std::size_t n = m_classes.size();
+    // Identity first
+    std::vector<std::size_t> identity(n);
+    for (std::size_t i = 0; i < n; i++) {
+      identity[i] = i;
+    }
+    automorphisms.push_back(identity);
+    m_perm.assign(n, 0);
+    m_used.assign(n, false);
+    m_pAutomorphisms = &automorphisms;
+    Extend(0);
+  }
+
+private:
+  void RefineClasses(const std::vector<int> &labels) {
+    std::size_t n = labels.size();
+    m_classes.resize(n);
+    std::map<std::vector<int>, int> classIds;
+    for (std::size_t i = 0; i < n; i++) {
+      std::vector<int> key{labels[i], static_cast<int>(m_adj[i].size())};
+      m_classes[i] = classIds.emplace(key, classIds.size()).first->second;
+    }
+    std::size_t nClasses = classIds.size();
+    while (true) {
+      classIds.clear();
+      std::vector<int> newClasses(n);
+      for (std::size_t i = 0; i < n; i++) {
+        std::vector<int> key{m_classes[i]};
+        for (std::size_t j : m_adj[i]) {
+          key.push_back(m_classes[j]);
+        }
+        std::sort(key.begin() + 1, key.end());
+        newClasses[i] = classIds.emplace(key, classIds.size()).first->second;
+      }
+      m_classes.swap(newClasses);
+      if (classIds.size() == nClasses) {
+        break;
+      }
+      nClasses = classIds.size();
+    }
+  }
+
+  // Breadth first order, so that each vertex (apart from the first of each
+  // component) has an already mapped neighbour constraining its image
+  void SetOrder() {
+    std::size_t n = m_classes.size();
+    std::vector<bool> bVisited(n, false);
+    for (std::size_t iStart = 0; iStart < n; iStart++) {
+      if (bVisited[iStart]) {
+        continue;
+      }
+      std::size_t iFirst = m_order.size();
+      m_order.push_back(iStart);
+      bVisited[iStart] = true;
+      for (std::size_t k = iFirst; k < m_order.size(); k++) {
+        for (std::size_t j : m_adj[m_order[k]]) {
+          if (!bVisited[j]) {
+            bVisited[j] = true;
+            m_order.push_back(j);
+          }
+        }
+      }
+    }
+  }
+
+  void Extend(std::size_t depth) {
+    std::size_t n = m_order.size();
+    if (depth == n) {
+      // The identity has already been added
+      for (std::size_t i = 0; i < n; i++) {
+        if (m_perm[i] != i) {
+          if (m_pAutomorphisms->size() < m_maxAutomorphisms) {
+            m_pAutomorphisms->push_back(m_perm);
+          } else {
+            m_bComplete = false;
+          }
+          return;
+        }
+      }
+      return;
+    }
+    std::size_t i = m_order[depth];
+    for (std::size_t j = 0; j < n && m_bComplete; j++) {
+      if (m_used[j] || m_classes[j] != m_classes[i]) {
+        continue;
+      }
+      bool bMatch = true;
+      for (std::size_t d = 0; d < depth && bMatch; d++) {
+        std::size_t k = m_order[d];
+        bMatch = (m_isAdj[i * n + k] == m_isAdj[j * n + m_perm[k]]);
+      }
+      if (bMatch) {
+        m_perm[i] = j;
+        m_used[j] = true;
+        Extend(depth + 1);
+        m_used[j] = false;
+      }
+    }
+  }
+
+  const std::vector<std::vector<std::size_t>> &m_adj;
+  std::size_t m_maxAutomorphisms;
+  bool m_bComplete;
+  std::vector<bool> m_isAdj; // Adjacency matrix
+  std::vector<int> m_classes;
+  std::vector<std::size_t> m_order;
+  std::vector<std::size_t> m_perm;
+  std::vector<bool> m_used;
+  std::vector<std::vector<std::size_t>> *m_pAutomorphisms;
+};
+
+} // namespace
+
+PoseRMSD::PoseRMSD(const Model &refModel, std::size_t maxSymmetries)
+    : m_bComplete(true), m_refNorm2(0.0) {
+  AtomList atomList = GetAtomListWithPredicate(refModel.GetAtomList(),
+                                               std::not1(isAtomicNo_eq(1)));
+  std::size_t n = atomList.size();
+  std::unordered_map<const Atom *, std::size_t> atomIndex;
+  for (std::size_t i = 0; i < n; i++) {
+    atomIndex[atomList[i].Ptr()] = i;
+    m_elements.push_back(atomList[i]->GetAtomicNo());
+  }
+  std::vector<std::vector<std::size_t>> adj(n);
+  for (std::size_t i = 0; i < n; i++) {
+    AtomList bondedAtoms = GetBondedAtomList(atomList[i].Ptr());
+    for (const auto &spAtom : bondedAtoms) {
+      auto iter = atomIndex.find(spAtom.Ptr());
+      if (iter != atomIndex.end()) {
+        adj[i].push_back(iter->second);
+      }
+    }
+  }
+  AutomorphismEnumerator enumerator(m_elements, adj,
+                                    std::max<std::size_t>(maxSymmetries, 1));
+  enumerator.Enumerate(m_symmetries);
+  m_bComplete = enumerator.isComplete();
+  if (!m_bComplete) {
+    LOG_F(WARNING,
+          "Only the first {} symmetries of {} are used for RMSD calculations",
+          m_symmetries.size(), refModel.GetName());
+  }
+
+  for (const auto &spAtom : atomList) {
+    m_refCenter += spAtom->GetCoords();
+  }
+  if (n > 0) {
+    m_refCenter /= n;
+  }
+  m_refCoords.resize(m_symmetries.size());
+  for (std::size_t s = 0; s < m_symmetries.size(); s++) {
+    std::vector<double> &refCoords = m_refCoords[s];
+    refCoords.resize(3 * n);
+    for (std::size_t i = 0; i < n; i++) {
+      Coord c = atomList[m_symmetries[s][i]]->GetCoords() - m_refCenter;
+      refCoords[3 * i] = c.xyz(0);
+      refCoords[3 * i + 1] = c.xyz(1);
+      refCoords[3 * i + 2] = c.xyz(2);
+    }
+  }
+  for (double x : m_refCoords.front()) {
+    m_refNorm2 += x * x;
+  }
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+PoseRMSD::~PoseRMSD() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+bool PoseRMSD::GetCoords(const Model &model,
+                         std::vector<double> &coords) const {
+  AtomList atomList = GetAtomListWithPredicate(model.GetAtomList(),
+                                               std::not1(isAtomicNo_eq(1)));
+  if (atomList.size() != m_elements.size()) {
+    return false;
+  }
+  coords.resize(3 * atomList.size());
+  for (std::size_t i = 0; i < atomList.size(); i++) {
+    if (atomList[i]->GetAtomicNo() != m_elements[i]) {
+      return false;
+    }
+    const Coord &c = atomList[i]->GetCoords();
+    coords[3 * i] = c.xyz(0);
+    coords[3 * i + 1] = c.xyz(1);
+    coords[3 * i + 2] = c.xyz(2);
+  }
+  return true;
+}
+
+double PoseRMSD::RMSD(const double *coords) const {
+  std::size_t n3 = 3 * GetNumAtoms();
+  if (n3 == 0) {
+    return 0.0;
+  }
+  double center[3] = {m_refCenter.xyz(0), m_refCenter.xyz(1),
+                      m_refCenter.xyz(2)};
+  double best = std::numeric_limits<double>::max();
+  for (const auto &refCoords : m_refCoords) {
+    double sum = 0.0;
+    // Give up on this symmetry once it cannot beat the best so far
+    for (std::size_t i = 0; i < n3 && sum < best; i++) {
+      double d = coords[i] - center[i % 3] - refCoords[i];
+      sum += d * d;
+    }
+    best = std::min(best, sum);
+  }
+  return std::sqrt(best / GetNumAtoms());
+}
+
+double PoseRMSD::RMSD(const double *coords1, const double *coords2) const {
+  std::size_t n = GetNumAtoms();
+  if (n == 0) {
+    return 0.0;
+  }
+  double best = std::numeric_limits<double>::max();
+  for (const auto &symmetry : m_symmetries) {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n && sum < best; i++) {
+      const double *c1 = coords1 + 3 * symmetry[i];
+      const double *c2 = coords2 + 3 * i;
+      double dx = c1[0] - c2[0];
+      double dy = c1[1] - c2[1];
+      double dz = c1[2] - c2[2];
+      sum += dx * dx + dy * dy + dz * dz;
+    }
+    best = std::min(best, sum);
+  }
+  return std::sqrt(best / n);
+}
+
+// Quaternion superposition: B.K.P. Horn, J. Opt. Soc. Am. A (1987) 4, 629.
+// The largest eigenvalue of the 4x4 key matrix gives the minimum sum of
+// squared distances, and its eigenvector the rotation
+double PoseRMSD::FitRMSD(const double *coords, Quat *pQuat,
+                         Vector *pTrans) const {
+  std::size_t n = GetNumAtoms();
+  if (n == 0) {
+    return 0.0;
+  }
+  double center[3] = {0.0, 0.0, 0.0};
+  for (std::size_t i = 0; i < n; i++) {
+    for (int k = 0; k < 3; k++) {
+      center[k] += coords[3 * i + k];
+    }
+  }
+  double norm2 = 0.0;
+  std::vector<double> poseCoords(3 * n);
+  for (int k = 0; k < 3; k++) {
+    center[k] /= n;
+  }
+  for (std::size_t i = 0; i < 3 * n; i++) {
+    poseCoords[i] = coords[i] - center[i % 3];
+    norm2 += poseCoords[i] * poseCoords[i];
+  }
+
+  double bestLambda = -std::numeric_limits<double>::max();
+  Eigen::Vector4d bestQuat(1.0, 0.0, 0.0, 0.0);
+  for (const auto &refCoords : m_refCoords) {
+    Eigen::Matrix3d S = Eigen::Matrix3d::Zero();
+    for (std::size_t i = 0; i < n; i++) {
+      const double *a = &poseCoords[3 * i];
+      const double *b = &refCoords[3 * i];
+      for (int j = 0; j < 3; j++) {
+        for (int k = 0; k < 3; k++) {
+          S(j, k) += a[j] * b[k];
+        }
+      }
+    }
+    Eigen::Matrix4d N;
+    N << S(0, 0) + S(1, 1) + S(2, 2), S(1, 2) - S(2, 1), S(2, 0) - S(0, 2),
+        S(0, 1) - S(1, 0), S(1, 2) - S(2, 1), S(0, 0) - S(1, 1) - S(2, 2),
+        S(0, 1) + S(1, 0), S(2, 0) + S(0, 2), S(2, 0) - S(0, 2),
+        S(0, 1) + S(1, 0), -S(0, 0) + S(1, 1) - S(2, 2), S(1, 2) + S(2, 1),
+        S(0, 1) - S(1, 0), S(2, 0) + S(0, 2), S(1, 2) + S(2, 1),
+        -S(0, 0) - S(1, 1) + S(2, 2);
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> solver(N);
+    // Eigenvalues are sorted in increasing order
+    double lambda = solver.eigenvalues()(3);
+    if (lambda > bestLambda) {
+      bestLambda = lambda;
+      bestQuat = solver.eigenvectors().col(3);
+    }
+  }
+
+  if (pQuat != nullptr && pTrans != nullptr) {
+    *pQuat = Quat(bestQuat(0), bestQuat(1), bestQuat(2), bestQuat(3));
+    Coord poseCenter(center[0], center[1], center[2]);
+    *pTrans = m_refCenter - pQuat->Rotate(poseCenter);
+  }
+  double sum = norm2 + m_refNorm2 - 2.0 * bestLambda;
+  return std::sqrt(std::max(sum, 0.0) / n);
+}
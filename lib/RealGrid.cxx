@@ -30,7 +30,8 @@ const std::string RealGrid::_CT = "RealGrid";
 // Construct a NXxNYxNZ grid running from gridMin at gridStep resolution
 RealGrid::RealGrid(const Coord &gridMin, const Coord &gridStep, unsigned int NX,
                    unsigned int NY, unsigned int NZ, unsigned int NPad)
-    : BaseGrid(gridMin, gridStep, NX, NY, NZ, NPad), m_tol(0.001) {
+    : BaseGrid(gridMin, gridStep, NX, NY, NZ, NPad), m_grid(nullptr, 0, 0, 0),
+      m_tol(0.001) {
   CreateArrays();
   // Initialise the grid to zero
   SetAllValues(0.0);
@@ -39,7 +40,8 @@ RealGrid::RealGrid(const Coord &gridMin, const Coord &gridStep, unsigned int NX,
 }
 
 // Constructor reading params from binary stream
-RealGrid::RealGrid(json j) : BaseGrid(j.at("base-grid")) {
+RealGrid::RealGrid(json j)
+    : BaseGrid(j.at("base-grid")), m_grid(nullptr, 0, 0, 0) {
   // Base class constructor has already read the grid dimensions
   // etc, so all we have to do here is created the array
   // and read in the grid values
@@ -48,11 +50,21 @@ RealGrid::RealGrid(json j) : BaseGrid(j.at("base-grid")) {
   _RBTOBJECTCOUNTER_CONSTR_("RealGrid");
 }
 
+RealGrid::RealGrid(const BaseGrid &grid, const float *pData, double tol,
+                   std::shared_ptr<const void> spOwner)
+    : BaseGrid(grid), m_spExternal(spOwner), m_grid(nullptr, 0, 0, 0),
+      m_tol(tol) {
+  // The map is only ever read through, see class declaration
+  MapArrays(const_cast<float *>(pData));
+  _RBTOBJECTCOUNTER_CONSTR_("RealGrid");
+}
+
 // Default destructor
 RealGrid::~RealGrid() { _RBTOBJECTCOUNTER_DESTR_("RealGrid"); }
 
 // Copy constructor
-RealGrid::RealGrid(const RealGrid &grid) : BaseGrid(grid) {
+RealGrid::RealGrid(const RealGrid &grid)
+    : BaseGrid(grid), m_grid(nullptr, 0, 0, 0) {
   // Base class constructor has already been called
   // so we just need to create the array and copy the array values
   CreateArrays();
@@ -62,7 +74,8 @@ RealGrid::RealGrid(const RealGrid &grid) : BaseGrid(grid) {
 
 // Copy constructor taking a base class argument
 // Sets up the grid dimensions, then creates an empty data array
-RealGrid::RealGrid(const BaseGrid &grid) : BaseGrid(grid) {
+RealGrid::RealGrid(const BaseGrid &grid)
+    : BaseGrid(grid), m_grid(nullptr, 0, 0, 0) {
   CreateArrays();
   SetAllValues(0.0);
   _RBTOBJECTCOUNTER_COPYCONSTR_("RealGrid");
@@ -111,74 +124,157 @@ void RealGrid::Print(std::ostream &ostr) const {
 // Get/Set value functions
 /////////////////////////
 
+namespace {
+
+// Grid constants needed for trilinear interpolation, computed once per call
+// rather than once per point
+struct Interpolator {
+  explicit Interpolator(const RealGrid &grid)
+      : pGrid(&grid), pData(grid.GetGridData()), sX(grid.GetNY() * grid.GetNZ()),
+        sY(grid.GetNZ()), nPad(grid.GetPad()),
+        // Lower left corners must be at least one grid point from the upper
+        // edge of the active region
+        xMax(grid.GetNX() > nPad + 1 ? grid.GetNX() - nPad - 1 : 0),
+        yMax(grid.GetNY() > nPad + 1 ? grid.GetNY() - nPad - 1 : 0),
+        zMax(grid.GetNZ() > nPad + 1 ? grid.GetNZ() - nPad - 1 : 0),
+        minX(grid.GetGridMin().xyz(0)), minY(grid.GetGridMin().xyz(1)),
+        minZ(grid.GetGridMin().xyz(2)), stepX(grid.GetGridStep().xyz(0)),
+        stepY(grid.GetGridStep().xyz(1)), stepZ(grid.GetGridStep().xyz(2)),
+        rx(1.0 / stepX), ry(1.0 / stepY), rz(1.0 / stepZ),
+        nXMin(grid.GetnXMin()), nYMin(grid.GetnYMin()), nZMin(grid.GetnZMin()) {
+  }
+
+  // Returns the interpolated value at (x,y,z). If bGradient is true, also
+  // returns the gradient in (dx,dy,dz); outside the grid the gradient is zero
+  // and the unsmoothed value is returned
+  template <bool bGradient>
+  double Value(double x, double y, double z, double &dx, double &dy,
+               double &dz) const {
+    // Get lower left corner grid point
+    //(not necessarily the nearest grid point as returned by GetIX() etc)
+    // Need to shift the int(..) argument by half a grid step
+    unsigned int iX = static_cast<unsigned int>(rx * (x - minX) - 0.5);
+    unsigned int iY = static_cast<unsigned int>(ry * (y - minY) - 0.5);
+    unsigned int iZ = static_cast<unsigned int>(rz * (z - minZ) - 0.5);
+    // Check this point (iX,iY,iZ) and (iX+1,iY+1,iZ+1) are all in bounds
+    // else return the unsmoothed GetValue(c)
+    if (iX < nPad || iX >= xMax || iY < nPad || iY >= yMax || iZ < nPad ||
+        iZ >= zMax) {
+      if (bGradient) {
+        dx = dy = dz = 0.0;
+      }
+      return pGrid->GetValue(Coord(x, y, z));
+    }
+    // Position relative to the lower left corner, in units of grid step
+    double bx1 = rx * (x - (nXMin + static_cast<int>(iX)) * stepX);
+    double bx0 = 1.0 - bx1;
+    double by1 = ry * (y - (nYMin + static_cast<int>(iY)) * stepY);
+    double by0 = 1.0 - by1;
+    double bz1 = rz * (z - (nZMin + static_cast<int>(iZ)) * stepZ);
+    double bz0 = 1.0 - bz1;
+    const float *p000 = pData + iX * sX + iY * sY + iZ;
+    const float *p100 = p000 + sX;
+    double v000 = p000[0];
+    double v001 = p000[1];
+    double v010 = p000[sY];
+    double v011 = p000[sY + 1];
+    double v100 = p100[0];
+    double v101 = p100[1];
+    double v110 = p100[sY];
+    double v111 = p100[sY + 1];
+    if (!bGradient) {
+      // DM 3/5/2005 - fully unroll this loop
+      double bx0by0 = bx0 * by0;
+      double bx0by1 = bx0 * by1;
+      double bx1by0 = bx1 * by0;
+      double bx1by1 = bx1 * by1;
+      double val(0.0);
+      val += v000 * bx0by0 * bz0;
+      val += v001 * bx0by0 * bz1;
+      val += v010 * bx0by1 * bz0;
+      val += v011 * bx0by1 * bz1;
+      val += v100 * bx1by0 * bz0;
+      val += v101 * bx1by0 * bz1;
+      val += v110 * bx1by1 * bz0;
+      val += v111 * bx1by1 * bz1;
+      return val;
+    }
+    // Interpolate along z first, then y, then x
+    double v00 = v000 * bz0 + v001 * bz1;
+    double v01 = v010 * bz0 + v011 * bz1;
+    double v10 = v100 * bz0 + v101 * bz1;
+    double v11 = v110 * bz0 + v111 * bz1;
+    double v0 = v00 * by0 + v01 * by1;
+    double v1 = v10 * by0 + v11 * by1;
+    dx = (v1 - v0) * rx;
+    dy = ((v01 - v00) * bx0 + (v11 - v10) * bx1) * ry;
+    dz = (((v001 - v000) * by0 + (v011 - v010) * by1) * bx0 +
+          ((v101 - v100) * by0 + (v111 - v110) * by1) * bx1) *
+         rz;
+    return v0 * bx0 + v1 * bx1;
+  }
+
+  const RealGrid *pGrid;
+  const float *pData;
+  unsigned int sX; // Strides of the row-major data array
+  unsigned int sY;
+  unsigned int nPad;
+  unsigned int xMax; // Upper bounds (exclusive) for the lower left corner
+  unsigned int yMax;
+  unsigned int zMax;
+  double minX;
+  double minY;
+  double minZ;
+  double stepX;
+  double stepY;
+  double stepZ;
+  double rx; // reciprocals of grid step
+  double ry;
+  double rz;
+  int nXMin;
+  int nYMin;
+  int nZMin;
+};
+
+} // namespace
+
 // DM 20 Jul 2000 - get values smoothed by trilinear interpolation
 // D. Oberlin and H.A. Scheraga, J. Comp. Chem. (1998) 19, 71.
 double RealGrid::GetSmoothedValue(const Coord &c) const {
-  const Coord &gridMin = GetGridMin();
-  const Vector &gridStep = GetGridStep();
-  Eigen::Vector3d rXYZ =
-      gridStep.xyz.Constant(1.0).array() / gridStep.xyz.array();
-  double rx = rXYZ(0); // reciprocal of grid step (x)
-  double ry = rXYZ(1); // reciprocal of grid step (y)
-  double rz = rXYZ(2); // reciprocal of grid step (z)
-  // Get lower left corner grid point
-  //(not necessarily the nearest grid point as returned by GetIX() etc)
-  // Need to shift the int(..) argument by half a grid step
-  Eigen::Vector3d diff = c.xyz - gridMin.xyz;
-  unsigned int iX = static_cast<unsigned int>(rx * diff(0) - 0.5);
-  unsigned int iY = static_cast<unsigned int>(ry * diff(1) - 0.5);
-  unsigned int iZ = static_cast<unsigned int>(rz * diff(2) - 0.5);
-  LOG_F(1, "RealGrid::GetSmoothedValue: {} iX={} iY={} iZ={}", c, iX, iY, iZ);
-  // Check this point (iX,iY,iZ) and (iX+1,iY+1,iZ+1) are all in bounds
-  // else return the unsmoothed GetValue(c)
-  if (!isValid(iX, iY, iZ) || !isValid(iX + 1, iY + 1, iZ + 1)) {
-    LOG_F(1, "Out of bounds");
-    return GetValue(c);
-  }
-  // p is the vector relative to the lower left corner
-  Vector p = c - GetCoord(iX, iY, iZ);
-  LOG_F(1, "p={}", p);
-  // Set up B0 and B1 for each of x,y,z axes
-  // std::vector<double> bx(2);
-  // std::vector<double> by(2);
-  // std::vector<double> bz(2);
-  // bx[1] = rx * p.xyz(0);
-  // bx[0] = 1.0 - bx[1];
-  // by[1] = ry * p.xyz(1);
-  // by[0] = 1.0 - by[1];
-  // bz[1] = rz * p.xyz(2);
-  // bz[0] = 1.0 - bz[1];
-
-  double val(0.0);
-  // DM 3/5/2005 - fully unroll this loop
-  double bx1 = rx * p.xyz(0);
-  double bx0 = 1.0 - bx1;
-  double by1 = ry * p.xyz(1);
-  double by0 = 1.0 - by1;
-  double bz1 = rz * p.xyz(2);
-  double bz0 = 1.0 - bz1;
-  double bx0by0 = bx0 * by0;
-  double bx0by1 = bx0 * by1;
-  double bx1by0 = bx1 * by0;
-  double bx1by1 = bx1 * by1;
-  val += m_grid(iX, iY, iZ) * bx0by0 * bz0;
-  val += m_grid(iX, iY, iZ + 1) * bx0by0 * bz1;
-  val += m_grid(iX, iY + 1, iZ) * bx0by1 * bz0;
-  val += m_grid(iX, iY + 1, iZ + 1) * bx0by1 * bz1;
-  val += m_grid(iX + 1, iY, iZ) * bx1by0 * bz0;
-  val += m_grid(iX + 1, iY, iZ + 1) * bx1by0 * bz1;
-  val += m_grid(iX + 1, iY + 1, iZ) * bx1by1 * bz0;
-  val += m_grid(iX + 1, iY + 1, iZ + 1) * bx1by1 * bz1;
-  // for (UInt i = 0; i < 2; i++) {
-  //  for (UInt j = 0; j < 2; j++) {
-  //    for (UInt k = 0; k < 2; k++) {
-  //      val += m_grid[iX+i][iY+j][iZ+k]*bx[i]*by[j]*bz[k];
-  //    }
-  //  }
-  //}
+  double dx, dy, dz;
+  return Interpolator(*this).Value<false>(c.xyz(0), c.xyz(1), c.xyz(2), dx, dy,
+                                          dz);
+}
+
+double RealGrid::GetSmoothedValueGradient(const Coord &c,
+                                          Vector &gradient) const {
+  double dx, dy, dz;
+  double val = Interpolator(*this).Value<true>(c.xyz(0), c.xyz(1), c.xyz(2),
+                                               dx, dy, dz);
+  gradient = Vector(dx, dy, dz);
   return val;
 }
 
+void RealGrid::AddSmoothedValues(std::size_t n, const double *x,
+                                 const double *y, const double *z,
+                                 double *values, double *gx, double *gy,
+                                 double *gz) const {
+  Interpolator interp(*this);
+  double dx, dy, dz;
+  if (gx == nullptr) {
+    for (std::size_t i = 0; i < n; i++) {
+      values[i] += interp.Value<false>(x[i], y[i], z[i], dx, dy, dz);
+    }
+  } else {
+    for (std::size_t i = 0; i < n; i++) {
+      values[i] += interp.Value<true>(x[i], y[i], z[i], dx, dy, dz);
+      gx[i] += dx;
+      gy[i] += dy;
+      gz[i] += dz;
+    }
+  }
+}
+
 // Set all grid points to the given value
 void RealGrid::SetAllValues(double val) { m_grid.setConstant(val); }
 
@@ -451,10 +547,15 @@ void RealGrid::SetValues(const std::vector<unsigned int> &iXYZList, double val,
 }
 
 void RealGrid::CreateArrays() {
-  int nX = GetNX();
-  int nY = GetNY();
-  int nZ = GetNZ();
-  m_grid = Eigen::Tensor<float, 3, Eigen::RowMajor>(nX, nY, nZ);
+  m_spExternal.reset();
+  m_data.assign(GetN(), 0.0f);
+  MapArrays(m_data.data());
+}
+
+void RealGrid::MapArrays(float *pData) {
+  // TensorMap cannot be reseated by assignment (that copies the values), so
+  // construct a new map in place (as recommended for Eigen::Map)
+  new (&m_grid) GridMap(pData, GetNX(), GetNY(), GetNZ());
 }
 
 // Helper function called by copy constructor and assignment operator
@@ -462,7 +563,7 @@ void RealGrid::CreateArrays() {
 // Gets called after array has been created, and base class copy has been done
 void RealGrid::CopyGrid(const RealGrid &grid) {
   m_tol = grid.m_tol;
-  m_grid = grid.m_grid;
+  std::copy(grid.m_grid.data(), grid.m_grid.data() + GetN(), m_grid.data());
 }
 
 void rxdock::to_json(json &j, const RealGrid &grid) {
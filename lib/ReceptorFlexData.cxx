@@ -16,9 +16,11 @@ using namespace rxdock;
 
 const std::string &ReceptorFlexData::_FLEX_DISTANCE = "flexibility-distance";
 const std::string &ReceptorFlexData::_DIHEDRAL_STEP = "dihedral-step";
+const std::string &ReceptorFlexData::_CONFORMER_STEP = "conformer-step";
 
 ReceptorFlexData::ReceptorFlexData(DockingSite *pDockSite)
     : FlexData(pDockSite) {
   AddParameter(_FLEX_DISTANCE, 3.0);
   AddParameter(_DIHEDRAL_STEP, 30.0);
+  AddParameter(_CONFORMER_STEP, 0.25);
 }
@@ -0,0 +1,220 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/ResultsTableSink.h"
+#include "rxdock/FileError.h"
+
+#include <nlohmann/json.hpp>
+
+#include <limits>
+
+using namespace rxdock;
+using json = nlohmann::json;
+
+const std::string ResultsTableSink::_CT = "ResultsTableSink";
+const std::string ResultsTableSink::_MAGIC = "RXDOCKRT";
+
+namespace {
+
+const char *GetTypeName(ResultsTableSink::ColumnType type) {
+  switch (type) {
+  case ResultsTableSink::INT64:
+    return "int64";
+  case ResultsTableSink::FLOAT64:
+    return "float64";
+  default:
+    return "string";
+  }
+}
+
+} // namespace
+
+ResultsTableSink::ResultsTableSink(const std::string &fileName,
+                                   std::size_t rowGroupSize)
+    : m_fileName(fileName),
+      m_rowGroupSize(std::max<std::size_t>(rowGroupSize, 1)), m_nRows(0),
+      m_nGroupRows(0), m_bClosed(false) {
+  m_fileOut.open(m_fileName, std::ios::binary);
+  if (!m_fileOut) {
+    throw FileWriteError(_WHERE_, "Error opening " + m_fileName);
+  }
+  m_fileOut.write(_MAGIC.data(), _MAGIC.size());
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+ResultsTableSink::~ResultsTableSink() {
+  if (!m_bClosed) {
+    try {
+      Close();
+    } catch (Error &) {
+      // Destructors must not throw
+    }
+  }
+  _RBTOBJECTCOUNTER_DESTR_(_CT);
+}
+
+void ResultsTableSink::SetInt(const std::string &name, std::int64_t value) {
+  Column &column = GetColumn(name, INT64);
+  Pad(column, m_nGroupRows);
+  if (column.ints.size() > m_nGroupRows) {
+    column.ints.back() = value;
+  } else {
+    column.ints.push_back(value);
+  }
+}
+
+void ResultsTableSink::SetDouble(const std::string &name, double value) {
+  Column &column = GetColumn(name, FLOAT64);
+  Pad(column, m_nGroupRows);
+  if (column.doubles.size() > m_nGroupRows) {
+    column.doubles.back() = value;
+  } else {
+    column.doubles.push_back(value);
+  }
+}
+
+void ResultsTableSink::SetString(const std::string &name,
+                                 const std::string &value) {
+  Column &column = GetColumn(name, STRING);
+  Pad(column, m_nGroupRows);
+  if (column.strings.size() > m_nGroupRows) {
+    column.strings.back() = value;
+  } else {
+    column.strings.push_back(value);
+  }
+}
+
+void ResultsTableSink::EndRow() {
+  m_nGroupRows++;
+  m_nRows++;
+  for (auto &column : m_columns) {
+    Pad(column, m_nGroupRows);
+  }
+  if (m_nGroupRows >= m_rowGroupSize) {
+    WriteRowGroup();
+  }
+}
+
+void ResultsTableSink::Close() {
+  if (m_bClosed) {
+    return;
+  }
+  m_bClosed = true;
+  if (m_nGroupRows > 0) {
+    WriteRowGroup();
+  }
+  json footer;
+  footer["version"] = 1;
+  footer["num-rows"] = m_nRows;
+  footer["row-groups"] = m_rowGroupSizes;
+  footer["columns"] = json::array();
+  for (const auto &column : m_columns) {
+    footer["columns"].push_back({{"name", column.name},
+                                 {"type", GetTypeName(column.type)},
+                                 {"chunks", column.chunks}});
+  }
+  std::string strFooter = footer.dump();
+  std::uint64_t footerLength = strFooter.size();
+  m_fileOut.write(strFooter.data(), strFooter.size());
+  m_fileOut.write(reinterpret_cast<const char *>(&footerLength),
+                  sizeof(footerLength));
+  m_fileOut.write(_MAGIC.data(), _MAGIC.size());
+  m_fileOut.close();
+  if (!m_fileOut) {
+    throw FileWriteError(_WHERE_, "Error writing " + m_fileName);
+  }
+}
+
+// Private methods
+
+ResultsTableSink::Column &ResultsTableSink::GetColumn(const std::string &name,
+                                                      ColumnType type) {
+  if (m_bClosed) {
+    throw InvalidRequest(_WHERE_, "Results table " + m_fileName + " is closed");
+  }
+  auto iter = m_columnIndex.find(name);
+  if (iter != m_columnIndex.end()) {
+    Column &column = m_columns[iter->second];
+    if (column.type != type) {
+      throw BadArgument(_WHERE_, "Column " + name + " is of type " +
+                                     GetTypeName(column.type));
+    }
+    return column;
+  }
+  m_columnIndex[name] = m_columns.size();
+  m_columns.push_back(Column());
+  Column &column = m_columns.back();
+  column.name = name;
+  column.type = type;
+  // Not present in the row groups already written
+  column.chunks.resize(m_rowGroupSizes.size(), std::make_pair(0, 0));
+  return column;
+}
+
+void ResultsTableSink::Pad(Column &column, std::size_t nRows) {
+  switch (column.type) {
+  case INT64:
+    column.ints.resize(std::max(column.ints.size(), nRows), 0);
+    break;
+  case FLOAT64:
+    column.doubles.resize(std::max(column.doubles.size(), nRows),
+                          std::numeric_limits<double>::quiet_NaN());
+    break;
+  case STRING:
+    column.strings.resize(std::max(column.strings.size(), nRows));
+    break;
+  }
+}
+
+void ResultsTableSink::WriteRowGroup() {
+  for (auto &column : m_columns) {
+    std::uint64_t offset = m_fileOut.tellp();
+    switch (column.type) {
+    case INT64:
+      m_fileOut.write(reinterpret_cast<const char *>(column.ints.data()),
+                      column.ints.size() * sizeof(std::int64_t));
+      column.ints.clear();
+      break;
+    case FLOAT64:
+      m_fileOut.write(reinterpret_cast<const char *>(column.doubles.data()),
+                      column.doubles.size() * sizeof(double));
+      column.doubles.clear();
+      break;
+    case STRING: {
+      // End offsets of the strings, then their characters
+      std::vector<std::uint64_t> ends;
+      ends.reserve(column.strings.size());
+      std::uint64_t end = 0;
+      for (const auto &str : column.strings) {
+        end += str.size();
+        ends.push_back(end);
+      }
+      m_fileOut.write(reinterpret_cast<const char *>(ends.data()),
+                      ends.size() * sizeof(std::uint64_t));
+      for (const auto &str : column.strings) {
+        m_fileOut.write(str.data(), str.size());
+      }
+      column.strings.clear();
+      break;
+    }
+    }
+    std::uint64_t length =
+        static_cast<std::uint64_t>(m_fileOut.tellp()) - offset;
+    column.chunks.push_back(std::make_pair(offset, length));
+  }
+  if (!m_fileOut) {
+    throw FileWriteError(_WHERE_, "Error writing " + m_fileName);
+  }
+  m_rowGroupSizes.push_back(m_nGroupRows);
+  m_nGroupRows = 0;
+}
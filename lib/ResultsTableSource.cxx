@@ -0,0 +1,217 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/ResultsTableSource.h"
+#include "rxdock/FileError.h"
+
+#include <nlohmann/json.hpp>
+
+#include <limits>
+
+using namespace rxdock;
+using json = nlohmann::json;
+
+const std::string ResultsTableSource::_CT = "ResultsTableSource";
+
+ResultsTableSource::ResultsTableSource(const std::string &fileName)
+    : m_fileName(fileName), m_nRows(0) {
+  m_fileIn.open(m_fileName, std::ios::binary);
+  if (!m_fileIn) {
+    throw FileReadError(_WHERE_, "Error opening " + m_fileName);
+  }
+  const std::string &magic = ResultsTableSink::_MAGIC;
+  std::uint64_t footerLength = 0;
+  std::string trailer(magic.size(), ' ');
+  m_fileIn.seekg(0, std::ios::end);
+  std::int64_t fileSize = m_fileIn.tellg();
+  std::int64_t trailerSize = sizeof(footerLength) + magic.size();
+  if (fileSize < trailerSize + static_cast<std::int64_t>(magic.size())) {
+    throw FileParseError(_WHERE_, m_fileName + " is not a results table");
+  }
+  m_fileIn.seekg(fileSize - trailerSize);
+  m_fileIn.read(reinterpret_cast<char *>(&footerLength), sizeof(footerLength));
+  m_fileIn.read(&trailer[0], trailer.size());
+  if (!m_fileIn || trailer != magic ||
+      footerLength > static_cast<std::uint64_t>(fileSize - trailerSize)) {
+    throw FileParseError(_WHERE_, m_fileName + " is not a results table");
+  }
+  std::string strFooter(footerLength, ' ');
+  m_fileIn.seekg(fileSize - trailerSize - footerLength);
+  m_fileIn.read(&strFooter[0], footerLength);
+
+  try {
+    json footer = json::parse(strFooter);
+    footer.at("num-rows").get_to(m_nRows);
+    footer.at("row-groups").get_to(m_rowGroupSizes);
+    for (const auto &col : footer.at("columns")) {
+      Column column;
+      col.at("name").get_to(column.name);
+      std::string strType = col.at("type").get<std::string>();
+      if (strType == "int64") {
+        column.type = ResultsTableSink::INT64;
+      } else if (strType == "float64") {
+        column.type = ResultsTableSink::FLOAT64;
+      } else if (strType == "string") {
+        column.type = ResultsTableSink::STRING;
+      } else {
+        throw FileParseError(_WHERE_, "Unknown column type " + strType +
+                                          " in " + m_fileName);
+      }
+      col.at("chunks").get_to(column.chunks);
+      if (column.chunks.size() != m_rowGroupSizes.size()) {
+        throw FileParseError(_WHERE_, "Inconsistent row groups in " +
+                                          m_fileName);
+      }
+      m_columns.push_back(column);
+    }
+  } catch (json::exception &e) {
+    throw FileParseError(_WHERE_, "Invalid footer in " + m_fileName + ": " +
+                                      e.what());
+  }
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+ResultsTableSource::~ResultsTableSource() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+std::vector<std::string> ResultsTableSource::GetColumnNames() const {
+  std::vector<std::string> names;
+  for (const auto &column : m_columns) {
+    names.push_back(column.name);
+  }
+  return names;
+}
+
+bool ResultsTableSource::isColumnPresent(const std::string &name) const {
+  for (const auto &column : m_columns) {
+    if (column.name == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+ResultsTableSink::ColumnType
+ResultsTableSource::GetColumnType(const std::string &name) const {
+  for (const auto &column : m_columns) {
+    if (column.name == name) {
+      return column.type;
+    }
+  }
+  throw BadArgument(_WHERE_, "No column " + name + " in " + m_fileName);
+}
+
+std::vector<std::int64_t>
+ResultsTableSource::GetIntColumn(const std::string &name) {
+  const Column &column = GetColumn(name, ResultsTableSink::INT64);
+  std::vector<std::int64_t> values(m_nRows, 0);
+  std::size_t iRow = 0;
+  for (std::size_t i = 0; i < m_rowGroupSizes.size(); i++) {
+    if (column.chunks[i].first != 0) {
+      if (column.chunks[i].second != m_rowGroupSizes[i] * 8) {
+        throw FileParseError(_WHERE_, "Invalid column " + name + " in " +
+                                          m_fileName);
+      }
+      ReadValues(column.chunks[i].first, m_rowGroupSizes[i], &values[iRow]);
+    }
+    iRow += m_rowGroupSizes[i];
+  }
+  return values;
+}
+
+std::vector<double>
+ResultsTableSource::GetDoubleColumn(const std::string &name) {
+  if (GetColumnType(name) == ResultsTableSink::INT64) {
+    std::vector<std::int64_t> ints = GetIntColumn(name);
+    return std::vector<double>(ints.begin(), ints.end());
+  }
+  const Column &column = GetColumn(name, ResultsTableSink::FLOAT64);
+  std::vector<double> values(m_nRows,
+                             std::numeric_limits<double>::quiet_NaN());
+  std::size_t iRow = 0;
+  for (std::size_t i = 0; i < m_rowGroupSizes.size(); i++) {
+    if (column.chunks[i].first != 0) {
+      if (column.chunks[i].second != m_rowGroupSizes[i] * 8) {
+        throw FileParseError(_WHERE_, "Invalid column " + name + " in " +
+                                          m_fileName);
+      }
+      ReadValues(column.chunks[i].first, m_rowGroupSizes[i], &values[iRow]);
+    }
+    iRow += m_rowGroupSizes[i];
+  }
+  return values;
+}
+
+std::vector<std::string>
+ResultsTableSource::GetStringColumn(const std::string &name) {
+  const Column &column = GetColumn(name, ResultsTableSink::STRING);
+  std::vector<std::string> values(m_nRows);
+  std::size_t iRow = 0;
+  std::vector<std::uint64_t> ends;
+  std::string chars;
+  for (std::size_t i = 0; i < m_rowGroupSizes.size(); i++) {
+    std::size_t n = m_rowGroupSizes[i];
+    if (column.chunks[i].first != 0 && n > 0) {
+      ends.resize(n);
+      ReadValues(column.chunks[i].first, n, ends.data());
+      std::uint64_t nChars =
+          column.chunks[i].second - n * sizeof(std::uint64_t);
+      if (ends.back() != nChars) {
+        throw FileParseError(_WHERE_, "Invalid string column " + name +
+                                          " in " + m_fileName);
+      }
+      chars.resize(nChars);
+      m_fileIn.read(&chars[0], nChars);
+      std::uint64_t start = 0;
+      for (std::size_t j = 0; j < n; j++) {
+        if (ends[j] < start || ends[j] > nChars) {
+          throw FileParseError(_WHERE_, "Invalid string column " + name +
+                                            " in " + m_fileName);
+        }
+        values[iRow + j].assign(chars, start, ends[j] - start);
+        start = ends[j];
+      }
+    }
+    iRow += n;
+  }
+  if (!m_fileIn) {
+    throw FileReadError(_WHERE_, "Error reading " + m_fileName);
+  }
+  return values;
+}
+
+// Private methods
+
+const ResultsTableSource::Column &
+ResultsTableSource::GetColumn(const std::string &name,
+                              ResultsTableSink::ColumnType type) const {
+  for (const auto &column : m_columns) {
+    if (column.name == name) {
+      if (column.type != type) {
+        throw BadArgument(_WHERE_, "Column " + name + " in " + m_fileName +
+                                       " has a different type");
+      }
+      return column;
+    }
+  }
+  throw BadArgument(_WHERE_, "No column " + name + " in " + m_fileName);
+}
+
+template <typename T>
+void ResultsTableSource::ReadValues(std::uint64_t offset, std::size_t n,
+                                    T *values) {
+  m_fileIn.clear();
+  m_fileIn.seekg(offset);
+  if (!m_fileIn.read(reinterpret_cast<char *>(values), n * sizeof(T))) {
+    throw FileReadError(_WHERE_, "Error reading " + m_fileName);
+  }
+}
@@ -51,14 +51,150 @@ void SAIdxSF::SetupReceptor() {
   if (GetReceptor().Null())
     return;
 
-  // Trap multiple receptor conformations here: this SF does not support them
-  // yet
-  bool bEnsemble = (GetReceptor()->GetNumSavedCoords() > 1);
-  if (bEnsemble) {
-    throw InvalidRequest(_WHERE_, "Solvation scoring function does not support "
-                                  "multiple receptor conformations yet");
+  // Multiple receptor conformations are only supported if the conformer is
+  // sampled during docking. Each conformer is then set up on its own, as the
+  // invariant surface areas differ between conformers
+  int nCoords = GetReceptor()->GetNumSavedCoords() - 1;
+  if (nCoords > 0) {
+    if (!GetReceptor()->isConformerSampled()) {
+      throw InvalidRequest(
+          _WHERE_, "Solvation scoring function only supports multiple "
+                   "receptor conformations if they are sampled (receptor "
+                   "parameter sample-conformers)");
+    }
+    for (int i = 1; i <= nCoords; i++) {
+      LOG_F(1, "SAIdxSF::SetupReceptor: Setting up receptor coords #{}", i);
+      GetReceptor()->SetCurrentConformer(i);
+      SetupReceptorCoords();
+      m_conformerRSPLists.push_back(theRSPList);
+      m_conformerCavLists.push_back(theCavList);
+      m_conformerIdxGrids.push_back(theIdxGrid);
+      m_conformerSite0.push_back(m_site_0);
+      theRSPList.clear();
+      theCavList.clear();
+      theIdxGrid = NonBondedHHSGridPtr();
+      m_site_0 = 0.0;
+    }
+  } else {
+    if (LoadReceptorSetup(GetReceptor())) {
+      return;
+    }
+    SetupReceptorCoords();
+    SaveReceptorSetup(GetReceptor());
+  }
+}
+
+// The interaction centers are written with their exposed fractions, so that
+// the surface areas need not be recalculated. The site lists, grid and
+// variable interactions refer to the interaction centers by their index in
+// the concatenated rigid and flexible receptor lists
+void SAIdxSF::WriteReceptorSetup(CacheEntryWriter &writer) const {
+  CacheIndexMap<Atom> atomIndex =
+      CreateCacheIndexMap(GetReceptorAtomTable(GetReceptor()));
+  HHS_SolvationRList hhsTable(theRSPList);
+  std::copy(theFlexList.begin(), theFlexList.end(),
+            std::back_inserter(hhsTable));
+  std::vector<std::int32_t> type;
+  AtomRList atoms;
+  std::vector<double> p, r, sigma, a, aInv;
+  for (const auto *pHHS : hhsTable) {
+    type.push_back(pHHS->GetHHSType());
+    atoms.push_back(pHHS->GetAtom());
+    p.push_back(pHHS->GetP_i());
+    r.push_back(pHHS->GetR_i());
+    sigma.push_back(pHHS->GetSigma());
+    a.push_back(pHHS->GetA_i());
+    aInv.push_back(pHHS->GetA_inv());
+  }
+  writer.Put<std::uint64_t>(theRSPList.size());
+  writer.Put<std::uint64_t>(theFlexList.size());
+  writer.PutValues(type);
+  writer.PutIndices(atoms, atomIndex);
+  writer.PutValues(p);
+  writer.PutValues(r);
+  writer.PutValues(sigma);
+  writer.PutValues(a);
+  writer.PutValues(aInv);
+
+  CacheIndexMap<HHS_Solvation> hhsIndex = CreateCacheIndexMap(hhsTable);
+  writer.PutIndexLists(
+      hhsTable.size(),
+      [&hhsTable](std::size_t i) -> const HHS_SolvationRList & {
+        return hhsTable[i]->GetAllVariable();
+      },
+      hhsIndex);
+  writer.PutIndexLists(
+      hhsTable.size(),
+      [&hhsTable](std::size_t i) -> const HHS_SolvationRList & {
+        return hhsTable[i]->GetVariable();
+      },
+      hhsIndex);
+  writer.PutIndices(theCavList, hhsIndex);
+  writer.PutIndices(thePeriphList, hhsIndex);
+  writer.PutIndexLists(
+      theIdxGrid->GetN(),
+      [this](std::size_t i) -> const HHS_SolvationRList & {
+        return theIdxGrid->GetHHSList(i);
+      },
+      hhsIndex);
+  writer.Put<double>(m_site_0);
+}
+
+void SAIdxSF::ReadReceptorSetup(CacheEntryReader &reader) {
+  AtomRList atomTable = GetReceptorAtomTable(GetReceptor());
+  std::size_t nRigid = reader.Get<std::uint64_t>();
+  std::size_t nFlex = reader.Get<std::uint64_t>();
+  std::size_t nHHS = nRigid + nFlex;
+  std::vector<std::int32_t> type = reader.GetColumn<std::int32_t>(nHHS);
+  for (auto t : type) {
+    if (t < 0 || t >= HHSType::MAXTYPES) {
+      throw std::length_error("Receptor setup solvation type out of range");
+    }
+  }
+  std::vector<std::uint32_t> atoms = reader.GetIndices(atomTable.size());
+  if (atoms.size() != nHHS) {
+    throw std::length_error("Receptor setup has too few solvation atoms");
+  }
+  std::vector<double> p = reader.GetColumn<double>(nHHS);
+  std::vector<double> r = reader.GetColumn<double>(nHHS);
+  std::vector<double> sigma = reader.GetColumn<double>(nHHS);
+  std::vector<double> a = reader.GetColumn<double>(nHHS);
+  std::vector<double> aInv = reader.GetColumn<double>(nHHS);
+  std::vector<std::vector<std::uint32_t>> var =
+      reader.GetIndexLists(nHHS, nHHS);
+  std::vector<std::vector<std::uint32_t>> prt =
+      reader.GetIndexLists(nHHS, nHHS);
+  std::vector<std::uint32_t> cav = reader.GetIndices(nHHS);
+  std::vector<std::uint32_t> periph = reader.GetIndices(nHHS);
+  NonBondedHHSGridPtr spGrid = CreateNonBondedHHSGrid();
+  std::vector<std::vector<std::uint32_t>> cells =
+      reader.GetIndexLists(spGrid->GetN(), nHHS);
+  double site0 = reader.Get<double>();
+
+  HHS_SolvationRList hhsTable;
+  for (std::size_t i = 0; i < nHHS; i++) {
+    hhsTable.push_back(
+        new HHS_Solvation(static_cast<HHSType::eType>(type[i]),
+                          atomTable[atoms[i]], p[i], r[i], sigma[i]));
+  }
+  for (std::size_t i = 0; i < nHHS; i++) {
+    hhsTable[i]->SetState(a[i], aInv[i], GetCachedPointers(var[i], hhsTable),
+                          GetCachedPointers(prt[i], hhsTable));
+  }
+  theRSPList.assign(hhsTable.begin(), hhsTable.begin() + nRigid);
+  theFlexList.assign(hhsTable.begin() + nRigid, hhsTable.end());
+  theCavList = GetCachedPointers(cav, hhsTable);
+  thePeriphList = GetCachedPointers(periph, hhsTable);
+  theIdxGrid = spGrid;
+  for (std::size_t i = 0; i < cells.size(); i++) {
+    theIdxGrid->SetHHSList(i, GetCachedPointers(cells[i], hhsTable));
   }
+  m_bFlexRec = GetReceptor()->isFlexible();
+  m_site_0 = site0;
+  LOG_F(INFO, "SAIdxSF: Initial site dG(solv): {} kcal/mol", m_site_0);
+}
 
+void SAIdxSF::SetupReceptorCoords() {
   // MAKE THE ASSUMPTION that the only flexible receptor atoms are terminal
   // OH/NH3 and that they don't move very far (up to 2A)
   m_bFlexRec = GetReceptor()->isFlexible();
@@ -298,12 +434,24 @@ void SAIdxSF::SetupSolvent() {
 void SAIdxSF::SetupScore() {}
 
 double SAIdxSF::RawScore(void) const {
+  // Receptor ensembles: use the receptor data of the current conformer
+  const HHS_SolvationRList *pCavList = &theCavList;
+  const NonBondedHHSGrid *pIdxGrid = theIdxGrid.Ptr();
+  double site_0 = m_site_0;
+  int iConformer = GetConformerIndex();
+  if (iConformer >= 0) {
+    pCavList = &m_conformerCavLists[iConformer];
+    pIdxGrid = m_conformerIdxGrids[iConformer].Ptr();
+    site_0 = m_conformerSite0[iConformer];
+  }
+  const HHS_SolvationRList &cavList = *pCavList;
+
   // restore invariant surface areas for ligand, solvent and rigid receptor
   for (HHS_SolvationRListConstIter iter = theLSPList.begin();
        iter != theLSPList.end(); ++iter)
     (*iter)->Restore();
-  for (HHS_SolvationRListConstIter iter = theCavList.begin();
-       iter != theCavList.end(); ++iter)
+  for (HHS_SolvationRListConstIter iter = cavList.begin();
+       iter != cavList.end(); ++iter)
     (*iter)->Restore();
   for (HHS_SolvationRListConstIter iter = theSolventList.begin();
        iter != theSolventList.end(); ++iter)
@@ -340,7 +488,7 @@ double SAIdxSF::RawScore(void) const {
     Atom *pSolventAtom = (*iIter)->GetAtom();
     if (pSolventAtom->GetEnabled()) {
       const Coord &rAtomCoords = pSolventAtom->GetCoords();
-      const HHS_SolvationRList &rList = theIdxGrid->GetHHSList(rAtomCoords);
+      const HHS_SolvationRList &rList = pIdxGrid->GetHHSList(rAtomCoords);
       for (HHS_SolvationRListConstIter jIter = rList.begin();
            jIter != rList.end(); ++jIter)
         (*iIter)->Overlap(*jIter, HHS_Solvation::Pij_14);
@@ -355,7 +503,7 @@ double SAIdxSF::RawScore(void) const {
   if (isAnnotationEnabled()) {
     m_lig_free = TotalEnergy(theLSPList);
     m_solvent_free = TotalEnergy(theSolventList);
-    m_site_free = TotalEnergy(theCavList) + TotalEnergy(theFlexList);
+    m_site_free = TotalEnergy(cavList) + TotalEnergy(theFlexList);
   } else {
     // Clear the intermediate scores just to avoid keeping stale values around
     m_lig_free = 0.0;
@@ -370,7 +518,7 @@ double SAIdxSF::RawScore(void) const {
   for (HHS_SolvationRListConstIter iIter = theLSPList.begin();
        iIter != theLSPList.end(); iIter++) {
     const Coord &rAtomCoords = (*iIter)->GetAtom()->GetCoords();
-    const HHS_SolvationRList &rList = theIdxGrid->GetHHSList(rAtomCoords);
+    const HHS_SolvationRList &rList = pIdxGrid->GetHHSList(rAtomCoords);
     for (HHS_SolvationRListConstIter jIter = rList.begin();
          jIter != rList.end(); ++jIter)
       (*iIter)->Overlap(*jIter, HHS_Solvation::Pij_14);
@@ -397,14 +545,14 @@ double SAIdxSF::RawScore(void) const {
   m_lig_bound = TotalEnergy(theLSPList);
 
   // Total solv energy for site (bound
-  m_site_bound = TotalEnergy(theCavList) + TotalEnergy(theFlexList);
+  m_site_bound = TotalEnergy(cavList) + TotalEnergy(theFlexList);
 
   // Total solv energy for solvent (bound)
   m_solvent_bound = TotalEnergy(theSolventList);
 
   // Total score is overall change in solvation energy for ligand, site and
   // solvent relative to initial unbound scores
-  double theScore = (m_lig_bound - m_lig_0) + (m_site_bound - m_site_0) +
+  double theScore = (m_lig_bound - m_lig_0) + (m_site_bound - site_0) +
                     (m_solvent_bound - m_solvent_0);
   return theScore;
 }
@@ -479,12 +627,37 @@ void SAIdxSF::ClearReceptor(void) {
   theFlexList.clear();
   theCavList.clear();
   thePeriphList.clear();
+  for (std::vector<HHS_SolvationRList>::iterator lIter =
+           m_conformerRSPLists.begin();
+       lIter != m_conformerRSPLists.end(); lIter++) {
+    for (HHS_SolvationRListIter iter = lIter->begin(); iter != lIter->end();
+         iter++) {
+      delete *iter;
+    }
+  }
+  m_conformerRSPLists.clear();
+  m_conformerCavLists.clear();
+  m_conformerIdxGrids.clear();
+  m_conformerSite0.clear();
   m_bFlexRec = false;
   m_site_0 = 0.0;
   m_site_free = 0.0;
   m_site_bound = 0.0;
 }
 
+int SAIdxSF::GetConformerIndex() const {
+  if (m_conformerCavLists.empty()) {
+    return -1;
+  }
+  int iConformer = GetReceptor()->GetCurrentCoords();
+  if (iConformer < 1 ||
+      iConformer > static_cast<int>(m_conformerCavLists.size())) {
+    throw InvalidRequest(_WHERE_, "No solvation data for receptor coords #" +
+                                      std::to_string(iConformer));
+  }
+  return iConformer - 1;
+}
+
 void SAIdxSF::ClearLigand(void) {
   for (HHS_SolvationRListIter iter = theLSPList.begin();
        iter != theLSPList.end(); iter++) {
@@ -549,8 +722,11 @@ void SAIdxSF::ScoreMap(StringVariantMap &scoreMap) const {
     // solvent between the initial conformations and the current conformations.
     // This is nothing to do with the binding event, and so belongs with the
     // other system scores.
+    int iConformer = GetConformerIndex();
+    double site_0 =
+        (iConformer >= 0) ? m_conformerSite0[iConformer] : m_site_0;
     double system_rs =
-        (m_site_free - m_site_0) + (m_solvent_free - m_solvent_0);
+        (m_site_free - site_0) + (m_solvent_free - m_solvent_0);
     std::string systemName = BaseSF::_SYSTEM_SF + "." + GetName();
     scoreMap[systemName] = system_rs;
     // increment the rxdock.score.system total
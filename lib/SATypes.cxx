@@ -372,6 +372,15 @@ void HHS_Solvation::AddVariable(HHS_Solvation *anAtom) {
   m_prt.push_back(anAtom);
 }
 
+void HHS_Solvation::SetState(double a, double aInv,
+                             const std::vector<HHS_Solvation *> &var,
+                             const std::vector<HHS_Solvation *> &prt) {
+  A_i = a;
+  A_inv = aInv;
+  m_var = var;
+  m_prt = prt;
+}
+
 // Helper function to calculate the overlap for all the variable interactions to
 // this center All are 1-4+ by definition
 void HHS_Solvation::OverlapVariable() {
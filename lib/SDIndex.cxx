@@ -0,0 +1,211 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/SDIndex.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <loguru.hpp>
+
+using namespace rxdock;
+
+const std::string SDIndex::_CT = "SDIndex";
+const std::string SDIndex::_MAGIC = "RXDOCKSI";
+const std::uint64_t SDIndex::_VERSION = 1;
+
+namespace {
+
+template <typename T>
+void writeValues(std::ostream &os, const T *p, std::size_t n) {
+  os.write(reinterpret_cast<const char *>(p), n * sizeof(T));
+}
+
+template <typename T> void readValues(std::istream &is, T *p, std::size_t n) {
+  is.read(reinterpret_cast<char *>(p), n * sizeof(T));
+}
+
+} // namespace
+
+SDIndex::SDIndex(const std::string &strSDFile, bool bSave)
+    : m_strSDFile(strSDFile), m_fileSize(0), m_fileTime(0) {
+  struct stat fileStat;
+  if (stat(m_strSDFile.c_str(), &fileStat) != 0) {
+    throw FileReadError(_WHERE_, "Error opening " + m_strSDFile);
+  }
+  m_fileSize = fileStat.st_size;
+  m_fileTime = fileStat.st_mtime;
+  if (!Load()) {
+    Build();
+    if (bSave) {
+      Save();
+    }
+  }
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+SDIndex::~SDIndex() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+std::string SDIndex::GetTitle(std::size_t iRecord) const {
+  std::size_t start = (iRecord == 0) ? 0 : m_titleEnds[iRecord - 1];
+  return m_titles.substr(start, m_titleEnds[iRecord] - start);
+}
+
+std::vector<std::size_t> SDIndex::FindTitle(const std::string &title) {
+  if (m_titleIndex.empty()) {
+    for (std::size_t i = 0; i < GetNumRecords(); i++) {
+      m_titleIndex[GetTitle(i)].push_back(i);
+    }
+  }
+  auto iter = m_titleIndex.find(title);
+  return (iter != m_titleIndex.end()) ? iter->second
+                                      : std::vector<std::size_t>();
+}
+
+bool SDIndex::Load() {
+  std::string strIndexFile = GetIndexFileName(m_strSDFile);
+  std::ifstream inFile(strIndexFile.c_str(),
+                       std::ios_base::in | std::ios_base::binary);
+  if (!inFile) {
+    return false;
+  }
+  std::string magic(_MAGIC.size(), ' ');
+  std::uint64_t header[4] = {0, 0, 0, 0};
+  inFile.read(&magic[0], magic.size());
+  readValues(inFile, header, 4);
+  if (!inFile || magic != _MAGIC || header[0] != _VERSION ||
+      header[1] != m_fileSize || header[2] != m_fileTime) {
+    LOG_F(WARNING, "Ignoring stale SD file index {}", strIndexFile);
+    return false;
+  }
+  std::uint64_t nRecords = header[3];
+  // The sidecar file must hold the offsets and titles of nRecords records,
+  // which also guards against allocating for a corrupt record count
+  std::uint64_t headerSize = _MAGIC.size() + sizeof(header);
+  std::uint64_t arraysSize = (2 * nRecords + 1) * sizeof(std::uint64_t);
+  inFile.seekg(0, std::ios_base::end);
+  std::uint64_t indexFileSize = inFile.tellg();
+  inFile.seekg(headerSize);
+  if (nRecords > indexFileSize || indexFileSize < headerSize + arraysSize) {
+    LOG_F(WARNING, "Ignoring corrupt SD file index {}", strIndexFile);
+    return false;
+  }
+  m_offsets.resize(nRecords + 1);
+  m_titleEnds.resize(nRecords);
+  readValues(inFile, m_offsets.data(), m_offsets.size());
+  readValues(inFile, m_titleEnds.data(), m_titleEnds.size());
+  std::uint64_t titlesSize = nRecords > 0 ? m_titleEnds.back() : 0;
+  if (!inFile || indexFileSize != headerSize + arraysSize + titlesSize) {
+    LOG_F(WARNING, "Ignoring corrupt SD file index {}", strIndexFile);
+    m_offsets.clear();
+    m_titleEnds.clear();
+    return false;
+  }
+  m_titles.resize(titlesSize);
+  inFile.read(&m_titles[0], titlesSize);
+  if (!inFile) {
+    LOG_F(WARNING, "Ignoring corrupt SD file index {}", strIndexFile);
+    m_offsets.clear();
+    m_titleEnds.clear();
+    m_titles.clear();
+    return false;
+  }
+  LOG_F(1, "Loaded index of {} records from {}", nRecords, strIndexFile);
+  return true;
+}
+
+// Records end after each $$$$ line. The last record may lack one, but
+// trailing whitespace after the last $$$$ line is not a record
+void SDIndex::Build() {
+  InputFileStream inFile(m_strSDFile);
+  if (!inFile) {
+    throw FileReadError(_WHERE_, "Error opening " + m_strSDFile);
+  }
+  m_offsets.clear();
+  m_titleEnds.clear();
+  m_titles.clear();
+  m_titleIndex.clear();
+  std::uint64_t offset = 0;
+  bool bInRecord = false; // True once the title line has been read
+  bool bContent = false;  // True if the record has non-blank lines
+  std::string line;
+  while (std::getline(inFile, line)) {
+    std::uint64_t lineStart = offset;
+    offset += line.size() + (inFile.eof() ? 0 : 1);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!bInRecord) {
+      m_offsets.push_back(lineStart);
+      m_titles += line;
+      m_titleEnds.push_back(m_titles.size());
+      bInRecord = true;
+      bContent = false;
+    }
+    if (line.compare(0, 4, "$$$$") == 0) {
+      bInRecord = false;
+    } else if (line.find_first_not_of(" \t") != std::string::npos) {
+      bContent = true;
+    }
+  }
+  inFile.CheckError();
+  if (bInRecord && !bContent) {
+    offset = m_offsets.back();
+    m_offsets.pop_back();
+    m_titleEnds.pop_back();
+    m_titles.resize(m_titleEnds.empty() ? 0 : m_titleEnds.back());
+  }
+  m_offsets.push_back(offset);
+  LOG_F(INFO, "Indexed {} records of {}", GetNumRecords(), m_strSDFile);
+}
+
+void SDIndex::Save() const {
+  std::string strIndexFile = GetIndexFileName(m_strSDFile);
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = getpid();
+#endif
+  std::string strTmpFile = strIndexFile + ".tmp" + std::to_string(pid);
+  std::ofstream outFile(strTmpFile.c_str(), std::ios_base::out |
+                                                std::ios_base::binary |
+                                                std::ios_base::trunc);
+  std::uint64_t header[4] = {_VERSION, m_fileSize, m_fileTime,
+                             GetNumRecords()};
+  outFile.write(_MAGIC.data(), _MAGIC.size());
+  writeValues(outFile, header, 4);
+  writeValues(outFile, m_offsets.data(), m_offsets.size());
+  writeValues(outFile, m_titleEnds.data(), m_titleEnds.size());
+  outFile.write(m_titles.data(), m_titles.size());
+  outFile.close();
+  // The index is still usable without its sidecar file, e.g. when the SD
+  // file is in a read-only directory
+  if (!outFile) {
+    LOG_F(WARNING, "Could not write SD file index {}", strTmpFile);
+    std::remove(strTmpFile.c_str());
+    return;
+  }
+  if (std::rename(strTmpFile.c_str(), strIndexFile.c_str()) != 0) {
+    LOG_F(WARNING, "Could not rename {} to {}", strTmpFile, strIndexFile);
+    std::remove(strTmpFile.c_str());
+    return;
+  }
+  LOG_F(INFO, "Saved SD file index {}", strIndexFile);
+}
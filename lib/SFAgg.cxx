@@ -12,10 +12,12 @@
 
 #include "rxdock/SFAgg.h"
 #include "rxdock/Model.h"
+#include "rxdock/PoseBatch.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
 
+#include <algorithm>
 #include <functional>
 
 using namespace rxdock;
@@ -189,6 +191,21 @@ void SFAgg::Print(std::ostream &s) const {
   }
 }
 
+// Gradient of an aggregate is the weighted sum of the gradients of its
+// children
+double SFAgg::ScoreGradient(AtomGradientMap &gradient, BaseSFList &noGradList,
+                            double scale) const {
+  if (!isEnabled()) {
+    return 0.0;
+  }
+  double score(0.0);
+  double w = GetWeight();
+  for (BaseSFListConstIter iter = m_sf.begin(); iter != m_sf.end(); iter++) {
+    score += (*iter)->ScoreGradient(gradient, noGradList, scale * w);
+  }
+  return w * score;
+}
+
 ////////////////////////////////////////
 // Private methods
 /////////////////
@@ -201,6 +218,48 @@ double SFAgg::RawScore() const {
   return score;
 }
 
+// Children with their own batched scoring score the whole batch in turn. The
+// others are scored together pose by pose, so that the models are only moved
+// once per pose
+void SFAgg::RawScoreBatch(const PoseBatch &poses, double *out) const {
+  std::size_t nPoses = poses.GetNumPoses();
+  std::fill(out, out + nPoses, 0.0);
+  std::vector<double> childScores(nPoses);
+  BaseSFList unbatched;
+  for (BaseSFListConstIter iter = m_sf.begin(); iter != m_sf.end(); iter++) {
+    if (!(*iter)->isEnabled()) {
+      continue;
+    } else if (!(*iter)->isRawScoreBatched()) {
+      unbatched.push_back(*iter);
+      continue;
+    }
+    (*iter)->RawScoreBatch(poses, childScores.data());
+    double w = (*iter)->GetWeight();
+    for (std::size_t i = 0; i < nPoses; i++) {
+      out[i] += w * childScores[i];
+    }
+  }
+  if (!unbatched.empty()) {
+    for (std::size_t i = 0; i < nPoses; i++) {
+      poses.ApplyPose(i);
+      for (BaseSFListConstIter iter = unbatched.begin();
+           iter != unbatched.end(); iter++) {
+        out[i] += (*iter)->Score();
+      }
+    }
+  }
+}
+
+// True if any child has its own batched scoring
+bool SFAgg::isRawScoreBatched() const {
+  for (BaseSFListConstIter iter = m_sf.begin(); iter != m_sf.end(); iter++) {
+    if ((*iter)->isRawScoreBatched()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void rxdock::to_json(json &j, const SFAgg &sfAgg) {
   json baseSFList;
   for (const auto &aIter : sfAgg.m_sf) {
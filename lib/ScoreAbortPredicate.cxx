@@ -0,0 +1,100 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/ScoreAbortPredicate.h"
+#include "rxdock/BaseSF.h"
+#include "rxdock/BaseTransform.h"
+#include "rxdock/WorkSpace.h"
+
+#include <loguru.hpp>
+
+using namespace rxdock;
+
+const std::string ScoreAbortPredicate::_CT = "ScoreAbortPredicate";
+const std::string ScoreAbortPredicate::_ABORT_THRESHOLD = "abort-threshold";
+const std::string ScoreAbortPredicate::_ABORT_AFTER = "abort-after";
+
+namespace {
+
+const std::string _TRANSFORM = "transform";
+
+} // namespace
+
+ScoreAbortPredicate::ScoreAbortPredicate(ParameterFileSourcePtr spPrmSource) {
+  std::string strOldSection = spPrmSource->GetSection();
+  std::vector<std::string> sectionList = spPrmSource->GetSectionList();
+  for (const auto &section : sectionList) {
+    spPrmSource->SetSection(section);
+    if (!spPrmSource->isParameterPresent(_TRANSFORM)) {
+      continue;
+    }
+    Check check;
+    check.after = 1.0;
+    std::vector<std::string> prmList = spPrmSource->GetParameterList();
+    for (const auto &prm : prmList) {
+      std::vector<std::string> compList =
+          ConvertDelimitedStringToList(prm, "@");
+      if (compList.size() == 2 && compList[0] == _ABORT_THRESHOLD) {
+        check.thresholds.push_back(
+            std::make_pair(compList[1], spPrmSource->GetParameterValue(prm)));
+      } else if (prm == _ABORT_AFTER) {
+        check.after = spPrmSource->GetParameterValue(prm);
+      }
+    }
+    if (!check.thresholds.empty()) {
+      m_checks[section] = check;
+    }
+  }
+  spPrmSource->SetSection(strOldSection);
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
+ScoreAbortPredicate::~ScoreAbortPredicate() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
+
+bool ScoreAbortPredicate::isAbortParameter(const std::string &strParamName) {
+  return strParamName == _ABORT_AFTER ||
+         strParamName.compare(0, _ABORT_THRESHOLD.size() + 1,
+                              _ABORT_THRESHOLD + "@") == 0;
+}
+
+bool ScoreAbortPredicate::isCheckDue(const BaseTransform *pTransform,
+                                     double progress) const {
+  auto iter = m_checks.find(pTransform->GetName());
+  return (iter != m_checks.end()) && (progress >= iter->second.after);
+}
+
+bool ScoreAbortPredicate::Abort(const BaseTransform *pTransform,
+                                WorkSpace *pWorkSpace) {
+  auto iter = m_checks.find(pTransform->GetName());
+  BaseSF *pSF = pWorkSpace->GetSF();
+  if (iter == m_checks.end() || pSF == nullptr) {
+    return false;
+  }
+  StringVariantMap scoreMap;
+  pSF->ScoreMap(scoreMap);
+  for (const auto &threshold : iter->second.thresholds) {
+    StringVariantMapConstIter sIter = scoreMap.find(threshold.first);
+    if (sIter == scoreMap.end()) {
+      throw InvalidRequest(_WHERE_, "Unknown score term " + threshold.first +
+                                        " in abort threshold of " +
+                                        pTransform->GetName());
+    }
+    double score = sIter->second.GetDouble();
+    if (score >= threshold.second) {
+      LOG_F(INFO, "{}: {} = {} is not below abort threshold {}",
+            pTransform->GetName(), threshold.first, score, threshold.second);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,90 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+
+#include "rxdock/ScreeningStage.h"
+#include "rxdock/FileError.h"
+
+#include <fmt/format.h>
+
+using namespace rxdock;
+
+namespace {
+
+const std::string _RUNS = "runs";
+const std::string _TRANSFORM = "transform";
+const std::string _THRESHOLD = "threshold";
+
+} // namespace
+
+ScreeningStageList
+rxdock::ReadScreeningStages(ParameterFileSourcePtr spPrmSource) {
+  ScreeningStageList stages;
+  std::string strOldSection = spPrmSource->GetSection();
+  std::vector<std::string> sectionList = spPrmSource->GetSectionList();
+  for (const auto &section : sectionList) {
+    spPrmSource->SetSection(section);
+    if (!spPrmSource->isParameterPresent(_RUNS) ||
+        spPrmSource->isParameterPresent(_TRANSFORM)) {
+      continue;
+    }
+    ScreeningStage stage;
+    stage.name = section;
+    double runs = spPrmSource->GetParameterValue(_RUNS);
+    if (runs < 1.0) {
+      throw FileParseError(_WHERE_, "Stage " + section + " in " +
+                                        spPrmSource->GetFileName() +
+                                        " must have at least one run");
+    }
+    stage.nRuns = static_cast<std::size_t>(runs);
+    std::vector<std::string> prmList = spPrmSource->GetParameterList();
+    for (const auto &prm : prmList) {
+      std::vector<std::string> compList =
+          ConvertDelimitedStringToList(prm, "@");
+      if (compList.size() == 2 && compList[0] == _THRESHOLD) {
+        stage.thresholds.push_back(
+            std::make_pair(compList[1], spPrmSource->GetParameterValue(prm)));
+      } else if (prm != _RUNS) {
+        throw FileParseError(_WHERE_, "Unknown parameter " + prm +
+                                          " in stage " + section + " in " +
+                                          spPrmSource->GetFileName());
+      }
+    }
+    stages.push_back(stage);
+  }
+  spPrmSource->SetSection(strOldSection);
+  return stages;
+}
+
+std::string
+rxdock::GetScreeningFilterDefinition(const ScreeningStageList &stages) {
+  // Termination filters return 1 to move on to the next stage, 0 to stop and
+  // -1 to continue in this stage. NRUNS counts the runs in the current stage
+  std::string strDefinition = fmt::format("{}\n", stages.size());
+  for (const auto &stage : stages) {
+    std::string strRunsLeft =
+        fmt::format("if - {}score.NRUNS {} 0.0 -1.0", GetMetaDataPrefix(),
+                    stage.nRuns - 1);
+    std::string strFilter;
+    for (const auto &threshold : stage.thresholds) {
+      strFilter += fmt::format("if - {} {} ", threshold.second,
+                               threshold.first);
+    }
+    strFilter += stage.thresholds.empty() ? strRunsLeft : "1.0";
+    for (std::size_t i = 0; i < stage.thresholds.size(); i++) {
+      strFilter += " " + strRunsLeft;
+    }
+    strDefinition += strFilter + ",\n";
+  }
+  strDefinition += "0\n";
+  return strDefinition;
+}
@@ -142,3 +142,10 @@ void SetupPolarSF::SetupScore() {
 }
 
 double SetupPolarSF::RawScore() const { return 0.0; }
+
+// The score is always zero, so the gradient is too
+bool SetupPolarSF::RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                    double scale) const {
+  score = 0.0;
+  return true;
+}
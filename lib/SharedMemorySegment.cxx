@@ -0,0 +1,212 @@
+/***********************************************************************
+ * The rDock program was developed from 1998 - 2006 by the software team
+ * at RiboTargets (subsequently Vernalis (R&D) Ltd).
+ * In 2006, the software was licensed to the University of York for
+ * maintenance and distribution.
+ * In 2012, Vernalis and the University of York agreed to release the
+ * program as Open Source software.
+ * This version is licensed under GNU-LGPL version 3.0 with support from
+ * the University of Barcelona.
+ * http://rdock.sourceforge.net/
+ ***********************************************************************/
+
+#include "rxdock/SharedMemorySegment.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#ifndef _WIN32
+#include <ctime>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <loguru.hpp>
+
+using namespace rxdock;
+
+const std::string SharedMemorySegment::_CT = "SharedMemorySegment";
+
+namespace {
+
+// Segment header, followed by the data. Padded so that the data is 64-byte
+// aligned
+struct SegmentHeader {
+  char magic[8];
+  std::atomic<std::uint32_t> published;
+  std::uint32_t version;
+  std::uint64_t nBytes;
+  char pad[40];
+};
+static_assert(sizeof(SegmentHeader) == 64, "unexpected segment header size");
+
+const char _MAGIC[8] = {'R', 'X', 'S', 'H', 'M', 'E', 'M', '\0'};
+const std::uint32_t _VERSION = 1;
+
+#ifndef _WIN32
+std::string GetShmName(const std::string &strName) { return "/" + strName; }
+
+// Whether an unlocked segment is old enough (one second since it was created
+// or sized) for its creator to be considered dead
+bool IsOrphanAge(const struct stat &fStat) {
+  struct timespec tNow;
+  clock_gettime(CLOCK_REALTIME, &tNow);
+  double dAge = static_cast<double>(tNow.tv_sec - fStat.st_ctim.tv_sec) +
+                1.0e-9 * (tNow.tv_nsec - fStat.st_ctim.tv_nsec);
+  return dAge >= 1.0;
+}
+#endif
+
+} // namespace
+
+SharedMemorySegment::SharedMemorySegment(const std::string &strName, int fd,
+                                         void *pBase, std::size_t nMapped,
+                                         bool bWritable)
+    : m_strName(strName), m_fd(fd), m_pBase(pBase), m_nMapped(nMapped),
+      m_pData(static_cast<char *>(pBase) + sizeof(SegmentHeader)),
+      m_nBytes(nMapped - sizeof(SegmentHeader)), m_bWritable(bWritable) {}
+
+SharedMemorySegment::~SharedMemorySegment() {
+#ifndef _WIN32
+  munmap(m_pBase, m_nMapped);
+  // The exclusive lock is only granted if no other process (or other
+  // attachment in this process) still holds its shared lock
+  if (flock(m_fd, LOCK_EX | LOCK_NB) == 0) {
+    LOG_F(1, "SharedMemorySegment: removing {}", GetShmName(m_strName));
+    shm_unlink(GetShmName(m_strName).c_str());
+  }
+  close(m_fd);
+#endif
+}
+
+SharedMemorySegmentPtr SharedMemorySegment::Create(const std::string &strName,
+                                                   std::size_t nBytes) {
+#ifdef _WIN32
+  LOG_F(WARNING, "Shared memory segments are not supported on Windows");
+  return SharedMemorySegmentPtr();
+#else
+  std::string strShmName = GetShmName(strName);
+  int fd = shm_open(strShmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    LOG_F(1, "SharedMemorySegment::Create: cannot create {}: {}", strShmName,
+          std::strerror(errno));
+    return SharedMemorySegmentPtr();
+  }
+  std::size_t nMapped = sizeof(SegmentHeader) + nBytes;
+  void *pBase = MAP_FAILED;
+  if (flock(fd, LOCK_SH) == 0 && ftruncate(fd, nMapped) == 0) {
+    pBase = mmap(nullptr, nMapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (pBase == MAP_FAILED) {
+    LOG_F(WARNING, "Cannot allocate {} bytes of shared memory for {}: {}",
+          nMapped, strShmName, std::strerror(errno));
+    shm_unlink(strShmName.c_str());
+    close(fd);
+    return SharedMemorySegmentPtr();
+  }
+  SegmentHeader *pHeader = new (pBase) SegmentHeader;
+  std::memcpy(pHeader->magic, _MAGIC, sizeof(_MAGIC));
+  pHeader->version = _VERSION;
+  pHeader->nBytes = nBytes;
+  pHeader->published.store(0, std::memory_order_release);
+  return SharedMemorySegmentPtr(
+      new SharedMemorySegment(strName, fd, pBase, nMapped, true));
+#endif
+}
+
+SharedMemorySegmentPtr SharedMemorySegment::Attach(const std::string &strName,
+                                                   double dTimeout) {
+#ifdef _WIN32
+  return SharedMemorySegmentPtr();
+#else
+  std::string strShmName = GetShmName(strName);
+  auto tStart = std::chrono::steady_clock::now();
+  while (true) {
+    int fd = shm_open(strShmName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      LOG_F(1, "SharedMemorySegment::Attach: {} does not exist", strShmName);
+      return SharedMemorySegmentPtr();
+    }
+    struct stat fStat;
+    void *pBase = MAP_FAILED;
+    std::size_t nMapped = 0;
+    bool bStat = (flock(fd, LOCK_SH) == 0 && fstat(fd, &fStat) == 0);
+    // The creator may not have sized the segment yet
+    if (bStat &&
+        static_cast<std::size_t>(fStat.st_size) >= sizeof(SegmentHeader)) {
+      nMapped = fStat.st_size;
+      pBase = mmap(nullptr, nMapped, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    if (pBase != MAP_FAILED) {
+      const SegmentHeader *pHeader = static_cast<const SegmentHeader *>(pBase);
+      if (pHeader->published.load(std::memory_order_acquire)) {
+        if (std::memcmp(pHeader->magic, _MAGIC, sizeof(_MAGIC)) != 0 ||
+            pHeader->version != _VERSION ||
+            pHeader->nBytes + sizeof(SegmentHeader) != nMapped) {
+          LOG_F(WARNING, "Ignoring incompatible shared memory segment {}",
+                strShmName);
+          munmap(pBase, nMapped);
+          close(fd);
+          return SharedMemorySegmentPtr();
+        }
+        return SharedMemorySegmentPtr(
+            new SharedMemorySegment(strName, fd, pBase, nMapped, false));
+      }
+      munmap(pBase, nMapped);
+    }
+    // A creator holds its shared lock from just after creating the segment
+    // until it detaches, so if nobody else holds a lock on an unpublished
+    // segment, its creator has died before publishing it. Leave young
+    // segments alone, as their creator may not have taken its lock yet
+    if (bStat && IsOrphanAge(fStat) && flock(fd, LOCK_EX | LOCK_NB) == 0) {
+      LOG_F(WARNING, "Removing unpublished shared memory segment {} of a "
+                     "process that has died",
+            strShmName);
+      shm_unlink(strShmName.c_str());
+      close(fd);
+      return SharedMemorySegmentPtr();
+    }
+    close(fd);
+    std::chrono::duration<double> tElapsed =
+        std::chrono::steady_clock::now() - tStart;
+    if (tElapsed.count() >= dTimeout) {
+      // Not worth a warning if we were only probing for the segment
+      if (dTimeout > 0.0) {
+        LOG_F(WARNING,
+              "Shared memory segment {} was not published after {} s; remove "
+              "/dev/shm{} if its creator has died",
+              strShmName, dTimeout, strShmName);
+      }
+      return SharedMemorySegmentPtr();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+#endif
+}
+
+void SharedMemorySegment::Remove(const std::string &strName) {
+#ifndef _WIN32
+  shm_unlink(GetShmName(strName).c_str());
+#endif
+}
+
+void SharedMemorySegment::Publish() {
+  if (!m_bWritable) {
+    return;
+  }
+#ifndef _WIN32
+  // Data stays mapped for this process, but is now read-only like in any
+  // other attached process
+  SegmentHeader *pHeader = static_cast<SegmentHeader *>(m_pBase);
+  pHeader->published.store(1, std::memory_order_release);
+  mprotect(m_pBase, m_nMapped, PROT_READ);
+#endif
+  m_bWritable = false;
+}
@@ -215,6 +215,22 @@ void SimAnnTransform::Execute() {
         m_spStats->InitBlock(pSF->Score());
       }
     }
+    // Give up early on hopeless runs, judged by the best pose so far (and
+    // without partitioning), then carry on from the current pose. The
+    // interaction lists are rebuilt around the restored current pose, not the
+    // best one. The end of the transform is checked by Go()
+    if ((iBlock < nBlocks) &&
+        isAbortCheckDue(static_cast<double>(iBlock) / nBlocks)) {
+      std::vector<double> currentVector;
+      m_chrom->GetVector(currentVector);
+      m_chrom->SetVector(m_minVector);
+      m_chrom->SyncToModel();
+      pSF->HandleRequest(RequestPtr(new SFPartitionRequest(0.0)));
+      CheckAbort();
+      m_chrom->SetVector(currentVector);
+      m_chrom->SyncToModel();
+      pSF->HandleRequest(m_spPartReq);
+    }
   }
   // Update the model coords with the minimum score chromosome
   m_chrom->SetVector(m_minVector);
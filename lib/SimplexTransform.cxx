@@ -111,14 +111,13 @@ void SimplexTransform::Execute() {
 
   m_chrom->SyncFromModel();
   // If we are minimising all degrees of freedom simultaneuously
-  // we have to compile a vector of variable step sizes for the NMSearch
+  // we have to compile a vector of variable step sizes for the simplex
   std::vector<double> sv;
   m_chrom->GetStepVector(sv);
-  int nsv = sv.size();
-  double *steps = new double[nsv];
-  for (int i = 0; i < nsv; ++i) {
-    steps[i] = sv[i] * stepSize;
-  }
+  SimplexCostFunction::ParameterType steps =
+      Eigen::Map<SimplexCostFunction::ParameterType, Eigen::Unaligned>(
+          sv.data(), sv.size()) *
+      stepSize;
 
   SimplexCostFunction costFunction(pSF, m_chrom);
 
@@ -131,7 +130,11 @@ void SimplexTransform::Execute() {
   int calls = 0;
   double initScore = pSF->Score(); // Current score
   double min = initScore;
-  std::vector<double> vc; // Vector representation of chromosome
+  // Vector representation of chromosome, and the simplex start point. Both
+  // keep their storage between cycles
+  std::vector<double> vc;
+  vc.reserve(m_chrom->GetLength());
+  SimplexCostFunction::ParameterType start_point(m_chrom->GetLength());
   // Energy change between cycles - initialise so as not to terminate loop
   // immediately
   double delta = -convergence - 1.0;
@@ -147,20 +150,21 @@ void SimplexTransform::Execute() {
     // Use a variable length simplex
     vc.clear();
     m_chrom->GetVector(vc);
-    SimplexCostFunction::ParameterType start_point =
+    start_point =
         Eigen::Map<SimplexCostFunction::ParameterType, Eigen::Unaligned>(
             vc.data(), vc.size());
 
     optimizer.SetStartPoint(start_point); // Starting parameters
-    optimizer.SetDelta(delta);            // Simplex size
+    optimizer.SetDelta(steps);            // Simplex size
     optimizer.Optimize(costFunction);     // Optimization start
 
     double newmin = optimizer.GetBestValue();
     delta = newmin - min;
     calls += costFunction.nCalls;
-    SimplexCostFunction::ParameterType best = optimizer.GetBestParameters();
-    std::vector<double> best_vec(best.data(), best.data() + best.size());
-    m_chrom->SetVector(best_vec);
+    const SimplexCostFunction::ParameterType &best =
+        optimizer.GetBestParameters();
+    vc.assign(best.data(), best.data() + best.size());
+    m_chrom->SetVector(vc);
 
     LOG_F(INFO, "{:5d}  ALL{:5d}{:10d}{:10f}{:10f}", i, vc.size(), calls,
           newmin, delta);
@@ -170,7 +174,6 @@ void SimplexTransform::Execute() {
   }
   m_chrom->SyncToModel();
   pSF->HandleRequest(spClearPartReq); // Clear any partitioning
-  delete[] steps;
   LOG_F(INFO, "Final    -    -{:10d}{:10f}{:10f}", calls, pSF->Score(),
         pSF->Score() - initScore);
 }
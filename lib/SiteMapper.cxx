@@ -15,6 +15,8 @@
 
 #include <loguru.hpp>
 
+#include <functional>
+
 using namespace rxdock;
 
 // Static data members
@@ -33,6 +35,33 @@ SiteMapper::~SiteMapper() {
   _RBTOBJECTCOUNTER_DESTR_(_CT);
 }
 
+CavityList SiteMapper::operator()() {
+  CoordList coordList;
+  std::vector<double> radiusList;
+  GetReceptorSnapshot(-1, coordList, radiusList);
+  return (*this)(coordList, radiusList);
+}
+
+void SiteMapper::GetReceptorSnapshot(int iCoord, CoordList &coordList,
+                                     std::vector<double> &radiusList) const {
+  coordList.clear();
+  radiusList.clear();
+  if (m_spReceptor.Null()) {
+    return;
+  }
+  // Only include non-H receptor atoms in the mapping
+  AtomList atomList = GetAtomListWithPredicate(m_spReceptor->GetAtomList(),
+                                               std::not1(isAtomicNo_eq(1)));
+  coordList.reserve(atomList.size());
+  radiusList.reserve(atomList.size());
+  for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
+       iter++) {
+    coordList.push_back((iCoord < 0) ? (**iter).GetCoords()
+                                     : (**iter).GetSavedCoords(iCoord));
+    radiusList.push_back((**iter).GetVdwRadius());
+  }
+}
+
 // Override Observer pure virtual
 // Notify observer that subject has changed
 void SiteMapper::Update(Subject *theChangedSubject) {
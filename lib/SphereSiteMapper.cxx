@@ -16,8 +16,6 @@
 #include <fmt/ostream.h>
 #include <loguru.hpp>
 
-#include <functional>
-
 using namespace rxdock;
 
 // Static data member for class type
@@ -52,10 +50,10 @@ SphereSiteMapper::~SphereSiteMapper() {
   _RBTOBJECTCOUNTER_DESTR_(_CT);
 }
 
-CavityList SphereSiteMapper::operator()() {
+CavityList SphereSiteMapper::operator()(const CoordList &coordList,
+                                        const std::vector<double> &radiusList) {
   CavityList cavityList;
-  ModelPtr spReceptor(GetReceptor());
-  if (spReceptor.Null())
+  if (coordList.empty())
     return cavityList;
 
   double rVolIncr = GetParameter(_VOL_INCR);
@@ -78,9 +76,6 @@ CavityList SphereSiteMapper::operator()() {
   // Convert from min volume (in A^3) to min size (number of grid points)
   double minSize = minVol / (step * step * step);
   FFTGridPtr spReceptorGrid;
-  // Only include non-H receptor atoms in the mapping
-  AtomList atomList = GetAtomListWithPredicate(spReceptor->GetAtomList(),
-                                               std::not1(isAtomicNo_eq(1)));
   Vector gridStep(step, step, step);
 
   // We extend the grid by 2*largeR on each side to eliminate edge effects in
@@ -116,10 +111,9 @@ CavityList SphereSiteMapper::operator()() {
   // Iterate over all receptor atoms as we want to include those whose centers
   // are outside the active site, but whose vdw volumes overlap the active site
   // region.
-  for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
-       iter++) {
-    double r = (**iter).GetVdwRadius();
-    spReceptorGrid->SetSphere((**iter).GetCoords(), r + rVolIncr, recVal, true);
+  for (std::size_t i = 0; i < coordList.size(); i++) {
+    spReceptorGrid->SetSphere(coordList[i], radiusList[i] + rVolIncr, recVal,
+                              true);
   }
   LOG_F(INFO, "EXCLUDE RECEPTOR VOLUME");
   LOG_F(INFO, "N(receptor)={}", spReceptorGrid->Count(recVal));
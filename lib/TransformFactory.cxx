@@ -14,6 +14,7 @@
 // Component transforms
 #include "rxdock/AlignTransform.h"
 #include "rxdock/GATransform.h"
+#include "rxdock/LBFGSTransform.h"
 #include "rxdock/NullTransform.h"
 #include "rxdock/RandLigTransform.h"
 #include "rxdock/RandPopTransform.h"
@@ -22,6 +23,7 @@
 
 #include "rxdock/FileError.h"
 #include "rxdock/SFRequest.h"
+#include "rxdock/ScoreAbortPredicate.h"
 
 using namespace rxdock;
 
@@ -56,6 +58,8 @@ BaseTransform *TransformFactory::Create(const std::string &strTransformClass,
     return new RandPopTransform(strName);
   if (strTransformClass == SimplexTransform::_CT)
     return new SimplexTransform(strName);
+  if (strTransformClass == LBFGSTransform::_CT)
+    return new LBFGSTransform(strName);
   // Aggregate transforms
   if (strTransformClass == TransformAgg::_CT)
     return new TransformAgg(strName);
@@ -109,7 +113,10 @@ TransformFactory::CreateAggFromFile(ParameterFileSourcePtr spPrmSource,
         // Only SetParamRequest currently supported
         std::vector<std::string> compList =
             ConvertDelimitedStringToList(*prmIter, "@");
-        if (compList.size() == 2) {
+        // Abort thresholds are read separately by ScoreAbortPredicate
+        if (ScoreAbortPredicate::isAbortParameter(*prmIter)) {
+          continue;
+        } else if (compList.size() == 2) {
           RequestPtr spReq(new SFSetParamRequest(
               compList[1], compList[0],
               spPrmSource->GetParameterValueAsString(*prmIter)));
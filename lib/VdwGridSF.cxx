@@ -12,8 +12,15 @@
 
 #include "rxdock/VdwGridSF.h"
 #include "rxdock/FileError.h"
+#include "rxdock/Hasher.h"
+#include "rxdock/PoseBatch.h"
 #include "rxdock/WorkSpace.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sys/stat.h>
+
 #include <loguru.hpp>
 
 using namespace rxdock;
@@ -22,17 +29,39 @@ using namespace rxdock;
 const std::string VdwGridSF::_CT = "VdwGridSF";
 const std::string VdwGridSF::_GRID = "grid";
 const std::string VdwGridSF::_SMOOTHED = "smoothed";
+const std::string VdwGridSF::_SHARED_MEMORY = "shared-memory";
+
+namespace {
+
+// Shared grid segment layout: uint64 number of grids, followed by one entry
+// per grid, followed by the grid values. Data offsets are relative to the start
+// of the segment data so the layout is position independent.
+struct SharedGridEntry {
+  std::int32_t type;
+  std::int32_t nXYZMin[3];
+  std::uint32_t nXYZ[3];
+  std::uint32_t nPad;
+  double step[3];
+  double tol;
+  std::uint64_t dataOffset;
+};
+
+// How long to wait for another process to finish creating the shared grids
+const double _SHARED_TIMEOUT = 600.0;
+
+} // namespace
 
 const std::string &VdwGridSF::GetCt() { return _CT; }
 
 // NB - Virtual base class constructor (BaseSF) gets called first,
 // implicit constructor for BaseInterSF is called second
 VdwGridSF::VdwGridSF(const std::string &strName)
-    : BaseSF(_CT, strName), m_bSmoothed(true) {
+    : BaseSF(_CT, strName), m_bSmoothed(true), m_bSharedMemory(false) {
   LOG_F(2, "VdwGridSF parameterised constructor");
   // Add parameters
   AddParameter(_GRID, ".grd");
   AddParameter(_SMOOTHED, m_bSmoothed);
+  AddParameter(_SHARED_MEMORY, m_bSharedMemory);
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
@@ -41,19 +70,30 @@ VdwGridSF::~VdwGridSF() {
   _RBTOBJECTCOUNTER_DESTR_(_CT);
 }
 
+std::string VdwGridSF::GetGridFileName(const std::string &strWSName,
+                                       const std::string &strSuffix,
+                                       int iConformer) {
+  if (iConformer > 0) {
+    return strWSName + "_" + std::to_string(iConformer) + strSuffix;
+  }
+  return strWSName + strSuffix;
+}
+
 void VdwGridSF::SetupReceptor() {
   m_grids.clear();
+  m_conformerGrids.clear();
   if (GetReceptor().Null())
     return;
 
-  // Trap multiple receptor conformations and flexible OH/NH3 here: this SF does
-  // not support them yet
+  // Trap flexible OH/NH3 here, and multiple receptor conformations unless
+  // they are sampled: this SF does not support them yet
   bool bEnsemble = (GetReceptor()->GetNumSavedCoords() > 1);
+  bool bSampled = GetReceptor()->isConformerSampled();
   bool bFlexRec = GetReceptor()->isFlexible();
-  if (bEnsemble || bFlexRec) {
-    std::string message("Vdw grid scoring function does not support multiple "
-                        "receptor conformations\n");
-    message += "or flexible OH/NH3 groups yet";
+  if ((bEnsemble && !bSampled) || bFlexRec) {
+    std::string message("Vdw grid scoring function does not support flexible "
+                        "OH/NH3 groups\n");
+    message += "or multiple receptor conformations that are not sampled yet";
     throw InvalidRequest(_WHERE_, message);
   }
 
@@ -62,14 +102,68 @@ void VdwGridSF::SetupReceptor() {
   // Reasonably safe to assume that GetWorkSpace is not nullptr,
   // as otherwise SetupReceptor would not have been called
   std::string strWSName = GetWorkSpace()->GetName();
-
   std::string strSuffix = GetParameter(_GRID);
-  std::string strFile = GetDataFileName("data/grids", strWSName + strSuffix);
+  if (bSampled) {
+    // Each sampled conformer has its own grid file
+    int nCoords = GetReceptor()->GetNumSavedCoords() - 1;
+    for (int i = 1; i <= nCoords; i++) {
+      ReadGridFile(GetDataFileName(
+          "data/grids", GetGridFileName(strWSName, strSuffix, i)));
+      m_conformerGrids.push_back(m_grids);
+    }
+    m_grids.clear();
+  } else {
+    ReadGridFile(
+        GetDataFileName("data/grids", GetGridFileName(strWSName, strSuffix)));
+  }
+}
+
+void VdwGridSF::ReadGridFile(const std::string &strFile) {
+  std::string strSegmentName;
+  if (m_bSharedMemory) {
+    strSegmentName = GetSharedGridsName(strFile);
+    SharedMemorySegmentPtr spSegment =
+        SharedMemorySegment::Attach(strSegmentName);
+    if (spSegment) {
+      ReadSharedGrids(spSegment);
+      return;
+    }
+  }
+
   std::ifstream file(strFile.c_str());
   json vdwGrids;
   file >> vdwGrids;
   file.close();
   ReadGrids(vdwGrids.at("vdw-grids"));
+
+  if (m_bSharedMemory) {
+    // Either we create the segment, or another process beat us to it. In both
+    // cases swap our private grids for the shared ones to free the memory
+    SharedMemorySegmentPtr spSegment = WriteSharedGrids(strSegmentName);
+    if (!spSegment) {
+      spSegment = SharedMemorySegment::Attach(strSegmentName, _SHARED_TIMEOUT);
+    }
+    // The segment was removed because its creator died before publishing it
+    if (!spSegment) {
+      spSegment = WriteSharedGrids(strSegmentName);
+    }
+    if (spSegment) {
+      ReadSharedGrids(spSegment);
+    }
+  }
+}
+
+const RealGridList &VdwGridSF::GetReceptorGrids() const {
+  if (m_conformerGrids.empty()) {
+    return m_grids;
+  }
+  int iConformer = GetReceptor()->GetCurrentCoords();
+  if (iConformer < 1 ||
+      iConformer > static_cast<int>(m_conformerGrids.size())) {
+    throw InvalidRequest(_WHERE_, "No vdW grids for receptor coords #" +
+                                      std::to_string(iConformer));
+  }
+  return m_conformerGrids[iConformer - 1];
 }
 
 void VdwGridSF::SetupLigand() {
@@ -105,7 +199,8 @@ void VdwGridSF::SetupScore() {
   // If so, we can use it if a particular atom type grid is missing
   // If not, then we have to throw an error if a particular atom type grid is
   // missing
-  bool bHasUndefined = !m_grids[TriposAtomType::UNDEFINED].Null();
+  const RealGridList &grids = GetReceptorGrids();
+  bool bHasUndefined = !grids[TriposAtomType::UNDEFINED].Null();
   TriposAtomType triposType;
 
   if (bHasUndefined) {
@@ -122,7 +217,7 @@ void VdwGridSF::SetupScore() {
 
     // If there is no grid for this atom type, revert to using the UNDEFINED
     // grid if available else throw an error
-    if (m_grids[aType].Null()) {
+    if (grids[aType].Null()) {
       std::string strError = "No vdw grid available for " +
                              (*iter)->GetFullAtomName() + " (type " +
                              triposType.Type2Str(aType) + ")";
@@ -143,7 +238,8 @@ double VdwGridSF::RawScore() const {
   double score = 0.0;
 
   // Check grids are defined
-  if (m_grids.empty())
+  const RealGridList &grids = GetReceptorGrids();
+  if (grids.empty())
     return score;
 
   // Loop over all ligand atoms
@@ -151,16 +247,84 @@ double VdwGridSF::RawScore() const {
   TriposAtomTypeListConstIter tIter = m_ligAtomTypes.begin();
   if (m_bSmoothed) {
     for (; aIter != m_ligAtomList.end(); aIter++, tIter++) {
-      score += m_grids[*tIter]->GetSmoothedValue((*aIter)->GetCoords());
+      score += grids[*tIter]->GetSmoothedValue((*aIter)->GetCoords());
     }
   } else {
     for (; aIter != m_ligAtomList.end(); aIter++, tIter++) {
-      score += m_grids[*tIter]->GetValue((*aIter)->GetCoords());
+      score += grids[*tIter]->GetValue((*aIter)->GetCoords());
     }
   }
   return score;
 }
 
+// Each ligand atom looks up its grid once, then scores all of the poses
+void VdwGridSF::RawScoreBatch(const PoseBatch &poses, double *out) const {
+  std::size_t nPoses = poses.GetNumPoses();
+  std::size_t nAtoms = poses.GetNumAtoms();
+  // Ligand atoms that are not in the batch have to be scored pose by pose, as
+  // do the poses of a sampled receptor, which may change conformer
+  for (AtomRListConstIter aIter = m_ligAtomList.begin();
+       aIter != m_ligAtomList.end(); aIter++) {
+    if (poses.GetAtomIndex(*aIter) == nAtoms) {
+      BaseSF::RawScoreBatch(poses, out);
+      return;
+    }
+  }
+  if (!m_conformerGrids.empty()) {
+    const ModelList &modelList = poses.GetModelList();
+    for (ModelListConstIter mIter = modelList.begin();
+         mIter != modelList.end(); mIter++) {
+      if ((*mIter).Ptr() == GetReceptor().Ptr()) {
+        BaseSF::RawScoreBatch(poses, out);
+        return;
+      }
+    }
+  }
+  std::fill(out, out + nPoses, 0.0);
+  const RealGridList &grids = GetReceptorGrids();
+  if (grids.empty())
+    return;
+
+  AtomRListConstIter aIter = m_ligAtomList.begin();
+  TriposAtomTypeListConstIter tIter = m_ligAtomTypes.begin();
+  for (; aIter != m_ligAtomList.end(); aIter++, tIter++) {
+    std::size_t iAtom = poses.GetAtomIndex(*aIter);
+    const double *x = poses.GetX(iAtom);
+    const double *y = poses.GetY(iAtom);
+    const double *z = poses.GetZ(iAtom);
+    const RealGrid *pGrid = grids[*tIter].Ptr();
+    if (m_bSmoothed) {
+      pGrid->AddSmoothedValues(nPoses, x, y, z, out);
+    } else {
+      for (std::size_t i = 0; i < nPoses; i++) {
+        out[i] += pGrid->GetValue(Coord(x[i], y[i], z[i]));
+      }
+    }
+  }
+}
+
+// Analytic gradient is only available for smoothed (interpolated) grids
+bool VdwGridSF::RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                 double scale) const {
+  if (!m_bSmoothed) {
+    return false;
+  }
+  score = 0.0;
+  const RealGridList &grids = GetReceptorGrids();
+  if (grids.empty())
+    return true;
+
+  AtomRListConstIter aIter = m_ligAtomList.begin();
+  TriposAtomTypeListConstIter tIter = m_ligAtomTypes.begin();
+  Vector g;
+  for (; aIter != m_ligAtomList.end(); aIter++, tIter++) {
+    score += grids[*tIter]->GetSmoothedValueGradient((*aIter)->GetCoords(),
+                                                       g);
+    gradient[*aIter] += g * scale;
+  }
+  return true;
+}
+
 // Read grids from input stream, checking that header string matches
 // VdwGridSF
 void VdwGridSF::ReadGrids(json vdwGrids) {
@@ -191,12 +355,107 @@ void VdwGridSF::ReadGrids(json vdwGrids) {
   }
 }
 
+std::string VdwGridSF::GetSharedGridsName(const std::string &strFile) const {
+  // Identify the grid file by name, size and modification time rather than by
+  // contents, so attaching does not require reading the file
+  Hasher hasher;
+  hasher.Add(GetProgramVersion());
+  hasher.Add(strFile);
+  struct stat fStat;
+  if (stat(strFile.c_str(), &fStat) == 0) {
+    hasher.Add(std::to_string(fStat.st_size));
+    hasher.Add(std::to_string(fStat.st_mtime));
+  }
+  return "rxdock-vdw-" + hasher.GetKey();
+}
+
+SharedMemorySegmentPtr
+VdwGridSF::WriteSharedGrids(const std::string &strName) const {
+  std::vector<SharedGridEntry> entries;
+  std::vector<RealGrid *> grids;
+  std::size_t nHeaderBytes = sizeof(std::uint64_t);
+  for (std::size_t i = 0; i < m_grids.size(); i++) {
+    if (!m_grids[i].Null()) {
+      nHeaderBytes += sizeof(SharedGridEntry);
+      grids.push_back(m_grids[i]);
+      SharedGridEntry entry;
+      std::memset(&entry, 0, sizeof(entry));
+      entry.type = i;
+      entries.push_back(entry);
+    }
+  }
+  // Align the grid values to 64 bytes
+  std::size_t nBytes = (nHeaderBytes + 63) & ~std::size_t(63);
+  for (std::size_t i = 0; i < grids.size(); i++) {
+    RealGrid *pGrid = grids[i];
+    SharedGridEntry &entry = entries[i];
+    entry.nXYZMin[0] = pGrid->GetnXMin();
+    entry.nXYZMin[1] = pGrid->GetnYMin();
+    entry.nXYZMin[2] = pGrid->GetnZMin();
+    entry.nXYZ[0] = pGrid->GetNX();
+    entry.nXYZ[1] = pGrid->GetNY();
+    entry.nXYZ[2] = pGrid->GetNZ();
+    entry.nPad = pGrid->GetPad();
+    entry.step[0] = pGrid->GetGridStep().xyz(0);
+    entry.step[1] = pGrid->GetGridStep().xyz(1);
+    entry.step[2] = pGrid->GetGridStep().xyz(2);
+    entry.tol = pGrid->GetTolerance();
+    entry.dataOffset = nBytes;
+    nBytes += ((pGrid->GetN() * sizeof(float) + 63) & ~std::size_t(63));
+  }
+
+  SharedMemorySegmentPtr spSegment =
+      SharedMemorySegment::Create(strName, nBytes);
+  if (!spSegment) {
+    return spSegment;
+  }
+  char *pData = spSegment->GetWritableData();
+  std::uint64_t nGrids = entries.size();
+  std::memcpy(pData, &nGrids, sizeof(nGrids));
+  std::memcpy(pData + sizeof(nGrids), entries.data(),
+              entries.size() * sizeof(SharedGridEntry));
+  for (std::size_t i = 0; i < grids.size(); i++) {
+    std::memcpy(pData + entries[i].dataOffset, grids[i]->GetGridData(),
+                grids[i]->GetN() * sizeof(float));
+  }
+  spSegment->Publish();
+  LOG_F(INFO, "VdwGridSF: shared {} grids ({} bytes) as {}", nGrids, nBytes,
+        strName);
+  return spSegment;
+}
+
+void VdwGridSF::ReadSharedGrids(SharedMemorySegmentPtr spSegment) {
+  const char *pData = spSegment->GetData();
+  std::uint64_t nGrids;
+  std::memcpy(&nGrids, pData, sizeof(nGrids));
+  const SharedGridEntry *pEntries =
+      reinterpret_cast<const SharedGridEntry *>(pData + sizeof(nGrids));
+  LOG_F(INFO, "VdwGridSF: attaching to {} shared grids in {}", nGrids,
+        spSegment->GetName());
+
+  m_grids = RealGridList(TriposAtomType::MAXTYPES);
+  for (std::uint64_t i = 0; i < nGrids; i++) {
+    const SharedGridEntry &entry = pEntries[i];
+    Vector gridStep(entry.step[0], entry.step[1], entry.step[2]);
+    Coord gridMin =
+        Coord(entry.nXYZMin[0], entry.nXYZMin[1], entry.nXYZMin[2]) * gridStep;
+    BaseGrid baseGrid(gridMin, gridStep, entry.nXYZ[0], entry.nXYZ[1],
+                      entry.nXYZ[2], entry.nPad);
+    const float *pValues =
+        reinterpret_cast<const float *>(pData + entry.dataOffset);
+    m_grids[entry.type] =
+        RealGridPtr(new RealGrid(baseGrid, pValues, entry.tol, spSegment));
+  }
+}
+
 // DM 25 Oct 2000 - track changes to parameter values in local data members
 // ParameterUpdated is invoked by ParamHandler::SetParameter
 void VdwGridSF::ParameterUpdated(const std::string &strName) {
   // DM 25 Oct 2000 - heavily used params
   if (strName == _SMOOTHED) {
     m_bSmoothed = GetParameter(_SMOOTHED);
+  } else if (strName == _SHARED_MEMORY) {
+    m_bSharedMemory = GetParameter(_SHARED_MEMORY);
   } else {
     BaseSF::ParameterUpdated(strName);
   }
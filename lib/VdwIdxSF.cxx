@@ -103,6 +103,7 @@ void VdwIdxSF::ScoreMap(StringVariantMap &scoreMap) const {
 
 void VdwIdxSF::SetupReceptor() {
   m_spGrid = NonBondedGridPtr();
+  m_conformerGrids.clear();
   m_recAtomList.clear();
   m_recRigidAtomList.clear();
   m_recFlexAtomList.clear();
@@ -114,26 +115,43 @@ void VdwIdxSF::SetupReceptor() {
   m_bFlexRec = GetReceptor()->isFlexible();
 
   m_recAtomList = GetReceptor()->GetAtomList();
-  m_spGrid = CreateNonBondedGrid();
   double maxError = GetMaxError();
   double flexDist = 2.0;
   DockingSitePtr spDS = GetWorkSpace()->GetDockingSite();
 
   int nCoords = GetReceptor()->GetNumSavedCoords() - 1;
   if (nCoords > 0) {
+    // Sampled conformers get a grid each, so that only the atoms of the
+    // current conformer are scored. Otherwise the union of all conformers is
+    // indexed
+    bool bSampled = GetReceptor()->isConformerSampled();
+    if (!bSampled) {
+      m_spGrid = CreateNonBondedGrid();
+    }
     for (int i = 1; i <= nCoords; i++) {
       LOG_F(1, "VdwIdxSF::SetupReceptor: Indexing receptor coords #{}", i);
-      GetReceptor()->RevertCoords(i);
+      GetReceptor()->SetCurrentConformer(i);
       AtomList atomList =
           spDS->GetAtomList(m_recAtomList, 0.0, GetCorrectedRange());
+      NonBondedGridPtr spGrid = m_spGrid;
+      if (bSampled) {
+        spGrid = CreateNonBondedGrid();
+        m_conformerGrids.push_back(spGrid);
+      }
       for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
            iter++) {
         double range = MaxVdwRange(*iter);
-        m_spGrid->SetAtomLists(*iter, range + maxError);
+        spGrid->SetAtomLists(*iter, range + maxError);
+      }
+      if (!bSampled) {
+        m_spGrid->UniqueAtomLists();
       }
-      m_spGrid->UniqueAtomLists();
     }
   } else {
+    if (LoadReceptorSetup(GetReceptor())) {
+      return;
+    }
+    m_spGrid = CreateNonBondedGrid();
     AtomList atomList =
         spDS->GetAtomList(m_recAtomList, 0.0, GetCorrectedRange());
     std::copy(atomList.begin(), atomList.end(),
@@ -185,7 +203,62 @@ void VdwIdxSF::SetupReceptor() {
       double range = MaxVdwRange(*iter);
       m_spGrid->SetAtomLists(*iter, range + maxError);
     }
+    SaveReceptorSetup(GetReceptor());
+  }
+}
+
+void VdwIdxSF::WriteReceptorSetup(CacheEntryWriter &writer) const {
+  CacheIndexMap<Atom> atomIndex =
+      CreateCacheIndexMap(GetReceptorAtomTable(GetReceptor()));
+  writer.PutIndices(m_recRigidAtomList, atomIndex);
+  writer.PutIndices(m_recFlexAtomList, atomIndex);
+  writer.PutIndexLists(m_recFlexIntns, atomIndex);
+  writer.PutIndexLists(m_recFlexPrtIntns, atomIndex);
+  writer.PutIndexLists(
+      m_spGrid->GetN(),
+      [this](std::size_t i) -> const AtomRList & {
+        return m_spGrid->GetAtomList(i);
+      },
+      atomIndex);
+}
+
+void VdwIdxSF::ReadReceptorSetup(CacheEntryReader &reader) {
+  AtomRList atomTable = GetReceptorAtomTable(GetReceptor());
+  std::size_t nAtoms = atomTable.size();
+  std::size_t nIntns = m_bFlexRec ? nAtoms : 0;
+  NonBondedGridPtr spGrid = CreateNonBondedGrid();
+  std::vector<std::uint32_t> rigidAtoms = reader.GetIndices(nAtoms);
+  std::vector<std::uint32_t> flexAtoms = reader.GetIndices(nAtoms);
+  std::vector<std::vector<std::uint32_t>> flexIntns =
+      reader.GetIndexLists(nIntns, nAtoms);
+  std::vector<std::vector<std::uint32_t>> flexPrtIntns =
+      reader.GetIndexLists(nIntns, nAtoms);
+  std::vector<std::vector<std::uint32_t>> cells =
+      reader.GetIndexLists(spGrid->GetN(), nAtoms);
+
+  m_spGrid = spGrid;
+  m_recRigidAtomList = GetCachedPointers(rigidAtoms, atomTable);
+  m_recFlexAtomList = GetCachedPointers(flexAtoms, atomTable);
+  for (std::size_t i = 0; i < nIntns; i++) {
+    m_recFlexIntns.push_back(GetCachedPointers(flexIntns[i], atomTable));
+    m_recFlexPrtIntns.push_back(GetCachedPointers(flexPrtIntns[i], atomTable));
+  }
+  for (std::size_t i = 0; i < cells.size(); i++) {
+    m_spGrid->SetAtomList(i, GetCachedPointers(cells[i], atomTable));
+  }
+}
+
+const NonBondedGrid *VdwIdxSF::GetReceptorGrid() const {
+  if (m_conformerGrids.empty()) {
+    return m_spGrid.Ptr();
+  }
+  int iConformer = GetReceptor()->GetCurrentCoords();
+  if (iConformer < 1 ||
+      iConformer > static_cast<int>(m_conformerGrids.size())) {
+    throw InvalidRequest(_WHERE_, "No indexing grid for receptor coords #" +
+                                      std::to_string(iConformer));
   }
+  return m_conformerGrids[iConformer - 1].Ptr();
 }
 
 void VdwIdxSF::SetupLigand() {
@@ -320,6 +393,32 @@ double VdwIdxSF::RawScore() const {
          SolventScore() + ReceptorSolventScore();
 }
 
+// Analytic gradient is implemented for the receptor-ligand and
+// intra-receptor terms only, i.e. not in the presence of explicit solvent
+bool VdwIdxSF::RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                double scale) const {
+  if (!m_solventAtomList.empty()) {
+    return false;
+  }
+  score = 0.0;
+  const NonBondedGrid *pGrid = GetReceptorGrid();
+  if (pGrid != nullptr) {
+    for (AtomRListConstIter iter = m_ligAtomList.begin();
+         iter != m_ligAtomList.end(); iter++) {
+      const AtomRList &recepAtomList = pGrid->GetAtomList((*iter)->GetCoords());
+      score += VdwScoreGradient(*iter, recepAtomList, gradient, scale);
+    }
+  }
+  if (m_bFlexRec) {
+    for (AtomRListConstIter iter = m_recFlexAtomList.begin();
+         iter != m_recFlexAtomList.end(); iter++) {
+      int id = (*iter)->GetAtomId() - 1;
+      score += VdwScoreGradient(*iter, m_recFlexPrtIntns[id], gradient, scale);
+    }
+  }
+  return true;
+}
+
 // DM 25 Oct 2000 - track changes to parameter values in local data members
 // ParameterUpdated is invoked by ParamHandler::SetParameter
 void VdwIdxSF::ParameterUpdated(const std::string &strName) {
@@ -436,14 +535,15 @@ double VdwIdxSF::InterScore() const {
   m_nRep = 0;
 
   // Check grid is defined
-  if (m_spGrid.Null())
+  const NonBondedGrid *pGrid = GetReceptorGrid();
+  if (pGrid == nullptr)
     return score;
 
   // Loop over all ligand atoms
   for (AtomRListConstIter iter = m_ligAtomList.begin();
        iter != m_ligAtomList.end(); iter++) {
     const Coord &c = (*iter)->GetCoords();
-    const AtomRList &recepAtomList = m_spGrid->GetAtomList(c);
+    const AtomRList &recepAtomList = pGrid->GetAtomList(c);
     double s = VdwScore(*iter, recepAtomList);
     score += s;
     if (s > m_repThreshold) {
@@ -505,14 +605,15 @@ double VdwIdxSF::SolventScore() const {
 // Receptor-solvent
 double VdwIdxSF::ReceptorSolventScore() const {
   double score = 0.0;
-  if (m_spGrid.Null())
+  const NonBondedGrid *pGrid = GetReceptorGrid();
+  if (pGrid == nullptr)
     return score;
   for (AtomRListConstIter iter = m_solventAtomList.begin();
        iter != m_solventAtomList.end(); iter++) {
     // DM 7 June 2006 - take into account the enabled state of each solvent atom
     if ((*iter)->GetEnabled()) {
       const Coord &c = (*iter)->GetCoords();
-      const AtomRList &recepAtomList = m_spGrid->GetAtomList(c);
+      const AtomRList &recepAtomList = pGrid->GetAtomList(c);
       // XB changed call from "VdwScore" to "VdwScoreIntra" and created new
       // function
       // in "VdwSF.cxx" to avoid using reweighting terms for intra
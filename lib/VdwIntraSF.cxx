@@ -110,6 +110,17 @@ double VdwIntraSF::RawScore() const {
   return score;
 }
 
+bool VdwIntraSF::RawScoreGradient(double &score, AtomGradientMap &gradient,
+                                  double scale) const {
+  score = 0.0;
+  for (AtomRListConstIter iter = m_ligAtomList.begin();
+       iter != m_ligAtomList.end(); iter++) {
+    int id = (*iter)->GetAtomId() - 1;
+    score += VdwScoreGradient(*iter, m_prtIntns[id], gradient, scale);
+  }
+  return true;
+}
+
 // DM 25 Oct 2000 - track changes to parameter values in local data members
 // ParameterUpdated is invoked by ParamHandler::SetParameter
 void VdwIntraSF::ParameterUpdated(const std::string &strName) {
@@ -220,6 +220,38 @@ double VdwSF::VdwScoreEnabledOnly(const Atom *pAtom,
   return score;
 }
 
+double VdwSF::VdwScoreGradient(const Atom *pAtom, const AtomRList &atomList,
+                               AtomGradientMap &gradient,
+                               double scale) const {
+  double score = 0.0;
+  if (atomList.empty()) {
+    return score;
+  }
+
+  const Coord &c1 = pAtom->GetCoords();
+  TriposAtomType::eType type1 = pAtom->GetTriposType();
+  VdwTableConstIter iter1 = m_vdwTable.begin() + type1;
+  Vector g1(0.0, 0.0, 0.0);
+  for (AtomRListConstIter iter = atomList.begin(); iter != atomList.end();
+       iter++) {
+    const Coord &c2 = (*iter)->GetCoords();
+    Vector r12 = c1 - c2;
+    double R_sq = r12.xyz.squaredNorm(); // Distance squared
+    TriposAtomType::eType type2 = (*iter)->GetTriposType();
+    VdwRowConstIter iter2 = (*iter1).begin() + type2;
+    double dS;
+    score += m_use_4_8 ? df4_8(R_sq, *iter2, dS) : df6_12(R_sq, *iter2, dS);
+    if (dS != 0.0) {
+      // d(R_sq)/d(c1) = 2 * (c1 - c2)
+      Vector g = r12 * (2.0 * scale * dS);
+      g1 += g;
+      gradient[*iter] -= g;
+    }
+  }
+  gradient[pAtom] += g1;
+  return score;
+}
+
 // XB This is the old  VdwScore, without reweighting factors
 // Double VdwSF::VdwScoreIntra(const Atom* pAtom, const AtomRList&
 // atomList) const {
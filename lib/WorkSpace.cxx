@@ -27,7 +27,8 @@ const std::string WorkSpace::_NAME = "NAME";
 
 // Create an empty model container of the right size
 WorkSpace::WorkSpace(unsigned int nModels)
-    : m_models(nModels), m_SF(nullptr), m_transform(nullptr) {
+    : m_models(nModels), m_SF(nullptr), m_transform(nullptr),
+      m_pReceptorCache(nullptr) {
   AddParameter(_NAME, _CT);
   LOG_F(2, "WorkSpace parametrised constructor");
   LOG_F(1, "Created model list of size {}", m_models.size());
@@ -201,3 +202,27 @@ void WorkSpace::SetFilter(FilterPtr spFilter) {
     m_spFilter->Register(this);
   }
 }
+
+// Abort predicate handling
+BaseAbortPredicate *WorkSpace::GetAbortPredicate() {
+  return m_spAbortPredicate.Ptr();
+}
+
+void WorkSpace::SetAbortPredicate(AbortPredicatePtr spAbortPredicate) {
+  m_spAbortPredicate = spAbortPredicate;
+}
+
+// Receptor cache handling
+const ModelCache *WorkSpace::GetReceptorCache() const {
+  return m_pReceptorCache;
+}
+
+std::string WorkSpace::GetReceptorCacheKey() const {
+  return m_strReceptorCacheKey;
+}
+
+void WorkSpace::SetReceptorCache(const ModelCache *pCache,
+                                 const std::string &strReceptorKey) {
+  m_pReceptorCache = pCache;
+  m_strReceptorCacheKey = strReceptorKey;
+}
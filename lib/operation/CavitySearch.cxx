@@ -26,6 +26,8 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <exception>
+
 static const std::string _MAPPER = "mapper";
 
 int rxdock::operation::cavitySearch(std::string strReceptorPrmFile,
@@ -54,16 +56,11 @@ int rxdock::operation::cavitySearch(std::string strReceptorPrmFile,
 
     DockingSitePtr spDockSite;
     std::string strDockingSiteFile = wsName + "-docking-site.json";
+    std::string strDockingSiteBinFile = wsName + "-docking-site.bin";
 
-    // Either read the docking site from the .as file
+    // Either read the docking site from the docking site file
     if (readDockingSite) {
-      std::string strInputFile =
-          GetDataFileName("data/grids", strDockingSiteFile);
-      std::ifstream inputFile(strInputFile.c_str());
-      json siteData;
-      inputFile >> siteData;
-      inputFile.close();
-      spDockSite = DockingSitePtr(new DockingSite(siteData.at("docking-site")));
+      spDockSite = ReadDockingSite(GetDockingSiteFileName(wsName));
     }
     // Or map the site using the prescribed mapping algorithm
     else {
@@ -78,11 +75,36 @@ int rxdock::operation::cavitySearch(std::string strReceptorPrmFile,
       if (nRI == 0) {
         spDockSite = DockingSitePtr(new DockingSite((*spMapper)(), border));
       } else {
+        // Take a coord snapshot of each receptor conformation up front; the
+        // atoms (and their reference counts) are shared by all conformations,
+        // so only the snapshots are handed to the concurrent mapping below
+        std::vector<CoordList> coordLists(nRI);
+        std::vector<std::vector<double>> radiusLists(nRI);
+        for (int i = 0; i < nRI; i++) {
+          spMapper->GetReceptorSnapshot(i + 1, coordLists[i], radiusLists[i]);
+        }
+        std::vector<CavityList> cavLists(nRI);
+        std::exception_ptr mapperError;
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < nRI; i++) {
+          try {
+            cavLists[i] = (*spMapper)(coordLists[i], radiusLists[i]);
+          } catch (...) {
+#pragma omp critical(rxdock_cavity_search_error)
+            if (!mapperError) {
+              mapperError = std::current_exception();
+            }
+          }
+        }
+        if (mapperError) {
+          std::rethrow_exception(mapperError);
+        }
+        // Merge in conformation order so the result does not depend on the
+        // thread scheduling
         CavityList allCavs;
-        for (int i = 1; i <= nRI; i++) {
-          spReceptor->RevertCoords(i);
-          CavityList cavs((*spMapper)());
-          std::copy(cavs.begin(), cavs.end(), std::back_inserter(allCavs));
+        for (int i = 0; i < nRI; i++) {
+          std::copy(cavLists[i].begin(), cavLists[i].end(),
+                    std::back_inserter(allCavs));
         }
         spDockSite = DockingSitePtr(new DockingSite(allCavs, border));
       }
@@ -96,6 +118,15 @@ int rxdock::operation::cavitySearch(std::string strReceptorPrmFile,
       dockingSite["docking-site"] = *spDockSite;
       ostr << dockingSite;
       ostr.close();
+      // The binary file includes the distance grid in a form which the
+      // docking runs can map into memory without any parsing. It records
+      // the JSON file it was written with, so that edits to the JSON file
+      // are not hidden by the binary file
+      std::ofstream binOstr(strDockingSiteBinFile.c_str(),
+                            std::ios_base::out | std::ios_base::binary |
+                                std::ios_base::trunc);
+      spDockSite->WriteBinary(binOstr, strDockingSiteFile);
+      binOstr.close();
     }
 
     // writing active site into MOE grid
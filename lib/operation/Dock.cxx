@@ -23,16 +23,23 @@
 #include "rxdock/LigandError.h"
 #include "rxdock/MdlFileSink.h"
 #include "rxdock/MdlFileSource.h"
+#include "rxdock/ModelCache.h"
 #include "rxdock/PRMFactory.h"
 #include "rxdock/ParameterFileSource.h"
+#include "rxdock/PoseClusterer.h"
+#include "rxdock/ResultsTableSink.h"
 #include "rxdock/SFFactory.h"
+#include "rxdock/ScoreAbortPredicate.h"
+#include "rxdock/ScreeningStage.h"
 #include "rxdock/TransformFactory.h"
 
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
 
 namespace rxdock {
 namespace operation {
@@ -41,328 +48,634 @@ static const std::string _ROOT_SF = "rxdock.score";
 static const std::string _RESTRAINT_SF = "restr";
 static const std::string _ROOT_TRANSFORM = "dock";
 
+namespace {
+
+// A receptor to dock against, with its own workspace, scoring function,
+// docking site, filter and output. Each ligand is read and prepared once and
+// then docked against every target in turn.
+struct DockingTarget {
+  std::string strName; // Receptor name used in per-receptor output file names
+  ParameterFileSourcePtr spRecepPrmSource;
+  BiMolWorkSpacePtr spWS;
+  SFAggPtr spSF;
+  TransformAggPtr spTransform;
+  DockingSitePtr spDS;
+  std::unique_ptr<PRMFactory> spPrmFactory;
+  ModelPtr spReceptor;
+  Variant vRecep;
+  MolecularFileSinkPtr spMdlFileSink;
+  std::unique_ptr<ResultsTableSink> spResultsTable;
+  std::string strOutputTableFile;
+  std::string strOutputHistoryFilePrefix;
+  std::string strOutputCrdFile;
+  FilterPtr spFilter;
+  // Per-stage statistics: number of ligands entering each stage (the last
+  // entry counts the ligands passing all stages) and of runs in each stage
+  std::vector<std::size_t> stageLigands;
+  std::vector<std::size_t> stageRuns;
+};
+
+// Inserts _<name> before the extension of fileName (e.g. out.sd.gz becomes
+// out_<name>.sd.gz), so that each target of a multi-receptor run writes its
+// own output
+std::string GetTargetFileName(const std::string &fileName,
+                              const std::string &name) {
+  std::string::size_type iDir = fileName.find_last_of('/');
+  std::string::size_type iExt =
+      fileName.find('.', (iDir == std::string::npos) ? 0 : iDir + 1);
+  if (iExt == std::string::npos) {
+    return fileName + "_" + name;
+  }
+  return fileName.substr(0, iExt) + "_" + name + fileName.substr(iExt);
+}
+
+// Docks the ligand of the current record against one target. recordData holds
+// the data fields of the record as read from strLigandMdlFile. Returns false if
+// the ligand was given up after too many docking errors.
+bool DockLigand(DockingTarget &target, ModelPtr spLigand,
+                const StringVariantMap &recordData,
+                const std::string &strLigandMdlFile, const Variant &vLib,
+                const Variant &vPrm, const Variant &vDir, std::size_t nRecord,
+                bool bOutputHistory, std::size_t nDockingRuns,
+                std::size_t nConvergedRuns, PoseClusterer &clusterer) {
+  BiMolWorkSpacePtr spWS = target.spWS;
+  SFAggPtr spSF = target.spSF;
+  FilterPtr spfilter = target.spFilter;
+  std::size_t nStages = target.stageRuns.size();
+  std::string strMolName = spLigand->GetName();
+  spWS->SetLigand(spLigand);
+  // Update any model coords from embedded chromosomes in the ligand file
+  spWS->UpdateModelCoordsFromChromRecords(recordData, strLigandMdlFile);
+
+  // DM 18 May 1999 - store run info in model data
+  // Clear any previous rxdock.program.* data fields
+  spLigand->ClearAllDataFields(GetMetaDataPrefix() + "program.");
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.library", vLib);
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.receptor",
+                         target.vRecep);
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.parameter_file", vPrm);
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.current_directory",
+                         vDir);
+  spLigand->ClearAllDataFields(GetMetaDataPrefix() + "cluster.");
+  clusterer.SetAtoms(spLigand->GetAtomList());
+
+  // DM 10 Dec 1999 - if in target mode, loop until target score is
+  // reached
+  bool bTargetMet = false;
+  bool bLigandOK = true;
+
+  ////////////////////////////////////////////////////
+  // MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
+  // Create a history file sink, just in case it's needed by any
+  // of the transforms
+  std::size_t iRun = 0;
+  std::size_t nErrors = 0;
+  std::size_t nAbandoned = 0;
+  // need to check this here. The termination
+  // filter is only run once at least
+  // one docking run has been done.
+  if (nDockingRuns < 1)
+    bTargetMet = true;
+  while (!bTargetMet) {
+    // Catching errors with this specific run
+    if (nErrors > 10) {
+      fmt::print("Target not met, but giving up on ligand after {} errors",
+                 nErrors);
+      bLigandOK = false;
+      break;
+    }
+    try {
+      if (bOutputHistory) {
+        std::ostringstream histr;
+        histr << target.strOutputHistoryFilePrefix << "_" << strMolName
+              << nRecord << "_his_" << iRun + 1 << ".sd";
+        MolecularFileSinkPtr spHistoryFileSink(
+            new MdlFileSink(histr.str(), spLigand));
+        spWS->SetHistorySink(spHistoryFileSink);
+      }
+      bool bAbandoned = false;
+      try {
+        spWS->Run(); // Dock!
+      } catch (DockingAbort &e) {
+        fmt::print("{}\n", e.what());
+        bAbandoned = true;
+        nAbandoned++;
+      }
+      std::size_t iStage = spfilter->GetTermFilterIndex();
+      if (iStage < nStages) {
+        target.stageRuns[iStage]++;
+      }
+      // Abandoned runs still count towards the number of runs, but
+      // their poses are neither clustered nor written
+      bool bwrite = false;
+      if (!bAbandoned && nConvergedRuns > 0) {
+        // Cluster the pose before any output, so that the cluster data
+        // fields are written with it. The total score is taken from the
+        // score map so that it matches the output score. Poses are only
+        // clustered when checking for convergence, so that the default
+        // output is unchanged
+        StringVariantMap scoreMap;
+        spSF->ScoreMap(scoreMap);
+        std::size_t iCluster =
+            clusterer.AddPose(scoreMap[spSF->GetFullName()].GetDouble());
+        spLigand->SetDataValue(GetMetaDataPrefix() + "cluster.id",
+                               static_cast<int>(iCluster + 1));
+        spLigand->SetDataValue(
+            GetMetaDataPrefix() + "cluster.size",
+            static_cast<int>(clusterer.GetClusterSize(iCluster)));
+        spLigand->SetDataValue(GetMetaDataPrefix() + "cluster.count",
+                               static_cast<int>(clusterer.GetNumClusters()));
+      }
+      bool bterm = spfilter->Terminate();
+      if (!bAbandoned) {
+        bwrite = spfilter->Write();
+      }
+      if (bterm)
+        bTargetMet = true;
+      if (nConvergedRuns > 0 &&
+          clusterer.GetNumConverged() >= nConvergedRuns) {
+        fmt::print("Converged after {} runs\n", iRun + 1);
+        bTargetMet = true;
+      }
+      if (bwrite) {
+        std::size_t recordOffset = target.spMdlFileSink->GetWriteOffset();
+        spWS->Save();
+        ResultsTableSink *pResultsTable = target.spResultsTable.get();
+        if (pResultsTable) {
+          pResultsTable->SetInt("ligand", nRecord);
+          pResultsTable->SetString("name", spLigand->GetName());
+          pResultsTable->SetInt("run", iRun + 1);
+          pResultsTable->SetInt("offset", recordOffset);
+          // The score terms saved with the pose
+          std::string strSFName = spSF->GetFullName();
+          StringVariantMap dataMap = spLigand->GetDataMap();
+          for (const auto &field : dataMap) {
+            if (field.first.compare(0, strSFName.size(), strSFName) == 0) {
+              pResultsTable->SetDouble(field.first, field.second.GetDouble());
+            }
+          }
+          pResultsTable->EndRow();
+        }
+      }
+      iRun++;
+    } catch (DockingError &e) {
+      fmt::print("{}\n", e.what());
+      nErrors++;
+    }
+  }
+  // END OF MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
+  ////////////////////////////////////////////////////
+
+  // here we use iRun since it got incremented in the last iteration to
+  // the number of runs done
+  fmt::print("Numer of docking runs done:   {} ({} errors, {} abandoned)\n",
+             iRun, nErrors, nAbandoned);
+  if (iRun > 0) {
+    std::size_t iLastStage = spfilter->GetTermFilterIndex();
+    for (std::size_t i = 0; i <= iLastStage && i <= nStages; i++) {
+      target.stageLigands[i]++;
+    }
+  }
+  if (clusterer.GetNumPoses() > 0) {
+    std::size_t iBest = clusterer.GetBestCluster();
+    fmt::print("Number of pose clusters:      {} (best cluster #{} has "
+               "{} pose(s), score {})\n",
+               clusterer.GetNumClusters(), iBest + 1,
+               clusterer.GetClusterSize(iBest),
+               clusterer.GetClusterScore(iBest));
+  }
+  return bLigandOK;
+}
+
+} // namespace
+
 } // namespace operation
 } // namespace rxdock
 
-int rxdock::operation::dock(
-    std::string strLigandMdlFile, std::string strOutputMdlFile, bool bOutputCrd,
-    std::string strOutputCrdFile, bool bOutputHistory,
-    std::string strOutputHistoryFilePrefix, std::string strReceptorPrmFile,
-    std::string strParamFile, bool bFilter, std::string strFilterFile,
-    bool bDockingRuns, std::size_t nDockingRuns, bool bPosIonise,
-    bool bNegIonise, bool bExplH, bool bTarget, double dTargetScore,
-    bool bContinue, bool bSeed, std::size_t nSeed) {
+int rxdock::operation::dock(const DockOptions &options) {
   try {
-    // Create a bimolecular workspace
-    BiMolWorkSpacePtr spWS(new BiMolWorkSpace());
-    // Set the workspace name to the root of the receptor .prm filename
-    std::vector<std::string> componentList =
-        ConvertDelimitedStringToList(strReceptorPrmFile, ".");
-    std::string wsName = componentList.front();
-    spWS->SetName(wsName);
+    if (options.receptorPrmFiles.empty()) {
+      throw BadArgument(_WHERE_, "No receptor parameter file given");
+    }
+    bool bMultiTarget = options.receptorPrmFiles.size() > 1;
 
     // Read the docking protocol parameter file
     ParameterFileSourcePtr spParamSource(
-        new ParameterFileSource(GetDataFileName("data/scripts", strParamFile)));
-    // Read the receptor parameter file
-    ParameterFileSourcePtr spRecepPrmSource(new ParameterFileSource(
-        GetDataFileName("data/receptors", strReceptorPrmFile)));
+        new ParameterFileSource(
+            GetDataFileName("data/scripts", options.strParamFile)));
     fmt::print("Docking protocol: {} {}\n", spParamSource->GetFileName(),
                spParamSource->GetTitle());
-    fmt::print("Receptor: {} {}\n", spRecepPrmSource->GetFileName(),
-               spRecepPrmSource->GetTitle());
-
-    // Create the scoring function from the rxdock.score section of the docking
-    // protocol prm file Format is: SECTION rxdock.score
-    //    inter    InterSF.prm
-    //    intra IntraSF.prm
-    // END_SECTION
-    //
-    // Notes:
-    // Section name must be rxdock.score. This is also the name of the root SF
-    // aggregate An aggregate is created for each parameter in the section.
-    // Parameter name becomes the name of the subaggregate (e.g.
-    // rxdock.score.inter) Parameter value is the file name for the subaggregate
-    // definition Default directory is $RBT_ROOT/data/sf
-    SFFactoryPtr spSFFactory(
-        new SFFactory());               // Factory class for scoring functions
-    SFAggPtr spSF(new SFAgg(_ROOT_SF)); // Root SF aggregate
-    spParamSource->SetSection(_ROOT_SF);
-    std::vector<std::string> sfList(spParamSource->GetParameterList());
-    // Loop over all parameters in the rxdock.score section
-    for (std::vector<std::string>::const_iterator sfIter = sfList.begin();
-         sfIter != sfList.end(); sfIter++) {
-      // sfFile = file name for scoring function subaggregate
-      std::string sfFile(GetDataFileName(
-          "data/sf", spParamSource->GetParameterValueAsString(*sfIter)));
-      ParameterFileSourcePtr spSFSource(new ParameterFileSource(sfFile));
-      // Create and add the subaggregate
-      spSF->Add(spSFFactory->CreateAggFromFile(spSFSource, *sfIter));
-    }
-
-    // Add the RESTRAINT subaggregate scoring function from any SF definitions
-    // in the receptor prm file
-    spSF->Add(spSFFactory->CreateAggFromFile(spRecepPrmSource, _RESTRAINT_SF));
-
-    // Create the docking transform aggregate from the transform definitions in
-    // the docking prm file
-    TransformFactoryPtr spTransformFactory(new TransformFactory());
-    spParamSource->SetSection();
-    TransformAggPtr spTransform(
-        spTransformFactory->CreateAggFromFile(spParamSource, _ROOT_TRANSFORM));
-
-    // Print the scoring function and the transform details
-    fmt::print("Scoring function details: {}\n", *spSF);
-    fmt::print("Search details: {}\n", *spTransform);
-
-    // Register the scoring function and the transform with the workspace
-    spWS->SetSF(spSF);
-    spWS->SetTransform(spTransform);
 
     // DM 18 May 1999
     // Variants describing the library version, parameter file, and current
     // directory will be stored in the ligand SD files
     Variant vLib(GetProduct() + "/" + GetProgramVersion());
-    Variant vRecep(spRecepPrmSource->GetFileName());
     Variant vPrm(spParamSource->GetFileName());
     Variant vDir(GetCurrentWorkingDirectory());
 
-    spRecepPrmSource->SetSection();
-    // Read docking site from file and register with workspace
-    std::string strDockingSiteFile = spWS->GetName() + "-docking-site.json";
-    std::string strInputFile =
-        GetDataFileName("data/grids", strDockingSiteFile);
-    // DM 14 June 2006 - bug fix to one of the longest standing rDock issues
-    //(the cryptic "Error reading from input stream" message, if cavity file was
-    // missing)
-    // std::string message = "Cavity file (" + strDockingSiteFile +
-    //                       ") not found in current directory or $RBT_HOME";
-    // message += " - run rbcavity first";
-    // throw FileReadError(_WHERE_, message);
-    std::ifstream inputFile(strInputFile.c_str());
-    json siteData;
-    inputFile >> siteData;
-    inputFile.close();
-    DockingSitePtr spDS(new DockingSite(siteData.at("docking-site")));
-    spWS->SetDockingSite(spDS);
-    fmt::print("Docking site: {}\n", *spDS);
-
-    // Prepare the SD file sink for saving the docked conformations for each
-    // ligand DM 3 Dec 1999 - replaced ostrstream with String in determining
-    // SD file name SRC 2014 moved here this block to allow WRITE_ERROR TRUE
-    MolecularFileSinkPtr spMdlFileSink(
-        new MdlFileSink(strOutputMdlFile, ModelPtr()));
-    spWS->SetSink(spMdlFileSink);
-
-    PRMFactory prmFactory(spRecepPrmSource, spDS);
-    // Create the receptor model from the file names in the receptor parameter
-    // file
-    ModelPtr spReceptor = prmFactory.CreateReceptor();
-    spWS->SetReceptor(spReceptor);
-
-    // Register any solvent
-    ModelList solventList = prmFactory.CreateSolvent();
-    spWS->SetSolvent(solventList);
-    if (spWS->hasSolvent()) {
-      int nSolvent = spWS->GetSolvent().size();
-      fmt::print("{} solvent molecules registered\n", nSolvent);
-    } else {
-      fmt::print("No solvent registered\n");
+    // Optionally reuse prepared receptors from a previous run
+    std::unique_ptr<ModelCache> spReceptorCache;
+    if (options.bReceptorCache) {
+      spReceptorCache.reset(new ModelCache(options.strReceptorCacheDir));
+    }
+    // Optionally reuse prepared ligands, keyed by the contents of their records
+    std::unique_ptr<ModelCache> spLigandCache;
+    if (options.bLigandCache) {
+      spLigandCache.reset(new ModelCache(options.strLigandCacheDir));
+    }
+
+    std::vector<DockingTarget> targets(options.receptorPrmFiles.size());
+    for (std::size_t iTarget = 0; iTarget < targets.size(); iTarget++) {
+      DockingTarget &target = targets[iTarget];
+      const std::string &strReceptorPrmFile = options.receptorPrmFiles[iTarget];
+      // Create a bimolecular workspace
+      BiMolWorkSpacePtr spWS(new BiMolWorkSpace());
+      target.spWS = spWS;
+      // Set the workspace name to the root of the receptor .prm filename
+      std::vector<std::string> componentList =
+          ConvertDelimitedStringToList(strReceptorPrmFile, ".");
+      std::string wsName = componentList.front();
+      spWS->SetName(wsName);
+      // The receptor name is the file name without directory and extension
+      std::string strBaseName =
+          strReceptorPrmFile.substr(strReceptorPrmFile.find_last_of('/') + 1);
+      target.strName = strBaseName.substr(0, strBaseName.find('.'));
+      for (std::size_t i = 0; i < iTarget; i++) {
+        if (targets[i].strName == target.strName) {
+          throw BadArgument(_WHERE_, "Receptors " +
+                                         options.receptorPrmFiles[i] +
+                                         " and " + strReceptorPrmFile +
+                                         " have the same name");
+        }
+      }
+
+      // Read the receptor parameter file
+      ParameterFileSourcePtr spRecepPrmSource(new ParameterFileSource(
+          GetDataFileName("data/receptors", strReceptorPrmFile)));
+      target.spRecepPrmSource = spRecepPrmSource;
+      fmt::print("Receptor: {} {}\n", spRecepPrmSource->GetFileName(),
+                 spRecepPrmSource->GetTitle());
+
+      // Create the scoring function from the rxdock.score section of the
+      // docking protocol prm file Format is: SECTION rxdock.score
+      //    inter    InterSF.prm
+      //    intra IntraSF.prm
+      // END_SECTION
+      //
+      // Notes:
+      // Section name must be rxdock.score. This is also the name of the root
+      // SF aggregate An aggregate is created for each parameter in the
+      // section. Parameter name becomes the name of the subaggregate (e.g.
+      // rxdock.score.inter) Parameter value is the file name for the
+      // subaggregate definition Default directory is $RBT_ROOT/data/sf
+      SFFactoryPtr spSFFactory(
+          new SFFactory());               // Factory class for scoring functions
+      SFAggPtr spSF(new SFAgg(_ROOT_SF)); // Root SF aggregate
+      target.spSF = spSF;
+      spParamSource->SetSection(_ROOT_SF);
+      std::vector<std::string> sfList(spParamSource->GetParameterList());
+      // Loop over all parameters in the rxdock.score section
+      for (std::vector<std::string>::const_iterator sfIter = sfList.begin();
+           sfIter != sfList.end(); sfIter++) {
+        // sfFile = file name for scoring function subaggregate
+        std::string sfFile(GetDataFileName(
+            "data/sf", spParamSource->GetParameterValueAsString(*sfIter)));
+        ParameterFileSourcePtr spSFSource(new ParameterFileSource(sfFile));
+        // Create and add the subaggregate
+        spSF->Add(spSFFactory->CreateAggFromFile(spSFSource, *sfIter));
+      }
+
+      // Add the RESTRAINT subaggregate scoring function from any SF
+      // definitions in the receptor prm file
+      spSF->Add(
+          spSFFactory->CreateAggFromFile(spRecepPrmSource, _RESTRAINT_SF));
+
+      // Create the docking transform aggregate from the transform definitions
+      // in the docking prm file
+      TransformFactoryPtr spTransformFactory(new TransformFactory());
+      spParamSource->SetSection();
+      TransformAggPtr spTransform(spTransformFactory->CreateAggFromFile(
+          spParamSource, _ROOT_TRANSFORM));
+      target.spTransform = spTransform;
+
+      // Print the scoring function and the transform details
+      fmt::print("Scoring function details: {}\n", *spSF);
+      fmt::print("Search details: {}\n", *spTransform);
+
+      // Register the scoring function and the transform with the workspace
+      spWS->SetSF(spSF);
+      spWS->SetTransform(spTransform);
+
+      // Runs are abandoned early if they miss any abort thresholds defined in
+      // the transform sections of the docking prm file
+      ScoreAbortPredicate *pAbort = new ScoreAbortPredicate(spParamSource);
+      AbortPredicatePtr spAbort(pAbort);
+      if (!pAbort->isEmpty()) {
+        fmt::print("Runs missing the abort thresholds will be abandoned\n");
+        spWS->SetAbortPredicate(spAbort);
+      }
+
+      target.vRecep = Variant(spRecepPrmSource->GetFileName());
+
+      spRecepPrmSource->SetSection();
+      // Read docking site from file and register with workspace
+      // The binary docking site file (if present) already contains the
+      // distance grid and is memory-mapped rather than parsed
+      std::string strInputFile = GetDockingSiteFileName(spWS->GetName());
+      // DM 14 June 2006 - bug fix to one of the longest standing rDock issues
+      //(the cryptic "Error reading from input stream" message, if cavity file
+      // was missing)
+      // std::string message = "Cavity file (" + strDockingSiteFile +
+      //                       ") not found in current directory or $RBT_HOME";
+      // message += " - run rbcavity first";
+      // throw FileReadError(_WHERE_, message);
+      DockingSitePtr spDS = ReadDockingSite(strInputFile);
+      target.spDS = spDS;
+      spWS->SetDockingSite(spDS);
+      fmt::print("Docking site: {}\n", *spDS);
+
+      // Prepare the SD file sink for saving the docked conformations for each
+      // ligand DM 3 Dec 1999 - replaced ostrstream with String in determining
+      // SD file name SRC 2014 moved here this block to allow WRITE_ERROR TRUE
+      // With several receptors, each writes to its own output files
+      std::string strTargetMdlFile = options.strOutputMdlFile;
+      target.strOutputTableFile = options.strOutputTableFile;
+      target.strOutputHistoryFilePrefix = options.strOutputHistoryFilePrefix;
+      target.strOutputCrdFile = options.strOutputCrdFile;
+      if (bMultiTarget) {
+        strTargetMdlFile =
+            GetTargetFileName(options.strOutputMdlFile, target.strName);
+        target.strOutputTableFile =
+            GetTargetFileName(options.strOutputTableFile, target.strName);
+        target.strOutputHistoryFilePrefix =
+            options.strOutputHistoryFilePrefix + "_" + target.strName;
+        target.strOutputCrdFile =
+            GetTargetFileName(options.strOutputCrdFile, target.strName);
+        fmt::print("Output for receptor {}: {}\n", target.strName,
+                   strTargetMdlFile);
+      }
+      target.spMdlFileSink = new MdlFileSink(strTargetMdlFile, ModelPtr());
+      spWS->SetSink(target.spMdlFileSink);
+      // Optional columnar table of the saved poses and their scores
+      if (options.bOutputTable) {
+        target.spResultsTable.reset(
+            new ResultsTableSink(target.strOutputTableFile));
+      }
+
+      target.spPrmFactory.reset(new PRMFactory(spRecepPrmSource, spDS));
+      target.spPrmFactory->SetModelCache(spReceptorCache.get());
+      // Create the receptor model from the file names in the receptor
+      // parameter file
+      target.spReceptor = target.spPrmFactory->CreateReceptor();
+      // The indexed scoring functions reuse their receptor setup (index grids
+      // and interaction lists) from the receptor cache as well
+      if (spReceptorCache) {
+        spWS->SetReceptorCache(spReceptorCache.get(),
+                               target.spPrmFactory->GetReceptorCacheKey());
+      }
+      spWS->SetReceptor(target.spReceptor);
+
+      // Register any solvent
+      ModelList solventList = target.spPrmFactory->CreateSolvent();
+      spWS->SetSolvent(solventList);
+      if (spWS->hasSolvent()) {
+        int nSolvent = spWS->GetSolvent().size();
+        fmt::print("{} solvent molecules registered\n", nSolvent);
+      } else {
+        fmt::print("No solvent registered\n");
+      }
     }
 
     // Seed the random number generator
     Rand &theRand = GetRandInstance(); // ref to random number generator
-    if (bSeed) {
-      theRand.Seed(nSeed);
+    if (options.bSeed) {
+      theRand.Seed(options.nSeed);
     }
 
     // BGD 26 Feb 2003 - Create filters to simulate old rbdock
     // behaviour
     std::ostringstream strFilter;
-    if (!bFilter) {
-      if (bTarget) // -t<TS>
+    if (!options.bFilter) {
+      if (options.bTarget) // -t<TS>
       {
-        fmt::print("Lower target intermolecular score = {}\n", dTargetScore);
-        if (!bDockingRuns) // -t<TS> only
+        fmt::print("Lower target intermolecular score = {}\n",
+                   options.dTargetScore);
+        if (!options.bDockingRuns) // -t<TS> only
         {
           strFilter << fmt::format("0 1 - {}score.inter ", GetMetaDataPrefix())
-                    << dTargetScore << std::endl;
+                    << options.dTargetScore << std::endl;
         } else             // -t<TS> -n<N> need to check if -cont present
                            // for all other cases it doesn't matter
-            if (bContinue) // -t<TS> -n<N> -cont
+            if (options.bContinue) // -t<TS> -n<N> -cont
         {
           strFilter << fmt::format("1 if - {}score.NRUNS ", GetMetaDataPrefix())
-                    << (nDockingRuns - 1)
+                    << (options.nDockingRuns - 1)
                     << fmt::format(" 0.0 -1.0,\n1 - {}score.inter ",
                                    GetMetaDataPrefix())
-                    << dTargetScore << std::endl;
+                    << options.dTargetScore << std::endl;
         } else // -t<TS> -n<N>
         {
-          strFilter << "1 if - " << dTargetScore
+          strFilter << "1 if - " << options.dTargetScore
                     << fmt::format(" {}score.inter 0.0 ", GetMetaDataPrefix())
                     << fmt::format("if - {}score.NRUNS ", GetMetaDataPrefix())
-                    << (nDockingRuns - 1)
+                    << (options.nDockingRuns - 1)
                     << fmt::format(" 0.0 -1.0,\n1 - {}score.inter ",
                                    GetMetaDataPrefix())
-                    << dTargetScore << std::endl;
+                    << options.dTargetScore << std::endl;
         }
       }                      // no target score, no filter
-      else if (bDockingRuns) // -n<N>
+      else if (options.bDockingRuns) // -n<N>
       {
         strFilter << fmt::format("1 if - {}score.NRUNS ", GetMetaDataPrefix())
-                  << (nDockingRuns - 1) << " 0.0 -1.0,\n0";
+                  << (options.nDockingRuns - 1) << " 0.0 -1.0,\n0";
       } else // no -t no -n
       {
         strFilter << "0 0\n";
       }
     }
 
+    // Multi-stage screening protocol defined in the docking protocol. A
+    // filter file takes precedence
+    ScreeningStageList stages = ReadScreeningStages(spParamSource);
+    bool bStages = !stages.empty() && !options.bFilter;
+    if (!stages.empty() && options.bFilter) {
+      fmt::print("Filter file given, ignoring the screening stages of the "
+                 "docking protocol\n");
+    } else if (bStages) {
+      if (options.bTarget) {
+        fmt::print("Screening stages defined, ignoring the score threshold\n");
+      }
+      for (const auto &stage : stages) {
+        fmt::print("Screening stage {}: up to {} run(s)", stage.name,
+                   stage.nRuns);
+        for (const auto &threshold : stage.thresholds) {
+          fmt::print(", {} < {}", threshold.first, threshold.second);
+        }
+        fmt::print("\n");
+      }
+    }
+
     // Create the filter object for controlling early termination of protocol
-    FilterPtr spfilter;
-    if (bFilter) {
-      spfilter = new Filter(strFilterFile);
-      if (bDockingRuns) {
-        spfilter->SetMaxNRuns(nDockingRuns);
+    // Each target has its own, as the filter keeps the state of the runs
+    std::size_t nStages = 0;
+    for (DockingTarget &target : targets) {
+      FilterPtr spfilter;
+      if (options.bFilter) {
+        spfilter = new Filter(options.strFilterFile);
+        if (options.bDockingRuns) {
+          spfilter->SetMaxNRuns(options.nDockingRuns);
+        }
+      } else if (bStages) {
+        spfilter = new Filter(GetScreeningFilterDefinition(stages), true);
+        if (options.bDockingRuns) {
+          spfilter->SetMaxNRuns(options.nDockingRuns);
+        }
+      } else {
+        spfilter = new Filter(strFilter.str(), true);
       }
-    } else {
-      spfilter = new Filter(strFilter.str(), true);
+      nStages = std::max(spfilter->GetNumTermFilters(), 0);
+      target.stageLigands.assign(nStages + 1, 0);
+      target.stageRuns.assign(nStages, 0);
+
+      // Register the Filter with the workspace
+      target.spFilter = spfilter;
+      target.spWS->SetFilter(spfilter);
     }
 
-    // Register the Filter with the workspace
-    spWS->SetFilter(spfilter);
+    // Poses from successive runs are clustered to detect convergence (only
+    // when a number of converged runs is given)
+    PoseClusterer clusterer(options.dClusterRMSD, options.dClusterScoreWindow);
+    if (options.nConvergedRuns > 0) {
+      fmt::print("Terminating ligand after {} consecutive runs converge on the "
+                 "best pose (RMSD {} A, score window {})\n",
+                 options.nConvergedRuns, options.dClusterRMSD,
+                 options.dClusterScoreWindow);
+    }
 
     // MAIN LOOP OVER LIGAND RECORDS
     // DM 20 Apr 1999 - set the auto-ionise flags
-    if (bPosIonise) {
+    if (options.bPosIonise) {
       fmt::print("Automatically protonating positive ionisable groups (amines, "
                  "imidazoles, and guanidines)\n");
     }
-    if (bNegIonise) {
+    if (options.bNegIonise) {
       fmt::print(
           "Automatically deprotonating negative ionisable groups (carboxylic "
           "acids, phosphates, sulphates, and sulphonates)\n");
     }
-    if (!bExplH) {
+    if (!options.bExplH) {
       fmt::print("Reading polar hydrogens only from ligand SD file\n");
     } else {
       fmt::print("Reading all hydrogens from ligand SD file\n");
     }
+    if (bMultiTarget) {
+      fmt::print("Docking each ligand against {} receptors\n", targets.size());
+    }
     // DM 20 Apr 1999 - add explicit bPosIonise and bNegIonise flags to
     // MdlFileSource constructor
-    MolecularFileSourcePtr spMdlFileSource(
-        new MdlFileSource(strLigandMdlFile, bPosIonise, bNegIonise, !bExplH));
+    MdlFileSourcePtr spMdlFileSource(
+        new MdlFileSource(options.strLigandMdlFile, options.bPosIonise,
+                          options.bNegIonise, !options.bExplH));
+    // Number of the first record read, counting from zero
+    std::size_t nFirstRec = 0;
+    if (options.bRecordRange) {
+      spMdlFileSource->SelectRecords(options.nStartRecord, options.nEndRecord);
+      fmt::print("Docking {} ligand record(s) from SDfile record #{}\n",
+                 spMdlFileSource->GetEstimatedNumRecords(),
+                 options.nStartRecord + 1);
+      nFirstRec = options.nStartRecord;
+    } else if (!options.ligandNames.empty()) {
+      fmt::print("Docking ligands {}\n", fmt::join(options.ligandNames, ", "));
+      spMdlFileSource->SelectRecords(options.ligandNames);
+    }
     std::chrono::duration<double> totalDuration(0.0);
     std::size_t nFailedLigands = 0;
     std::size_t nUnnamedLigands = 0;
     std::chrono::system_clock::time_point loopBegin =
         std::chrono::system_clock::now();
     std::size_t nRec;
+    // DM 26 Jul 1999 - only read the largest segment (guaranteed to be called
+    // H)
+    spMdlFileSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+    std::size_t nCachedLigands = 0;
     for (nRec = 0; spMdlFileSource->FileStatusOK();
          spMdlFileSource->NextRecord(), nRec++) {
-      fmt::print("SDfile record #{}\n", nRec + 1);
-      Error molStatus = spMdlFileSource->Status();
-      if (!molStatus.isOK()) {
-        fmt::print("{}\n", molStatus.what());
-        continue;
+      fmt::print("SDfile record #{}\n", nFirstRec + nRec + 1);
+      // A cached ligand was prepared from an identical record, so the record
+      // is neither parsed nor checked again
+      std::string strLigandCacheKey;
+      ModelPtr spLigand;
+      if (spLigandCache) {
+        strLigandCacheKey = spMdlFileSource->GetRecordCacheKey();
+        spLigand = spLigandCache->Load(strLigandCacheKey);
+      }
+      if (spLigand.Null()) {
+        Error molStatus = spMdlFileSource->Status();
+        if (!molStatus.isOK()) {
+          fmt::print("{}\n", molStatus.what());
+          continue;
+        }
+      } else {
+        nCachedLigands++;
       }
 
       auto startTime = std::chrono::high_resolution_clock::now();
       bool bLigandError = false;
 
-      // DM 26 Jul 1999 - only read the largest segment (guaranteed to be called
-      // H) BGD 07 Oct 2002 - catching errors created by the ligands, so rbdock
+      // BGD 07 Oct 2002 - catching errors created by the ligands, so rbdock
       // continues with the next one, instead of completely stopping
       try {
-        spMdlFileSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
-
-        if (spMdlFileSource->isDataFieldPresent("Name")) {
-          Variant molName = spMdlFileSource->GetDataValue("Name");
-          if (molName.isEmpty())
+        // Data fields of the record, before any docking results are added
+        StringVariantMap recordData = spLigand.Null()
+                                          ? spMdlFileSource->GetDataMap()
+                                          : spLigand->GetDataMap();
+        StringVariantMapConstIter nameIter = recordData.find("Name");
+        if (nameIter != recordData.end()) {
+          if (nameIter->second.isEmpty())
             nUnnamedLigands++;
-          fmt::print("Name: {}\n", molName.GetString());
+          fmt::print("Name: {}\n", nameIter->second.GetString());
         }
-        if (spMdlFileSource->isDataFieldPresent("REG_Number"))
-          fmt::print("REG_Number: {}\n",
-                     spMdlFileSource->GetDataValue("REG_Number").GetString());
+        StringVariantMapConstIter regIter = recordData.find("REG_Number");
+        if (regIter != recordData.end())
+          fmt::print("REG_Number: {}\n", regIter->second.GetString());
         fmt::print("RNG seed: ");
-        if (bSeed) {
-          fmt::print("{}\n", nSeed);
+        if (options.bSeed) {
+          fmt::print("{}\n", options.nSeed);
         } else {
           fmt::print("std::random_device\n");
         }
 
-        // Create and register the ligand model
-        ModelPtr spLigand = prmFactory.CreateLigand(spMdlFileSource);
-        std::string strMolName = spLigand->GetName();
-        spWS->SetLigand(spLigand);
-        // Update any model coords from embedded chromosomes in the ligand file
-        spWS->UpdateModelCoordsFromChromRecords(spMdlFileSource);
-
-        // DM 18 May 1999 - store run info in model data
-        // Clear any previous rxdock.program.* data fields
-        spLigand->ClearAllDataFields(GetMetaDataPrefix() + "program.");
-        spLigand->SetDataValue(GetMetaDataPrefix() + "program.library", vLib);
-        spLigand->SetDataValue(GetMetaDataPrefix() + "program.receptor",
-                               vRecep);
-        spLigand->SetDataValue(GetMetaDataPrefix() + "program.parameter_file",
-                               vPrm);
-        spLigand->SetDataValue(
-            GetMetaDataPrefix() + "program.current_directory", vDir);
-
-        // DM 10 Dec 1999 - if in target mode, loop until target score is
-        // reached
-        bool bTargetMet = false;
-
-        ////////////////////////////////////////////////////
-        // MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
-        // Create a history file sink, just in case it's needed by any
-        // of the transforms
-        std::size_t iRun = 0;
-        std::size_t nErrors = 0;
-        // need to check this here. The termination
-        // filter is only run once at least
-        // one docking run has been done.
-        if (nDockingRuns < 1)
-          bTargetMet = true;
-        while (!bTargetMet) {
-          // Catching errors with this specific run
-          if (nErrors > 10) {
-            fmt::print(
-                "Target not met, but giving up on ligand after {} errors",
-                nErrors);
-            bLigandError = true;
-            break;
+        // Create and prepare the ligand model once for all the receptors. The
+        // cache holds the model without its flexibility data, which depends on
+        // the docking site
+        if (spLigand.Null()) {
+          spLigand = new Model(spMdlFileSource);
+          if (spLigandCache) {
+            spLigandCache->Save(strLigandCacheKey, *spLigand);
           }
-          try {
-            if (bOutputHistory) {
-              std::ostringstream histr;
-              histr << strOutputHistoryFilePrefix << "_" << strMolName
-                    << nRec + 1 << "_his_" << iRun + 1 << ".sd";
-              MolecularFileSinkPtr spHistoryFileSink(
-                  new MdlFileSink(histr.str(), spLigand));
-              spWS->SetHistorySink(spHistoryFileSink);
-            }
-            spWS->Run(); // Dock!
-            bool bterm = spfilter->Terminate();
-            bool bwrite = spfilter->Write();
-            if (bterm)
-              bTargetMet = true;
-            if (bwrite) {
-              spWS->Save();
-            }
-            iRun++;
-          } catch (DockingError &e) {
-            fmt::print("{}\n", e.what());
-            nErrors++;
+        }
+        targets.front().spPrmFactory->AttachLigandFlexData(spLigand);
+        // Each receptor docks the ligand from its input coordinates
+        if (bMultiTarget) {
+          spLigand->SaveCoords();
+        }
+        for (std::size_t iTarget = 0; iTarget < targets.size(); iTarget++) {
+          DockingTarget &target = targets[iTarget];
+          if (bMultiTarget) {
+            fmt::print("Receptor: {}\n", target.strName);
+          }
+          if (iTarget > 0) {
+            spLigand->RevertCoords();
+            target.spPrmFactory->AttachLigandFlexData(spLigand);
+          }
+          if (!DockLigand(target, spLigand, recordData,
+                          options.strLigandMdlFile, vLib, vPrm, vDir,
+                          nFirstRec + nRec + 1, options.bOutputHistory,
+                          options.nDockingRuns, options.nConvergedRuns,
+                          clusterer)) {
+            bLigandError = true;
           }
         }
-        // END OF MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
-        ////////////////////////////////////////////////////
-
-        // here we use iRun since it got incremented in the last iteration to
-        // the number of runs done
-        fmt::print("Numer of docking runs done:   {} ({} errors)\n", iRun,
-                   nErrors);
       }
       // END OF TRY
       catch (LigandError &e) {
@@ -409,6 +722,10 @@ int rxdock::operation::dock(
       fmt::print(", of which {} failed to dock\n", nFailedLigands);
     else
       fmt::print(", all ligands docked without errors\n");
+    if (options.bLigandCache) {
+      fmt::print("Prepared ligands loaded from cache {}: {}\n",
+                 options.strLigandCacheDir, nCachedLigands);
+    }
 
     if (nRec - nFailedLigands > 0) {
       auto hTotal =
@@ -430,6 +747,27 @@ int rxdock::operation::dock(
       fmt::print("{} second(s)\n", totalDuration.count());
     }
 
+    for (DockingTarget &target : targets) {
+      if (bStages || (options.bFilter && nStages > 1)) {
+        if (bMultiTarget) {
+          fmt::print("\nStage statistics for receptor {}:\n", target.strName);
+        } else {
+          fmt::print("\nStage statistics:\n");
+        }
+        for (std::size_t i = 0; i < nStages; i++) {
+          std::string strName =
+              bStages ? stages[i].name : fmt::format("filter {}", i + 1);
+          fmt::print("Stage {} ({}): {} ligand(s), {} run(s)", i + 1, strName,
+                     target.stageLigands[i], target.stageRuns[i]);
+          // A stage without thresholds just runs to completion
+          if (!bStages || !stages[i].thresholds.empty()) {
+            fmt::print(", {} passed", target.stageLigands[i + 1]);
+          }
+          fmt::print("\n");
+        }
+      }
+    }
+
     if (nUnnamedLigands > 0) {
       fmt::print("Warning: {} ligand(s) are unnamed. Post-processing tools "
                  "might have an issue correctly identifying different poses of "
@@ -437,10 +775,19 @@ int rxdock::operation::dock(
                  nUnnamedLigands);
     }
 
-    if (bOutputCrd) {
-      MolecularFileSinkPtr spRecepSink(
-          new CrdFileSink(strOutputCrdFile, spReceptor));
-      spRecepSink->Render();
+    for (DockingTarget &target : targets) {
+      if (target.spResultsTable) {
+        target.spResultsTable->Close();
+        fmt::print("Wrote {} pose(s) to results table {}\n",
+                   target.spResultsTable->GetNumRows(),
+                   target.strOutputTableFile);
+      }
+
+      if (options.bOutputCrd) {
+        MolecularFileSinkPtr spRecepSink(
+            new CrdFileSink(target.strOutputCrdFile, target.spReceptor));
+        spRecepSink->Render();
+      }
     }
     std::cout << std::endl;
     PrintBibliographyItem(std::cout, "RiboDock2004");
@@ -0,0 +1,361 @@
+//===-- Predict.cxx - Predict operation -------------------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://rxdock.gitlab.io/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Predict operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/operation/Predict.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/Error.h"
+#include "rxdock/FileError.h"
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+using json = nlohmann::json;
+
+namespace rxdock {
+namespace operation {
+
+namespace {
+
+// Scores of all docking runs of a ligand
+struct LigandScores {
+  std::string name;
+  std::vector<double> scores;
+};
+
+// Evaluated protocol
+struct Protocol {
+  double thr1;
+  double thr2;
+  double runs;   // Expected number of runs per ligand
+  double perc1;  // Percentage of ligands passing stage 1
+  double perc2;  // Percentage of ligands passing stage 2
+  double recall; // Percentage of top ligands passing stage 2
+};
+
+class ScoreTable {
+public:
+  void Add(const std::string &strName, double score) {
+    auto iter = m_index.find(strName);
+    if (iter == m_index.end()) {
+      iter = m_index.insert(std::make_pair(strName, m_ligands.size())).first;
+      m_ligands.push_back(LigandScores{strName, std::vector<double>()});
+    }
+    m_ligands[iter->second].scores.push_back(score);
+  }
+  std::vector<LigandScores> &GetLigands() { return m_ligands; }
+
+private:
+  std::vector<LigandScores> m_ligands;
+  std::unordered_map<std::string, std::size_t> m_index;
+};
+
+std::string Trim(const std::string &str) {
+  std::size_t begin = str.find_first_not_of(" \t\r\"");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  std::size_t end = str.find_last_not_of(" \t\r\"");
+  return str.substr(begin, end - begin + 1);
+}
+
+bool ParseScore(const std::string &str, double &score) {
+  try {
+    score = std::stod(str);
+    return true;
+  } catch (std::logic_error &) {
+    return false;
+  }
+}
+
+// Scans the data fields of a structure-data file directly, without building
+// the molecules. Records without a name field are named by their title line
+std::size_t ReadSDScores(std::istream &inFile, const std::string &strNameField,
+                         const std::string &strScoreField, ScoreTable &table) {
+  std::size_t nSkipped = 0;
+  std::string line;
+  std::string strField;
+  std::string strName;
+  std::string strScore;
+  bool bTitle = true;
+  while (std::getline(inFile, line)) {
+    if (bTitle) {
+      strName = Trim(line);
+      strScore.clear();
+      bTitle = false;
+    } else if (line.compare(0, 4, "$$$$") == 0) {
+      double score;
+      if (ParseScore(strScore, score)) {
+        table.Add(strName, score);
+      } else {
+        nSkipped++;
+      }
+      strField.clear();
+      bTitle = true;
+    } else if (!strField.empty()) {
+      if (strField == strNameField) {
+        strName = Trim(line);
+      } else {
+        strScore = Trim(line);
+      }
+      strField.clear();
+    } else if (!line.empty() && line[0] == '>') {
+      std::size_t begin = line.find('<');
+      std::size_t end = line.find('>', begin);
+      if (begin != std::string::npos && end != std::string::npos) {
+        std::string strThisField = line.substr(begin + 1, end - begin - 1);
+        if (strThisField == strNameField || strThisField == strScoreField) {
+          strField = strThisField;
+        }
+      }
+    }
+  }
+  return nSkipped;
+}
+
+std::vector<std::string> SplitRow(const std::string &line, char delimiter) {
+  std::vector<std::string> fields;
+  if (delimiter == ' ') {
+    std::istringstream istr(line);
+    std::string field;
+    while (istr >> field) {
+      fields.push_back(Trim(field));
+    }
+  } else {
+    std::size_t begin = 0;
+    std::size_t end;
+    while ((end = line.find(delimiter, begin)) != std::string::npos) {
+      fields.push_back(Trim(line.substr(begin, end - begin)));
+      begin = end + 1;
+    }
+    fields.push_back(Trim(line.substr(begin)));
+  }
+  return fields;
+}
+
+// Reads a table with a header row naming the columns
+std::size_t ReadTableScores(std::istream &inFile,
+                            const std::string &strNameField,
+                            const std::string &strScoreField,
+                            const std::string &strFileName,
+                            ScoreTable &table) {
+  std::string line;
+  std::getline(inFile, line);
+  char delimiter = ' ';
+  if (line.find(',') != std::string::npos) {
+    delimiter = ',';
+  } else if (line.find('\t') != std::string::npos) {
+    delimiter = '\t';
+  }
+  std::vector<std::string> header = SplitRow(line, delimiter);
+  auto nameIter = std::find(header.begin(), header.end(), strNameField);
+  auto scoreIter = std::find(header.begin(), header.end(), strScoreField);
+  if (nameIter == header.end() || scoreIter == header.end()) {
+    throw FileParseError(_WHERE_, "Columns " + strNameField + " and " +
+                                      strScoreField + " not found in " +
+                                      strFileName);
+  }
+  std::size_t iName = nameIter - header.begin();
+  std::size_t iScore = scoreIter - header.begin();
+
+  std::size_t nSkipped = 0;
+  while (std::getline(inFile, line)) {
+    std::vector<std::string> fields = SplitRow(line, delimiter);
+    double score;
+    if (fields.size() > std::max(iName, iScore) &&
+        ParseScore(fields[iScore], score)) {
+      table.Add(fields[iName], score);
+    } else if (!Trim(line).empty()) {
+      nSkipped++;
+    }
+  }
+  return nSkipped;
+}
+
+// Probability of a run scoring below the threshold
+double GetProbability(const std::vector<double> &sortedScores, double thr) {
+  return static_cast<double>(std::lower_bound(sortedScores.begin(),
+                                              sortedScores.end(), thr) -
+                             sortedScores.begin()) /
+         sortedScores.size();
+}
+
+// Probability of at least one of nRuns runs succeeding
+double GetPassProbability(double p, std::size_t nRuns) {
+  return 1.0 - std::pow(1.0 - p, static_cast<double>(nRuns));
+}
+
+// Expected number of runs, up to nRuns, until the first success
+double GetExpectedRuns(double p, std::size_t nRuns) {
+  return (p > 0.0) ? GetPassProbability(p, nRuns) / p
+                   : static_cast<double>(nRuns);
+}
+
+} // namespace
+
+} // namespace operation
+} // namespace rxdock
+
+int rxdock::operation::predict(std::string strInputFile,
+                               std::string strOutputFile,
+                               std::string strNameField,
+                               std::string strScoreField, std::size_t nRuns1,
+                               std::size_t nRuns2, std::size_t nRunsFinal,
+                               double dThr1Max, double dThr1Min,
+                               double dThr2Max, double dThr2Min,
+                               double dThrStep, double dTopPercent,
+                               double dMinRecall) {
+  try {
+    if (nRuns1 < 1 || nRuns2 < 1 || nRunsFinal < 1 || dThrStep <= 0.0) {
+      throw BadArgument(_WHERE_, "Numbers of runs and the threshold step must "
+                                 "be positive");
+    }
+    InputFileStream inFile(strInputFile);
+    if (!inFile) {
+      throw FileReadError(_WHERE_, "Cannot open " + strInputFile);
+    }
+    ScoreTable table;
+    // The file type of compressed files is given by the extension before
+    // .gz or .zst
+    std::string strBaseName = strInputFile;
+    if (isCompressedFileName(strBaseName)) {
+      strBaseName.erase(strBaseName.rfind('.'));
+    }
+    std::string strExt = strBaseName.substr(strBaseName.rfind('.') + 1);
+    std::size_t nSkipped =
+        (strExt == "sd" || strExt == "sdf")
+            ? ReadSDScores(inFile, strNameField, strScoreField, table)
+            : ReadTableScores(inFile, strNameField, strScoreField,
+                              strInputFile, table);
+    inFile.CheckError();
+    std::vector<LigandScores> &ligands = table.GetLigands();
+    if (ligands.empty()) {
+      throw FileParseError(_WHERE_, "No " + strScoreField +
+                                        " scores found in " + strInputFile);
+    }
+
+    std::size_t nScores = 0;
+    for (auto &ligand : ligands) {
+      std::sort(ligand.scores.begin(), ligand.scores.end());
+      nScores += ligand.scores.size();
+    }
+    double meanRuns = static_cast<double>(nScores) / ligands.size();
+    fmt::print("Read {} scores for {} ligands ({} records skipped)\n", nScores,
+               ligands.size(), nSkipped);
+
+    // The top ligands are those with the best scores over all their runs
+    std::vector<double> bestScores;
+    for (const auto &ligand : ligands) {
+      bestScores.push_back(ligand.scores.front());
+    }
+    std::sort(bestScores.begin(), bestScores.end());
+    std::size_t nTop = std::max<std::size_t>(
+        1, static_cast<std::size_t>(
+               std::round(ligands.size() * dTopPercent / 100.0)));
+    nTop = std::min(nTop, ligands.size());
+    double topScore = bestScores[nTop - 1];
+
+    std::vector<Protocol> protocols;
+    int nThr1 = static_cast<int>(std::floor((dThr1Max - dThr1Min) / dThrStep +
+                                            1.0e-6));
+    int nThr2 = static_cast<int>(std::floor((dThr2Max - dThr2Min) / dThrStep +
+                                            1.0e-6));
+    for (int i = 0; i <= nThr1; i++) {
+      double thr1 = dThr1Max - i * dThrStep;
+      for (int j = 0; j <= nThr2; j++) {
+        double thr2 = dThr2Max - j * dThrStep;
+        if (thr2 > thr1) {
+          continue;
+        }
+        Protocol protocol{thr1, thr2, 0.0, 0.0, 0.0, 0.0};
+        for (const auto &ligand : ligands) {
+          double p1 = GetProbability(ligand.scores, thr1);
+          double p2 = GetProbability(ligand.scores, thr2);
+          double pass1 = GetPassProbability(p1, nRuns1);
+          // The pose passing stage 1 is checked against stage 2 straight away
+          double q = (p1 > 0.0) ? p2 / p1 : 0.0;
+          double pass2 = q + (1.0 - q) * GetPassProbability(p2, nRuns2);
+          double runs2 = (1.0 - q) * GetExpectedRuns(p2, nRuns2);
+          protocol.runs += GetExpectedRuns(p1, nRuns1) +
+                           pass1 * (runs2 + pass2 * nRunsFinal);
+          protocol.perc1 += pass1;
+          protocol.perc2 += pass1 * pass2;
+          if (ligand.scores.front() <= topScore) {
+            protocol.recall += pass1 * pass2;
+          }
+        }
+        protocol.runs /= ligands.size();
+        protocol.perc1 *= 100.0 / ligands.size();
+        protocol.perc2 *= 100.0 / ligands.size();
+        protocol.recall *= 100.0 / nTop;
+        protocols.push_back(protocol);
+      }
+    }
+
+    std::ofstream outFile(strOutputFile.c_str());
+    if (!outFile) {
+      throw FileWriteError(_WHERE_, "Cannot open " + strOutputFile);
+    }
+    // TIME is relative to the exhaustive docking of the input
+    outFile << "TIME,RUNS,PERC1,PERC2,RECALL,N1,THR1,N2,THR2,NFINAL\n";
+    const Protocol *pBest = nullptr;
+    for (const auto &protocol : protocols) {
+      outFile << fmt::format(
+          "{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{},{},{},{},{}\n",
+          protocol.runs * 100.0 / meanRuns, protocol.runs, protocol.perc1,
+          protocol.perc2, protocol.recall, nRuns1, protocol.thr1, nRuns2,
+          protocol.thr2, nRunsFinal);
+      if (protocol.recall >= dMinRecall &&
+          (pBest == nullptr || protocol.runs < pBest->runs)) {
+        pBest = &protocol;
+      }
+    }
+    outFile.close();
+    fmt::print("{} protocols written to {}\n", protocols.size(), strOutputFile);
+
+    if (pBest == nullptr) {
+      fmt::print("No protocol keeps {}% of the top {} ligand(s); try higher "
+                 "thresholds\n",
+                 dMinRecall, nTop);
+      return EXIT_SUCCESS;
+    }
+    fmt::print("Cheapest protocol keeping {}% of the top {} ligand(s): {:.3f} "
+               "runs per ligand ({:.3f}% of the input), {:.3f}% pass stage 1, "
+               "{:.3f}% pass stage 2, {:.3f}% of the top ligands kept\n",
+               dMinRecall, nTop, pBest->runs, pBest->runs * 100.0 / meanRuns,
+               pBest->perc1, pBest->perc2, pBest->recall);
+    std::string strThreshold = "threshold@" + strScoreField;
+    json stages;
+    stages["sections"] = {"stage-1", "stage-2", "stage-3"};
+    stages["stage-1"] = {{"runs", nRuns1}, {strThreshold, pBest->thr1}};
+    stages["stage-2"] = {{"runs", nRuns2}, {strThreshold, pBest->thr2}};
+    stages["stage-3"] = {{"runs", nRunsFinal}};
+    fmt::print("Screening stages for the docking protocol:\n{}\n",
+               stages.dump(2));
+  } catch (Error &e) {
+    fmt::print("{}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+//===-- Rmsd.cxx - RMSD operation -------------------------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://rxdock.gitlab.io/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// RMSD operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/operation/Rmsd.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+#include "rxdock/MdlFileSink.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/MdlRecord.h"
+#include "rxdock/ModelError.h"
+#include "rxdock/PoseRMSD.h"
+
+#include <fmt/format.h>
+#include <loguru.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+
+namespace rxdock {
+namespace operation {
+
+namespace {
+
+// Number of poses read before their RMSDs are calculated concurrently
+const std::size_t _CHUNK_SIZE = 4096;
+
+// Kept poses, hashed by the cell of their center on a grid with a spacing of
+// the duplicate threshold. Poses within the threshold RMSD of each other
+// have centers within the threshold distance, so only poses in neighbouring
+// cells need to be compared
+class PoseHash {
+public:
+  PoseHash(const PoseRMSD &poseRMSD, double dThreshold)
+      : m_poseRMSD(poseRMSD), m_dThreshold(dThreshold),
+        m_n3(3 * poseRMSD.GetNumAtoms()), m_nPoses(0) {}
+
+  // Returns the index of the closest kept pose within the threshold, or the
+  // number of kept poses if there is none
+  std::size_t FindClosest(const double *coords, double &dMinRMSD) const {
+    std::int64_t cell[3];
+    GetCell(coords, cell);
+    std::size_t iClosest = m_nPoses;
+    dMinRMSD = m_dThreshold;
+    for (std::int64_t i = -1; i <= 1; i++) {
+      for (std::int64_t j = -1; j <= 1; j++) {
+        for (std::int64_t k = -1; k <= 1; k++) {
+          auto iter =
+              m_cells.find(GetKey(cell[0] + i, cell[1] + j, cell[2] + k));
+          if (iter == m_cells.end()) {
+            continue;
+          }
+          for (std::size_t iPose : iter->second) {
+            double rms = m_poseRMSD.RMSD(&m_coords[iPose * m_n3], coords);
+            if (rms < dMinRMSD) {
+              dMinRMSD = rms;
+              iClosest = iPose;
+            }
+          }
+        }
+      }
+    }
+    return iClosest;
+  }
+
+  void Add(const double *coords) {
+    std::int64_t cell[3];
+    GetCell(coords, cell);
+    m_cells[GetKey(cell[0], cell[1], cell[2])].push_back(m_nPoses++);
+    m_coords.insert(m_coords.end(), coords, coords + m_n3);
+  }
+
+private:
+  void GetCell(const double *coords, std::int64_t cell[3]) const {
+    double center[3] = {0.0, 0.0, 0.0};
+    for (std::size_t i = 0; i < m_n3; i++) {
+      center[i % 3] += coords[i];
+    }
+    for (int k = 0; k < 3; k++) {
+      center[k] /= (m_n3 / 3);
+      cell[k] = static_cast<std::int64_t>(std::floor(center[k] / m_dThreshold));
+    }
+  }
+
+  static std::int64_t GetKey(std::int64_t i, std::int64_t j, std::int64_t k) {
+    // 21 bits per axis is ample for any realistic coordinate range
+    const std::int64_t mask = (1 << 21) - 1;
+    return ((i & mask) << 42) | ((j & mask) << 21) | (k & mask);
+  }
+
+  const PoseRMSD &m_poseRMSD;
+  double m_dThreshold;
+  std::size_t m_n3;
+  std::size_t m_nPoses;
+  std::vector<double> m_coords; // Contiguous coordinates of the kept poses
+  std::unordered_map<std::int64_t, std::vector<std::size_t>> m_cells;
+};
+
+// Moves the model, or the coordinates, by the superposition
+void Superpose(Model &model, const Quat &q, const Vector &t) {
+  AtomList atomList = model.GetAtomList();
+  for (auto &spAtom : atomList) {
+    spAtom->SetCoords(q.Rotate(spAtom->GetCoords()) + t);
+  }
+}
+
+void Superpose(double *coords, std::size_t n, const Quat &q, const Vector &t) {
+  for (std::size_t i = 0; i < n; i++) {
+    Coord c = q.Rotate(Coord(coords[3 * i], coords[3 * i + 1],
+                             coords[3 * i + 2])) +
+              t;
+    coords[3 * i] = c.xyz(0);
+    coords[3 * i + 1] = c.xyz(1);
+    coords[3 * i + 2] = c.xyz(2);
+  }
+}
+
+// Heavy atoms of a record read as text, as a Model read by OpenSDFile would
+// have them: only the largest fragment is kept (the first of equally large
+// ones, as in MdlFileSource::SetupSegmentNames). Returns their element names
+// and coordinates, in file order
+void GetHeavyAtoms(const MdlRecord &record, std::vector<std::string> &elements,
+                   std::vector<double> &coords) {
+  elements.clear();
+  coords.clear();
+  std::size_t nAtoms = record.GetNumAtoms();
+  // Fragments as disjoint sets of atoms
+  std::vector<std::size_t> parents(nAtoms);
+  std::iota(parents.begin(), parents.end(), 0);
+  auto findRoot = [&parents](std::size_t i) {
+    while (parents[i] != i) {
+      i = parents[i] = parents[parents[i]];
+    }
+    return i;
+  };
+  for (std::size_t iBond = 0; iBond < record.GetNumBonds(); iBond++) {
+    std::size_t iAtom1, iAtom2;
+    record.GetBond(iBond, iAtom1, iAtom2);
+    if (iAtom1 < nAtoms && iAtom2 < nAtoms) {
+      parents[findRoot(iAtom1)] = findRoot(iAtom2);
+    }
+  }
+  std::vector<std::size_t> sizes(nAtoms, 0);
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    sizes[findRoot(i)]++;
+  }
+  // Fragments are ranked by their first atom, as they are found in order
+  std::size_t iLargest = nAtoms;
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    std::size_t iRoot = findRoot(i);
+    if (iLargest == nAtoms || sizes[iRoot] > sizes[iLargest]) {
+      iLargest = iRoot;
+    }
+  }
+  std::string strElementName;
+  Coord coord;
+  int nFormalCharge;
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    if (findRoot(i) != iLargest) {
+      continue;
+    }
+    record.GetAtom(i, strElementName, coord, nFormalCharge);
+    if (strElementName != "H") {
+      elements.push_back(strElementName);
+      coords.insert(coords.end(), {coord.xyz(0), coord.xyz(1), coord.xyz(2)});
+    }
+  }
+}
+
+MolecularFileSourcePtr OpenSDFile(const std::string &strSDFile) {
+  MolecularFileSourcePtr spSource(
+      new MdlFileSource(strSDFile, false, false, false));
+  // DM 16 June 2006 - remove any solvent fragments from each record
+  // The largest fragment in each SD record always has segment name="H"
+  spSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+  return spSource;
+}
+
+} // namespace
+
+int rmsd(std::string strRefSDFile, std::string strInputSDFile,
+         std::string strOutputSDFile, bool bFit, double dThreshold,
+         std::size_t nMaxSymmetries) {
+  try {
+    MolecularFileSourcePtr spRefSource = OpenSDFile(strRefSDFile);
+    ModelPtr spRefModel(new Model(spRefSource));
+    PoseRMSD poseRMSD(*spRefModel, nMaxSymmetries);
+    std::size_t n3 = 3 * poseRMSD.GetNumAtoms();
+    LOG_F(INFO, "Reference {}: {} heavy atoms, {} symmetries",
+          spRefModel->GetName(), poseRMSD.GetNumAtoms(),
+          poseRMSD.GetNumSymmetries());
+    // Poses are read as text, and matched against the reference elements
+    std::vector<std::string> refElements;
+    {
+      InputFileStream refFile(strRefSDFile);
+      MdlRecord refRecord;
+      std::vector<double> refCoords;
+      if (refRecord.Read(refFile)) {
+        GetHeavyAtoms(refRecord, refElements, refCoords);
+      }
+      if (refElements.size() != poseRMSD.GetNumAtoms()) {
+        throw ModelError(_WHERE_, "Cannot read the heavy atoms of " +
+                                      spRefModel->GetName() + " as text");
+      }
+    }
+
+    bool bRemoveDups = (dThreshold > 0.0);
+    PoseHash poseHash(poseRMSD, bRemoveDups ? dThreshold : 1.0);
+    // Per record: RMSD, or a negative value if skipped; and the record
+    // number of the kept pose it belongs to
+    std::vector<double> rmsds;
+    std::vector<std::size_t> owners;
+    std::vector<std::size_t> keptRecords;
+    std::unordered_map<std::size_t, std::size_t> populations;
+    std::size_t nSkipped = 0;
+
+    fmt::print("POSE\t{}\n", bFit ? "RMSD_FIT" : "RMSD_NOFIT");
+    InputFileStream inputFile(strInputSDFile);
+    if (!inputFile) {
+      throw FileReadError(_WHERE_, "Error opening " + strInputSDFile);
+    }
+    std::unique_ptr<MdlRecord[]> chunkRecords(new MdlRecord[_CHUNK_SIZE]);
+    std::vector<double> chunkCoords(_CHUNK_SIZE * n3);
+    std::vector<double> chunkRMSDs(_CHUNK_SIZE);
+    std::vector<char> chunkValid(_CHUNK_SIZE);
+    bool bMoreRecords = true;
+    while (bMoreRecords) {
+      // Only splitting the text into records is sequential
+      std::size_t nChunk = 0;
+      while (nChunk < _CHUNK_SIZE &&
+             (bMoreRecords = chunkRecords[nChunk].Read(inputFile))) {
+        nChunk++;
+      }
+      int nPoses = static_cast<int>(nChunk);
+#pragma omp parallel for schedule(dynamic, 64)
+      for (int i = 0; i < nPoses; i++) {
+        std::vector<std::string> elements;
+        std::vector<double> coords;
+        GetHeavyAtoms(chunkRecords[i], elements, coords);
+        chunkValid[i] = (elements == refElements);
+        if (!chunkValid[i]) {
+          continue;
+        }
+        std::copy(coords.begin(), coords.end(), chunkCoords.begin() + i * n3);
+        double *pCoords = &chunkCoords[i * n3];
+        if (bFit) {
+          // Duplicates are detected between the superposed poses
+          Quat q;
+          Vector t;
+          chunkRMSDs[i] = poseRMSD.FitRMSD(pCoords, &q, &t);
+          Superpose(pCoords, n3 / 3, q, t);
+        } else {
+          chunkRMSDs[i] = poseRMSD.RMSD(pCoords);
+        }
+      }
+
+      for (std::size_t i = 0; i < nChunk; i++) {
+        std::size_t iRecord = rmsds.size();
+        if (!chunkValid[i]) {
+          LOG_F(WARNING, "Record {} skipped", iRecord + 1);
+          rmsds.push_back(-1.0);
+          owners.push_back(iRecord);
+          nSkipped++;
+          continue;
+        }
+        rmsds.push_back(chunkRMSDs[i]);
+        owners.push_back(iRecord);
+        if (bRemoveDups) {
+          const double *coords = &chunkCoords[i * n3];
+          double dMinRMSD;
+          std::size_t iClosest = poseHash.FindClosest(coords, dMinRMSD);
+          if (iClosest < keptRecords.size()) {
+            owners.back() = keptRecords[iClosest];
+            populations[keptRecords[iClosest]]++;
+            LOG_F(1, "Pose {} matches pose {} with {:.3f} RMSD", iRecord + 1,
+                  keptRecords[iClosest] + 1, dMinRMSD);
+            continue;
+          }
+          poseHash.Add(coords);
+          keptRecords.push_back(iRecord);
+          populations[iRecord] = 1;
+        }
+        fmt::print("{}\t{:.2f}\n", iRecord + 1, chunkRMSDs[i]);
+      }
+    }
+    if (nSkipped > 0) {
+      LOG_F(WARNING,
+            "{} records were skipped as their heavy atoms do not match the "
+            "reference",
+            nSkipped);
+    }
+    if (bRemoveDups) {
+      fmt::print("{} of {} poses kept\n", keptRecords.size(),
+                 rmsds.size() - nSkipped);
+    }
+
+    inputFile.CheckError();
+
+    // Only the kept poses are built as models, to be written
+    if (!strOutputSDFile.empty()) {
+      MolecularFileSinkPtr spSink(new MdlFileSink(strOutputSDFile, ModelPtr()));
+      MolecularFileSourcePtr spSource = OpenSDFile(strInputSDFile);
+      for (std::size_t iRecord = 0;
+           iRecord < rmsds.size() && spSource->FileStatusOK();
+           iRecord++, spSource->NextRecord()) {
+        if (rmsds[iRecord] < 0.0 || owners[iRecord] != iRecord) {
+          continue;
+        }
+        ModelPtr spModel;
+        try {
+          spModel = ModelPtr(new Model(spSource));
+        } catch (ModelError &e) {
+          LOG_F(WARNING, "Record {} not written: {}", iRecord + 1, e.what());
+          continue;
+        }
+        if (bFit) {
+          std::vector<double> coords;
+          poseRMSD.GetCoords(*spModel, coords);
+          Quat q;
+          Vector t;
+          poseRMSD.FitRMSD(coords.data(), &q, &t);
+          Superpose(*spModel, q, t);
+        }
+        spModel->SetDataValue(GetMetaDataPrefix() + "rmsd", rmsds[iRecord]);
+        if (bRemoveDups) {
+          spModel->SetDataValue(GetMetaDataPrefix() + "population",
+                                static_cast<int>(populations[iRecord]));
+        }
+        spSink->SetModel(spModel);
+        spSink->Render();
+      }
+    }
+  } catch (Error &e) {
+    fmt::print("{}", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+} // namespace operation
+} // namespace rxdock
@@ -17,31 +17,202 @@
 
 #include "rxdock/operation/Tabularize.h"
 #include "rxdock/CSVFileSink.h"
-#include "rxdock/MdlFileSource.h"
-#include "rxdock/ModelError.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+#include "rxdock/MdlRecord.h"
 
 #include <fmt/format.h>
 
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+
+namespace rxdock {
+namespace operation {
+
+namespace {
+
+// Size of the blocks of the input file that are split into records and
+// tabulated concurrently
+const std::size_t _BLOCK_SIZE = 16 << 20;
+
+// Quotes a CSV value if needed
+std::string escapeCSV(const std::string &value) {
+  if (value.find_first_of(",\"\n") == std::string::npos) {
+    return value;
+  }
+  std::string escaped = "\"";
+  for (auto c : value) {
+    if (c == '"') {
+      escaped += '"';
+    }
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+// Writes the title, the first nAtoms atoms and the named data fields of
+// records, one column each
+class ProjectedTable {
+public:
+  ProjectedTable(std::size_t nAtoms, const std::vector<std::string> &fieldNames)
+      : m_nAtoms(nAtoms), m_fieldNames(fieldNames) {}
+
+  std::string GetHeader() const {
+    std::ostringstream oss;
+    oss << "title";
+    for (std::size_t i = 1; i <= m_nAtoms; i++) {
+      oss << fmt::format(",atom{0}.element,atom{0}.x,atom{0}.y,atom{0}.z,"
+                         "atom{0}.charge",
+                         i);
+    }
+    for (const auto &fieldName : m_fieldNames) {
+      oss << "," << escapeCSV(fieldName);
+    }
+    return oss.str();
+  }
+
+  std::string GetLine(const MdlRecord &record) const {
+    std::ostringstream oss;
+    oss << escapeCSV(record.GetTitle());
+    std::string strElementName;
+    Coord coord;
+    int nFormalCharge;
+    std::size_t i = 0;
+    for (; i < m_nAtoms && i < record.GetNumAtoms(); i++) {
+      record.GetAtom(i, strElementName, coord, nFormalCharge);
+      oss << "," << strElementName << "," << coord.xyz(0) << ","
+          << coord.xyz(1) << "," << coord.xyz(2) << "," << nFormalCharge;
+    }
+    for (; i < m_nAtoms; i++) {
+      oss << ",,,,,";
+    }
+    for (const auto &fieldName : m_fieldNames) {
+      std::vector<std::string> sl =
+          record.GetDataValue(fieldName).GetStringList();
+      std::string value;
+      for (std::size_t j = 0; j < sl.size(); j++) {
+        value += (j > 0 ? "," : "") + sl[j];
+      }
+      oss << "," << escapeCSV(value);
+    }
+    return oss.str();
+  }
+
+private:
+  std::size_t m_nAtoms;
+  std::vector<std::string> m_fieldNames;
+};
+
+// Returns the offsets at which the records in text[0, n) end, i.e. just
+// after each $$$$ line
+std::vector<std::size_t> findRecordEnds(const char *text, std::size_t n) {
+  std::vector<std::size_t> ends;
+  std::size_t pos = 0;
+  while (pos < n) {
+    const char *pEnd =
+        static_cast<const char *>(std::memchr(text + pos, '\n', n - pos));
+    if (pEnd == nullptr) {
+      break;
+    }
+    std::size_t lineEnd = pEnd - text + 1;
+    if (lineEnd - pos >= 4 && std::strncmp(text + pos, "$$$$", 4) == 0) {
+      ends.push_back(lineEnd);
+    }
+    pos = lineEnd;
+  }
+  return ends;
+}
+
+} // namespace
+
+} // namespace operation
+} // namespace rxdock
+
 int rxdock::operation::tabularize(std::string inputSDFile,
                                   std::string outputCSVFile, std::size_t nAtoms,
-                                  std::size_t nDataFields) {
+                                  std::size_t nDataFields,
+                                  std::vector<std::string> fieldNames) {
   try {
-    MolecularFileSourcePtr fileSource(new MdlFileSource(inputSDFile));
-    MolecularFileSinkPtr fileSink(
+    // Records are only split into title, atoms and data fields; building
+    // Models would cost far more than reading the file
+    InputFileStream inputFile(inputSDFile);
+    if (!inputFile) {
+      throw FileReadError(_WHERE_, "Error opening " + inputSDFile);
+    }
+    CSVFileSinkPtr fileSink(
         new CSVFileSink(outputCSVFile, ModelPtr(), nAtoms, nDataFields));
+    ProjectedTable projectedTable(nAtoms, fieldNames);
+    bool bProjected = !fieldNames.empty();
 
-    std::map<std::string, std::size_t> numRecPerMolecule;
-    for (std::size_t nRead = 1; fileSource->FileStatusOK();
-         fileSource->NextRecord(), nRead++) {
-      try {
-        ModelPtr model(new Model(fileSource));
-        fileSink->SetModel(model);
-        fileSink->Render();
-      } catch (ModelError &e) {
-        fmt::print("{}", e.what());
-      }
+    // As with CSVFileSink, rows are appended to the output file
+    std::ofstream outputFile(outputCSVFile, std::ios::app | std::ios::binary);
+    if (!outputFile) {
+      throw FileWriteError(_WHERE_, "Error opening " + outputCSVFile);
+    }
+    outputFile.seekp(0, std::ios::end);
+    if (bProjected && outputFile.tellp() == 0) {
+      outputFile << projectedTable.GetHeader() << '\n';
     }
 
+    // Read the input in blocks, and tabulate the complete records of each
+    // block concurrently. Lines are written in the order of the records
+    std::string block;
+    std::size_t nRecords = 0;
+    bool bEOF = false;
+    while (!bEOF) {
+      std::size_t nCarried = block.size();
+      block.resize(nCarried + _BLOCK_SIZE);
+      inputFile.read(&block[nCarried], _BLOCK_SIZE);
+      block.resize(nCarried + inputFile.gcount());
+      inputFile.CheckError();
+      bEOF = !inputFile;
+
+      std::vector<std::size_t> ends =
+          findRecordEnds(block.data(), block.size());
+      // The last record may not have a $$$$ line
+      std::size_t tailStart = ends.empty() ? 0 : ends.back();
+      if (bEOF && block.find_first_not_of(" \t\r\n", tailStart) !=
+                      std::string::npos) {
+        ends.push_back(block.size());
+      }
+      int nBlockRecords = static_cast<int>(ends.size());
+      std::vector<std::string> lines(nBlockRecords);
+      std::exception_ptr recordError;
+#pragma omp parallel
+      {
+        MdlRecord record;
+#pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < nBlockRecords; i++) {
+          try {
+            std::size_t start = (i == 0) ? 0 : ends[i - 1];
+            record.Parse(block.substr(start, ends[i] - start));
+            lines[i] = bProjected ? projectedTable.GetLine(record)
+                                  : fileSink->GetRecordLine(record);
+          } catch (...) {
+#pragma omp critical(rxdock_tabularize_error)
+            if (!recordError) {
+              recordError = std::current_exception();
+            }
+          }
+        }
+      }
+      if (recordError) {
+        std::rethrow_exception(recordError);
+      }
+      for (const auto &line : lines) {
+        outputFile << line << '\n';
+      }
+      nRecords += lines.size();
+      // Keep the incomplete record at the end of the block for the next one
+      block.erase(0, ends.empty() ? 0 : ends.back());
+    }
+    outputFile.close();
+    if (!outputFile) {
+      throw FileWriteError(_WHERE_, "Error writing " + outputCSVFile);
+    }
+    fmt::print("Wrote {} records to {}\n", nRecords, outputCSVFile);
   } catch (Error &e) {
     fmt::print("{}", e.what());
     return EXIT_FAILURE;
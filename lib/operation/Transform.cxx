@@ -16,21 +16,379 @@
 //===----------------------------------------------------------------------===//
 
 #include "rxdock/operation/Transform.h"
-#include "rxdock/MdlFileSink.h"
-#include "rxdock/MdlFileSource.h"
-#include "rxdock/ModelError.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+#include "rxdock/MdlRecord.h"
+
+#include <fmt/format.h>
+#include <loguru.hpp>
 
 #include <algorithm>
-#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <functional>
-
-#include <fmt/chrono.h>
-#include <fmt/format.h>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <sstream>
 
 namespace rxdock {
 namespace operation {
 
-static void changeModelName(ModelPtr model, std::string newName) {
+namespace {
+
+// Maximum number of run files merged at once
+const std::size_t _MAX_MERGE_WIDTH = 256;
+
+const std::uint64_t _NO_TITLE = std::numeric_limits<std::uint64_t>::max();
+
+// A selected record: its sort key, its position in the input (so that equal
+// keys keep the input order), and where its text is in the input file (or in
+// the record file, for compressed input). If the record is renamed,
+// titleOffset points to its new title in the title file, otherwise it is
+// _NO_TITLE
+struct RecordRef {
+  double key;
+  std::uint64_t seq;
+  std::uint64_t offset;
+  std::uint64_t length;
+  std::uint64_t titleOffset;
+
+  bool operator<(const RecordRef &r) const {
+    return key < r.key || (key == r.key && seq < r.seq);
+  }
+};
+
+// A selected record with the name of its molecule, for limiting the number
+// of records per molecule. Sorting groups the records of each molecule, best
+// first
+struct NamedRecordRef {
+  std::string name;
+  RecordRef ref;
+
+  bool operator<(const NamedRecordRef &r) const {
+    int c = name.compare(r.name);
+    return c < 0 || (c == 0 && ref < r.ref);
+  }
+};
+
+// Run file serialization, and the groups that per group limits apply to
+void writeRef(std::ostream &out, const RecordRef &ref) {
+  out.write(reinterpret_cast<const char *>(&ref), sizeof(RecordRef));
+}
+
+bool readRef(std::istream &in, RecordRef &ref) {
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(&ref), sizeof(RecordRef)));
+}
+
+bool isSameGroup(const RecordRef &, const RecordRef &) { return true; }
+
+void writeRef(std::ostream &out, const NamedRecordRef &ref) {
+  std::uint64_t nameLength = ref.name.size();
+  out.write(reinterpret_cast<const char *>(&nameLength), sizeof(nameLength));
+  out.write(ref.name.data(), nameLength);
+  writeRef(out, ref.ref);
+}
+
+bool readRef(std::istream &in, NamedRecordRef &ref) {
+  std::uint64_t nameLength;
+  if (!in.read(reinterpret_cast<char *>(&nameLength), sizeof(nameLength))) {
+    return false;
+  }
+  ref.name.resize(nameLength);
+  return in.read(&ref.name[0], nameLength) && readRef(in, ref.ref);
+}
+
+bool isSameGroup(const NamedRecordRef &a, const NamedRecordRef &b) {
+  return a.name == b.name;
+}
+
+// Applies the total and per group limits to records passed in sorted order
+template <typename T> class RecordLimiter {
+public:
+  RecordLimiter(std::size_t maxRecords, std::size_t maxPerGroup)
+      : m_maxRecords(maxRecords), m_maxPerGroup(maxPerGroup), m_nAccepted(0),
+        m_nInGroup(0) {}
+
+  bool IsFull() const { return m_nAccepted >= m_maxRecords; }
+
+  // Whether the next record is within the limits
+  bool Accept(const T &ref) {
+    if (IsFull()) {
+      return false;
+    }
+    std::size_t nInGroup =
+        (m_nAccepted > 0 && isSameGroup(ref, m_last)) ? m_nInGroup + 1 : 1;
+    if (nInGroup > m_maxPerGroup) {
+      return false;
+    }
+    m_nInGroup = nInGroup;
+    m_last = ref;
+    m_nAccepted++;
+    return true;
+  }
+
+private:
+  std::size_t m_maxRecords;
+  std::size_t m_maxPerGroup;
+  std::size_t m_nAccepted;
+  std::size_t m_nInGroup;
+  T m_last;
+};
+
+// Temporary file, removed when it goes out of scope
+class TempFile {
+public:
+  explicit TempFile(const std::string &fileName) : m_fileName(fileName) {}
+  ~TempFile() { std::remove(m_fileName.c_str()); }
+  const std::string &GetFileName() const { return m_fileName; }
+
+private:
+  TempFile(const TempFile &);
+  TempFile &operator=(const TempFile &);
+
+  std::string m_fileName;
+};
+
+typedef std::unique_ptr<TempFile> TempFilePtr;
+
+// Sorts record references with bounded memory. Up to bufferSize references
+// are sorted in memory; larger inputs are spilled to disk as sorted runs and
+// merged. Only the first maxPerGroup records of each group (see isSameGroup)
+// and the first maxRecords records in total are output, and records beyond
+// these limits are dropped from the runs. When at most bufferSize records
+// are wanted in total, only the best ones are kept, in a heap
+template <typename T> class RecordSorter {
+public:
+  RecordSorter(
+      const std::string &tempPrefix, std::size_t bufferSize,
+      std::size_t maxRecords,
+      std::size_t maxPerGroup = std::numeric_limits<std::size_t>::max())
+      : m_tempPrefix(tempPrefix),
+        m_bufferSize(std::max<std::size_t>(bufferSize, 1)),
+        m_maxRecords(maxRecords), m_maxPerGroup(maxPerGroup),
+        m_nTempFiles(0) {
+    m_bBounded = m_maxRecords <= m_bufferSize &&
+                 m_maxPerGroup == std::numeric_limits<std::size_t>::max();
+    m_buffer.reserve(m_bBounded ? m_maxRecords : m_bufferSize);
+  }
+
+  void Add(const T &ref) {
+    if (m_bBounded) {
+      if (m_buffer.size() < m_maxRecords) {
+        m_buffer.push_back(ref);
+        std::push_heap(m_buffer.begin(), m_buffer.end());
+      } else if (!m_buffer.empty() && ref < m_buffer.front()) {
+        std::pop_heap(m_buffer.begin(), m_buffer.end());
+        m_buffer.back() = ref;
+        std::push_heap(m_buffer.begin(), m_buffer.end());
+      }
+      return;
+    }
+    m_buffer.push_back(ref);
+    if (m_buffer.size() >= m_bufferSize) {
+      Spill();
+    }
+  }
+
+  std::size_t GetNumRuns() const { return m_runs.size(); }
+
+  // Passes the best references within the limits to emit, in order
+  void Finish(const std::function<void(const T &)> &emit) {
+    if (m_runs.empty()) {
+      std::sort(m_buffer.begin(), m_buffer.end());
+      RecordLimiter<T> limiter(m_maxRecords, m_maxPerGroup);
+      for (std::size_t i = 0; i < m_buffer.size() && !limiter.IsFull(); i++) {
+        if (limiter.Accept(m_buffer[i])) {
+          emit(m_buffer[i]);
+        }
+      }
+      return;
+    }
+    if (!m_buffer.empty()) {
+      Spill();
+    }
+    std::vector<T>().swap(m_buffer);
+    // Merge in several passes if there are too many runs to open at once
+    while (m_runs.size() > _MAX_MERGE_WIDTH) {
+      std::vector<TempFilePtr> merged;
+      for (std::size_t i = 0; i < m_runs.size(); i += _MAX_MERGE_WIDTH) {
+        std::size_t j = std::min(i + _MAX_MERGE_WIDTH, m_runs.size());
+        TempFilePtr run(NewTempFile());
+        std::ofstream out(run->GetFileName(), std::ios::binary);
+        Merge(i, j, [&out](const T &ref) { writeRef(out, ref); });
+        if (!out) {
+          throw FileWriteError(_WHERE_, "Error writing " + run->GetFileName());
+        }
+        merged.push_back(std::move(run));
+      }
+      m_runs.swap(merged);
+    }
+    Merge(0, m_runs.size(), emit);
+  }
+
+private:
+  TempFile *NewTempFile() {
+    return new TempFile(m_tempPrefix + ".run" + std::to_string(m_nTempFiles++));
+  }
+
+  // Writes the sorted buffer to a new run file. Records beyond the limits
+  // can never be output
+  void Spill() {
+    std::sort(m_buffer.begin(), m_buffer.end());
+    RecordLimiter<T> limiter(m_maxRecords, m_maxPerGroup);
+    std::size_t n = 0;
+    TempFilePtr run(NewTempFile());
+    std::ofstream out(run->GetFileName(), std::ios::binary);
+    for (std::size_t i = 0; i < m_buffer.size() && !limiter.IsFull(); i++) {
+      if (limiter.Accept(m_buffer[i])) {
+        writeRef(out, m_buffer[i]);
+        n++;
+      }
+    }
+    if (!out) {
+      throw FileWriteError(_WHERE_, "Error writing " + run->GetFileName());
+    }
+    LOG_F(1, "Wrote {} sorted records to {}", n, run->GetFileName());
+    m_runs.push_back(std::move(run));
+    m_buffer.clear();
+  }
+
+  // K-way merge of runs [iBegin, iEnd), applying the limits
+  void Merge(std::size_t iBegin, std::size_t iEnd,
+             const std::function<void(const T &)> &emit) {
+    std::vector<std::unique_ptr<std::ifstream>> inputs;
+    typedef std::pair<T, std::size_t> HeadRef;
+    auto cmp = [](const HeadRef &a, const HeadRef &b) {
+      return b.first < a.first;
+    };
+    std::priority_queue<HeadRef, std::vector<HeadRef>, decltype(cmp)> heads(
+        cmp);
+    T ref;
+    for (std::size_t i = iBegin; i < iEnd; i++) {
+      inputs.emplace_back(
+          new std::ifstream(m_runs[i]->GetFileName(), std::ios::binary));
+      if (!*inputs.back()) {
+        throw FileReadError(_WHERE_,
+                            "Error reading " + m_runs[i]->GetFileName());
+      }
+      if (readRef(*inputs.back(), ref)) {
+        heads.emplace(ref, inputs.size() - 1);
+      }
+    }
+    RecordLimiter<T> limiter(m_maxRecords, m_maxPerGroup);
+    while (!limiter.IsFull() && !heads.empty()) {
+      HeadRef head = heads.top();
+      heads.pop();
+      if (limiter.Accept(head.first)) {
+        emit(head.first);
+      }
+      if (readRef(*inputs[head.second], ref)) {
+        heads.emplace(ref, head.second);
+      }
+    }
+  }
+
+  std::string m_tempPrefix;
+  std::size_t m_bufferSize;
+  std::size_t m_maxRecords;
+  std::size_t m_maxPerGroup;
+  bool m_bBounded;
+  std::size_t m_nTempFiles;
+  std::vector<T> m_buffer;
+  std::vector<TempFilePtr> m_runs;
+};
+
+// Copies records from the input file to the output file, replacing their
+// titles if they have been renamed
+class RecordWriter {
+public:
+  RecordWriter(const std::string &inputFile, const std::string &titleFile,
+               const std::string &outputFile)
+      : m_inputFile(inputFile), m_outputFile(outputFile), m_nWritten(0) {
+    if (!titleFile.empty()) {
+      m_titles.open(titleFile, std::ios::binary);
+    }
+  }
+
+  std::size_t GetNumWritten() const { return m_nWritten; }
+
+  // Copies a record from the input file
+  void Write(const RecordRef &ref) {
+    OpenOutput();
+    // The record file is only complete once all records have been read
+    if (!m_in.isOpen()) {
+      m_in.Open(m_inputFile);
+    }
+    m_buf.resize(ref.length);
+    m_in.seekg(ref.offset);
+    if (!m_in.read(m_buf.data(), ref.length)) {
+      m_in.CheckError();
+      throw FileReadError(_WHERE_, "Error reading record " +
+                                       std::to_string(ref.seq + 1));
+    }
+    const char *p = m_buf.data();
+    const char *pEnd = p + ref.length;
+    if (ref.titleOffset != _NO_TITLE) {
+      std::string title;
+      m_titles.seekg(ref.titleOffset);
+      std::getline(m_titles, title);
+      m_out << title << '\n';
+      p = std::find(p, pEnd, '\n');
+      p = (p == pEnd) ? pEnd : p + 1;
+    }
+    m_out.write(p, pEnd - p);
+    if (ref.length == 0 || m_buf.back() != '\n') {
+      m_out.put('\n');
+    }
+    EndRecord();
+  }
+
+  // Writes a record as it is read
+  void Write(const MdlRecord &record) {
+    OpenOutput();
+    record.Write(m_out);
+    EndRecord();
+  }
+
+  // Completes the output file, which for compressed files writes the
+  // remaining data
+  void Close() { m_out.Close(); }
+
+private:
+  // Flushing at a record boundary lets compressed output write its buffered
+  // block. Plain files are left to the stream buffer
+  void EndRecord() {
+    if (isCompressedFileName(m_outputFile)) {
+      m_out.flush();
+    }
+    m_out.CheckError();
+    m_nWritten++;
+  }
+
+  // Only create the output file once there is something to write
+  void OpenOutput() {
+    if (!m_out.isOpen()) {
+      m_out.Open(m_outputFile);
+      if (!m_out) {
+        throw FileWriteError(_WHERE_, "Error opening " + m_outputFile);
+      }
+    }
+  }
+
+  std::string m_inputFile;
+  std::string m_outputFile;
+  InputFileStream m_in;
+  std::ifstream m_titles;
+  OutputFileStream m_out;
+  std::vector<char> m_buf;
+  std::size_t m_nWritten;
+};
+
+std::string formatRecordName(const MdlRecord &record,
+                             const std::string &newName) {
   std::string formattedName;
   std::ostringstream oss;
   bool inField = false;
@@ -49,7 +407,7 @@ static void changeModelName(ModelPtr model, std::string newName) {
                                     oss.str() + ">");
       }
       inField = false;
-      formattedName += model->GetDataValue(oss.str()).GetString();
+      formattedName += record.GetDataValue(oss.str()).GetString();
       oss.str("");
     } else
       oss.put(c);
@@ -61,9 +419,11 @@ static void changeModelName(ModelPtr model, std::string newName) {
   if (oss.tellp() > 0) {
     formattedName += oss.str();
   }
-  model->SetTitle(0, formattedName);
+  return formattedName;
 }
 
+} // namespace
+
 } // namespace operation
 } // namespace rxdock
 
@@ -75,216 +435,139 @@ int rxdock::operation::transform(
     std::size_t bufferSize, bool doSorting, std::string sortDataField,
     bool limitedRecords, std::size_t maxNumRecords) {
   try {
-    MolecularFileSourcePtr fileSource(new MdlFileSource(inputSDFile));
-    MolecularFileSinkPtr fileSink(new MdlFileSink(outputSDFile, ModelPtr()));
+    // Records are only split into title, atoms and data fields, and are
+    // copied verbatim to the output
+    InputFileStream inputFile(inputSDFile);
+    if (!inputFile) {
+      throw FileReadError(_WHERE_, "Error opening " + inputSDFile);
+    }
+    if (!limitedRecords) {
+      maxNumRecords = std::numeric_limits<std::size_t>::max();
+    }
 
-    auto startTime = std::chrono::system_clock::now();
+    // Unsorted output without a limit per molecule is written as it is read
+    bool bStreaming = !doSorting && !limitedRecPerMolecule;
+    // Otherwise new titles are kept on disk, next to the sort runs
+    TempFilePtr titleFile;
+    std::ofstream titlesOut;
+    if (changeName && !bStreaming) {
+      titleFile.reset(new TempFile(outputSDFile + ".titles"));
+      titlesOut.open(titleFile->GetFileName(), std::ios::binary);
+    }
+    // Compressed input cannot be read at random efficiently, so the selected
+    // records are copied to a record file to be sorted from
+    bool bCopyRecords = !bStreaming && isCompressedFileName(inputSDFile);
+    TempFilePtr recordFile;
+    std::ofstream recordsOut;
+    if (bCopyRecords) {
+      recordFile.reset(new TempFile(outputSDFile + ".records"));
+      recordsOut.open(recordFile->GetFileName(), std::ios::binary);
+    }
+    RecordWriter writer(bCopyRecords ? recordFile->GetFileName() : inputSDFile,
+                        titleFile ? titleFile->GetFileName() : "",
+                        outputSDFile);
+    RecordSorter<RecordRef> sorter(outputSDFile, bufferSize, maxNumRecords);
+    // With a limit per molecule, records are first sorted by molecule name so
+    // that the best records of each molecule can be picked while merging,
+    // however many molecules there are. Unsorted records all have the same
+    // key, so the first ones read are kept
+    std::unique_ptr<RecordSorter<NamedRecordRef>> moleculeSorter;
+    if (limitedRecPerMolecule) {
+      moleculeSorter.reset(new RecordSorter<NamedRecordRef>(
+          outputSDFile + ".molecules", bufferSize,
+          std::numeric_limits<std::size_t>::max(), maxNumRecPerMolecule));
+    }
+    std::size_t nMatched = 0;
+    MdlRecord record;
+    std::uint64_t offset = 0;
+    for (std::uint64_t seq = 0; record.Read(inputFile); seq++) {
+      std::uint64_t length = record.GetText().size();
+      offset += length;
+      if (bStreaming && writer.GetNumWritten() >= maxNumRecords) {
+        break;
+      }
+      // FIXME reconsider generalizing this assumption
+      const std::string &moleculeName = record.GetTitle();
+      // FIXME: multiple data, correct variant, consider order
+      if ((checkName && moleculeName != name) ||
+          (checkData &&
+           record.GetDataValue(dataFieldName).GetString() != dataValue)) {
+        continue;
+      }
+      nMatched++;
 
-    auto dataFieldCmp = [&sortDataField](ModelPtr a, ModelPtr b) {
-      Variant va = a->GetDataValue(sortDataField);
-      Variant vb = b->GetDataValue(sortDataField);
+      RecordRef ref;
       // FIXME will work for rxdock.score, what about the rest?
-      return va.GetDouble() < vb.GetDouble();
-    };
+      ref.key =
+          doSorting ? record.GetDataValue(sortDataField).GetDouble() : 0.0;
+      ref.seq = seq;
+      ref.offset = offset - length;
+      ref.length = length;
+      ref.titleOffset = _NO_TITLE;
 
-    std::vector<ModelPtr> ligands;
-    std::size_t nLigandsRendered = 0;
-    std::size_t nLigandsFailed = 0;
-    std::map<std::string, std::vector<ModelPtr>> recsPerMolecule;
-    for (std::size_t nRead = 1; fileSource->FileStatusOK();
-         fileSource->NextRecord(), nRead++) {
-      try {
-        ModelPtr model(new Model(fileSource));
-        // FIXME reconsider generalizing this assumption
-        std::string moleculeName = model->GetTitleList()[0];
-        // FIXME: multiple data, correct variant, consider order
-        if ((checkName && moleculeName != name) ||
-            (checkData &&
-             model->GetDataValue(dataFieldName).GetString() != dataValue)) {
-          continue;
-        }
+      /* if (changeData) */
 
+      if (bStreaming) {
         if (changeName) {
-          changeModelName(model, newName);
-        }
-
-        /* if (changeData) */
-
-        if (recsPerMolecule.find(moleculeName) == recsPerMolecule.end()) {
-          recsPerMolecule[moleculeName] = std::vector<ModelPtr>{};
-          recsPerMolecule[moleculeName].reserve(maxNumRecPerMolecule);
-          fmt::print(
-              "Picking {} (score {}, {} out of {})\n", model->GetTitleList()[0],
-              model->GetDataValue(sortDataField).GetDouble(),
-              recsPerMolecule[moleculeName].size(), maxNumRecPerMolecule);
-          recsPerMolecule[moleculeName].push_back(model);
-        } else if (limitedRecPerMolecule &&
-                   recsPerMolecule.find(moleculeName) !=
-                       recsPerMolecule.end() &&
-                   recsPerMolecule[moleculeName].size() <
-                       maxNumRecPerMolecule) {
-          fmt::print(
-              "Picking {} (score {}, {} out of {})\n", model->GetTitleList()[0],
-              model->GetDataValue(sortDataField).GetDouble(),
-              recsPerMolecule[moleculeName].size(), maxNumRecPerMolecule);
-          recsPerMolecule[moleculeName].push_back(model);
-          if (doSorting) {
-            std::sort(recsPerMolecule[moleculeName].begin(),
-                      recsPerMolecule[moleculeName].end(), dataFieldCmp);
-          }
-        } else if (limitedRecPerMolecule) {
-          Variant worstValue =
-              recsPerMolecule[moleculeName]
-                             [recsPerMolecule[moleculeName].size() - 1]
-                                 ->GetDataValue(sortDataField);
-          Variant vModel = model->GetDataValue(sortDataField);
-          if (vModel.GetDouble() < worstValue.GetDouble()) {
-            auto it = std::lower_bound(recsPerMolecule[moleculeName].begin(),
-                                       recsPerMolecule[moleculeName].end(),
-                                       model, dataFieldCmp);
-            fmt::print("Picking {} (score {}, {} out of {})\n",
-                       model->GetTitleList()[0],
-                       model->GetDataValue(sortDataField).GetDouble(),
-                       recsPerMolecule[moleculeName].size(),
-                       maxNumRecPerMolecule);
-            recsPerMolecule[moleculeName].insert(it, model);
-            recsPerMolecule[moleculeName].pop_back();
-          } else {
-            fmt::print("Not good enough {} (score {}, worst {})\n",
-                       model->GetTitleList()[0], vModel.GetDouble(),
-                       worstValue.GetDouble());
-          }
-        } else {
-          recsPerMolecule[moleculeName].push_back(model);
-        }
-
-        /*if (limitedRecPerMolecule &&
-            recsPerMolecule[moleculeName].size() > maxNumRecPerMolecule) {
-          recsPerMolecule[moleculeName].pop_back();
-        }*/
-
-        /* FIXME simplify, remove later check */
-        /*if (doSorting && !ligands.empty() &&
-            (limitedRecords &&
-             nLigandsRendered + ligands.size() >= maxNumRecords)) {
-          double worstValue =
-              ligands[ligands.size() - 1]->GetDataValue(sortDataField);
-          Variant vModel = model->GetDataValue(sortDataField);
-          if (vModel.GetDouble() < worstValue) {
-            ligands.pop_back();
-
-            auto it = std::lower_bound(ligands.begin(), ligands.end(), model,
-                                       dataFieldCmp);
-            fmt::print("Ligand printer goes brrr for {} ({} out of {})\n",
-                       model->GetTitleList()[0],
-                       recsPerMolecule[moleculeName].size(),
-                       maxNumRecPerMolecule);
-            ligands.insert(it, model);
-          }
-        } else {
-          fmt::print("Ligand printer goes brrr for {} ({} out of {})\n",
-                     model->GetTitleList()[0],
-                     recsPerMolecule[moleculeName].size(),
-                     maxNumRecPerMolecule);
-          ligands.push_back(model);
+          record.SetTitle(formatRecordName(record, newName));
         }
+        writer.Write(record);
+        continue;
       }
-
-      if (ligands.size() % bufferSize == 0) {
-        if (!doSorting) {
-          fmt::print("Will write {} molecules now.\n", nLigandsRendered);
-          for (auto &model : ligands) {
-            fileSink->SetModel(model);
-            fileSink->Render();
-          }
-          nLigandsRendered += ligands.size();
-          ligands.clear();
-          fmt::print(
-              "Wrote {} molecules, no molecules remain to be written.\n",
-              nLigandsRendered);
-        }
+      if (bCopyRecords) {
+        ref.offset = recordsOut.tellp();
+        record.Write(recordsOut);
       }
-
-      if (nRead % bufferSize == 0) {
-        std::size_t estNumRecords = fileSource->GetEstimatedNumRecords();
-        fmt::print(
-            "Read and processed {} molecules out of approximately {}.\n",
-            nRead, estNumRecords);
-
-        auto endTime = std::chrono::system_clock::now();
-        std::chrono::duration<double> totalDuration = endTime - startTime;
-        std::chrono::duration<double> estimatedTimeRemaining =
-            estNumRecords * (totalDuration / nRead);
-        std::chrono::system_clock::time_point predictedEndTime =
-            startTime + std::chrono::duration_cast<std::chrono::seconds>(
-                            estimatedTimeRemaining);
-        std::time_t predictedEndTimeT =
-            std::chrono::system_clock::to_time_t(predictedEndTime);
-
-        auto mTotal =
-            std::chrono::duration_cast<std::chrono::minutes>(totalDuration);
-        totalDuration -= mTotal;
-
-        if (!doSorting)
-          fmt::print("Reading, processing, and writing ");
-        else
-          fmt::print("Reading and processing ");
-        fmt::print("of {} molecules took ", nRead);
-        if (mTotal.count() > 0)
-          fmt::print("{} minute(s) and ", mTotal.count());
-        fmt::print("{} second(s).\n", totalDuration.count());
-
-        fmt::print("Approximately {} molecule(s) remaining, reading and "
-                   "processing will finish {:%c}.\n",
-                   estNumRecords - nRead,
-                   *std::localtime(&predictedEndTimeT));
-      }*/
-      } catch (ModelError &e) {
-        fmt::print("{}", e.what());
-        nLigandsFailed++;
+      if (changeName) {
+        ref.titleOffset = titlesOut.tellp();
+        titlesOut << formatRecordName(record, newName) << '\n';
       }
-
-      /* FIXME uncomment eventually */
-      /* if (limitedRecords && nLigandsRendered + ligands.size() >=
-        maxNumRecords) break; */
-    }
-
-    if (recsPerMolecule.empty()) {
-      fmt::print("No molecules matched, output file will not be written.\n");
-      return EXIT_FAILURE;
-    }
-
-    for (auto const &ligandsName : recsPerMolecule) {
-      for (auto const &ligand : ligandsName.second) {
-        ligands.push_back(ligand);
+      if (moleculeSorter) {
+        NamedRecordRef namedRef;
+        namedRef.name = moleculeName;
+        namedRef.ref = ref;
+        moleculeSorter->Add(namedRef);
+      } else {
+        sorter.Add(ref);
       }
     }
-
-    if (doSorting) {
-      std::sort(ligands.begin(), ligands.end(), dataFieldCmp);
+    titlesOut.close();
+    inputFile.CheckError();
+    if (bCopyRecords) {
+      recordsOut.close();
+      if (!recordsOut) {
+        throw FileWriteError(_WHERE_,
+                             "Error writing " + recordFile->GetFileName());
+      }
     }
 
-    if (nLigandsRendered == 0 && ligands.empty()) {
-      // FIXME add matched what
+    if (nMatched == 0) {
       fmt::print("No molecules matched, output file will not be written.\n");
       return EXIT_FAILURE;
     }
 
-    fmt::print("Will write {} molecules more.\n", nLigandsRendered);
-    fmt::print("Will not write {} molecules due to errors (see above).\n",
-               nLigandsFailed);
-    for (auto &model : ligands) {
-      fileSink->SetModel(model);
-      fileSink->Render();
-      nLigandsRendered++;
-      if (limitedRecords && nLigandsRendered >= maxNumRecords) {
-        break;
+    if (!bStreaming) {
+      if (moleculeSorter) {
+        if (moleculeSorter->GetNumRuns() > 0) {
+          fmt::print("Merging {} runs of up to {} molecules by name.\n",
+                     moleculeSorter->GetNumRuns(), bufferSize);
+        }
+        moleculeSorter->Finish([&sorter](const NamedRecordRef &namedRef) {
+          LOG_F(1, "Picking {} (score {})", namedRef.name, namedRef.ref.key);
+          sorter.Add(namedRef.ref);
+        });
+        moleculeSorter.reset();
+      }
+      if (sorter.GetNumRuns() > 0) {
+        fmt::print("Merging {} sorted runs of up to {} molecules.\n",
+                   sorter.GetNumRuns(), bufferSize);
       }
+      sorter.Finish([&writer](const RecordRef &ref) { writer.Write(ref); });
     }
-    // nLigandsRendered += ligands.size();
-    ligands.clear();
+    writer.Close();
+
     fmt::print("Wrote {} molecules, no molecules remain to be written.\n",
-               nLigandsRendered);
+               writer.GetNumWritten());
   } catch (Error &e) {
     fmt::print("{}", e.what());
     return EXIT_FAILURE;
@@ -718,6 +718,26 @@ TEST_F(ChromTest, OccupancyThreshold) {
   ASSERT_LT(std::fabs(enabledProb - occupancyProb), 0.01);
 }
 
+// 43) Check that immigration from another island keeps the population size,
+// and that the best migrant is retained if it is better than the best genome
+TEST_F(ChromTest, PopulationImmigrate) {
+  setupWorkSpace();
+  int popSize = 50;
+  double equalityThreshold = 1.0E-2;
+  PopulationPtr pop1 = new Population(m_chrom_1koc, popSize, m_SF);
+  PopulationPtr pop2 = new Population(m_chrom_1koc, popSize, m_SF);
+  double bestScore =
+      std::max(pop1->Best()->GetScore(), pop2->Best()->GetScore());
+  const GenomeList &genomeList = pop2->GetGenomeList();
+  GenomeList migrants(genomeList.begin(), genomeList.begin() + 5);
+  pop1->Immigrate(migrants, equalityThreshold);
+  ASSERT_EQ(pop1->GetActualSize(), popSize);
+  ASSERT_DOUBLE_EQ(pop1->Best()->GetScore(), bestScore);
+  // Migrant scores must be consistent with the shared scoring function
+  pop1->Best()->GetChrom()->SyncToModel();
+  ASSERT_NEAR(-m_SF->Score(), bestScore, 1.0E-6);
+}
+
 void ChromTest::measureRandOrMutateDiff(ChromElement *chrom, int nTrials,
                                         bool bMutate, double &meanDiff,
                                         double &minDiff, double &maxDiff) {
@@ -0,0 +1,103 @@
+#include "CompressedFileStreamTest.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/SDIndex.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void CompressedFileStreamTest::TearDown() {
+  for (const auto &fileName : m_fileNames) {
+    std::remove(fileName.c_str());
+    std::remove(SDIndex::GetIndexFileName(fileName).c_str());
+  }
+  m_fileNames.clear();
+}
+
+bool CompressedFileStreamTest::WriteAppended(const std::string &fileName,
+                                             const std::string &text) {
+  m_fileNames.push_back(fileName);
+  try {
+    OutputFileStream outputFile(fileName);
+    outputFile << text.substr(0, 1000);
+    outputFile.Close();
+    OutputFileStream appendedFile(fileName, true);
+    appendedFile << text.substr(1000);
+    appendedFile.Close();
+  } catch (FileWriteError &) {
+    return false;
+  }
+  return true;
+}
+
+// 1 Check that compressed files, written in several blocks and appended to,
+// read back as written, and that a corrupt block is reported
+TEST_F(CompressedFileStreamTest, ReadBack) {
+  std::string text;
+  for (int i = 0; i < 200000; i++) {
+    text += "line " + std::to_string(i) + "\n";
+  }
+  std::size_t nTested = 0;
+  for (const std::string fileName :
+       {"compressed.txt.gz", "compressed.txt.zst"}) {
+    if (!WriteAppended(fileName, text)) {
+      continue; // Built without support for this compression
+    }
+    nTested++;
+    InputFileStream inputFile(fileName);
+    std::ostringstream contents;
+    contents << inputFile.rdbuf();
+    ASSERT_EQ(contents.str(), text);
+    for (std::size_t pos : {1234567, 10, 2000000}) {
+      std::string line;
+      ASSERT_TRUE(inputFile.seekg(pos));
+      std::getline(inputFile, line);
+      ASSERT_EQ(line, text.substr(pos, text.find('\n', pos) - pos));
+    }
+    // A corrupt block ends the input, and the error is reported by CheckError
+    {
+      std::fstream file(fileName, std::ios_base::in | std::ios_base::out |
+                                      std::ios_base::binary);
+      file.seekp(2000);
+      file.write("corrupt", 7);
+    }
+    InputFileStream corruptFile(fileName);
+    std::string line;
+    while (std::getline(corruptFile, line)) {
+    }
+    ASSERT_THROW(corruptFile.CheckError(), FileReadError);
+  }
+  if (nTested == 0) {
+    GTEST_SKIP();
+  }
+}
+
+// 2 Check that SD records are read from, and selected in, compressed files
+TEST_F(CompressedFileStreamTest, SDRecords) {
+  const std::string sdFileName = "compressed.sd.gz";
+  std::string record;
+  {
+    std::ifstream inputFile(GetDataFileName("", "1koc_l.sd"));
+    std::ostringstream ostr;
+    ostr << inputFile.rdbuf();
+    record = ostr.str();
+  }
+  if (!WriteAppended(sdFileName, record + record)) {
+    GTEST_SKIP(); // Built without gzip support
+  }
+  MdlFileSourcePtr spSource(
+      new MdlFileSource(sdFileName, false, false, false));
+  std::size_t nRecords = 0;
+  for (; spSource->FileStatusOK(); spSource->NextRecord(), nRecords++) {
+    ASSERT_EQ(spSource->GetTitleList()[0], "1koc");
+    ASSERT_EQ(spSource->GetRecordStart(), nRecords * record.size());
+  }
+  ASSERT_EQ(nRecords, 2u);
+  spSource->SelectRecords(1, 2);
+  ASSERT_EQ(spSource->GetRecordStart(), record.size());
+}
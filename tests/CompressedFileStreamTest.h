@@ -0,0 +1,37 @@
+// Unit tests for InputFileStream and OutputFileStream
+//
+// Required input files:
+// 1koc_l.sd Ligand coordinate file
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef COMPRESSEDFILESTREAMTEST_H_
+#define COMPRESSEDFILESTREAMTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class CompressedFileStreamTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void TearDown() override;
+
+  // Helper functions
+  // Writes text to fileName, in two parts, the second one appended. Returns
+  // false if the library was built without support for its compression
+  bool WriteAppended(const std::string &fileName, const std::string &text);
+  std::vector<std::string> m_fileNames; // Removed after each test
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*COMPRESSEDFILESTREAMTEST_H_*/
@@ -0,0 +1,132 @@
+#include "DockTest.h"
+#include "rxdock/MdlRecord.h"
+#include "rxdock/Rbt.h"
+#include "rxdock/operation/Dock.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string DockTest::_PROTOCOL_FILE = "dock-test.json";
+
+void DockTest::TearDown() {
+  for (const auto &fileName : m_fileNames) {
+    std::remove(fileName.c_str());
+  }
+  m_fileNames.clear();
+}
+
+void DockTest::WriteProtocol(const std::vector<std::string> &stages) {
+  m_fileNames.push_back(_PROTOCOL_FILE);
+  std::ofstream protocolFile(_PROTOCOL_FILE);
+  protocolFile << "{\n"
+                  "  \"media-type\": \"application/vnd.rxdock.run-script\",\n"
+                  "  \"title\": \"Unit test docking\",\n"
+                  "  \"version\": \"0.1.0\",\n"
+                  "  \"sections\": [\"rxdock.score\", \"random-population\", "
+                  "\"simplex\"";
+  for (std::size_t i = 0; i < stages.size(); i++) {
+    protocolFile << ", \"stage-" << i + 1 << "\"";
+  }
+  protocolFile << "],\n"
+                  "  \"rxdock.score\": {\n"
+                  "    \"inter\": \"intermolecular-indexed.json\",\n"
+                  "    \"intra\": \"intra-ligand.json\",\n"
+                  "    \"system\": \"intra-target.json\"\n"
+                  "  },\n"
+                  "  \"random-population\": {\n"
+                  "    \"transform\": \"RandPopTransform\",\n"
+                  "    \"population-size\": 10\n"
+                  "  },\n"
+                  "  \"simplex\": {\n"
+                  "    \"transform\": \"SimplexTransform\",\n"
+                  "    \"maximum-number-of-calls\": 100\n"
+                  "  }";
+  for (std::size_t i = 0; i < stages.size(); i++) {
+    protocolFile << ",\n  \"stage-" << i + 1 << "\": " << stages[i];
+  }
+  protocolFile << "\n}\n";
+}
+
+void DockTest::CopyDataFile(const std::string &fromFileName,
+                            const std::string &toFileName) {
+  m_fileNames.push_back(toFileName);
+  std::ifstream fromFile(GetDataFileName("", fromFileName), std::ios::binary);
+  std::ofstream toFile(toFileName, std::ios::binary);
+  toFile << fromFile.rdbuf();
+}
+
+std::size_t DockTest::CountRecords(const std::string &fileName) {
+  std::ifstream sdFile(fileName);
+  std::size_t nRecords = 0;
+  std::string line;
+  while (std::getline(sdFile, line)) {
+    if (line.compare(0, 4, "$$$$") == 0) {
+      nRecords++;
+    }
+  }
+  return nRecords;
+}
+
+// 1 Check that a ligand missing the score threshold of the first screening
+// stage is not docked in the second one, and that one meeting it is
+TEST_F(DockTest, ScreeningStageRejects) {
+  const std::string outputFile = "dock-test-out.sd";
+  m_fileNames.push_back(outputFile);
+  operation::DockOptions options;
+  options.strLigandMdlFile = GetDataFileName("", "1koc_l.sd");
+  options.strOutputMdlFile = outputFile;
+  options.receptorPrmFiles = {"1koc.json"};
+  options.strParamFile = _PROTOCOL_FILE;
+  options.bSeed = true;
+  options.nSeed = 42;
+
+  // No pose scores this low
+  WriteProtocol({"{\"runs\": 1, \"threshold@rxdock.score.inter\": -1000}",
+                 "{\"runs\": 2}"});
+  ASSERT_EQ(operation::dock(options), EXIT_SUCCESS);
+  ASSERT_EQ(CountRecords(outputFile), 1u);
+
+  // Every pose scores this low
+  WriteProtocol({"{\"runs\": 1, \"threshold@rxdock.score.inter\": 1000}",
+                 "{\"runs\": 2}"});
+  ASSERT_EQ(operation::dock(options), EXIT_SUCCESS);
+  ASSERT_EQ(CountRecords(outputFile), 3u);
+}
+
+// 2 Check that docking against two receptors writes the poses for each one to
+// its own file. The second receptor is a copy of the first, under another
+// name
+TEST_F(DockTest, MultipleReceptors) {
+  CopyDataFile("1koc.json", "dock-test-b.json");
+  CopyDataFile("1koc-docking-site.json", "dock-test-b-docking-site.json");
+  WriteProtocol({});
+  operation::DockOptions options;
+  options.strLigandMdlFile = GetDataFileName("", "1koc_l.sd");
+  options.strOutputMdlFile = "dock-test-out.sd";
+  options.receptorPrmFiles = {"1koc.json", "dock-test-b.json"};
+  options.strParamFile = _PROTOCOL_FILE;
+  options.bDockingRuns = true;
+  options.nDockingRuns = 1;
+  options.bSeed = true;
+  options.nSeed = 42;
+  for (const std::string receptor : {"1koc", "dock-test-b"}) {
+    m_fileNames.push_back("dock-test-out_" + receptor + ".sd");
+  }
+  ASSERT_EQ(operation::dock(options), EXIT_SUCCESS);
+
+  for (const std::string receptor : {"1koc", "dock-test-b"}) {
+    std::ifstream sdFile("dock-test-out_" + receptor + ".sd");
+    MdlRecord record;
+    ASSERT_TRUE(record.Read(sdFile));
+    ASSERT_EQ(record.GetTitle(), "1koc");
+    std::string strReceptorFile =
+        record.GetDataValue(GetMetaDataPrefix() + "program.receptor")
+            .GetString();
+    ASSERT_EQ(strReceptorFile.substr(strReceptorFile.find_last_of('/') + 1),
+              receptor + ".json");
+    ASSERT_FALSE(record.Read(sdFile));
+  }
+}
@@ -0,0 +1,50 @@
+// Unit tests for the docking operation (rxcmd dock)
+//
+// Required input files:
+// 1koc.json               RxDock receptor file
+// 1koc.psf                Receptor topology file
+// 1koc.crd                Receptor coordinate file
+// 1koc_l.sd               Ligand coordinate file
+// 1koc-docking-site.json  Docking site, written by rxcmd cavity-search
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+//
+// The docking protocol is written by the tests themselves, with a short
+// search so that each run is quick
+#ifndef DOCKTEST_H_
+#define DOCKTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class DockTest : public ::testing::Test {
+protected:
+  static const std::string _PROTOCOL_FILE;
+  // TextFixture methods
+  void TearDown() override;
+
+  // Helper functions
+  // Writes the docking protocol, with the screening stages given as JSON
+  // sections named stage-1, stage-2...
+  void WriteProtocol(const std::vector<std::string> &stages);
+  // Copies a file from RBT_HOME to the current directory
+  void CopyDataFile(const std::string &fromFileName,
+                    const std::string &toFileName);
+  // Number of records in an SD file
+  static std::size_t CountRecords(const std::string &fileName);
+  std::vector<std::string> m_fileNames; // Removed after each test
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*DOCKTEST_H_*/
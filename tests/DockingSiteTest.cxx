@@ -0,0 +1,71 @@
+#include "DockingSiteTest.h"
+#include "rxdock/DockingSite.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string DockingSiteTest::_WS_NAME = "docking-site-test";
+
+void DockingSiteTest::SetUp() {
+  m_strJSONFile = _WS_NAME + "-docking-site.json";
+  m_strBinFile = _WS_NAME + "-docking-site.bin";
+  {
+    std::ifstream inputFile(GetDataFileName("", "1koc-docking-site.json"),
+                            std::ios::binary);
+    std::ofstream outputFile(m_strJSONFile, std::ios::binary);
+    outputFile << inputFile.rdbuf();
+  }
+  DockingSitePtr spSite = ReadDockingSite(m_strJSONFile);
+  std::ofstream binFile(m_strBinFile, std::ios::binary);
+  spSite->WriteBinary(binFile, m_strJSONFile);
+}
+
+void DockingSiteTest::TearDown() {
+  std::remove(m_strJSONFile.c_str());
+  std::remove(m_strBinFile.c_str());
+}
+
+// 1 Check that the binary file holds the same docking site as the JSON file,
+// and that its distance grid is used without copying
+TEST_F(DockingSiteTest, RoundTrip) {
+  DockingSitePtr spJSONSite = ReadDockingSite(m_strJSONFile);
+  DockingSitePtr spBinSite = ReadDockingSite(m_strBinFile);
+  ASSERT_EQ(spBinSite->GetBorder(), spJSONSite->GetBorder());
+  ASSERT_EQ(spBinSite->GetMinCoord(), spJSONSite->GetMinCoord());
+  ASSERT_EQ(spBinSite->GetMaxCoord(), spJSONSite->GetMaxCoord());
+  CavityList jsonCavities = spJSONSite->GetCavityList();
+  CavityList binCavities = spBinSite->GetCavityList();
+  ASSERT_EQ(binCavities.size(), jsonCavities.size());
+  for (std::size_t i = 0; i < jsonCavities.size(); i++) {
+    ASSERT_EQ(binCavities[i]->GetGridStep(), jsonCavities[i]->GetGridStep());
+    ASSERT_EQ(binCavities[i]->GetCoordList(), jsonCavities[i]->GetCoordList());
+  }
+  RealGridPtr spJSONGrid = spJSONSite->GetGrid();
+  RealGridPtr spBinGrid = spBinSite->GetGrid();
+  ASSERT_TRUE(spBinGrid->isExternal());
+  ASSERT_EQ(spBinGrid->GetGridMin(), spJSONGrid->GetGridMin());
+  ASSERT_EQ(spBinGrid->GetGridStep(), spJSONGrid->GetGridStep());
+  ASSERT_EQ(spBinGrid->GetN(), spJSONGrid->GetN());
+  ASSERT_EQ(spBinGrid->GetTolerance(), spJSONGrid->GetTolerance());
+  for (unsigned int i = 0; i < spJSONGrid->GetN(); i++) {
+    ASSERT_EQ(spBinGrid->GetValue(i), spJSONGrid->GetValue(i));
+  }
+}
+
+// 2 Check that the binary file is only preferred while the JSON file it was
+// written with is unchanged
+TEST_F(DockingSiteTest, Staleness) {
+  ASSERT_TRUE(DockingSite::isBinaryUpToDate(m_strBinFile, m_strJSONFile));
+  ASSERT_EQ(GetDockingSiteFileName(_WS_NAME), m_strBinFile);
+  {
+    std::ofstream outputFile(m_strJSONFile, std::ios::app);
+    outputFile << "\n";
+  }
+  ASSERT_FALSE(DockingSite::isBinaryUpToDate(m_strBinFile, m_strJSONFile));
+  ASSERT_EQ(GetDockingSiteFileName(_WS_NAME), m_strJSONFile);
+  std::remove(m_strJSONFile.c_str());
+  ASSERT_EQ(GetDockingSiteFileName(_WS_NAME), m_strBinFile);
+}
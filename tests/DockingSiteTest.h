@@ -0,0 +1,37 @@
+// Unit tests for the JSON and binary docking site files
+//
+// Required input files:
+// 1koc-docking-site.json Docking site file
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef DOCKINGSITETEST_H_
+#define DOCKINGSITETEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class DockingSiteTest : public ::testing::Test {
+protected:
+  static const std::string _WS_NAME;
+  // TextFixture methods
+  // Copies the input docking site file into the current directory, where it
+  // can be modified, and writes the binary file next to it
+  void SetUp() override;
+  void TearDown() override;
+
+  std::string m_strJSONFile;
+  std::string m_strBinFile;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*DOCKINGSITETEST_H_*/
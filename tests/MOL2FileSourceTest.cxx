@@ -0,0 +1,40 @@
+#include "MOL2FileSourceTest.h"
+#include "rxdock/MOL2FileSource.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string MOL2FileSourceTest::_FILE_NAME = "fields.mol2";
+
+void MOL2FileSourceTest::TearDown() { std::remove(_FILE_NAME.c_str()); }
+
+// 1 Check that MOL2 ATOM and BOND records are split at any whitespace, with
+// extra fields ignored and missing optional fields defaulted
+TEST_F(MOL2FileSourceTest, Fields) {
+  {
+    std::ofstream outputFile(_FILE_NAME);
+    outputFile << "@<TRIPOS>MOLECULE\nFIELDS\n 3 2 1 0 0\nSMALL\n"
+                  "GASTEIGER\n\n@<TRIPOS>ATOM\n"
+                  "  1 C1   1.0000   2.0000   3.0000 C.3  1 LIG1 -0.1 extra\n"
+                  "2\tO1\t1.5\t2.0\t3.0\tO.3\t1\tLIG1\t-0.5\n"
+                  "  3 N1   0.5 2.0 3.0 N.3\n"
+                  "@<TRIPOS>BOND\n  1  1  2  1\n2\t1\t3\t1\n"
+                  "@<TRIPOS>SUBSTRUCTURE\n  1 LIG1  1 RESIDUE 1 A LIG\n";
+  }
+  MOL2FileSourcePtr spSource(new MOL2FileSource(_FILE_NAME, false));
+  AtomList atomList = spSource->GetAtomList();
+  ASSERT_EQ(atomList.size(), 3u);
+  ASSERT_EQ(spSource->GetNumBonds(), 2u);
+  ASSERT_EQ(atomList[1]->GetName(), "O1");
+  ASSERT_DOUBLE_EQ(atomList[1]->GetX(), 1.5);
+  ASSERT_DOUBLE_EQ(atomList[1]->GetPartialCharge(), -0.5);
+  ASSERT_EQ(atomList[1]->GetSubunitName(), "LIG");
+  ASSERT_EQ(atomList[1]->GetSegmentName(), "A");
+  ASSERT_DOUBLE_EQ(atomList[0]->GetPartialCharge(), -0.1);
+  ASSERT_EQ(atomList[2]->GetSubunitId(), "1");
+  ASSERT_EQ(atomList[2]->GetSubunitName(), "UNK");
+  ASSERT_DOUBLE_EQ(atomList[2]->GetPartialCharge(), 0.0);
+}
@@ -0,0 +1,27 @@
+// Unit tests for MOL2FileSource
+//
+// The MOL2 files are written by the tests themselves, so no input files are
+// required
+#ifndef MOL2FILESOURCETEST_H_
+#define MOL2FILESOURCETEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class MOL2FileSourceTest : public ::testing::Test {
+protected:
+  static const std::string _FILE_NAME;
+  // TextFixture methods
+  void TearDown() override;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*MOL2FILESOURCETEST_H_*/
@@ -0,0 +1,86 @@
+#include "MdlRecordTest.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/MdlRecord.h"
+#include "rxdock/Model.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void MdlRecordTest::SetUp() {
+  m_fileName = GetDataFileName("", "1YET_reference_out.sd");
+}
+
+// 1 Check that SD records read as text have the same titles, atoms, bonds
+// and data fields as the models, and are written back unchanged
+TEST_F(MdlRecordTest, MatchesModel) {
+  MolecularFileSourcePtr spSource(
+      new MdlFileSource(m_fileName, false, false, false));
+  std::ifstream inputFile(m_fileName, std::ios::binary);
+  std::ostringstream text;
+  MdlRecord record;
+  std::size_t nRecords = 0;
+  for (; spSource->FileStatusOK(); spSource->NextRecord(), nRecords++) {
+    ModelPtr spModel(new Model(spSource));
+    ASSERT_TRUE(record.Read(inputFile));
+    ASSERT_EQ(record.GetTitle(), spModel->GetTitleList()[0]);
+    StringVariantMap dataMap = record.GetDataMap();
+    StringVariantMap modelDataMap = spModel->GetDataMap();
+    ASSERT_EQ(dataMap.size(), modelDataMap.size());
+    for (const auto &field : modelDataMap) {
+      ASSERT_EQ(record.GetDataValue(field.first).GetStringList(),
+                field.second.GetStringList());
+    }
+    ASSERT_EQ(record.GetNumAtoms(),
+              static_cast<std::size_t>(spModel->GetNumAtoms()));
+    std::string strElementName;
+    Coord coord;
+    int nFormalCharge;
+    record.GetAtom(0, strElementName, coord, nFormalCharge);
+    AtomPtr spAtom = spModel->GetAtomList().front();
+    ASSERT_NEAR(Length(coord, spAtom->GetCoords()), 0.0, 1.0e-6);
+    ASSERT_EQ(nFormalCharge, spAtom->GetFormalCharge());
+    ASSERT_EQ(record.GetNumBonds(),
+              static_cast<std::size_t>(spModel->GetNumBonds()));
+    std::size_t iAtom1, iAtom2;
+    record.GetBond(0, iAtom1, iAtom2);
+    BondPtr spBond = spModel->GetBondList().front();
+    ASSERT_EQ(iAtom1 + 1,
+              static_cast<std::size_t>(spBond->GetAtom1Ptr()->GetAtomId()));
+    ASSERT_EQ(iAtom2 + 1,
+              static_cast<std::size_t>(spBond->GetAtom2Ptr()->GetAtomId()));
+    record.Write(text);
+  }
+  ASSERT_GT(nRecords, 0u);
+  ASSERT_FALSE(record.Read(inputFile));
+  std::ifstream originalFile(m_fileName, std::ios::binary);
+  std::ostringstream original;
+  original << originalFile.rdbuf();
+  ASSERT_EQ(text.str(), original.str());
+}
+
+// 2 Check that renaming a record only replaces its title line, and that its
+// atoms and bonds are still found
+TEST_F(MdlRecordTest, SetTitle) {
+  std::ifstream inputFile(m_fileName, std::ios::binary);
+  MdlRecord record;
+  ASSERT_TRUE(record.Read(inputFile));
+  std::string oldText = record.GetText();
+  std::size_t iOldAtom1, iOldAtom2;
+  record.GetBond(0, iOldAtom1, iOldAtom2);
+  record.SetTitle("renamed");
+  ASSERT_EQ(record.GetTitle(), "renamed");
+  ASSERT_EQ(record.GetText(),
+            "renamed" + oldText.substr(oldText.find('\n')));
+  std::string strElementName;
+  Coord coord;
+  int nFormalCharge;
+  record.GetAtom(0, strElementName, coord, nFormalCharge);
+  ASSERT_EQ(strElementName, "O");
+  std::size_t iAtom1, iAtom2;
+  record.GetBond(0, iAtom1, iAtom2);
+  ASSERT_EQ(iAtom1, iOldAtom1);
+  ASSERT_EQ(iAtom2, iOldAtom2);
+}
@@ -0,0 +1,32 @@
+// Unit tests for MdlRecord
+//
+// Required input files:
+// 1YET_reference_out.sd Docked ligand poses
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef MDLRECORDTEST_H_
+#define MDLRECORDTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class MdlRecordTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+
+  std::string m_fileName; // Input file, with several records
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*MDLRECORDTEST_H_*/
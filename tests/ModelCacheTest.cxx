@@ -0,0 +1,305 @@
+#include "ModelCacheTest.h"
+#include "rxdock/BaseIdxSF.h"
+#include "rxdock/BiMolWorkSpace.h"
+#include "rxdock/Hasher.h"
+#include "rxdock/NonBondedGrid.h"
+#include "rxdock/PRMFactory.h"
+#include "rxdock/ParameterFileSource.h"
+#include "rxdock/SFFactory.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string ModelCacheTest::_CACHE_DIR = "model-cache-test";
+
+void ModelCacheTest::TearDown() {
+  // Remove the entries, then their shard directories, then the cache itself
+  for (const auto &entryFileName : m_entryFileNames) {
+    std::remove(entryFileName.c_str());
+  }
+  for (const auto &entryFileName : m_entryFileNames) {
+    std::remove(entryFileName.substr(0, entryFileName.rfind('/')).c_str());
+  }
+  std::remove(_CACHE_DIR.c_str());
+}
+
+MdlFileSourcePtr ModelCacheTest::OpenLigand(const std::string &fileName,
+                                            bool bImplHydrogens) {
+  MdlFileSourcePtr spSource(new MdlFileSource(GetDataFileName("", fileName),
+                                              true, true, bImplHydrogens));
+  spSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+  return spSource;
+}
+
+double ModelCacheTest::ScoreLigand(ModelPtr spReceptor, DockingSitePtr spDS,
+                                   const ModelCache *pCache,
+                                   const std::string &strReceptorKey) {
+  ParameterFileSourcePtr spPrmSource(
+      new ParameterFileSource(GetDataFileName("", "1YET.json")));
+  PRMFactory prmFactory(spPrmSource, spDS);
+  MolecularFileSourcePtr spLigandSource(
+      new MdlFileSource(GetDataFileName("", "1YET_c.sd"), true, true, true));
+  BiMolWorkSpacePtr spWS(new BiMolWorkSpace());
+  spWS->SetDockingSite(spDS);
+  if (pCache != nullptr) {
+    spWS->SetReceptorCache(pCache, strReceptorKey);
+  }
+  spWS->SetReceptor(spReceptor);
+  spWS->SetLigand(prmFactory.CreateLigand(spLigandSource));
+  SFFactoryPtr spSFFactory(new SFFactory());
+  ParameterFileSourcePtr spSFSource(new ParameterFileSource(
+      GetDataFileName("data/sf", "intermolecular-solvation-indexed.json")));
+  spWS->SetSF(spSFFactory->CreateAggFromFile(spSFSource, "score"));
+  return spWS->GetSF()->Score();
+}
+
+std::vector<std::string> ModelCacheTest::GetSetupEntryFileNames() {
+  std::vector<std::string> entryFileNames;
+  for (const auto &shard : GetDirList(_CACHE_DIR)) {
+    std::string shardDir = _CACHE_DIR + "/" + shard;
+    for (const auto &entry :
+         GetDirList(shardDir, "", BaseIdxSF::_SETUP_ENTRY)) {
+      entryFileNames.push_back(shardDir + "/" + entry);
+    }
+  }
+  return entryFileNames;
+}
+
+// 1 Check that the key of a ligand depends on its record and options
+TEST_F(ModelCacheTest, LigandKey) {
+  std::string strKey =
+      OpenLigand("1YET_reference_out.sd", true)->GetRecordCacheKey();
+  ASSERT_EQ(OpenLigand("1YET_reference_out.sd", true)->GetRecordCacheKey(),
+            strKey);
+  ASSERT_NE(OpenLigand("1YET_reference_out.sd", false)->GetRecordCacheKey(),
+            strKey);
+  ASSERT_NE(OpenLigand("1YET_c.sd", true)->GetRecordCacheKey(), strKey);
+  // Keys are SHA-256 digests, and entries are sharded by their first digits
+  ASSERT_EQ(strKey.size(), 64u);
+  ASSERT_EQ(ModelCache(_CACHE_DIR).GetEntryFileName(strKey),
+            _CACHE_DIR + "/" + strKey.substr(0, 2) + "/" + strKey + ".model");
+}
+
+// 2 Check that a prepared ligand loaded from the model cache matches the
+// freshly prepared one, and that a truncated entry is a cache miss
+TEST_F(ModelCacheTest, LigandRoundTrip) {
+  MdlFileSourcePtr spSource = OpenLigand("1YET_reference_out.sd", true);
+  std::string strKey = spSource->GetRecordCacheKey();
+  ModelPtr spLigand(new Model(spSource));
+  ModelCache cache(_CACHE_DIR);
+  ASSERT_TRUE(cache.Load(strKey).Null());
+  cache.Save(strKey, *spLigand);
+  m_entryFileNames.push_back(cache.GetEntryFileName(strKey));
+  ModelPtr spCached = cache.Load(strKey);
+  ASSERT_FALSE(spCached.Null());
+  ASSERT_EQ(spCached->GetName(), spLigand->GetName());
+  ASSERT_EQ(spCached->GetNumBonds(), spLigand->GetNumBonds());
+  ASSERT_EQ(spCached->GetNumRings(), spLigand->GetNumRings());
+  AtomList atomList = spLigand->GetAtomList();
+  AtomList cachedAtomList = spCached->GetAtomList();
+  ASSERT_EQ(cachedAtomList.size(), atomList.size());
+  for (std::size_t i = 0; i < atomList.size(); i++) {
+    ASSERT_EQ(cachedAtomList[i]->GetFullAtomName(),
+              atomList[i]->GetFullAtomName());
+    ASSERT_EQ(cachedAtomList[i]->GetFFType(), atomList[i]->GetFFType());
+    ASSERT_EQ(cachedAtomList[i]->GetTriposType(), atomList[i]->GetTriposType());
+    ASSERT_EQ(cachedAtomList[i]->GetNumBonds(), atomList[i]->GetNumBonds());
+    ASSERT_EQ(cachedAtomList[i]->GetCyclicFlag(), atomList[i]->GetCyclicFlag());
+    ASSERT_DOUBLE_EQ(cachedAtomList[i]->GetGroupCharge(),
+                     atomList[i]->GetGroupCharge());
+    ASSERT_DOUBLE_EQ(cachedAtomList[i]->GetZ(), atomList[i]->GetZ());
+  }
+  ASSERT_EQ(spCached->GetDataMap().size(), spLigand->GetDataMap().size());
+  ASSERT_EQ(spCached->GetDataValue("Name").GetString(),
+            spLigand->GetDataValue("Name").GetString());
+
+  std::string entry;
+  {
+    std::ifstream entryFile(m_entryFileNames[0], std::ios_base::binary);
+    entry.assign(std::istreambuf_iterator<char>(entryFile),
+                 std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream entryFile(m_entryFileNames[0], std::ios_base::binary);
+    entryFile.write(entry.data(), entry.size() / 2);
+  }
+  ASSERT_TRUE(cache.Load(strKey).Null());
+}
+
+// 3 Check that a receptor loaded from the model cache matches the freshly
+// prepared one, and that both are indexed onto identical grids and score the
+// ligand alike
+TEST_F(ModelCacheTest, ReceptorRoundTrip) {
+  ParameterFileSourcePtr spPrmSource(
+      new ParameterFileSource(GetDataFileName("", "1YET.json")));
+  DockingSitePtr spDS =
+      ReadDockingSite(GetDataFileName("", "1YET-docking-site.json"));
+  ModelCache cache(_CACHE_DIR);
+  PRMFactory prmFactory(spPrmSource, spDS);
+  prmFactory.SetModelCache(&cache);
+  std::string strKey = prmFactory.GetReceptorCacheKey();
+  ASSERT_TRUE(cache.Load(strKey).Null());
+  ModelPtr spReceptor = prmFactory.CreateReceptor();
+  m_entryFileNames.push_back(cache.GetEntryFileName(strKey));
+  ASSERT_FALSE(cache.Load(strKey).Null());
+  ModelPtr spCached = prmFactory.CreateReceptor();
+  ASSERT_EQ(spCached->GetName(), spReceptor->GetName());
+  ASSERT_EQ(spCached->GetNumBonds(), spReceptor->GetNumBonds());
+  ASSERT_EQ(spCached->GetNumSavedCoords(), spReceptor->GetNumSavedCoords());
+  ASSERT_EQ(spCached->isFlexible(), spReceptor->isFlexible());
+  AtomList atomList = spReceptor->GetAtomList();
+  AtomList cachedAtomList = spCached->GetAtomList();
+  ASSERT_EQ(cachedAtomList.size(), atomList.size());
+  for (std::size_t i = 0; i < atomList.size(); i++) {
+    ASSERT_EQ(cachedAtomList[i]->GetFullAtomName(),
+              atomList[i]->GetFullAtomName());
+    ASSERT_EQ(cachedAtomList[i]->GetAtomId(), atomList[i]->GetAtomId());
+    ASSERT_EQ(cachedAtomList[i]->GetFFType(), atomList[i]->GetFFType());
+    ASSERT_EQ(cachedAtomList[i]->GetTriposType(), atomList[i]->GetTriposType());
+    ASSERT_EQ(cachedAtomList[i]->GetNumBonds(), atomList[i]->GetNumBonds());
+    ASSERT_EQ(cachedAtomList[i]->GetCyclicFlag(), atomList[i]->GetCyclicFlag());
+    ASSERT_DOUBLE_EQ(cachedAtomList[i]->GetPartialCharge(),
+                     atomList[i]->GetPartialCharge());
+    ASSERT_DOUBLE_EQ(cachedAtomList[i]->GetX(), atomList[i]->GetX());
+    ASSERT_DOUBLE_EQ(cachedAtomList[i]->GetY(), atomList[i]->GetY());
+    ASSERT_DOUBLE_EQ(cachedAtomList[i]->GetZ(), atomList[i]->GetZ());
+  }
+
+  // Index the receptor atoms around the docking site onto a grid, as the
+  // indexed scoring functions do in SetupReceptor
+  double step = 0.5;
+  double range = 5.0;
+  Coord minCoord = spDS->GetMinCoord();
+  Vector extent = spDS->GetMaxCoord() - minCoord;
+  unsigned int nX = static_cast<unsigned int>(extent.xyz(0) / step) + 1;
+  unsigned int nY = static_cast<unsigned int>(extent.xyz(1) / step) + 1;
+  unsigned int nZ = static_cast<unsigned int>(extent.xyz(2) / step) + 1;
+  NonBondedGrid grid(minCoord, Vector(step, step, step), nX, nY, nZ);
+  NonBondedGrid cachedGrid(grid);
+  AtomList siteAtomList = spDS->GetAtomList(atomList, 0.0, range);
+  AtomList cachedSiteAtomList = spDS->GetAtomList(cachedAtomList, 0.0, range);
+  ASSERT_FALSE(siteAtomList.empty());
+  for (AtomListConstIter iter = siteAtomList.begin();
+       iter != siteAtomList.end(); iter++) {
+    grid.SetAtomLists(*iter, range);
+  }
+  for (AtomListConstIter iter = cachedSiteAtomList.begin();
+       iter != cachedSiteAtomList.end(); iter++) {
+    cachedGrid.SetAtomLists(*iter, range);
+  }
+  for (unsigned int iXYZ = 0; iXYZ < grid.GetN(); iXYZ++) {
+    const AtomRList &gridAtoms = grid.GetAtomList(iXYZ);
+    const AtomRList &cachedGridAtoms = cachedGrid.GetAtomList(iXYZ);
+    ASSERT_EQ(cachedGridAtoms.size(), gridAtoms.size());
+    for (std::size_t i = 0; i < gridAtoms.size(); i++) {
+      ASSERT_EQ(cachedGridAtoms[i]->GetAtomId(), gridAtoms[i]->GetAtomId());
+    }
+  }
+
+  // The scoring functions set up from either receptor score the ligand alike
+  ASSERT_NEAR(ScoreLigand(spCached, spDS), ScoreLigand(spReceptor, spDS),
+              1e-9);
+}
+
+// 4 Check that an entry is only loaded under its own key, even if it is found
+// at the path of another key
+TEST_F(ModelCacheTest, KeyMismatch) {
+  MdlFileSourcePtr spSource = OpenLigand("1YET_reference_out.sd", true);
+  std::string strKey = spSource->GetRecordCacheKey();
+  ModelPtr spLigand(new Model(spSource));
+  MdlFileSourcePtr spOtherSource = OpenLigand("1YET_c.sd", true);
+  std::string strOtherKey = spOtherSource->GetRecordCacheKey();
+  ModelPtr spOtherLigand(new Model(spOtherSource));
+  ModelCache cache(_CACHE_DIR);
+  cache.Save(strKey, *spLigand);
+  m_entryFileNames.push_back(cache.GetEntryFileName(strKey));
+  cache.Save(strOtherKey, *spOtherLigand);
+  m_entryFileNames.push_back(cache.GetEntryFileName(strOtherKey));
+  ASSERT_FALSE(cache.Load(strOtherKey).Null());
+
+  {
+    std::ifstream entryFile(m_entryFileNames[0], std::ios_base::binary);
+    std::ofstream otherEntryFile(m_entryFileNames[1], std::ios_base::binary);
+    otherEntryFile << entryFile.rdbuf();
+  }
+  ASSERT_TRUE(cache.Load(strOtherKey).Null());
+  ASSERT_FALSE(cache.Load(strKey).Null());
+}
+
+// 5 Check the SHA-256 digest against known values. Each added string is
+// followed by a 0xff separator, which is part of the hashed input
+TEST_F(ModelCacheTest, Digest) {
+  Hasher hasher;
+  hasher.Add("abc");
+  ASSERT_EQ(hasher.GetDigest(),
+            "8e3b08dc1236880bf0c55873db58b12d8bf0398b1b17c9686e015ccfe098d35d");
+  Hasher longHasher;
+  longHasher.Add(std::string(1000, 'a'));
+  ASSERT_EQ(longHasher.GetDigest(),
+            "ddb100a1bd0af91eb3585c08565a9a973d383b693e8208cb70ec6684e93c39b2");
+  Hasher splitHasher;
+  splitHasher.Add("a");
+  splitHasher.Add("bc");
+  ASSERT_EQ(splitHasher.GetDigest(),
+            "6fef7d6fcc7c048c81ac8c968cb3e4af52621a4421b6449385bb7fb5887a8533");
+  // Taking the digest does not end the input
+  splitHasher.Add("");
+  ASSERT_EQ(splitHasher.GetDigest(),
+            "6790608cd26d17d85f1d063ace2ab22eac388a4ef352369cb47357f4886c9b7e");
+}
+
+// 6 Check that the indexed scoring functions cache their receptor setup, that
+// the setup loaded from the cache scores the ligand alike, that it is keyed by
+// the docking site, and that a truncated entry is set up afresh
+TEST_F(ModelCacheTest, ReceptorSetup) {
+  ParameterFileSourcePtr spPrmSource(
+      new ParameterFileSource(GetDataFileName("", "1YET.json")));
+  DockingSitePtr spDS =
+      ReadDockingSite(GetDataFileName("", "1YET-docking-site.json"));
+  ModelCache cache(_CACHE_DIR);
+  PRMFactory prmFactory(spPrmSource, spDS);
+  std::string strKey = prmFactory.GetReceptorCacheKey();
+  ModelPtr spReceptor = prmFactory.CreateReceptor();
+  double score = ScoreLigand(spReceptor, spDS);
+
+  // The vdW, polar and solvation terms each save their setup
+  ASSERT_TRUE(GetSetupEntryFileNames().empty());
+  ASSERT_NEAR(ScoreLigand(spReceptor, spDS, &cache, strKey), score, 1e-9);
+  m_entryFileNames = GetSetupEntryFileNames();
+  ASSERT_EQ(m_entryFileNames.size(), 3u);
+  std::vector<std::string> entries;
+  for (const auto &entryFileName : m_entryFileNames) {
+    std::ifstream entryFile(entryFileName, std::ios_base::binary);
+    entries.emplace_back(std::istreambuf_iterator<char>(entryFile),
+                         std::istreambuf_iterator<char>());
+  }
+  ASSERT_NEAR(ScoreLigand(spReceptor, spDS, &cache, strKey), score, 1e-9);
+  ASSERT_NEAR(ScoreLigand(prmFactory.CreateReceptor(), spDS, &cache, strKey),
+              score, 1e-9);
+  ASSERT_EQ(GetSetupEntryFileNames().size(), 3u);
+
+  // A docking site with a different border is a cache miss
+  DockingSitePtr spOtherDS(
+      new DockingSite(spDS->GetCavityList(), spDS->GetBorder() + 1.0));
+  ScoreLigand(spReceptor, spOtherDS, &cache, strKey);
+  ASSERT_EQ(GetSetupEntryFileNames().size(), 6u);
+
+  // Truncated entries are ignored, and overwritten by a fresh setup
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    std::ofstream entryFile(m_entryFileNames[i], std::ios_base::binary);
+    entryFile.write(entries[i].data(), entries[i].size() - 8);
+  }
+  ASSERT_NEAR(ScoreLigand(spReceptor, spDS, &cache, strKey), score, 1e-9);
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    std::ifstream entryFile(m_entryFileNames[i], std::ios_base::binary);
+    ASSERT_EQ(std::string(std::istreambuf_iterator<char>(entryFile),
+                          std::istreambuf_iterator<char>()),
+              entries[i]);
+  }
+  ASSERT_NEAR(ScoreLigand(spReceptor, spDS, &cache, strKey), score, 1e-9);
+  m_entryFileNames = GetSetupEntryFileNames();
+}
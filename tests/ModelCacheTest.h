@@ -0,0 +1,57 @@
+// Unit tests for ModelCache, the cache keys of MdlFileSource and PRMFactory,
+// and the Hasher digest they are based on
+//
+// Required input files:
+// 1YET.json               Receptor parameter file
+// 1YET-docking-site.json  Docking site
+// 1YET_c.sd               Ligand coordinate file
+// 1YET_reference_out.sd   Docked ligand poses
+// R_1YET_protein.mol2     Receptor coordinate file
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef MODELCACHETEST_H_
+#define MODELCACHETEST_H_
+
+#include <gtest/gtest.h>
+
+#include "rxdock/DockingSite.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/Model.h"
+#include "rxdock/ModelCache.h"
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class ModelCacheTest : public ::testing::Test {
+protected:
+  static const std::string _CACHE_DIR;
+  // TextFixture methods
+  void TearDown() override;
+
+  // Helper functions
+  // Opens an SD file as a ligand source, as rxcmd dock does
+  static MdlFileSourcePtr OpenLigand(const std::string &fileName,
+                                     bool bImplHydrogens);
+  // Scores the 1YET ligand against the receptor with the indexed
+  // intermolecular scoring function (with solvation). If pCache is given, the
+  // scoring functions use it to cache their receptor setup
+  static double ScoreLigand(ModelPtr spReceptor, DockingSitePtr spDS,
+                            const ModelCache *pCache = nullptr,
+                            const std::string &strReceptorKey = "");
+  // Receptor setup cache entries in the test cache
+  static std::vector<std::string> GetSetupEntryFileNames();
+  // Cache entries written by the test
+  std::vector<std::string> m_entryFileNames;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*MODELCACHETEST_H_*/
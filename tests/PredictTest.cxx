@@ -0,0 +1,91 @@
+#include "PredictTest.h"
+#include "rxdock/CompressedFileStream.h"
+#include "rxdock/FileError.h"
+#include "rxdock/operation/Predict.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string PredictTest::_SCORE_FIELD = "rxdock.score.inter";
+
+void PredictTest::TearDown() {
+  for (const auto &fileName : m_fileNames) {
+    std::remove(fileName.c_str());
+  }
+  m_fileNames.clear();
+}
+
+void PredictTest::WriteScores(const std::string &fileName,
+                              const std::vector<double> &ligandScores,
+                              int runsPerLigand, bool bTable) {
+  m_fileNames.push_back(fileName);
+  OutputFileStream outFile(fileName);
+  if (bTable) {
+    outFile << "Name," << _SCORE_FIELD << "\n";
+  }
+  for (std::size_t i = 0; i < ligandScores.size(); i++) {
+    for (int iRun = 0; iRun < runsPerLigand; iRun++) {
+      std::string strName = "LIG" + std::to_string(i);
+      if (bTable) {
+        outFile << strName << "," << ligandScores[i] << "\n";
+      } else {
+        outFile << strName << "\n\n\n"
+                << "  0  0  0  0  0  0  0  0  0  0999 V2000\nM  END\n"
+                << ">  <" << _SCORE_FIELD << ">\n"
+                << ligandScores[i] << "\n\n$$$$\n";
+      }
+    }
+  }
+  outFile.Close();
+}
+
+std::vector<std::string>
+PredictTest::ReadOutputRows(const std::string &fileName) {
+  std::ifstream inFile(fileName);
+  std::vector<std::string> rows;
+  std::string line;
+  std::getline(inFile, line);
+  while (std::getline(inFile, line)) {
+    rows.push_back(line);
+  }
+  return rows;
+}
+
+// 1 Check the expected runs and pass rates of a two stage protocol. One of
+// four ligands always passes both stages, the others never pass stage 1
+TEST_F(PredictTest, ExpectedRuns) {
+  const std::string outputFile = "predict.csv";
+  m_fileNames.push_back(outputFile);
+  WriteScores("scores.csv", {-20.0, -1.0, -1.0, -1.0}, 10, true);
+  ASSERT_EQ(operation::predict("scores.csv", outputFile, "Name", _SCORE_FIELD,
+                               2, 3, 5, -5.0, -10.0, -10.0, -15.0, 1.0, 25.0,
+                               90.0),
+            EXIT_SUCCESS);
+  std::vector<std::string> rows = ReadOutputRows(outputFile);
+  // 6 stage 1 thresholds, each with 6 lower stage 2 thresholds
+  ASSERT_EQ(rows.size(), 36u);
+  // The top ligand takes 1 run in stage 1, none in stage 2 (its stage 1 pose
+  // passes it) and 5 final runs. The others take the 2 runs of stage 1
+  ASSERT_EQ(rows.front(), "30.000,3.000,25.000,25.000,100.000,2,-5,3,-10,5");
+}
+
+// 2 Check that compressed SD files are read as SD files, not as tables
+TEST_F(PredictTest, CompressedSDInput) {
+  const std::string outputFile = "predict.csv";
+  m_fileNames.push_back(outputFile);
+  try {
+    WriteScores("scores.sd.gz", {-20.0, -1.0, -1.0, -1.0}, 10, false);
+  } catch (FileWriteError &) {
+    GTEST_SKIP(); // Built without gzip support
+  }
+  ASSERT_EQ(operation::predict("scores.sd.gz", outputFile, "Name",
+                               _SCORE_FIELD, 2, 3, 5, -5.0, -10.0, -10.0,
+                               -15.0, 1.0, 25.0, 90.0),
+            EXIT_SUCCESS);
+  std::vector<std::string> rows = ReadOutputRows(outputFile);
+  ASSERT_EQ(rows.size(), 36u);
+  ASSERT_EQ(rows.front(), "30.000,3.000,25.000,25.000,100.000,2,-5,3,-10,5");
+}
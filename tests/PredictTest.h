@@ -0,0 +1,38 @@
+// Unit tests for the screening protocol prediction (rxcmd predict)
+//
+// The score files are written by the tests themselves, so no input files are
+// required
+#ifndef PREDICTTEST_H_
+#define PREDICTTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class PredictTest : public ::testing::Test {
+protected:
+  static const std::string _SCORE_FIELD;
+  // TextFixture methods
+  void TearDown() override;
+
+  // Helper functions
+  // Writes runsPerLigand runs of each ligand with the given score, as an SD
+  // file or as a comma-separated table
+  void WriteScores(const std::string &fileName,
+                   const std::vector<double> &ligandScores,
+                   int runsPerLigand, bool bTable);
+  // Rows of the output table, without the header
+  std::vector<std::string> ReadOutputRows(const std::string &fileName);
+  std::vector<std::string> m_fileNames; // Removed after each test
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*PREDICTTEST_H_*/
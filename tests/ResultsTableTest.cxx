@@ -0,0 +1,50 @@
+#include "ResultsTableTest.h"
+#include "rxdock/Error.h"
+#include "rxdock/ResultsTableSink.h"
+#include "rxdock/ResultsTableSource.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string ResultsTableTest::_FILE_NAME = "results-table.bin";
+
+void ResultsTableTest::TearDown() { std::remove(_FILE_NAME.c_str()); }
+
+// 1 Check that a results table reads back the columns it was written with,
+// across row groups and with columns added part way through
+TEST_F(ResultsTableTest, ReadBack) {
+  {
+    ResultsTableSink sink(_FILE_NAME, 3);
+    for (int i = 0; i < 8; i++) {
+      sink.SetInt("run", i + 1);
+      sink.SetString("name", i % 2 ? "" : "ligand" + std::to_string(i));
+      if (i >= 4) {
+        sink.SetDouble("rxdock.score", -0.5 * i);
+      }
+      sink.EndRow();
+    }
+    ASSERT_THROW(sink.SetDouble("run", 1.0), BadArgument);
+  }
+  ResultsTableSource source(_FILE_NAME);
+  ASSERT_EQ(source.GetNumRows(), 8u);
+  ASSERT_EQ(source.GetColumnNames().size(), 3u);
+  std::vector<std::int64_t> runs = source.GetIntColumn("run");
+  std::vector<double> scores = source.GetDoubleColumn("rxdock.score");
+  std::vector<std::string> names = source.GetStringColumn("name");
+  std::vector<double> runsAsDoubles = source.GetDoubleColumn("run");
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(runs[i], i + 1);
+    ASSERT_EQ(runsAsDoubles[i], i + 1.0);
+    ASSERT_EQ(names[i], i % 2 ? "" : "ligand" + std::to_string(i));
+    if (i >= 4) {
+      ASSERT_EQ(scores[i], -0.5 * i);
+    } else {
+      ASSERT_TRUE(std::isnan(scores[i]));
+    }
+  }
+  ASSERT_THROW(source.GetIntColumn("rxdock.score"), BadArgument);
+  ASSERT_THROW(source.GetIntColumn("missing"), BadArgument);
+}
@@ -0,0 +1,27 @@
+// Unit tests for ResultsTableSink and ResultsTableSource
+//
+// The tables are written by the tests themselves, so no input files are
+// required
+#ifndef RESULTSTABLETEST_H_
+#define RESULTSTABLETEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class ResultsTableTest : public ::testing::Test {
+protected:
+  static const std::string _FILE_NAME;
+  // TextFixture methods
+  void TearDown() override;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*RESULTSTABLETEST_H_*/
@@ -0,0 +1,70 @@
+#include "SDIndexTest.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/SDIndex.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string SDIndexTest::_FILE_NAME = "sd-index.sd";
+
+void SDIndexTest::SetUp() {
+  {
+    std::ofstream outputFile(_FILE_NAME, std::ios::binary);
+    for (const std::string &inputFileName :
+         {"1YET_c.sd", "1koc_l.sd", "1YET_reference_out.sd", "1YET_c.sd"}) {
+      std::ifstream inputFile(GetDataFileName("", inputFileName),
+                              std::ios::binary);
+      outputFile << inputFile.rdbuf();
+    }
+  }
+  MolecularFileSourcePtr spSource(
+      new MdlFileSource(_FILE_NAME, false, false, false));
+  for (; spSource->FileStatusOK(); spSource->NextRecord()) {
+    m_offsets.push_back(spSource->GetRecordStart());
+    m_titles.push_back(spSource->GetTitleList()[0]);
+  }
+}
+
+void SDIndexTest::TearDown() {
+  std::remove(_FILE_NAME.c_str());
+  std::remove(SDIndex::GetIndexFileName(_FILE_NAME).c_str());
+}
+
+// 1 Check that the SD file index, built or loaded from its sidecar file,
+// locates the same records as a sequential read
+TEST_F(SDIndexTest, BuildAndLoad) {
+  ASSERT_EQ(m_offsets.size(), 4u);
+  for (int i = 0; i < 2; i++) {
+    // The first index is built and saved, the second one loaded
+    SDIndex index(_FILE_NAME);
+    ASSERT_EQ(index.GetNumRecords(), m_offsets.size());
+    for (std::size_t j = 0; j < m_offsets.size(); j++) {
+      ASSERT_EQ(index.GetRecordOffset(j), m_offsets[j]);
+      ASSERT_EQ(index.GetTitle(j), m_titles[j]);
+    }
+    ASSERT_EQ(index.FindTitle(m_titles[0]),
+              (std::vector<std::size_t>{0, 2, 3}));
+    ASSERT_TRUE(index.FindTitle("missing").empty());
+  }
+}
+
+// 2 Check that MdlFileSource reads only the selected records
+TEST_F(SDIndexTest, SelectRecords) {
+  MdlFileSourcePtr spMdlSource(
+      new MdlFileSource(_FILE_NAME, false, false, false));
+  spMdlSource->SelectRecords(1, 3);
+  std::size_t nRecords = 0;
+  for (; spMdlSource->FileStatusOK(); spMdlSource->NextRecord(), nRecords++) {
+    ASSERT_EQ(spMdlSource->GetRecordStart(), m_offsets[nRecords + 1]);
+    ASSERT_EQ(spMdlSource->GetTitleList()[0], m_titles[nRecords + 1]);
+  }
+  ASSERT_EQ(nRecords, 2u);
+  spMdlSource->SelectRecords(m_offsets.size() - 1, m_offsets.size() + 10);
+  ASSERT_EQ(spMdlSource->GetEstimatedNumRecords(), 1u);
+  ASSERT_EQ(spMdlSource->GetRecordStart(), m_offsets.back());
+  spMdlSource->SelectRecords(std::vector<std::string>{"missing"});
+  ASSERT_FALSE(spMdlSource->FileStatusOK());
+}
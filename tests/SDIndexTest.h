@@ -0,0 +1,40 @@
+// Unit tests for SDIndex and record selection in MdlFileSource
+//
+// Required input files:
+// 1YET_c.sd             Ligand coordinate file
+// 1koc_l.sd             Ligand coordinate file
+// 1YET_reference_out.sd Docked ligand poses
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef SDINDEXTEST_H_
+#define SDINDEXTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class SDIndexTest : public ::testing::Test {
+protected:
+  static const std::string _FILE_NAME;
+  // TextFixture methods
+  // Concatenates the input files into one SD file, with three records of
+  // the same title, and reads their offsets and titles sequentially
+  void SetUp() override;
+  void TearDown() override;
+
+  std::vector<std::size_t> m_offsets;
+  std::vector<std::string> m_titles;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*SDINDEXTEST_H_*/
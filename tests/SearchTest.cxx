@@ -1,17 +1,34 @@
 #include "SearchTest.h"
 #include "rxdock/BiMolWorkSpace.h"
+#include "rxdock/AromIdxSF.h"
+#include "rxdock/BaseAbortPredicate.h"
 #include "rxdock/CavityGridSF.h"
+#include "rxdock/ChromDihedralElement.h"
+#include "rxdock/ChromPositionElement.h"
+#include "rxdock/DockingError.h"
 #include "rxdock/GATransform.h"
+#include "rxdock/LBFGSTransform.h"
 #include "rxdock/MdlFileSink.h"
 #include "rxdock/MdlFileSource.h"
 #include "rxdock/PRMFactory.h"
+#include "rxdock/PolarIdxSF.h"
+#include "rxdock/PoseBatch.h"
+#include "rxdock/PoseClusterer.h"
+#include "rxdock/PoseRMSD.h"
+#include "rxdock/Population.h"
 #include "rxdock/RandPopTransform.h"
+#include "rxdock/RealGrid.h"
+#include "rxdock/ReceptorFlexData.h"
+#include "rxdock/SAIdxSF.h"
+#include "rxdock/SFFactory.h"
 #include "rxdock/SimAnnTransform.h"
 #include "rxdock/SimplexTransform.h"
 #include "rxdock/TransformAgg.h"
 #include "rxdock/VdwIdxSF.h"
 #include "rxdock/VdwIntraSF.h"
 
+#include <set>
+
 using namespace rxdock;
 using namespace rxdock::unittest;
 
@@ -63,6 +80,41 @@ void SearchTest::TearDown() {
   m_workSpace.SetNull();
 }
 
+namespace {
+
+// Abandons every run of the named transform once it is half done
+class HalfwayAbortPredicate : public BaseAbortPredicate {
+public:
+  HalfwayAbortPredicate(const std::string &strName)
+      : m_bAborted(false), m_strName(strName) {}
+  virtual bool isCheckDue(const BaseTransform *pTransform,
+                          double progress) const {
+    return pTransform->GetName() == m_strName && progress >= 0.5;
+  }
+  virtual bool Abort(const BaseTransform *pTransform, WorkSpace *pWorkSpace) {
+    m_bAborted = true;
+    return true;
+  }
+  bool m_bAborted;
+
+private:
+  std::string m_strName;
+};
+
+// Creates the attractive and repulsive polar terms of the standard indexed
+// scoring function
+SFAgg *CreatePolarSF() {
+  SFFactoryPtr spSFFactory(new SFFactory());
+  ParameterFileSourcePtr spSFSource(new ParameterFileSource(
+      GetDataFileName("data/sf", "intermolecular-indexed.json")));
+  // Parse the file first, as parsing resets the current section
+  spSFSource->GetTitle();
+  return spSFFactory->CreateAggFromFile(spSFSource, "polar",
+                                        "setup-polar,polar,repul");
+}
+
+} // namespace
+
 // RMSD calculation between two coordinate lists
 double SearchTest::rmsd(const CoordList &rc, const CoordList &c) {
   double retVal(0.0);
@@ -127,6 +179,327 @@ TEST_F(SearchTest, Simplex) {
   }
 }
 
+// 4a Run a sample L-BFGS minimisation; the score should never get worse
+TEST_F(SearchTest, LBFGS) {
+  TransformAggPtr spTransformAgg(new TransformAgg());
+  BaseTransform *pLBFGS = new LBFGSTransform();
+  pLBFGS->SetParameter(LBFGSTransform::_MAX_ITER, 50);
+  spTransformAgg->Add(pLBFGS);
+  m_workSpace->SetTransform(spTransformAgg);
+  double initScore = m_SF->Score();
+  try {
+    ASSERT_NO_THROW(m_workSpace->Run());
+  } catch (Error &e) {
+    std::cout << e.Message() << std::endl;
+  }
+  ASSERT_LE(m_SF->Score(), initScore);
+}
+
+// 4b Check the analytic vdW gradient against finite differences
+TEST_F(SearchTest, VdwGradient) {
+  BaseSF *pIntra = m_SF->GetSF(1);
+  AtomGradientMap gradients;
+  BaseSFList noGradList;
+  double score = pIntra->ScoreGradient(gradients, noGradList);
+  ASSERT_TRUE(noGradList.empty());
+  ASSERT_NEAR(score, pIntra->Score(), 1.0e-6);
+  ASSERT_FALSE(gradients.empty());
+  const double h = 1.0e-5;
+  for (const auto &gradient : gradients) {
+    Atom *pAtom = const_cast<Atom *>(gradient.first);
+    Coord c = pAtom->GetCoords();
+    for (int i = 0; i < 3; i++) {
+      Coord cPlus(c);
+      Coord cMinus(c);
+      cPlus.xyz(i) += h;
+      cMinus.xyz(i) -= h;
+      pAtom->SetCoords(cPlus);
+      double sPlus = pIntra->Score();
+      pAtom->SetCoords(cMinus);
+      double sMinus = pIntra->Score();
+      pAtom->SetCoords(c);
+      double g = (sPlus - sMinus) / (2.0 * h);
+      ASSERT_NEAR(gradient.second.xyz(i), g, 1.0e-3 * (1.0 + std::fabs(g)));
+    }
+  }
+}
+
+// 4b2 Check the analytic polar gradients, including the angular and lone pair
+// geometry of the interaction centers, against finite differences. The
+// ligand is turned and shifted slightly from the crystal pose so that more of
+// the angular terms are on their slopes
+TEST_F(SearchTest, PolarGradient) {
+  // The analytic polar gradient is only available without explicit solvent
+  m_workSpace->RemoveSolvent();
+  SFAggPtr spPolar(CreatePolarSF());
+  m_workSpace->SetSF(spPolar);
+  // The crystal pose makes hydrogen bonds
+  ASSERT_LT(spPolar->Score(), 0.0);
+  ModelPtr spLigand = m_workSpace->GetLigand();
+  AtomList ligAtomList = spLigand->GetAtomList();
+  CoordList coords;
+  GetCoordList(ligAtomList, coords);
+  Coord com = spLigand->GetCenterOfMass();
+  std::vector<Vector> moves(1, Vector(0.0, 0.0, 0.0));
+  for (int i = 0; i < 3; i++) {
+    Vector move(0.0, 0.0, 0.0);
+    move.xyz(i) = 0.3;
+    moves.push_back(move);
+    moves.push_back(-move);
+  }
+  const double h = 1.0e-5;
+  // Each move is used both as a shift and as the axis of a 0.2 radian turn
+  // about the center of mass
+  for (const auto &rotation : moves) {
+    for (const auto &shift : moves) {
+      TranslateAtoms(ligAtomList, -com);
+      if (rotation.Length() > 0.0) {
+        RotateAtomsUsingQuat(ligAtomList, Quat(rotation.Unit(), 0.2));
+      }
+      TranslateAtoms(ligAtomList, com + shift);
+      spLigand->UpdatePseudoAtoms();
+      AtomGradientMap gradients;
+      BaseSFList noGradList;
+      double score = spPolar->ScoreGradient(gradients, noGradList);
+      ASSERT_TRUE(noGradList.empty());
+      ASSERT_NEAR(score, spPolar->Score(), 1.0e-6);
+      for (const auto &gradient : gradients) {
+        Atom *pAtom = const_cast<Atom *>(gradient.first);
+        Model *pModel = pAtom->GetModelPtr();
+        Coord c = pAtom->GetCoords();
+        for (int i = 0; i < 3; i++) {
+          Coord cPlus(c);
+          Coord cMinus(c);
+          cPlus.xyz(i) += h;
+          cMinus.xyz(i) -= h;
+          pAtom->SetCoords(cPlus);
+          pModel->UpdatePseudoAtoms();
+          double sPlus = spPolar->Score();
+          pAtom->SetCoords(cMinus);
+          pModel->UpdatePseudoAtoms();
+          double sMinus = spPolar->Score();
+          pAtom->SetCoords(c);
+          pModel->UpdatePseudoAtoms();
+          double g = (sPlus - sMinus) / (2.0 * h);
+          ASSERT_NEAR(gradient.second.xyz(i), g,
+                      1.0e-3 * (1.0 + std::fabs(g)));
+        }
+      }
+      for (std::size_t i = 0; i < ligAtomList.size(); i++) {
+        ligAtomList[i]->SetCoords(coords[i]);
+      }
+      spLigand->UpdatePseudoAtoms();
+    }
+  }
+}
+
+// 4b3 Check the projection of the analytic vdW and polar gradients onto the
+// ligand position and dihedral angles against finite differences of the score
+TEST_F(SearchTest, ChromGradient) {
+  // The analytic gradients are only available without explicit solvent
+  m_workSpace->RemoveSolvent();
+  m_SF->Add(CreatePolarSF());
+  m_workSpace->SetSF(m_SF);
+  ModelPtr spLigand = m_workSpace->GetLigand();
+  ChromElementPtr spPosition(new ChromPositionElement(
+      spLigand, m_workSpace->GetDockingSite(), 1.0, 0.1));
+  ChromElementPtr spDihedrals(new Chrom());
+  BondList rotBondList = GetRotatableBondList(spLigand->GetBondList());
+  ASSERT_FALSE(rotBondList.empty());
+  for (const auto &spBond : rotBondList) {
+    spDihedrals->Add(new ChromDihedralElement(spBond, AtomList(), 30.0));
+  }
+  // The indexed receptor atom lists make the score slightly discontinuous
+  // when the whole ligand moves, so use a small step for the position. The
+  // dihedral elements ignore changes below 0.001 degrees
+  std::vector<std::pair<ChromElementPtr, double>> chromSteps = {
+      {spPosition, 1.0e-5}, {spDihedrals, 1.0e-2}};
+  for (const auto &chromStep : chromSteps) {
+    ChromElementPtr spChrom = chromStep.first;
+    const double h = chromStep.second;
+    spChrom->SyncToModel();
+    AtomGradientMap gradients;
+    BaseSFList noGradList;
+    m_SF->ScoreGradient(gradients, noGradList);
+    ASSERT_TRUE(noGradList.empty());
+    std::vector<double> g;
+    std::vector<bool> bProjected;
+    spChrom->GetGradientVector(gradients, g, bProjected);
+    std::vector<double> v;
+    spChrom->GetVector(v);
+    ASSERT_EQ(g.size(), v.size());
+    for (std::size_t k = 0; k < v.size(); k++) {
+      ASSERT_TRUE(bProjected[k]);
+      std::vector<double> vh(v);
+      vh[k] = v[k] + h;
+      spChrom->SetVector(vh);
+      spChrom->SyncToModel();
+      double sPlus = m_SF->Score();
+      vh[k] = v[k] - h;
+      spChrom->SetVector(vh);
+      spChrom->SyncToModel();
+      double sMinus = m_SF->Score();
+      spChrom->SetVector(v);
+      spChrom->SyncToModel();
+      double gh = (sPlus - sMinus) / (2.0 * h);
+      ASSERT_NEAR(g[k], gh, 1.0e-2 * (1.0 + std::fabs(gh)));
+    }
+  }
+}
+
+// 4c Check that batched scoring matches scoring one pose at a time, and that
+// the models are left in their original pose
+TEST_F(SearchTest, ScoreBatch) {
+  ModelPtr spLigand = m_workSpace->GetLigand();
+  AtomList atomList = spLigand->GetAtomList();
+  CoordList coords;
+  GetCoordList(atomList, coords);
+  PoseBatch poses(ModelList(1, spLigand), 4);
+  std::vector<double> scores;
+  for (std::size_t i = 0; i < poses.GetNumPoses(); i++) {
+    TranslateAtoms(atomList, Vector(0.3 * i, -0.2, 0.1));
+    poses.SetPose(i);
+    scores.push_back(m_SF->Score());
+  }
+  for (std::size_t i = 0; i < atomList.size(); i++) {
+    atomList[i]->SetCoords(coords[i]);
+  }
+  std::vector<double> batchScores(poses.GetNumPoses());
+  m_SF->ScoreBatch(poses, batchScores.data());
+  for (std::size_t i = 0; i < poses.GetNumPoses(); i++) {
+    ASSERT_NEAR(batchScores[i], scores[i], 1.0e-9);
+  }
+  CoordList finalCoords;
+  GetCoordList(atomList, finalCoords);
+  ASSERT_EQ(rmsd(coords, finalCoords), 0.0);
+}
+
+// 4c2 Check that the batched scores of receptor ensemble poses match scoring
+// one pose at a time, i.e. that each pose is scored against the receptor
+// conformer it was created with
+TEST_F(SearchTest, EnsembleScoreBatch) {
+  ModelPtr spReceptor = m_workSpace->GetReceptor();
+  AtomList recepAtomList = spReceptor->GetAtomList();
+  spReceptor->SaveCoords("conformer-1");
+  TranslateAtoms(recepAtomList, Vector(2.0, -1.5, 1.0));
+  spReceptor->SaveCoords("conformer-2");
+  ASSERT_EQ(spReceptor->GetNumSavedCoords(), 3);
+  FlexData *pFlexData = new ReceptorFlexData(m_workSpace->GetDockingSite());
+  pFlexData->SetParameter(ReceptorFlexData::_FLEX_DISTANCE, 0.0);
+  pFlexData->SetParameter(ReceptorFlexData::_CONFORMER_STEP, 0.5);
+  spReceptor->SetFlexData(pFlexData);
+  // Re-index the receptor conformers in the scoring function
+  m_workSpace->SetReceptor(ModelPtr());
+  m_workSpace->SetReceptor(spReceptor);
+  ChromElementPtr spChrom(new Chrom());
+  spChrom->Add(m_workSpace->GetLigand()->GetChrom());
+  spChrom->Add(spReceptor->GetChrom());
+  Population pop(spChrom, 20, m_SF);
+  GenomeList genomes = pop.GetGenomeList();
+  // The poses are batched as they are scored, as the pose a chromosome syncs
+  // to can depend slightly on the previous pose of the model
+  ModelList modelList;
+  for (const auto &spModel : m_workSpace->GetModels()) {
+    if (!spModel.Null()) {
+      modelList.push_back(spModel);
+    }
+  }
+  PoseBatch poses(modelList, genomes.size());
+  std::vector<double> scores(genomes.size());
+  std::set<int> conformers;
+  for (std::size_t i = 0; i < genomes.size(); i++) {
+    genomes[i]->GetChrom()->SyncToModel();
+    conformers.insert(spReceptor->GetCurrentCoords());
+    scores[i] = m_SF->Score();
+    poses.SetPose(i);
+  }
+  ASSERT_EQ(conformers.size(), 2);
+  std::vector<double> batchScores(genomes.size());
+  m_SF->ScoreBatch(poses, batchScores.data());
+  for (std::size_t i = 0; i < genomes.size(); i++) {
+    ASSERT_NEAR(batchScores[i], scores[i], 1.0e-9);
+  }
+}
+
+// 4c3 Check that each sampled receptor conformer is indexed on its own, i.e.
+// that the ligand scores the same against each conformer as it does against
+// the rigid receptor in the coords of that conformer
+TEST_F(SearchTest, EnsembleConformerScore) {
+  m_workSpace->RemoveSolvent();
+  SFAggPtr spSF(new SFAgg(GetMetaDataPrefix() + "score"));
+  spSF->Add(new VdwIdxSF("inter.vdw"));
+  // The ranges used by the indexed scoring function files, which fit in the
+  // docking site border
+  BaseSF *sfPolar = new PolarIdxSF("inter.polar");
+  sfPolar->SetRange(5.31);
+  spSF->Add(sfPolar);
+  BaseSF *sfArom = new AromIdxSF("inter.arom");
+  sfArom->SetRange(4.1);
+  spSF->Add(sfArom);
+  spSF->Add(new SAIdxSF("inter.solv"));
+  m_workSpace->SetSF(spSF);
+  ModelPtr spReceptor = m_workSpace->GetReceptor();
+  AtomList recepAtomList = spReceptor->GetAtomList();
+  Vector shift(0.6, -0.4, 0.3);
+  // Score the rigid receptor, before and after shifting it. The flexible
+  // groups are removed, as the sampled conformers are rigid
+  spReceptor->SetFlexData(nullptr);
+  m_workSpace->SetReceptor(ModelPtr());
+  m_workSpace->SetReceptor(spReceptor);
+  double rigidScore1 = spSF->Score();
+  TranslateAtoms(recepAtomList, shift);
+  m_workSpace->SetReceptor(ModelPtr());
+  m_workSpace->SetReceptor(spReceptor);
+  double rigidScore2 = spSF->Score();
+  ASSERT_GT(std::fabs(rigidScore2 - rigidScore1), 1.0e-3);
+  // Save the shifted receptor as the second conformer of an ensemble
+  TranslateAtoms(recepAtomList, -shift);
+  spReceptor->SaveCoords("conformer-1");
+  TranslateAtoms(recepAtomList, shift);
+  spReceptor->SaveCoords("conformer-2");
+  FlexData *pFlexData = new ReceptorFlexData(m_workSpace->GetDockingSite());
+  pFlexData->SetParameter(ReceptorFlexData::_FLEX_DISTANCE, 0.0);
+  spReceptor->SetFlexData(pFlexData);
+  ASSERT_TRUE(spReceptor->isConformerSampled());
+  // Re-index the receptor conformers in the scoring function
+  m_workSpace->SetReceptor(ModelPtr());
+  m_workSpace->SetReceptor(spReceptor);
+  spReceptor->SetCurrentConformer(1);
+  ASSERT_NEAR(spSF->Score(), rigidScore1, 1.0e-6);
+  spReceptor->SetCurrentConformer(2);
+  ASSERT_NEAR(spSF->Score(), rigidScore2, 1.0e-6);
+}
+
+// 4d Check that batched grid interpolation adds the same values and
+// gradients as interpolating one point at a time, inside and outside the grid
+TEST_F(SearchTest, SmoothedValues) {
+  RealGrid grid(Coord(-1.0, 0.0, 1.0), Coord(0.5, 0.4, 0.3), 8, 7, 6, 1);
+  for (unsigned int i = 0; i < grid.GetN(); i++) {
+    grid.SetValue(i, std::sin(0.37 * i) + 0.01 * i);
+  }
+  const std::size_t n = 50;
+  std::vector<double> x(n), y(n), z(n);
+  for (std::size_t i = 0; i < n; i++) {
+    x[i] = -2.0 + 0.13 * i;
+    y[i] = -0.5 + 0.07 * i;
+    z[i] = 0.5 + 0.05 * i;
+  }
+  std::vector<double> values(n, 1.0), gx(n, 1.0), gy(n, 1.0), gz(n, 1.0);
+  grid.AddSmoothedValues(n, x.data(), y.data(), z.data(), values.data());
+  std::vector<double> gValues(n, 0.0);
+  grid.AddSmoothedValues(n, x.data(), y.data(), z.data(), gValues.data(),
+                         gx.data(), gy.data(), gz.data());
+  for (std::size_t i = 0; i < n; i++) {
+    Coord c(x[i], y[i], z[i]);
+    ASSERT_EQ(values[i], 1.0 + grid.GetSmoothedValue(c));
+    Vector g;
+    ASSERT_EQ(gValues[i], grid.GetSmoothedValueGradient(c, g));
+    ASSERT_EQ(gx[i], 1.0 + g.xyz(0));
+    ASSERT_EQ(gy[i], 1.0 + g.xyz(1));
+    ASSERT_EQ(gz[i], 1.0 + g.xyz(2));
+  }
+}
+
 // 5 Run a sample simulated annealing
 TEST_F(SearchTest, SimAnn) {
   BaseTransform *pSimAnn = new SimAnnTransform();
@@ -146,6 +519,109 @@ TEST_F(SearchTest, SimAnn) {
   delete pSimAnn;
 }
 
+// 5a Check that poses are clustered by heavy atom RMSD, and that only
+// repeated poses near the best one count as converged
+TEST_F(SearchTest, PoseClusterer) {
+  AtomList atomList = m_workSpace->GetLigand()->GetAtomList();
+  PoseClusterer clusterer(1.0, 1.0);
+  clusterer.SetAtoms(atomList);
+  ASSERT_EQ(clusterer.AddPose(-10.0), 0);
+  ASSERT_EQ(clusterer.GetNumConverged(), 0);
+  // Small shift, same cluster and score within the window
+  TranslateAtoms(atomList, Vector(0.5, 0.0, 0.0));
+  ASSERT_EQ(clusterer.AddPose(-9.5), 0);
+  ASSERT_EQ(clusterer.GetNumConverged(), 1);
+  // Large shift with a better score, new best cluster
+  TranslateAtoms(atomList, Vector(5.0, 0.0, 0.0));
+  ASSERT_EQ(clusterer.AddPose(-20.0), 1);
+  ASSERT_EQ(clusterer.GetNumConverged(), 0);
+  ASSERT_EQ(clusterer.GetBestCluster(), 1);
+  ASSERT_EQ(clusterer.AddPose(-19.5), 1);
+  ASSERT_EQ(clusterer.GetNumConverged(), 1);
+  // Same pose, but outside the score window
+  ASSERT_EQ(clusterer.AddPose(-15.0), 1);
+  ASSERT_EQ(clusterer.GetNumConverged(), 0);
+  ASSERT_EQ(clusterer.GetNumClusters(), 2);
+  ASSERT_EQ(clusterer.GetClusterSize(0), 2);
+  ASSERT_EQ(clusterer.GetClusterSize(1), 3);
+}
+
+// 5b Check that a GA run is abandoned by the abort predicate, and that
+// other transforms are unaffected
+TEST_F(SearchTest, AbortPredicate) {
+  TransformAggPtr spTransformAgg(new TransformAgg());
+  BaseTransform *pRandPop = new RandPopTransform();
+  BaseTransform *pGA = new GATransform();
+  spTransformAgg->Add(pRandPop);
+  spTransformAgg->Add(pGA);
+  m_workSpace->SetTransform(spTransformAgg);
+  HalfwayAbortPredicate *pAbort = new HalfwayAbortPredicate(pGA->GetName());
+  m_workSpace->SetAbortPredicate(pAbort);
+  ASSERT_THROW(m_workSpace->Run(), DockingAbort);
+  ASSERT_TRUE(pAbort->m_bAborted);
+  // Predicate only applies to the GA
+  m_workSpace->SetAbortPredicate(new HalfwayAbortPredicate("NoSuchTransform"));
+  ASSERT_NO_THROW(m_workSpace->Run());
+}
+
+// 5c Check the symmetry corrected RMSD: symmetry related, translated and
+// superposed poses of a ligand with two pairs of equivalent guanidinium
+// nitrogens
+TEST_F(SearchTest, PoseRMSD) {
+  MolecularFileSourcePtr spSource(new MdlFileSource(
+      GetDataFileName("", "1koc_l.sd"), false, false, false));
+  ModelPtr spLigand(new Model(spSource));
+  PoseRMSD poseRMSD(*spLigand);
+  ASSERT_EQ(poseRMSD.GetNumSymmetries(), 4u);
+  ASSERT_TRUE(poseRMSD.isComplete());
+  std::vector<double> refCoords;
+  ASSERT_TRUE(poseRMSD.GetCoords(*spLigand, refCoords));
+  ASSERT_EQ(refCoords.size(), 3 * poseRMSD.GetNumAtoms());
+  ASSERT_NEAR(poseRMSD.RMSD(refCoords.data()), 0.0, 1.0e-9);
+
+  std::size_t n = poseRMSD.GetNumAtoms();
+  std::vector<double> coords(3 * n);
+  for (std::size_t iSym = 0; iSym < poseRMSD.GetNumSymmetries(); iSym++) {
+    const std::vector<std::size_t> &symmetry = poseRMSD.GetSymmetry(iSym);
+    for (std::size_t i = 0; i < n; i++) {
+      for (int k = 0; k < 3; k++) {
+        coords[3 * i + k] = refCoords[3 * symmetry[i] + k];
+      }
+    }
+    ASSERT_NEAR(poseRMSD.RMSD(coords.data()), 0.0, 1.0e-9);
+  }
+
+  for (std::size_t i = 0; i < n; i++) {
+    coords[3 * i] = refCoords[3 * i] + 1.0;
+    coords[3 * i + 1] = refCoords[3 * i + 1];
+    coords[3 * i + 2] = refCoords[3 * i + 2];
+  }
+  ASSERT_NEAR(poseRMSD.RMSD(coords.data()), 1.0, 1.0e-9);
+  ASSERT_NEAR(poseRMSD.RMSD(refCoords.data(), coords.data()), 1.0, 1.0e-9);
+
+  Quat rot(Vector(0.3, -1.0, 0.5), 1.2);
+  for (std::size_t i = 0; i < n; i++) {
+    Coord c = rot.Rotate(Coord(refCoords[3 * i], refCoords[3 * i + 1],
+                               refCoords[3 * i + 2])) +
+              Vector(2.0, -1.0, 0.5);
+    coords[3 * i] = c.xyz(0);
+    coords[3 * i + 1] = c.xyz(1);
+    coords[3 * i + 2] = c.xyz(2);
+  }
+  ASSERT_GT(poseRMSD.RMSD(coords.data()), 1.0);
+  Quat q;
+  Vector t;
+  ASSERT_NEAR(poseRMSD.FitRMSD(coords.data(), &q, &t), 0.0, 1.0e-6);
+  for (std::size_t i = 0; i < n; i++) {
+    Coord c = q.Rotate(Coord(coords[3 * i], coords[3 * i + 1],
+                             coords[3 * i + 2])) +
+              t;
+    ASSERT_NEAR(c.xyz(0), refCoords[3 * i], 1.0e-6);
+    ASSERT_NEAR(c.xyz(1), refCoords[3 * i + 1], 1.0e-6);
+    ASSERT_NEAR(c.xyz(2), refCoords[3 * i + 2], 1.0e-6);
+  }
+}
+
 // 6 Check we can reload solvent coords from ligand SD file
 TEST_F(SearchTest, Restart) {
   TransformAggPtr spTransformAgg(new TransformAgg());
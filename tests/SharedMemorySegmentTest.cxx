@@ -0,0 +1,88 @@
+#include "SharedMemorySegmentTest.h"
+#include "rxdock/SharedMemorySegment.h"
+
+#include <cstring>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void SharedMemorySegmentTest::SetUp() {
+  const ::testing::TestInfo *pInfo =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+  m_strName = std::string("rxdock-unittest-") + pInfo->name() + "-" +
+              std::to_string(getpid());
+}
+
+// Makes sure nothing is left behind if a test fails half way through
+void SharedMemorySegmentTest::TearDown() {
+  SharedMemorySegment::Remove(m_strName);
+}
+
+#ifndef _WIN32
+// 1 Data written by the creator is visible to a process attaching later, and
+// the name cannot be created twice while the segment is in use
+TEST_F(SharedMemorySegmentTest, AttachAndReuse) {
+  const char data[] = "shared grid data";
+  SharedMemorySegmentPtr spCreated =
+      SharedMemorySegment::Create(m_strName, sizeof(data));
+  ASSERT_TRUE(spCreated);
+  ASSERT_NE(spCreated->GetWritableData(), nullptr);
+  std::memcpy(spCreated->GetWritableData(), data, sizeof(data));
+  // Unpublished segments are not attached to
+  EXPECT_FALSE(SharedMemorySegment::Attach(m_strName));
+  spCreated->Publish();
+
+  SharedMemorySegmentPtr spAttached = SharedMemorySegment::Attach(m_strName);
+  ASSERT_TRUE(spAttached);
+  EXPECT_EQ(spAttached->GetSize(), sizeof(data));
+  EXPECT_EQ(spAttached->GetWritableData(), nullptr);
+  EXPECT_STREQ(spAttached->GetData(), data);
+  EXPECT_FALSE(SharedMemorySegment::Create(m_strName, sizeof(data)));
+
+  // The creator detaching leaves the segment in place for the others
+  spCreated.reset();
+  SharedMemorySegmentPtr spReused = SharedMemorySegment::Attach(m_strName);
+  ASSERT_TRUE(spReused);
+  EXPECT_STREQ(spReused->GetData(), data);
+}
+
+// 2 The last one to detach removes the segment
+TEST_F(SharedMemorySegmentTest, RemovedOnLastDetach) {
+  SharedMemorySegmentPtr spCreated = SharedMemorySegment::Create(m_strName, 8);
+  ASSERT_TRUE(spCreated);
+  spCreated->Publish();
+  SharedMemorySegmentPtr spAttached = SharedMemorySegment::Attach(m_strName);
+  ASSERT_TRUE(spAttached);
+  spCreated.reset();
+  spAttached.reset();
+  EXPECT_FALSE(SharedMemorySegment::Attach(m_strName));
+  // The name is free again
+  EXPECT_TRUE(SharedMemorySegment::Create(m_strName, 8));
+}
+
+// 3 A segment whose creator died before publishing it is removed by the next
+// process waiting for it, which can then create it
+TEST_F(SharedMemorySegmentTest, RemovedIfCreatorDied) {
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // Exits without detaching, as a crashed creator would
+    SharedMemorySegmentPtr spCreated =
+        SharedMemorySegment::Create(m_strName, 8);
+    _exit(spCreated ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+  // Too young to be taken for an orphan
+  EXPECT_FALSE(SharedMemorySegment::Attach(m_strName));
+  EXPECT_FALSE(SharedMemorySegment::Create(m_strName, 8));
+  // Removed well before the timeout
+  EXPECT_FALSE(SharedMemorySegment::Attach(m_strName, 600.0));
+  EXPECT_TRUE(SharedMemorySegment::Create(m_strName, 8));
+}
+#endif
@@ -0,0 +1,29 @@
+// Unit tests for SharedMemorySegment
+//
+// Each test uses a segment name unique to the test process, so that tests can
+// run concurrently on the same node
+#ifndef SHAREDMEMORYSEGMENTTEST_H_
+#define SHAREDMEMORYSEGMENTTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class SharedMemorySegmentTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  std::string m_strName; // Segment name for the current test
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*SHAREDMEMORYSEGMENTTEST_H_*/
@@ -0,0 +1,111 @@
+#include "TransformTest.h"
+#include "rxdock/operation/Transform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string TransformTest::_INPUT_FILE = "transform-in.sd";
+const std::string TransformTest::_OUTPUT_FILE = "transform-out.sd";
+const std::size_t TransformTest::_NUM_MOLECULES = 7;
+const std::size_t TransformTest::_NUM_RECORDS = 50;
+
+void TransformTest::SetUp() {
+  std::ofstream inFile(_INPUT_FILE);
+  for (std::size_t i = 0; i < _NUM_RECORDS; i++) {
+    inFile << GetMoleculeName(i) << "\n\n\n"
+           << "  0  0  0  0  0  0  0  0  0  0999 V2000\nM  END\n"
+           << ">  <rxdock.score>\n"
+           << GetScore(i) << "\n\n"
+           << ">  <index>\n"
+           << i << "\n\n$$$$\n";
+  }
+}
+
+void TransformTest::TearDown() {
+  std::remove(_INPUT_FILE.c_str());
+  std::remove(_OUTPUT_FILE.c_str());
+}
+
+double TransformTest::GetScore(std::size_t i) {
+  // Some ties, so that the input order matters
+  return -static_cast<double>((i * 17) % 23);
+}
+
+std::string TransformTest::GetMoleculeName(std::size_t i) {
+  return "MOL" + std::to_string(i % _NUM_MOLECULES);
+}
+
+std::vector<std::size_t> TransformTest::ReadOutputIndices() {
+  std::ifstream outFile(_OUTPUT_FILE);
+  std::vector<std::size_t> indices;
+  std::string line;
+  while (std::getline(outFile, line)) {
+    if (line == ">  <index>" && std::getline(outFile, line)) {
+      indices.push_back(std::stoul(line));
+    }
+  }
+  return indices;
+}
+
+bool TransformTest::HasTempFiles() {
+  for (const std::string &suffix : {".run0", ".molecules.run0"}) {
+    if (std::ifstream(_OUTPUT_FILE + suffix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 1 Keep the 2 best scoring records of each molecule, and the best 9 of those
+// overall, with a sort buffer of 4 records
+TEST_F(TransformTest, SortedLimitPerMoleculeSpills) {
+  const std::size_t maxPerMolecule = 2;
+  const std::size_t maxRecords = 9;
+  ASSERT_EQ(operation::transform(_INPUT_FILE, _OUTPUT_FILE, true,
+                                 maxPerMolecule, false, "", false, "", "",
+                                 false, "", 4, true, "rxdock.score", true,
+                                 maxRecords),
+            EXIT_SUCCESS);
+
+  // Brute force: sort by score then input order, and apply the limits
+  std::vector<std::size_t> sorted(_NUM_RECORDS);
+  for (std::size_t i = 0; i < _NUM_RECORDS; i++) {
+    sorted[i] = i;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](std::size_t a, std::size_t b) {
+                     return GetScore(a) < GetScore(b);
+                   });
+  std::map<std::string, std::size_t> nPerMolecule;
+  std::vector<std::size_t> expected;
+  for (std::size_t i : sorted) {
+    if (expected.size() < maxRecords &&
+        nPerMolecule[GetMoleculeName(i)]++ < maxPerMolecule) {
+      expected.push_back(i);
+    }
+  }
+  ASSERT_EQ(ReadOutputIndices(), expected);
+  ASSERT_FALSE(HasTempFiles());
+}
+
+// 2 Without sorting, the first 3 records of each molecule are kept in input
+// order, with a sort buffer of 5 records
+TEST_F(TransformTest, UnsortedLimitPerMoleculeSpills) {
+  const std::size_t maxPerMolecule = 3;
+  ASSERT_EQ(operation::transform(_INPUT_FILE, _OUTPUT_FILE, true,
+                                 maxPerMolecule, false, "", false, "", "",
+                                 false, "", 5, false, "", false, 0),
+            EXIT_SUCCESS);
+  std::vector<std::size_t> expected;
+  for (std::size_t i = 0; i < maxPerMolecule * _NUM_MOLECULES; i++) {
+    expected.push_back(i);
+  }
+  ASSERT_EQ(ReadOutputIndices(), expected);
+  ASSERT_FALSE(HasTempFiles());
+}
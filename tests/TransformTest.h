@@ -0,0 +1,42 @@
+// Unit tests for the SD file transformation (rxcmd transform)
+//
+// The input files are written by the tests themselves, and are small, so a
+// tiny sort buffer is used to exercise the spilling to, and merging of,
+// sorted runs
+#ifndef TRANSFORMTEST_H_
+#define TRANSFORMTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class TransformTest : public ::testing::Test {
+protected:
+  static const std::string _INPUT_FILE;
+  static const std::string _OUTPUT_FILE;
+  static const std::size_t _NUM_MOLECULES;
+  static const std::size_t _NUM_RECORDS;
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Helper functions
+  // Score of input record i; records of each molecule are interleaved
+  static double GetScore(std::size_t i);
+  static std::string GetMoleculeName(std::size_t i);
+  // Input indices of the records in the output file, in order
+  std::vector<std::size_t> ReadOutputIndices();
+  // Whether the transform left any of its temporary files behind
+  bool HasTempFiles();
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*TRANSFORMTEST_H_*/
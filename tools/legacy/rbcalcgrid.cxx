@@ -15,9 +15,12 @@
 #include "rxdock/BiMolWorkSpace.h"
 #include "rxdock/PRMFactory.h"
 #include "rxdock/ParameterFileSource.h"
+#include "rxdock/PoseBatch.h"
 #include "rxdock/RealGrid.h"
 #include "rxdock/SFFactory.h"
 #include "rxdock/TriposAtomType.h"
+#include "rxdock/VdwGridSF.h"
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
@@ -196,24 +199,19 @@ int main(int argc, char *argv[]) {
     spRecepPrmSource->SetSection();
     PRMFactory prmFactory(spRecepPrmSource);
     ModelPtr spReceptor = prmFactory.CreateReceptor();
-    // Trap multiple receptor conformations here: this SF does not support them
-    // yet
+    // Trap multiple receptor conformations here unless they are sampled, in
+    // which case each conformer gets its own grid file
     bool bEnsemble = (spReceptor->GetNumSavedCoords() > 1);
-    if (bEnsemble) {
-      std::string message(
-          "rbcalcgrid does not support multiple receptor conformations yet");
+    bool bSampled = spReceptor->isConformerSampled();
+    if (bEnsemble && !bSampled) {
+      std::string message("rbcalcgrid does not support multiple receptor "
+                          "conformations that are not sampled yet");
       throw InvalidRequest(_WHERE_, message);
     }
 
     // Read docking site from file and register with workspace
-    std::string strDockingSiteFile = spWS->GetName() + ".as";
-    std::string strInputFile =
-        GetDataFileName("data/grids", strDockingSiteFile);
-    std::ifstream inputFile(strInputFile.c_str());
-    json siteData;
-    inputFile >> siteData;
-    inputFile.close();
-    DockingSitePtr spDS(new DockingSite(siteData.at("docking-site")));
+    DockingSitePtr spDS =
+        ReadDockingSite(GetDockingSiteFileName(spWS->GetName()));
     spWS->SetDockingSite(spDS);
 
     // Register receptor with workspace
@@ -239,41 +237,60 @@ int main(int argc, char *argv[]) {
     // Create probes
     ModelList probes = CreateProbes();
 
-    // Open output file
-    std::string strOutputFile(spWS->GetName() + strSuffix);
-    std::ofstream ostr(strOutputFile.c_str(),
-                       std::ios_base::out | std::ios_base::trunc);
+    int nConformers = bSampled ? spReceptor->GetNumSavedCoords() - 1 : 0;
+    for (int iConformer = bSampled ? 1 : 0; iConformer <= nConformers;
+         iConformer++) {
+      if (bSampled) {
+        std::cout << "Receptor conformer #" << iConformer << std::endl;
+        spReceptor->SetCurrentConformer(iConformer);
+      }
+      // Open output file
+      std::string strOutputFile(
+          VdwGridSF::GetGridFileName(spWS->GetName(), strSuffix, iConformer));
+      std::ofstream ostr(strOutputFile.c_str(),
+                         std::ios_base::out | std::ios_base::trunc);
 
-    json gridList;
+      json gridList;
 
-    // Store regular pointers to avoid smart pointer dereferencing overheads
-    RealGrid *pGrid(spGrid);
-    SFAgg *pSF(spSF);
-    TriposAtomType triposType;
-    // Main loop over each probe model
-    for (ModelListConstIter mIter = probes.begin(); mIter != probes.end();
-         mIter++) {
-      ModelPtr spLigand(*mIter);
-      Atom *pAtom = spLigand->GetAtomList().front();
-      TriposAtomType::eType atomType = pAtom->GetTriposType();
-      std::string strType = triposType.Type2Str(atomType);
-      std::cout << "Atom type=" << strType << std::endl;
-      // Register ligand with workspace
-      spWS->SetLigand(spLigand);
-      pGrid->SetAllValues(0.0);
-      // Loop over all grid coords and calculate the score at each position
-      for (unsigned int i = 0; i < spGrid->GetN(); i++) {
-        pAtom->SetCoords(pGrid->GetCoord(i));
-        gridData[i] = pSF->Score();
+      // Store regular pointers to avoid smart pointer dereferencing overheads
+      RealGrid *pGrid(spGrid);
+      SFAgg *pSF(spSF);
+      TriposAtomType triposType;
+      // Main loop over each probe model
+      for (ModelListConstIter mIter = probes.begin(); mIter != probes.end();
+           mIter++) {
+        ModelPtr spLigand(*mIter);
+        Atom *pAtom = spLigand->GetAtomList().front();
+        TriposAtomType::eType atomType = pAtom->GetTriposType();
+        std::string strType = triposType.Type2Str(atomType);
+        std::cout << "Atom type=" << strType << std::endl;
+        // Register ligand with workspace
+        spWS->SetLigand(spLigand);
+        pGrid->SetAllValues(0.0);
+        // Loop over all grid coords and calculate the score at each position.
+        // The probe positions are scored in batches
+        const unsigned int nBatch = 4096;
+        PoseBatch poses(ModelList(1, spLigand), nBatch);
+        std::vector<double> scores(nBatch);
+        for (unsigned int i = 0; i < spGrid->GetN(); i += nBatch) {
+          unsigned int n = std::min(nBatch, spGrid->GetN() - i);
+          poses.SetNumPoses(n);
+          for (unsigned int j = 0; j < n; j++) {
+            pAtom->SetCoords(pGrid->GetCoord(i + j));
+            poses.SetPose(j);
+          }
+          pSF->ScoreBatch(poses, scores.data());
+          std::copy(scores.begin(), scores.begin() + n, gridData + i);
+        }
+        // Write the atom type string to the grid file, before the grid itself
+        json grid{{"tripos-type", strType}, {"real-grid", *pGrid}};
+        gridList.push_back(grid);
       }
-      // Write the atom type string to the grid file, before the grid itself
-      json grid{{"tripos-type", strType}, {"real-grid", *pGrid}};
-      gridList.push_back(grid);
+      json vdwGrids;
+      vdwGrids["vdw-grids"] = gridList;
+      ostr << vdwGrids;
+      ostr.close();
     }
-    json vdwGrids;
-    vdwGrids["vdw-grids"] = gridList;
-    ostr << vdwGrids;
-    ostr.close();
   } catch (Error &e) {
     std::cout << e.what() << std::endl;
   } catch (...) {
@@ -181,14 +181,8 @@ int main(int argc, char *argv[]) {
       ModelPtr spReceptor = prmFactory.CreateReceptor();
 
       // Read docking site from file and register with workspace
-      std::string strDockingSiteFile = spWS->GetName() + ".as";
-      std::string strInputFile =
-          GetDataFileName("data/grids", strDockingSiteFile);
-      std::ifstream inputFile(strInputFile);
-      json siteData;
-      inputFile >> siteData;
-      inputFile.close();
-      DockingSitePtr spDS(new DockingSite(siteData["docking-site"]));
+      DockingSitePtr spDS =
+          ReadDockingSite(GetDockingSiteFileName(spWS->GetName()));
       spWS->SetDockingSite(spDS);
 
       // Register receptor with workspace
@@ -32,14 +32,27 @@ int rxdock::parseDock(int argc, char *argv[]) {
   cxxopts::OptionAdder adder = options.add_options();
   adder("i,input", "Input ligand structure-data file (SDfile) name",
         cxxopts::value<std::string>());
+  adder("start-record",
+        "First ligand record to dock, counting from zero (uses the index of "
+        "the input file, which is built on first use)",
+        cxxopts::value<std::size_t>());
+  adder("end-record", "Ligand record to stop before, counting from zero",
+        cxxopts::value<std::size_t>());
+  adder("ligand-names", "Dock only the ligand records with these titles",
+        cxxopts::value<std::vector<std::string>>());
   adder("o,output", "Output docked ligand structure-data file (SDfile) name",
         cxxopts::value<std::string>());
   adder("output-crd", "Output receptor CRD file name",
         cxxopts::value<std::string>());
   adder("output-history", "History structure-data file (SDfile) name prefix",
         cxxopts::value<std::string>());
-  adder("r,receptor-param", "Receptor parameters file",
+  adder("output-table",
+        "Columnar results table file name (one row of scores per output pose)",
         cxxopts::value<std::string>());
+  adder("r,receptor-param",
+        "Receptor parameters file(s); with several, each ligand is prepared "
+        "once and docked against every receptor",
+        cxxopts::value<std::vector<std::string>>());
   adder("p,docking-param", "Docking protocol parameters file",
         cxxopts::value<std::string>());
   adder("n,number", "Number of runs per ligand (0 = unlimited)",
@@ -54,8 +67,24 @@ int rxdock::parseDock(int argc, char *argv[]) {
   adder("c,continue",
         "Continue if score threshold is met instead of terminating ligand");
   adder("f,filter", "Filter file name", cxxopts::value<std::string>());
+  adder("converge",
+        "Stop ligand after this many consecutive runs converge on the best "
+        "pose (0 = never)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("cluster-rmsd",
+        "Heavy atom RMSD threshold for clustering poses of a ligand",
+        cxxopts::value<double>()->default_value("2.0"));
+  adder("cluster-score-window",
+        "Score window above the best pose within which a run converges",
+        cxxopts::value<double>()->default_value("1.0"));
   adder("s,seed", "Random number seed to use instead of std::random_device",
         cxxopts::value<std::size_t>());
+  adder("receptor-cache",
+        "Directory for caching the prepared receptor between runs",
+        cxxopts::value<std::string>());
+  adder("ligand-cache",
+        "Directory for caching the prepared ligands between runs",
+        cxxopts::value<std::string>());
   adder("positional",
         "Positional arguments: unused, but useful to have to catch errors",
         cxxopts::value<std::vector<std::string>>());
@@ -78,86 +107,112 @@ int rxdock::parseDock(int argc, char *argv[]) {
     }
 
     // Command line arguments and default values
-    std::string strLigandMdlFile;
+    operation::DockOptions dockOptions;
     if (result.count("i")) {
-      strLigandMdlFile = result["i"].as<std::string>();
+      dockOptions.strLigandMdlFile = result["i"].as<std::string>();
     } else {
       fmt::print("Input ligand structure-data file name is missing.\n");
       return EXIT_FAILURE;
     }
     // FIXME check if file exists
 
-    std::string strOutputMdlFile;
+    dockOptions.bRecordRange =
+        result.count("start-record") || result.count("end-record");
+    if (result.count("start-record")) {
+      dockOptions.nStartRecord = result["start-record"].as<std::size_t>();
+    }
+    if (result.count("end-record")) {
+      dockOptions.nEndRecord = result["end-record"].as<std::size_t>();
+    }
+    if (result.count("ligand-names")) {
+      if (dockOptions.bRecordRange) {
+        fmt::print("Ligand record range and names cannot both be given.\n");
+        return EXIT_FAILURE;
+      }
+      dockOptions.ligandNames =
+          result["ligand-names"].as<std::vector<std::string>>();
+    }
+
     if (result.count("o")) {
-      strOutputMdlFile = result["o"].as<std::string>();
+      dockOptions.strOutputMdlFile = result["o"].as<std::string>();
     } else {
       fmt::print("Output ligand structure-data file name is missing.\n");
       return EXIT_FAILURE;
     }
     // FIXME check if file exists
 
-    bool bOutputCrd = result.count("output-crd");
-    std::string strOutputCrdFile;
-    if (bOutputCrd) {
-      strOutputCrdFile = result["output-crd"].as<std::string>();
+    dockOptions.bOutputCrd = result.count("output-crd");
+    if (dockOptions.bOutputCrd) {
+      dockOptions.strOutputCrdFile = result["output-crd"].as<std::string>();
+    }
+
+    dockOptions.bOutputHistory = result.count("output-history");
+    if (dockOptions.bOutputHistory) {
+      dockOptions.strOutputHistoryFilePrefix =
+          result["output-history"].as<std::string>();
     }
 
-    bool bOutputHistory = result.count("output-history");
-    std::string strOutputHistoryFilePrefix;
-    if (bOutputHistory) {
-      strOutputHistoryFilePrefix = result["output-history"].as<std::string>();
+    dockOptions.bOutputTable = result.count("output-table");
+    if (dockOptions.bOutputTable) {
+      dockOptions.strOutputTableFile = result["output-table"].as<std::string>();
     }
 
-    std::string strReceptorPrmFile;
     if (result.count("r")) {
-      strReceptorPrmFile = result["r"].as<std::string>();
+      dockOptions.receptorPrmFiles = result["r"].as<std::vector<std::string>>();
     } else {
       fmt::print("Receptor parameters file name is missing.\n");
       return EXIT_FAILURE;
     }
     // FIXME check if file exists
 
-    std::string strParamFile;
     if (result.count("p")) {
-      strParamFile = result["p"].as<std::string>();
+      dockOptions.strParamFile = result["p"].as<std::string>();
     } else {
       fmt::print("Docking protocol parameters file name is missing.\n");
       return EXIT_FAILURE;
     }
     // FIXME check if file exists
 
-    bool bFilter = result.count("f");
-    std::string strFilterFile;
-    if (bFilter) {
-      strFilterFile = result["f"].as<std::string>();
+    dockOptions.bFilter = result.count("f");
+    if (dockOptions.bFilter) {
+      dockOptions.strFilterFile = result["f"].as<std::string>();
+    }
+
+    dockOptions.bDockingRuns = result.count("n");
+    dockOptions.nDockingRuns = result["n"].as<std::size_t>();
+
+    dockOptions.bPosIonise = result.count("P");
+    dockOptions.bNegIonise = result.count("D");
+    dockOptions.bExplH = result.count("H");
+
+    dockOptions.bTarget = result.count("t");
+    if (dockOptions.bTarget) {
+      dockOptions.dTargetScore = result["t"].as<double>();
     }
+    dockOptions.bContinue = result.count("c");
 
-    bool bDockingRuns = result.count("n");
-    std::size_t nDockingRuns = result["n"].as<std::size_t>();
+    dockOptions.nConvergedRuns = result["converge"].as<std::size_t>();
+    dockOptions.dClusterRMSD = result["cluster-rmsd"].as<double>();
+    dockOptions.dClusterScoreWindow =
+        result["cluster-score-window"].as<double>();
 
-    bool bPosIonise = result.count("P");
-    bool bNegIonise = result.count("D");
-    bool bExplH = result.count("H");
+    dockOptions.bSeed = result.count("s");
+    if (dockOptions.bSeed) {
+      dockOptions.nSeed = result["s"].as<std::size_t>();
+    }
 
-    bool bTarget = result.count("t");
-    double dTargetScore = 0.0;
-    if (bTarget) {
-      dTargetScore = result["t"].as<double>();
+    dockOptions.bReceptorCache = result.count("receptor-cache");
+    if (dockOptions.bReceptorCache) {
+      dockOptions.strReceptorCacheDir =
+          result["receptor-cache"].as<std::string>();
     }
-    bool bContinue = result.count("c");
 
-    bool bSeed = result.count("s");
-    std::size_t nSeed = 0;
-    if (bSeed) {
-      nSeed = result["s"].as<std::size_t>();
+    dockOptions.bLigandCache = result.count("ligand-cache");
+    if (dockOptions.bLigandCache) {
+      dockOptions.strLigandCacheDir = result["ligand-cache"].as<std::string>();
     }
 
-    return operation::dock(strLigandMdlFile, strOutputMdlFile, bOutputCrd,
-                           strOutputCrdFile, bOutputHistory,
-                           strOutputHistoryFilePrefix, strReceptorPrmFile,
-                           strParamFile, bFilter, strFilterFile, bDockingRuns,
-                           nDockingRuns, bPosIonise, bNegIonise, bExplH,
-                           bTarget, dTargetScore, bContinue, bSeed, nSeed);
+    return operation::dock(dockOptions);
 
   } catch (const cxxopts::OptionException &e) {
     fmt::print("Error parsing options: {}\n", e.what());
@@ -0,0 +1,137 @@
+//===-- ParsePredict.cxx - Parse CLI params for Predict ---------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://rxdock.gitlab.io/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Parse command-line interface parameters for Predict operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParsePredict.h"
+
+#include "rxdock/Rbt.h"
+#include "rxdock/operation/Predict.h"
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+#include <stdexcept> // TODO
+
+int rxdock::parsePredict(int argc, char *argv[]) {
+  cxxopts::Options options(
+      "rxcmd predict",
+      "Find score thresholds for a multi-stage high-throughput screening "
+      "protocol");
+  options.positional_help("");
+
+  // Command line arguments and default values
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("i,input",
+        "Input structure-data file (SDfile) or table with the scores of an "
+        "exhaustive docking",
+        cxxopts::value<std::string>());
+  adder("o,output", "Output CSV file name for the evaluated protocols",
+        cxxopts::value<std::string>());
+  adder("name-field", "Data field or column with the ligand name",
+        cxxopts::value<std::string>()->default_value("Name"));
+  adder("score-field", "Data field or column with the score to threshold",
+        cxxopts::value<std::string>()->default_value(GetMetaDataPrefix() +
+                                                     "score.inter"));
+  adder("runs-1", "Number of runs in stage 1",
+        cxxopts::value<std::size_t>()->default_value("5"));
+  adder("runs-2", "Number of runs in stage 2",
+        cxxopts::value<std::size_t>()->default_value("15"));
+  adder("runs-final", "Number of runs for ligands passing stage 2",
+        cxxopts::value<std::size_t>()->default_value("50"));
+  adder("threshold-1-max", "Highest stage 1 threshold to try",
+        cxxopts::value<double>());
+  adder("threshold-1-min", "Lowest stage 1 threshold to try",
+        cxxopts::value<double>());
+  adder("threshold-2-max",
+        "Highest stage 2 threshold to try (default: 5 below the highest "
+        "stage 1 threshold)",
+        cxxopts::value<double>());
+  adder("threshold-2-min",
+        "Lowest stage 2 threshold to try (default: 7 below the lowest stage 1 "
+        "threshold)",
+        cxxopts::value<double>());
+  adder("threshold-step", "Step between the thresholds to try",
+        cxxopts::value<double>()->default_value("1.0"));
+  adder("top", "Percentage of best scoring ligands that should be kept",
+        cxxopts::value<double>()->default_value("5.0"));
+  adder("recall", "Minimum percentage of the best scoring ligands to keep",
+        cxxopts::value<double>()->default_value("90.0"));
+  adder("positional",
+        "Positional arguments: unused, but useful to have to catch errors",
+        cxxopts::value<std::vector<std::string>>());
+  adder("h,help", "Print help");
+
+  try {
+    options.parse_positional({"positional"});
+    auto result = options.parse(argc, argv);
+
+    if (result.count("positional")) {
+      fmt::print(
+          "Positional arguments are unsupported but were used: {}.\n",
+          fmt::join(result["positional"].as<std::vector<std::string>>(), ", "));
+      return EXIT_FAILURE;
+    }
+
+    if (result.count("h")) {
+      fmt::print(options.help());
+      return EXIT_SUCCESS;
+    }
+
+    // Command line arguments and default values
+    std::string strInputFile;
+    if (result.count("i")) {
+      strInputFile = result["i"].as<std::string>();
+    } else {
+      fmt::print("Input score file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strOutputFile;
+    if (result.count("o")) {
+      strOutputFile = result["o"].as<std::string>();
+    } else {
+      fmt::print("Output CSV file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    if (!result.count("threshold-1-max") || !result.count("threshold-1-min")) {
+      fmt::print("Range of stage 1 thresholds is missing.\n");
+      return EXIT_FAILURE;
+    }
+    double dThr1Max = result["threshold-1-max"].as<double>();
+    double dThr1Min = result["threshold-1-min"].as<double>();
+    double dThr2Max = result.count("threshold-2-max")
+                          ? result["threshold-2-max"].as<double>()
+                          : dThr1Max - 5.0;
+    double dThr2Min = result.count("threshold-2-min")
+                          ? result["threshold-2-min"].as<double>()
+                          : dThr1Min - 7.0;
+
+    return operation::predict(
+        strInputFile, strOutputFile, result["name-field"].as<std::string>(),
+        result["score-field"].as<std::string>(),
+        result["runs-1"].as<std::size_t>(), result["runs-2"].as<std::size_t>(),
+        result["runs-final"].as<std::size_t>(), dThr1Max, dThr1Min, dThr2Max,
+        dThr2Min, result["threshold-step"].as<double>(),
+        result["top"].as<double>(), result["recall"].as<double>());
+
+  } catch (const cxxopts::OptionException &e) {
+    fmt::print("Error parsing options: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
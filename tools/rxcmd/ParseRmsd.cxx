@@ -0,0 +1,111 @@
+//===-- ParseRmsd.cxx - Parse CLI params for RMSD ---------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://rxdock.gitlab.io/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Parse command-line interface parameters for RMSD operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParseRmsd.h"
+
+#include "rxdock/operation/Rmsd.h"
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+int rxdock::parseRmsd(int argc, char *argv[]) {
+  cxxopts::Options options(
+      "rxcmd rmsd",
+      "Calculate symmetry corrected heavy atom RMSD of poses to a reference");
+  options.positional_help("");
+
+  // Command line arguments and default values
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("r,reference",
+        "Reference structure-data file (SDfile) name (first record is used)",
+        cxxopts::value<std::string>());
+  adder("i,input", "Input structure-data file (SDfile) name",
+        cxxopts::value<std::string>());
+  adder("o,output",
+        "Output SDfile name for the (kept) poses with their RMSD",
+        cxxopts::value<std::string>());
+  adder("f,fit", "Superpose poses onto the reference before calculating RMSD");
+  adder("t,threshold",
+        "Discard poses within this RMSD of an earlier kept pose, adding them "
+        "to its population",
+        cxxopts::value<double>());
+  adder("max-symmetries",
+        "Maximum number of reference symmetries to consider",
+        cxxopts::value<std::size_t>()->default_value("1000"));
+  adder("positional",
+        "Positional arguments: unused, but useful to have to catch errors",
+        cxxopts::value<std::vector<std::string>>());
+  adder("h,help", "Print help");
+
+  try {
+    options.parse_positional({"positional"});
+    auto result = options.parse(argc, argv);
+
+    if (result.count("positional")) {
+      fmt::print(
+          "Positional arguments are unsupported but were used: {}.\n",
+          fmt::join(result["positional"].as<std::vector<std::string>>(), ", "));
+      return EXIT_FAILURE;
+    }
+
+    if (result.count("h")) {
+      fmt::print(options.help());
+      return EXIT_SUCCESS;
+    }
+
+    std::string strRefSDFile;
+    if (result.count("r")) {
+      strRefSDFile = result["r"].as<std::string>();
+    } else {
+      fmt::print("Reference SDfile name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strInputSDFile;
+    if (result.count("i")) {
+      strInputSDFile = result["i"].as<std::string>();
+    } else {
+      fmt::print("Input SDfile name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strOutputSDFile;
+    if (result.count("o")) {
+      strOutputSDFile = result["o"].as<std::string>();
+    }
+
+    bool bFit = result.count("f");
+    double dThreshold = 0.0;
+    if (result.count("t")) {
+      dThreshold = result["t"].as<double>();
+      if (dThreshold <= 0.0) {
+        fmt::print("RMSD threshold must be positive.\n");
+        return EXIT_FAILURE;
+      }
+    }
+    std::size_t nMaxSymmetries = result["max-symmetries"].as<std::size_t>();
+
+    return operation::rmsd(strRefSDFile, strInputSDFile, strOutputSDFile, bFit,
+                           dThreshold, nMaxSymmetries);
+
+  } catch (const cxxopts::OptionException &e) {
+    fmt::print("Error parsing options: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -39,6 +39,10 @@ int rxdock::parseTabularize(int argc, char *argv[]) {
         cxxopts::value<std::size_t>()->default_value("50"));
   adder("d,data-fields", "Number of data fields to output per molecule",
         cxxopts::value<std::size_t>()->default_value("50"));
+  adder("f,fields",
+        "Data fields to output, one column each, instead of the first "
+        "data-fields fields (with no atoms unless atoms is set)",
+        cxxopts::value<std::vector<std::string>>());
   adder("positional",
         "Positional arguments: unused, but useful to have to catch errors",
         cxxopts::value<std::vector<std::string>>());
@@ -81,9 +85,16 @@ int rxdock::parseTabularize(int argc, char *argv[]) {
 
     std::size_t nAtoms = result["a"].as<std::size_t>();
     std::size_t nDataFields = result["d"].as<std::size_t>();
+    std::vector<std::string> fieldNames;
+    if (result.count("f")) {
+      fieldNames = result["f"].as<std::vector<std::string>>();
+      if (!result.count("a")) {
+        nAtoms = 0;
+      }
+    }
 
     return operation::tabularize(inputSDFile, outputCSVFile, nAtoms,
-                                 nDataFields);
+                                 nDataFields, fieldNames);
 
   } catch (const cxxopts::OptionException &e) {
     fmt::print("Error parsing options: {}\n", e.what());
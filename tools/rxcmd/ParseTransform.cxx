@@ -52,9 +52,9 @@ int rxdock::parseTransform(int argc, char *argv[]) {
   adder("p,limit-per-molecule", "Number of records to output per molecule",
         cxxopts::value<std::size_t>());
   adder("b,buffer",
-        "Number of molecules to read in a render cycle (ignored if sorting is "
-        "used)",
-        cxxopts::value<std::size_t>()->default_value("1000"));
+        "Number of molecules to sort in memory before spilling to temporary "
+        "files",
+        cxxopts::value<std::size_t>()->default_value("1000000"));
   adder("positional",
         "Positional arguments: unused, but useful to have to catch errors",
         cxxopts::value<std::vector<std::string>>());
@@ -17,6 +17,8 @@
 
 #include "ParseCavitySearch.h"
 #include "ParseDock.h"
+#include "ParsePredict.h"
+#include "ParseRmsd.h"
 #include "ParseTabularize.h"
 #include "ParseTransform.h"
 
@@ -98,11 +100,11 @@ int main(int argc, char *argv[]) {
       {"cavity-search", parseCavitySearch}, // rbcavity
       {"grid", parseNull},   // rbcalcgrid, make_grid.csh, rbconvgrid, rbmoegrid
       {"tether", parseNull}, // sdtether
-      {"rmsd", parseNull},   // rbrms, sdrmsd
+      {"rmsd", parseRmsd},   // rbrms, sdrmsd
       {"subset", parseNull}, // representative subset for predictions
-      {"predict", parseNull},  // rbhtfinder
-      {"describe", parseNull}, // rblist (add molecular descriptors and
-                               // fingerprints to structure-data files)
+      {"predict", parsePredict}, // rbhtfinder
+      {"describe", parseNull},   // rblist (add molecular descriptors and
+                                 // fingerprints to structure-data files)
       {"transform",
        parseTransform}, // sdfilter, sdsort, sdsplit, sdmodify, sdfield
       {"tabularize", parseTabularize}, // sdreport-like